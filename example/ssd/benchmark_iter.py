@@ -0,0 +1,54 @@
+"""Benchmark the throughput of the detection data iterator with training
+augmentations, without running any network."""
+import argparse
+import tools.find_mxnet
+import mxnet as mx
+import os
+import time
+from config.config import cfg
+from dataset.iterator import DetRecordIter
+
+def parse_args():
+    parser = argparse.ArgumentParser(description='Benchmark detection data iterator')
+    parser.add_argument('--train-path', dest='train_path', help='train record to use',
+                        default=os.path.join(os.getcwd(), 'data', 'train.rec'), type=str)
+    parser.add_argument('--train-list', dest='train_list', help='train list to use',
+                        default="", type=str)
+    parser.add_argument('--batch-size', dest='batch_size', type=int, default=32,
+                        help='batch size')
+    parser.add_argument('--data-shape', dest='data_shape', type=int, default=300,
+                        help='set image shape')
+    parser.add_argument('--num-batches', dest='num_batches', type=int, default=100,
+                        help='number of batches to time')
+    parser.add_argument('--threads', dest='threads', type=int,
+                        default=cfg.train['preprocess_threads'],
+                        help='number of decoding and augmentation threads')
+    parser.add_argument('--label-width', dest='label_width', type=int, default=350,
+                        help='force padding label width to sync across train and validation')
+    args = parser.parse_args()
+    return args
+
+if __name__ == '__main__':
+    args = parse_args()
+    kwargs = dict(cfg.train)
+    kwargs['preprocess_threads'] = args.threads
+    data_iter = DetRecordIter(args.train_path, args.batch_size,
+                              (3, args.data_shape, args.data_shape),
+                              label_pad_width=args.label_width,
+                              path_imglist=args.train_list, **kwargs)
+    # skip the first batch, which includes the warm-up of the workers
+    data_iter.next()
+    count = 0
+    tic = time.time()
+    while count < args.num_batches:
+        try:
+            data_iter.next()
+        except StopIteration:
+            data_iter.reset()
+            continue
+        count += 1
+    elapsed = time.time() - tic
+    print('%d batches in %.2f sec, %.1f images/sec' %
+          (count, elapsed, count * args.batch_size / elapsed))
+    for name, value in sorted(data_iter.rec.getstats().items()):
+        print('%s: %f' % (name, value))
@@ -937,6 +937,34 @@ MXNET_DLL int MXSymbolInferType(SymbolHandle sym, mx_uint num_args,
                                 const int **out_type_data,
                                 mx_uint *aux_type_size,
                                 const int **aux_type_data, int *complete);
+/*!
+ * \brief Convert a symbol into a quantized symbol, which computes
+ *  Convolution, FullyConnected and the Pooling, Flatten and relu following
+ *  them on uint8 data.
+ *
+ * \param sym_handle symbol to quantize
+ * \param ret_sym_handle the returned quantized symbol
+ * \param num_excluded_symbols number of nodes to keep in float
+ * \param excluded_symbols names of the nodes to keep in float
+ * \param num_offline number of parameters quantized ahead of time
+ * \param offline_params names of the parameters quantized ahead of time.
+ *  Each is replaced by the arguments name_quantize, name_min and name_max.
+ * \param num_calib number of calibrated outputs
+ * \param calib_names names of the calibrated outputs, such as conv0_output
+ * \param calib_min the minimum of each calibrated output
+ * \param calib_max the maximum of each calibrated output
+ * \return 0 when success, -1 when failure happens
+ */
+MXNET_DLL int MXQuantizeSymbol(SymbolHandle sym_handle,
+                               SymbolHandle *ret_sym_handle,
+                               const mx_uint num_excluded_symbols,
+                               const char **excluded_symbols,
+                               const mx_uint num_offline,
+                               const char **offline_params,
+                               const mx_uint num_calib,
+                               const char **calib_names,
+                               const float *calib_min,
+                               const float *calib_max);
 //--------------------------------------------
 // Part 4: Executor interface
 //--------------------------------------------
@@ -1150,6 +1178,49 @@ MXNET_DLL int MXDataIterGetIndex(DataIterHandle handle, uint64_t **out_index,
  * \return 0 when success, -1 when failure happens
  */
 MXNET_DLL int MXDataIterGetPadNum(DataIterHandle handle, int *pad);
+/*!
+ * \brief Get an auxiliary array of current batch, such as the indices and
+ *  the row pointer of a batch in CSR format.
+ * \param handle the handle pointer to the data iterator
+ * \param index index of the auxiliary array
+ * \param out handle to the auxiliary array
+ * \return 0 when success, -1 when failure happens
+ */
+MXNET_DLL int MXDataIterGetAuxData(DataIterHandle handle, mx_uint index,
+                                   NDArrayHandle *out);
+/*!
+ * \brief Get the cumulative statistics of the data iterator pipeline, such as
+ *  the seconds spent reading, decoding, batching and waiting for batches.
+ * \param handle the handle pointer to the data iterator
+ * \param out_size number of statistics
+ * \param out_keys names of the statistics
+ * \param out_vals values of the statistics
+ * \return 0 when success, -1 when failure happens
+ */
+MXNET_DLL int MXDataIterGetStats(DataIterHandle handle, mx_uint *out_size,
+                                 const char ***out_keys,
+                                 const double **out_vals);
+/*!
+ * \brief Save the position of the data iterator after the last batch,
+ *  including cursors, shuffle orders and random states.
+ * \param handle the handle pointer to the data iterator
+ * \param out_size size of the state in bytes
+ * \param out_buf the state, valid until the next call in this thread
+ * \return 0 when success, -1 when failure happens
+ */
+MXNET_DLL int MXDataIterSaveState(DataIterHandle handle, size_t *out_size,
+                                  const char **out_buf);
+/*!
+ * \brief Restore the position saved by MXDataIterSaveState, the next batch
+ *  is the one after the saved position. The iterator must be created with
+ *  the same parameters.
+ * \param handle the handle pointer to the data iterator
+ * \param size size of the state in bytes
+ * \param buf the state
+ * \return 0 when success, -1 when failure happens
+ */
+MXNET_DLL int MXDataIterLoadState(DataIterHandle handle, size_t size,
+                                  const void *buf);
 
 /*!
  * \brief Get the handle to the NDArray of underlying label
@@ -7,6 +7,7 @@
 #define MXNET_IO_H_
 
 #include <dmlc/data.h>
+#include <dmlc/io.h>
 #include <dmlc/registry.h>
 #include <queue>
 #include <string>
@@ -35,6 +36,28 @@ class IIterator : public dmlc::DataIter<DType> {
     virtual bool Next(void) = 0;
     /*! \brief get current data */
     virtual const DType &Value(void) const = 0;
+    /*!
+     * \brief get cumulative statistics of the iterator pipeline, such as the
+     *  seconds spent in each stage, as (name, value) pairs
+     * \param stats the statistics are appended to it
+     */
+    virtual void GetStats(
+        std::vector<std::pair<std::string, double> > *stats) const {}
+    /*!
+     * \brief save the position of the iterator after the last item returned,
+     *  including cursors, shuffle orders and random states, so that an
+     *  iterator initialized with the same parameters continues from the next
+     *  item after LoadState, without reading the items before it
+     * \param fo the stream to write the state to, a valid state is not empty
+     * \return false if the iterator does not support saving its state
+     */
+    virtual bool SaveState(dmlc::Stream *fo) const { return false; }
+    /*!
+     * \brief restore the position saved by SaveState
+     * \param fi the stream to read the state from
+     * \return false if the iterator does not support restoring its state
+     */
+    virtual bool LoadState(dmlc::Stream *fi) { return false; }
     /*! \brief constructor */
     virtual ~IIterator(void) {}
     /*! \brief store the name of each data, it could be used for making NDArrays
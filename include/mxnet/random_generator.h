@@ -0,0 +1,131 @@
+/*!
+ *  Copyright (c) 2017 by Contributors
+ * \file random_generator.h
+ * \brief counter-based random number generation, which workers can draw
+ *  from independently and reproducibly by their offset in the output.
+ */
+#ifndef MXNET_RANDOM_GENERATOR_H_
+#define MXNET_RANDOM_GENERATOR_H_
+
+#include <dmlc/logging.h>
+#include <cstdint>
+#include "./base.h"
+
+namespace mxnet {
+namespace random {
+/*!
+ * \brief The Philox4x32-10 generator of Salmon et al., "Parallel random
+ *  numbers: as easy as 1, 2, 3". Each (key, subsequence) pair is an
+ *  independent stream of 2^34 numbers, and no state is shared between
+ *  streams, so any worker can start any stream without synchronization.
+ */
+class Philox4x32 {
+   public:
+    /*!
+     * \brief the stream of numbers at subsequence of key
+     * \param key the key, taken from the seed
+     * \param subsequence index of the stream for this key
+     */
+    MSHADOW_XINLINE Philox4x32(uint64_t key, uint64_t subsequence)
+        : counter_(0), pos_(4) {
+        key_[0] = static_cast<uint32_t>(key);
+        key_[1] = static_cast<uint32_t>(key >> 32);
+        sub_[0] = static_cast<uint32_t>(subsequence);
+        sub_[1] = static_cast<uint32_t>(subsequence >> 32);
+    }
+    /*! \brief the next number of the stream */
+    MSHADOW_XINLINE uint32_t operator()() {
+        if (pos_ == 4) {
+            Block(counter_++, out_);
+            pos_ = 0;
+        }
+        return out_[pos_++];
+    }
+    /*! \brief uniform in [0, 1) with 24 random bits */
+    MSHADOW_XINLINE float UniformFloat() {
+        return ((*this)() >> 8) * (1.0f / 16777216.0f);
+    }
+    /*! \brief uniform in [0, 1) with 53 random bits */
+    MSHADOW_XINLINE double UniformDouble() {
+        const uint32_t a = (*this)() >> 5, b = (*this)() >> 6;
+        return (a * 67108864.0 + b) * (1.0 / 9007199254740992.0);
+    }
+    /*!
+     * \brief the four numbers at the given counter of the stream
+     * \param counter position in the stream, in units of four numbers
+     * \param out the numbers
+     */
+    MSHADOW_XINLINE void Block(uint32_t counter, uint32_t out[4]) const {
+        uint32_t c[4] = {counter, 0, sub_[0], sub_[1]};
+        uint32_t k[2] = {key_[0], key_[1]};
+        for (int round = 0; round < 10; ++round) {
+            const uint64_t p0 = static_cast<uint64_t>(kMul0) * c[0];
+            const uint64_t p1 = static_cast<uint64_t>(kMul1) * c[2];
+            const uint32_t hi0 = static_cast<uint32_t>(p0 >> 32);
+            const uint32_t hi1 = static_cast<uint32_t>(p1 >> 32);
+            c[0] = hi1 ^ c[1] ^ k[0];
+            c[1] = static_cast<uint32_t>(p1);
+            c[2] = hi0 ^ c[3] ^ k[1];
+            c[3] = static_cast<uint32_t>(p0);
+            k[0] += kWeyl0;
+            k[1] += kWeyl1;
+        }
+        for (int i = 0; i < 4; ++i) out[i] = c[i];
+    }
+
+   private:
+    static const uint32_t kMul0 = 0xD2511F53U;
+    static const uint32_t kMul1 = 0xCD9E8D57U;
+    static const uint32_t kWeyl0 = 0x9E3779B9U;
+    static const uint32_t kWeyl1 = 0xBB67AE85U;
+    /*! \brief the key */
+    uint32_t key_[2];
+    /*! \brief the subsequence, the high half of the counter */
+    uint32_t sub_[2];
+    /*! \brief the next block of the subsequence */
+    uint32_t counter_;
+    /*! \brief the numbers of the current block and the next one to return */
+    uint32_t out_[4];
+    int pos_;
+};
+
+/*!
+ * \brief State of the parallel random resource: the key, and the first
+ *  subsequence not handed out yet. An operator reserves the subsequences it
+ *  draws from, typically one per fixed-size block of its output, so its
+ *  result depends on the seed and the calls before it but not on how the
+ *  blocks are spread over threads. The engine serializes the operators that
+ *  request the resource, so reserving needs no locking.
+ */
+class ParallelRandom {
+   public:
+    explicit ParallelRandom(uint64_t key) { Seed(key); }
+    /*! \brief restart from the first subsequence of key */
+    inline void Seed(uint64_t key) {
+        key_ = key;
+        next_ = 0;
+    }
+    /*!
+     * \brief reserve subsequences for one call
+     * \param count number of subsequences
+     * \return the first of them
+     */
+    inline uint64_t Reserve(uint64_t count) {
+        const uint64_t first = next_;
+        next_ += count;
+        return first;
+    }
+    /*! \brief the stream of a subsequence */
+    MSHADOW_XINLINE Philox4x32 Stream(uint64_t subsequence) const {
+        return Philox4x32(key_, subsequence);
+    }
+
+   private:
+    /*! \brief the key of all streams */
+    uint64_t key_;
+    /*! \brief the first subsequence not reserved yet */
+    uint64_t next_;
+};
+}  // namespace random
+}  // namespace mxnet
+#endif  // MXNET_RANDOM_GENERATOR_H_
@@ -9,6 +9,7 @@
 #include <dmlc/logging.h>
 #include "./base.h"
 #include "./engine.h"
+#include "./random_generator.h"
 
 namespace mxnet {
 
@@ -21,7 +22,9 @@ struct ResourceRequest {
         /*! \brief mshadow::Random<xpu> object */
         kRandom,
         /*! \brief A dynamic temp space that can be arbitrary size */
-        kTempSpace
+        kTempSpace,
+        /*! \brief random::ParallelRandom object, drawn from by offset */
+        kParallelRandom
     };
     /*! \brief type of resources */
     Type type;
@@ -69,6 +72,15 @@ struct Resource {
         ret->set_stream(stream);
         return ret;
     }
+    /*!
+     * \brief Get the counter-based random number generator, whose streams
+     *  can be drawn from in parallel.
+     * \return the generator state, kept on the host for all devices.
+     */
+    inline random::ParallelRandom *get_parallel_random() const {
+        CHECK_EQ(req.type, ResourceRequest::kParallelRandom);
+        return static_cast<random::ParallelRandom *>(ptr_);
+    }
     /*!
      * \brief Get space requested as mshadow Tensor.
      *  The caller can request arbitrary size.
@@ -0,0 +1,160 @@
+# coding: utf-8
+"""Quantization of trained models for uint8 inference on CPU."""
+from __future__ import absolute_import
+
+import ctypes
+import json
+import logging
+from ..base import _LIB, check_call, mx_uint, mx_float, c_array, c_str
+from ..base import SymbolHandle
+from ..context import cpu
+from .. import ndarray as nd
+from .. import symbol as sym
+from . import ndarray as contrib_nd
+
+_QUANTIZABLE_LAYERS = ('Convolution', 'FullyConnected')
+
+
+def _quantize_symbol(symbol, excluded_sym_names=(), offline_params=(),
+                     calib_table=None):
+    """Replace the layers of `symbol` that have quantized versions.
+
+    Parameters
+    ----------
+    symbol : Symbol
+        The float symbol.
+    excluded_sym_names : list of str
+        Names of the layers to keep in float.
+    offline_params : list of str
+        Names of the parameters quantized ahead of time. Each is replaced by
+        the arguments `name_quantize`, `name_min` and `name_max`.
+    calib_table : dict of str to (float, float)
+        Calibrated range of the layer outputs, such as `conv0_output`.
+    """
+    calib_table = calib_table or {}
+    calib_names = list(calib_table.keys())
+    out = SymbolHandle()
+    check_call(_LIB.MXQuantizeSymbol(
+        symbol.handle, ctypes.byref(out),
+        mx_uint(len(excluded_sym_names)),
+        c_array(ctypes.c_char_p, [c_str(n) for n in excluded_sym_names]),
+        mx_uint(len(offline_params)),
+        c_array(ctypes.c_char_p, [c_str(n) for n in offline_params]),
+        mx_uint(len(calib_names)),
+        c_array(ctypes.c_char_p, [c_str(n) for n in calib_names]),
+        c_array(mx_float, [calib_table[n][0] for n in calib_names]),
+        c_array(mx_float, [calib_table[n][1] for n in calib_names])))
+    return sym.Symbol(out)
+
+
+def _quantize_params(qsym, params):
+    """Quantize the parameters the quantized symbol takes as `name_quantize`,
+    and pass the others through."""
+    qparams = {}
+    for name in qsym.list_arguments():
+        if name.endswith('_quantize') and name[:-9] in params:
+            original = name[:-9]
+            param = params[original]
+            qparam, vmin, vmax = contrib_nd.quantize(
+                param, nd.min(param), nd.max(param), out_type='uint8')
+            qparams[name] = qparam
+            qparams[original + '_min'] = vmin
+            qparams[original + '_max'] = vmax
+        elif name in params:
+            qparams[name] = params[name]
+    return qparams
+
+
+def _collect_layer_output_ranges(symbol, arg_params, aux_params, layers, ctx,
+                                 calib_data, num_calib_examples, logger):
+    """Run the float model over `calib_data` and return the minimum and the
+    maximum of the output of each layer."""
+    internals = symbol.get_internals()
+    outputs = [name + '_output' for name in layers]
+    group = sym.Group([internals[name] for name in outputs])
+    data_names = [desc[0] for desc in calib_data.provide_data]
+    shapes = dict((desc[0], desc[1]) for desc in calib_data.provide_data
+                  if desc[0] in group.list_arguments())
+    exe = group.simple_bind(ctx, grad_req='null', **shapes)
+    exe.copy_params_from(arg_params, aux_params, allow_extra_params=True)
+    ranges = {}
+    num_examples = 0
+    calib_data.reset()
+    for batch in calib_data:
+        for name, data in zip(data_names, batch.data):
+            if name in exe.arg_dict:
+                data.copyto(exe.arg_dict[name])
+        exe.forward(is_train=False)
+        for name, out in zip(outputs, exe.outputs):
+            vmin = float(nd.min(out).asscalar())
+            vmax = float(nd.max(out).asscalar())
+            if name in ranges:
+                vmin = min(vmin, ranges[name][0])
+                vmax = max(vmax, ranges[name][1])
+            ranges[name] = (vmin, vmax)
+        num_examples += batch.data[0].shape[0] - (batch.pad or 0)
+        if num_calib_examples is not None and \
+           num_examples >= num_calib_examples:
+            break
+    logger.info('Collected the output ranges of %d layers from %d examples',
+                len(ranges), num_examples)
+    return ranges
+
+
+def quantize_model(symbol, arg_params, aux_params, ctx=cpu(),
+                   excluded_sym_names=None, calib_mode='none',
+                   calib_data=None, num_calib_examples=None,
+                   logger=logging):
+    """Convert a float model into a model computing Convolution,
+    FullyConnected, and the Pooling, Flatten and relu following them, on
+    uint8 data with int32 accumulation.
+
+    Data is quantized and dequantized only where quantized and float layers
+    meet, and the weights are quantized ahead of time.
+
+    Parameters
+    ----------
+    symbol : Symbol
+        The float model.
+    arg_params : dict of str to NDArray
+        The parameters of the model.
+    aux_params : dict of str to NDArray
+        The auxiliary states of the model.
+    ctx : Context
+        The context calibration runs on.
+    excluded_sym_names : list of str
+        Names of the layers to keep in float, such as the first
+        convolution, which is often sensitive to quantization.
+    calib_mode : str
+        'none' computes the range of every layer output at run time.
+        'naive' uses the minimum and maximum of each output over
+        `calib_data` instead, which saves a pass over the output.
+    calib_data : DataIter
+        Representative data for calibration.
+    num_calib_examples : int
+        Number of examples of `calib_data` to use. All if None.
+    logger : Object
+        Logger for messages about the calibration.
+
+    Returns
+    -------
+    tuple
+        The quantized symbol, its parameters and its auxiliary states.
+    """
+    excluded_sym_names = excluded_sym_names or []
+    if calib_mode not in ('none', 'naive'):
+        raise ValueError('unknown calib_mode %s' % calib_mode)
+    calib_table = {}
+    if calib_mode == 'naive':
+        if calib_data is None:
+            raise ValueError('calib_data is required for naive calibration')
+        nodes = json.loads(symbol.tojson())['nodes']
+        layers = [node['name'] for node in nodes
+                  if node['op'] in _QUANTIZABLE_LAYERS and
+                  node['name'] not in excluded_sym_names]
+        calib_table = _collect_layer_output_ranges(
+            symbol, arg_params, aux_params, layers, ctx, calib_data,
+            num_calib_examples, logger)
+    qsym = _quantize_symbol(symbol, excluded_sym_names,
+                            list(arg_params.keys()), calib_table)
+    return qsym, _quantize_params(qsym, arg_params), aux_params
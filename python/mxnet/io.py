@@ -8,9 +8,10 @@ import logging
 import threading
 import numpy as np
 from .base import _LIB
-from .base import c_array, c_str, mx_uint, py_str
+from .base import c_array, c_str, mx_uint, py_str, ctypes2buffer
 from .base import DataIterHandle, NDArrayHandle
 from .base import mx_real_t
+from .base import MXNetError
 from .base import check_call, build_param_doc as _build_param_doc
 from .ndarray import NDArray
 from .ndarray import array
@@ -699,6 +700,13 @@ class MXDataIter(DataIter):
         # debug option, used to test the speed with io effect eliminated
         self._debug_skip_load = False
 
+        # the state at the beginning, which getstate returns while the first
+        # batch is not returned yet; None if the iterator has no state
+        try:
+            self._begin_state = self._savestate()
+        except MXNetError:
+            self._begin_state = None
+
         # load the first batch to get shape information
         self.first_batch = None
         self.first_batch = self.next()
@@ -708,7 +716,8 @@ class MXDataIter(DataIter):
         # properties
         self.provide_data = [DataDesc(data_name, data.shape, data.dtype)]
         self.provide_label = [DataDesc(label_name, label.shape, label.dtype)]
-        self.batch_size = data.shape[0]
+        # the data of a sparse batch is not batch major, use the label instead
+        self.batch_size = label.shape[0]
 
     def __del__(self):
         check_call(_LIB.MXDataIterFree(self.handle))
@@ -775,6 +784,92 @@ class MXDataIter(DataIter):
         check_call(_LIB.MXDataIterGetPadNum(self.handle, ctypes.byref(pad)))
         return pad.value
 
+    def getaux(self, index):
+        """Returns an auxiliary array of the current batch.
+
+        Iterators producing sparse batches, such as `LibSVMIter`, return the
+        indices of the stored elements as auxiliary array 0 and the row pointer
+        as auxiliary array 1.
+
+        Parameters
+        ----------
+        index : int
+            The index of the auxiliary array.
+
+        Returns
+        -------
+        NDArray
+            The auxiliary array.
+        """
+        hdl = NDArrayHandle()
+        check_call(_LIB.MXDataIterGetAuxData(self.handle, mx_uint(index),
+                                             ctypes.byref(hdl)))
+        return NDArray(hdl, False)
+
+    def getstats(self):
+        """Returns the cumulative statistics of the iterator pipeline.
+
+        Iterators with a prefetch thread report ``wait_time``, the seconds the
+        caller was blocked waiting for a batch, ``num_batches`` and
+        ``queued_batches``, the sum over batches of the number of batches that
+        were ready. A large ``wait_time`` means training is stalled on data.
+        Depending on the iterator, the seconds spent in each stage, such as
+        ``read_time``, ``decode_time``, ``augment_time`` and ``batch_time``,
+        are reported as well. Stage times are summed over worker threads.
+
+        Returns
+        -------
+        dict of str to float
+            The statistics.
+        """
+        size = mx_uint()
+        keys = ctypes.POINTER(ctypes.c_char_p)()
+        vals = ctypes.POINTER(ctypes.c_double)()
+        check_call(_LIB.MXDataIterGetStats(self.handle, ctypes.byref(size),
+                                           ctypes.byref(keys),
+                                           ctypes.byref(vals)))
+        return {py_str(keys[i]): vals[i] for i in range(size.value)}
+
+    def getstate(self):
+        """Returns the position of the iterator after the last batch returned.
+
+        The state holds the cursors, shuffle orders and random states, so an
+        iterator created with the same parameters continues from the next batch
+        after `setstate`, without reading the batches before it. It is
+        supported by `ImageRecordIter`, `CSVIter` and `MNISTIter`.
+
+        Returns
+        -------
+        bytearray
+            The state.
+        """
+        if self.first_batch is not None and self._begin_state is not None:
+            # the batch loaded at creation is not returned yet
+            return bytearray(self._begin_state)
+        return self._savestate()
+
+    def _savestate(self):
+        """Returns the state of the underlying C++ iterator."""
+        length = ctypes.c_size_t()
+        cptr = ctypes.POINTER(ctypes.c_char)()
+        check_call(_LIB.MXDataIterSaveState(self.handle, ctypes.byref(length),
+                                            ctypes.byref(cptr)))
+        return ctypes2buffer(cptr, length.value)
+
+    def setstate(self, state):
+        """Restores the position returned by `getstate`.
+
+        Parameters
+        ----------
+        state : bytearray
+            The state returned by `getstate` of an iterator with the same
+            parameters.
+        """
+        buf = bytearray(state)
+        ptr = (ctypes.c_char * len(buf)).from_buffer(buf)
+        check_call(_LIB.MXDataIterLoadState(self.handle, ctypes.c_size_t(len(buf)), ptr))
+        self.first_batch = None
+
 def _make_io_iterator(handle):
     """Create an io iterator by handle."""
     name = ctypes.c_char_p()
@@ -2,8 +2,9 @@
 import math
 import pickle
 import logging
-from .ndarray import NDArray, zeros, clip, sqrt, sign
+from .ndarray import NDArray, zeros, clip, sqrt
 from .ndarray import sgd_update, sgd_mom_update, adam_update, rmsprop_update, rmspropalex_update
+from .ndarray import lars_mom_update, lamb_update, adagrad_update, ftrl_update
 from .random import normal
 
 
@@ -534,6 +535,113 @@ class Adam(Optimizer):
         adam_update(weight, grad, mean, var, out=weight,
                     lr=lr, wd=wd, **kwargs)
 
+@register
+class LARS(Optimizer):
+    """The LARS optimizer, SGD with momentum and a layer-wise learning rate.
+
+    This class implements the optimizer described in *Large Batch Training of
+    Convolutional Networks*, available at https://arxiv.org/abs/1708.03888.
+
+    This optimizer accepts the following parameters in addition to those accepted
+    by :class:`.Optimizer`.
+
+    For details of the update algorithm, see :class:`ndarray.lars_mom_update`.
+
+    Parameters
+    ----------
+    momentum : float, optional
+       The momentum value.
+    eta : float, optional
+       Trust coefficient of the layer-wise learning rate.
+    epsilon : float, optional
+        Small value to avoid division by 0.
+    """
+    def __init__(self, momentum=0.9, eta=0.001, epsilon=1e-9, **kwargs):
+        super(LARS, self).__init__(**kwargs)
+        self.momentum = momentum
+        self.eta = eta
+        self.epsilon = epsilon
+
+    def create_state(self, index, weight):
+        return zeros(weight.shape, weight.context, dtype=weight.dtype)  # momentum
+
+    def update(self, index, weight, grad, state):
+        assert(isinstance(weight, NDArray))
+        assert(isinstance(grad, NDArray))
+        lr = self._get_lr(index)
+        wd = self._get_wd(index)
+        self._update_count(index)
+
+        kwargs = {'momentum': self.momentum, 'eta': self.eta, 'epsilon': self.epsilon,
+                  'rescale_grad': self.rescale_grad}
+        if self.clip_gradient:
+            kwargs['clip_gradient'] = self.clip_gradient
+
+        lars_mom_update(weight, grad, state, out=weight, lr=lr, wd=wd, **kwargs)
+
+@register
+class LAMB(Optimizer):
+    """The LAMB optimizer, Adam with a layer-wise trust ratio.
+
+    This class implements the optimizer described in *Large Batch Optimization for
+    Deep Learning: Training BERT in 76 minutes*, available at
+    https://arxiv.org/abs/1904.00962.
+
+    This optimizer accepts the following parameters in addition to those accepted
+    by :class:`.Optimizer`.
+
+    For details of the update algorithm, see :class:`ndarray.lamb_update`.
+
+    Parameters
+    ----------
+    beta1 : float, optional
+        Exponential decay rate for the first moment estimates.
+    beta2 : float, optional
+        Exponential decay rate for the second moment estimates.
+    epsilon : float, optional
+        Small value to avoid division by 0.
+    lower_bound : float, optional
+        Lower bound of the weight norm in the trust ratio, if not None.
+    upper_bound : float, optional
+        Upper bound of the weight norm in the trust ratio, if not None.
+    bias_correction : bool, optional
+        Whether to correct the bias of the moment estimates.
+    """
+    def __init__(self, learning_rate=0.001, beta1=0.9, beta2=0.999, epsilon=1e-6,
+                 lower_bound=None, upper_bound=None, bias_correction=True, **kwargs):
+        super(LAMB, self).__init__(learning_rate=learning_rate, **kwargs)
+        self.beta1 = beta1
+        self.beta2 = beta2
+        self.epsilon = epsilon
+        self.lower_bound = lower_bound
+        self.upper_bound = upper_bound
+        self.bias_correction = bias_correction
+
+    def create_state(self, index, weight):
+        return (zeros(weight.shape, weight.context, dtype=weight.dtype),  # mean
+                zeros(weight.shape, weight.context, dtype=weight.dtype))  # variance
+
+    def update(self, index, weight, grad, state):
+        assert(isinstance(weight, NDArray))
+        assert(isinstance(grad, NDArray))
+        lr = self._get_lr(index)
+        wd = self._get_wd(index)
+        self._update_count(index)
+
+        t = self._index_update_count[index]
+        kwargs = {'beta1': self.beta1, 'beta2': self.beta2, 'epsilon': self.epsilon,
+                  't': t, 'bias_correction': self.bias_correction,
+                  'rescale_grad': self.rescale_grad}
+        if self.lower_bound:
+            kwargs['lower_bound'] = self.lower_bound
+        if self.upper_bound:
+            kwargs['upper_bound'] = self.upper_bound
+        if self.clip_gradient:
+            kwargs['clip_gradient'] = self.clip_gradient
+
+        mean, var = state
+        lamb_update(weight, grad, mean, var, out=weight, lr=lr, wd=wd, **kwargs)
+
 @register
 class AdaGrad(Optimizer):
     """AdaGrad optimizer.
@@ -545,17 +653,23 @@ class AdaGrad(Optimizer):
     This optimizer accepts the following parameters in addition to those accepted
     by :class:`.Optimizer`.
 
+    For details of the update algorithm, see :class:`ndarray.adagrad_update`.
+
     Parameters
     ----------
     eps: float, optional
         Small value to avoid division by 0.
+    lazy_update : bool, optional
+        If True, rows of a weight whose gradient is all zero, such as the rows of an
+        embedding that no sample looked up, are not updated.
     """
-    def __init__(self, eps=1e-7, **kwargs):
+    def __init__(self, eps=1e-7, lazy_update=False, **kwargs):
         super(AdaGrad, self).__init__(**kwargs)
         self.float_stable_eps = eps
+        self.lazy_update = lazy_update
 
     def create_state(self, index, weight):
-        return zeros(weight.shape, weight.context)  # history
+        return zeros(weight.shape, weight.context, dtype=weight.dtype)  # history
 
     def update(self, index, weight, grad, state):
         assert(isinstance(weight, NDArray))
@@ -564,12 +678,12 @@ class AdaGrad(Optimizer):
         wd = self._get_wd(index)
         self._update_count(index)
 
-        grad = grad * self.rescale_grad
-        if self.clip_gradient is not None:
-            grad = clip(grad, -self.clip_gradient, self.clip_gradient)
-        history = state
-        history[:] += (grad * grad)
-        weight[:] += -lr * (grad / sqrt(history + self.float_stable_eps) + wd * weight)
+        kwargs = {'epsilon': self.float_stable_eps, 'rescale_grad': self.rescale_grad,
+                  'lazy_update': self.lazy_update}
+        if self.clip_gradient:
+            kwargs['clip_gradient'] = self.clip_gradient
+
+        adagrad_update(weight, grad, state, out=weight, lr=lr, wd=wd, **kwargs)
 
 @register
 class RMSProp(Optimizer):
@@ -714,17 +828,23 @@ class Ftrl(Optimizer):
     eta :
         .. math::
            \\eta_{t,i} = \\frac{learningrate}{\\beta+\\sqrt{\\sum_{s=1}^tg_{s,i}^t}}
+    lazy_update : bool, optional
+        If True, rows of a weight whose gradient is all zero, such as the rows of an
+        embedding that no sample looked up, are not updated.
+
+    For details of the update algorithm, see :class:`ndarray.ftrl_update`.
     """
 
-    def __init__(self, lamda1=0.01, learning_rate=0.1, beta=1, **kwargs):
+    def __init__(self, lamda1=0.01, learning_rate=0.1, beta=1, lazy_update=False, **kwargs):
         super(Ftrl, self).__init__(**kwargs)
         self.lamda1 = lamda1
         self.beta = beta
         self.lr = learning_rate
+        self.lazy_update = lazy_update
 
     def create_state(self, index, weight):
-        return (zeros(weight.shape, weight.context),  # dn
-                zeros(weight.shape, weight.context))  # n
+        return (zeros(weight.shape, weight.context, dtype=weight.dtype),  # dn
+                zeros(weight.shape, weight.context, dtype=weight.dtype))  # n
 
     def update(self, index, weight, grad, state):
         assert(isinstance(weight, NDArray))
@@ -733,21 +853,13 @@ class Ftrl(Optimizer):
         wd = self._get_wd(index)
         lr = self._get_lr(index)
 
-        # preprocess grad
-        grad *= self.rescale_grad
-        if self.clip_gradient is not None:
-            grad = clip(grad, -self.clip_gradient, self.clip_gradient)
+        kwargs = {'lamda1': self.lamda1, 'beta': self.beta,
+                  'rescale_grad': self.rescale_grad, 'lazy_update': self.lazy_update}
+        if self.clip_gradient:
+            kwargs['clip_gradient'] = self.clip_gradient
 
-        # accumulated g and delta initialization
         dn, n = state
-
-        #update dn, n
-        dn += grad - (sqrt(n + grad * grad) - sqrt(n)) * weight / lr
-        n += grad * grad
-
-        # update weight
-        weight[:] = (sign(dn) * self.lamda1 - dn) / \
-                    ((self.beta + sqrt(n)) / lr + wd) * (NDArray.abs(dn) > self.lamda1)
+        ftrl_update(weight, grad, dn, n, out=weight, lr=lr, wd=wd, **kwargs)
 
 @register
 class Test(Optimizer):
@@ -541,6 +541,62 @@ int MXDataIterGetPadNum(DataIterHandle handle, int *pad) {
     API_END();
 }
 
+int MXDataIterGetAuxData(DataIterHandle handle, mx_uint index,
+                         NDArrayHandle *out) {
+    API_BEGIN();
+    const DataBatch &db = static_cast<IIterator<DataBatch> *>(handle)->Value();
+    // data[0] and data[1] are the data and the label
+    CHECK_LT(index + 2, db.data.size())
+        << "The batch has " << db.data.size() - 2 << " auxiliary arrays";
+    NDArray *pndarray = new NDArray();
+    *pndarray = db.data[index + 2];
+    *out = pndarray;
+    API_END();
+}
+
+int MXDataIterGetStats(DataIterHandle handle, mx_uint *out_size,
+                       const char ***out_keys, const double **out_vals) {
+    MXAPIThreadLocalEntry *ret = MXAPIThreadLocalStore::Get();
+    API_BEGIN();
+    std::vector<std::pair<std::string, double> > stats;
+    static_cast<IIterator<DataBatch> *>(handle)->GetStats(&stats);
+    ret->ret_vec_str.clear();
+    ret->ret_vec_charp.clear();
+    ret->ret_vec_double.clear();
+    for (const auto &kv : stats) {
+        ret->ret_vec_str.push_back(kv.first);
+        ret->ret_vec_double.push_back(kv.second);
+    }
+    for (const auto &name : ret->ret_vec_str) {
+        ret->ret_vec_charp.push_back(name.c_str());
+    }
+    *out_size = static_cast<mx_uint>(stats.size());
+    *out_keys = dmlc::BeginPtr(ret->ret_vec_charp);
+    *out_vals = dmlc::BeginPtr(ret->ret_vec_double);
+    API_END();
+}
+
+int MXDataIterSaveState(DataIterHandle handle, size_t *out_size,
+                        const char **out_buf) {
+    MXAPIThreadLocalEntry *ret = MXAPIThreadLocalStore::Get();
+    API_BEGIN();
+    ret->ret_str.resize(0);
+    dmlc::MemoryStringStream strm(&ret->ret_str);
+    CHECK(static_cast<IIterator<DataBatch> *>(handle)->SaveState(&strm))
+        << "The data iterator does not support saving its state";
+    *out_size = ret->ret_str.length();
+    *out_buf = ret->ret_str.c_str();
+    API_END();
+}
+
+int MXDataIterLoadState(DataIterHandle handle, size_t size, const void *buf) {
+    API_BEGIN();
+    dmlc::MemoryFixedSizeStream strm((void *)buf, size);  // NOLINT(*)
+    CHECK(static_cast<IIterator<DataBatch> *>(handle)->LoadState(&strm))
+        << "The data iterator does not support restoring its state";
+    API_END();
+}
+
 int MXKVStoreCreate(const char *type, KVStoreHandle *out) {
     API_BEGIN();
     *out = KVStore::Create(type);
@@ -66,6 +66,8 @@ struct MXAPIThreadLocalEntry {
     std::vector<const char*> ret_vec_charp;
     /*! \brief result holder for returning handles */
     std::vector<void*> ret_handles;
+    /*! \brief result holder for returning doubles */
+    std::vector<double> ret_vec_double;
     /*! \brief result holder for returning shapes */
     std::vector<TShape> arg_shapes, out_shapes, aux_shapes;
     /*! \brief result holder for returning type flags */
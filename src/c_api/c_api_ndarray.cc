@@ -199,6 +199,7 @@ void SetDependency(std::vector<engine::VarHandle>* p_read_vars,
                 case ResourceRequest::kTempSpace:
                     ++ntmp;
                 case ResourceRequest::kRandom:
+                case ResourceRequest::kParallelRandom:
                     requested.push_back(
                         ResourceManager::Get()->Request(ctx, req));
                     write_vars.push_back(requested.back().var);
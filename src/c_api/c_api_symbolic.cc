@@ -529,3 +529,30 @@ int MXSymbolGrad(SymbolHandle sym, mx_uint num_wrt, const char **wrt,
     LOG(FATAL) << "not implemented";
     API_END();
 }
+
+int MXQuantizeSymbol(SymbolHandle sym_handle, SymbolHandle *ret_sym_handle,
+                     const mx_uint num_excluded_symbols,
+                     const char **excluded_symbols,
+                     const mx_uint num_offline, const char **offline_params,
+                     const mx_uint num_calib, const char **calib_names,
+                     const float *calib_min, const float *calib_max) {
+    nnvm::Symbol *s = new nnvm::Symbol();
+    API_BEGIN();
+    nnvm::Symbol *sym = static_cast<nnvm::Symbol *>(sym_handle);
+    nnvm::Graph g = Symbol2Graph(*sym);
+    std::unordered_set<std::string> excluded(
+        excluded_symbols, excluded_symbols + num_excluded_symbols);
+    std::unordered_set<std::string> offline(offline_params,
+                                            offline_params + num_offline);
+    std::unordered_map<std::string, std::pair<float, float> > calib;
+    for (mx_uint i = 0; i < num_calib; ++i) {
+        calib[calib_names[i]] = std::make_pair(calib_min[i], calib_max[i]);
+    }
+    g.attrs["excluded_nodes"] =
+        std::make_shared<nnvm::any>(std::move(excluded));
+    g.attrs["offline_params"] = std::make_shared<nnvm::any>(std::move(offline));
+    g.attrs["calib_table"] = std::make_shared<nnvm::any>(std::move(calib));
+    s->outputs = nnvm::ApplyPass(std::move(g), "QuantizeGraph").outputs;
+    *ret_sym_handle = s;
+    API_END_HANDLE_ERROR(delete s);
+}
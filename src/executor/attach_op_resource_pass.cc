@@ -37,7 +37,8 @@ Graph AttachOpResources(Graph g) {
                     requested.push_back(r);
                     cached_temp[ctx] = r;
                 }
-            } else if (req.type == ResourceRequest::kRandom) {
+            } else if (req.type == ResourceRequest::kRandom ||
+                       req.type == ResourceRequest::kParallelRandom) {
                 requested.push_back(ResourceManager::Get()->Request(ctx, req));
             } else {
                 LOG(FATAL) << "resource type not yet supported";
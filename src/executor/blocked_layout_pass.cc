@@ -0,0 +1,179 @@
+/*!
+ * Copyright (c) 2017 by Contributors
+ * \file blocked_layout_pass.cc
+ * \brief switch runs of CPU operators to the channel-blocked layout
+ */
+#include <mxnet/base.h>
+#include <mxnet/ndarray.h>
+#include <mxnet/operator.h>
+#include <nnvm/graph_attr_types.h>
+#include <string>
+#include <unordered_map>
+
+#include "../operator/batch_norm-inl.h"
+#include "../operator/convolution-inl.h"
+#include "../operator/pooling-inl.h"
+#include "./exec_pass.h"
+
+namespace mxnet {
+namespace exec {
+using nnvm::Node;
+using nnvm::NodeEntry;
+using nnvm::NodePtr;
+using nnvm::Op;
+
+Graph ConvertBlockedLayout(Graph src, const std::vector<NDArray>& in_args,
+                           const std::vector<NDArray>& aux_states,
+                           int block) {
+    CHECK(block == 8 || block == 16)
+        << "MXNET_CPU_BLOCKED_LAYOUT must be 0, 8 or 16, got " << block;
+    static const Op* conv_op = Op::Get("Convolution");
+    static const Op* pool_op = Op::Get("Pooling");
+    static const Op* bn_op = Op::Get("BatchNorm");
+    static const Op* act_op = Op::Get("Activation");
+    static const Op* add_op = Op::Get("elemwise_add");
+    const auto& idx = src.indexed_graph();
+
+    // shapes and types of the plain graph decide which nodes can be blocked
+    const auto& mutable_nodes = idx.mutable_input_nodes();
+    Graph g = InferForwardAttrs(src, in_args, aux_states);
+    if (g.GetAttr<size_t>("shape_num_unknown_nodes") != 0 ||
+        g.GetAttr<size_t>("dtype_num_unknown_nodes") != 0) {
+        return src;
+    }
+    const auto& shapes = g.GetAttr<nnvm::ShapeVector>("shape");
+    const auto& dtypes = g.GetAttr<nnvm::DTypeVector>("dtype");
+    std::vector<uint32_t> ref_count(idx.num_node_entries(), 0);
+    for (const auto& e : idx.outputs()) ++ref_count[idx.entry_id(e)];
+    for (uint32_t nid = 0; nid < idx.num_nodes(); ++nid) {
+        for (const auto& e : idx[nid].inputs) ++ref_count[idx.entry_id(e)];
+    }
+
+    // blocked[eid] is true if the new graph keeps entry eid blocked
+    std::vector<bool> blocked(idx.num_node_entries(), false);
+    std::unordered_map<const Node*, NodePtr> mirror;
+    std::unordered_map<uint32_t, NodeEntry> to_blocked, from_blocked;
+    auto can_block = [&](const NodeEntry& e) {
+        const uint32_t eid = idx.entry_id(e);
+        return dtypes[eid] == mshadow::kFloat32 && shapes[eid].ndim() == 4 &&
+               shapes[eid][1] % block == 0;
+    };
+    auto is_blocked = [&](const NodeEntry& e) {
+        return blocked[idx.entry_id(e)];
+    };
+    // hidden outputs such as the pooling mask are not computed when blocked
+    auto only_first_output_used = [&](uint32_t nid) -> bool {
+        for (uint32_t i = 1; i < idx[nid].source->num_outputs(); ++i) {
+            if (ref_count[idx.entry_id(nid, i)] != 0) return false;
+        }
+        return true;
+    };
+    // the entry of the new graph in the requested layout, converting once
+    auto convert = [&](const NodeEntry& e, bool as_blocked) -> NodeEntry {
+        const uint32_t eid = idx.entry_id(e);
+        const NodeEntry mapped{mirror.at(e.node.get()), e.index, e.version};
+        if (blocked[eid] == as_blocked) return mapped;
+        auto& memo = as_blocked ? to_blocked : from_blocked;
+        auto it = memo.find(eid);
+        if (it != memo.end()) return it->second;
+        NodePtr n = Node::Create();
+        n->attrs.name = e.node->attrs.name +
+                        (as_blocked ? "_to_blocked" : "_from_blocked");
+        if (as_blocked) {
+            n->attrs.op = Op::Get("_layout_to_blocked");
+            n->attrs.dict["block"] = std::to_string(block);
+            n->op()->attr_parser(&(n->attrs));
+        } else {
+            n->attrs.op = Op::Get("_layout_from_blocked");
+        }
+        n->inputs.push_back(mapped);
+        return memo[eid] = NodeEntry{n, 0, 0};
+    };
+
+    size_t num_converted = 0;
+    nnvm::DFSVisit(src.outputs, [&](const NodePtr& n) {
+        if (n->is_variable()) {
+            mirror[n.get()] = n;
+            return;
+        }
+        const uint32_t nid = idx.node_id(n.get());
+        const std::vector<NodeEntry>& inputs = n->inputs;
+        // a run of blocked nodes starts at a convolution; pooling and batch
+        // norm join it, and elementwise nodes follow any blocked input
+        const char* blocked_op = nullptr;
+        bool blocked_elemwise = false;
+        if (n->op() == conv_op) {
+            const auto param = GetLegacyParam<op::ConvolutionParam>(*n);
+            if (param.kernel.ndim() == 2 && param.num_group == 1 &&
+                param.layout.value() == mshadow::kNCHW &&
+                param.num_filter % block == 0 &&
+                can_block(inputs[op::conv::kData])) {
+                blocked_op = "_blocked_Convolution";
+            }
+        } else if (n->op() == pool_op) {
+            const auto param = GetLegacyParam<op::PoolingParam>(*n);
+            if (param.kernel.ndim() == 2 &&
+                is_blocked(inputs[op::pool_enum::kData]) &&
+                only_first_output_used(nid)) {
+                blocked_op = "_blocked_Pooling";
+            }
+        } else if (n->op() == bn_op) {
+            const auto param = GetLegacyParam<op::BatchNormParam>(*n);
+            if (!param.output_mean_var &&
+                is_blocked(inputs[op::batchnorm::kData]) &&
+                only_first_output_used(nid)) {
+                blocked_op = "_blocked_BatchNorm";
+            }
+        } else if (n->op() == act_op || n->op() == add_op) {
+            bool any_blocked = false, all_blockable = true;
+            for (const NodeEntry& e : inputs) {
+                any_blocked = any_blocked || is_blocked(e);
+                all_blockable = all_blockable && can_block(e);
+            }
+            blocked_elemwise = any_blocked && all_blockable;
+        }
+
+        NodePtr p = Node::Create();
+        p->attrs = n->attrs;
+        if (blocked_op != nullptr) {
+            p->attrs.op = Op::Get(blocked_op);
+            p->op()->attr_parser(&(p->attrs));
+        }
+        for (size_t i = 0; i < inputs.size(); ++i) {
+            // weights and statistics stay plain
+            const bool as_blocked =
+                blocked_elemwise || (blocked_op != nullptr && i == 0);
+            p->inputs.push_back(convert(inputs[i], as_blocked));
+        }
+        for (const NodePtr& dep : n->control_deps) {
+            p->control_deps.push_back(mirror.at(dep.get()));
+        }
+        mirror[n.get()] = p;
+        if (blocked_op != nullptr || blocked_elemwise) {
+            blocked[idx.entry_id(nid, 0)] = true;
+            ++num_converted;
+        }
+    });
+    if (num_converted == 0) return src;
+
+    Graph ret;
+    for (const NodeEntry& e : src.outputs) {
+        ret.outputs.push_back(convert(e, false));
+    }
+    // arguments and auxiliary states are bound by the order of the inputs,
+    // which the conversion nodes must not change
+    const auto& new_idx = ret.indexed_graph();
+    const auto& new_mutable_nodes = new_idx.mutable_input_nodes();
+    if (new_idx.input_nodes().size() != idx.input_nodes().size()) return src;
+    for (size_t i = 0; i < idx.input_nodes().size(); ++i) {
+        const uint32_t nid = idx.input_nodes()[i];
+        const uint32_t new_nid = new_idx.input_nodes()[i];
+        if (new_idx[new_nid].source != idx[nid].source ||
+            new_mutable_nodes.count(new_nid) != mutable_nodes.count(nid)) {
+            return src;
+        }
+    }
+    return ret;
+}
+}  // namespace exec
+}  // namespace mxnet
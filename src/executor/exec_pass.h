@@ -14,11 +14,26 @@
 #include <vector>
 
 namespace mxnet {
+namespace op {
+const OperatorProperty* OpPropGetOpProperty(const nnvm::NodeAttrs& attrs);
+}  // namespace op
+
 namespace exec {
 
 /*! \brief reuse graph definition */
 using nnvm::Graph;
 
+/*!
+ * \brief parameters of a node of a legacy operator, with the defaults its
+ *  property fills in
+ */
+template <typename PType>
+inline PType GetLegacyParam(const nnvm::Node& node) {
+    PType param;
+    param.Init(op::OpPropGetOpProperty(node.attrs)->GetParams());
+    return param;
+}
+
 /*!
  * \brief executor to execute an operator
  * This is a graph executor dependent interface
@@ -103,6 +118,55 @@ Graph AttachOpResources(Graph g);
  */
 Graph DetectInplaceAddTo(Graph g);
 
+/*!
+ * \brief Infer the shapes and types of a forward graph.
+ *
+ * \param g forward graph without gradients
+ * \param in_args the arguments the graph is bound to
+ * \param aux_states the auxiliary states the graph is bound to
+ *
+ * \return graph with the attributes "shape" and "dtype"
+ */
+Graph InferForwardAttrs(Graph g, const std::vector<NDArray>& in_args,
+                        const std::vector<NDArray>& aux_states);
+
+/*!
+ * \brief Switch runs of CPU operators of an inference graph to the
+ *  channel-blocked layout (N, C / block, H, W, block).
+ *
+ * Convolutions start a run, and pooling, batch norm and elementwise
+ *  operators whose input is blocked join it. Conversion nodes are only
+ *  inserted where a run meets operators that need the plain layout.
+ *
+ * \param g forward graph without gradients
+ * \param in_args the arguments the graph is bound to
+ * \param aux_states the auxiliary states the graph is bound to
+ * \param block number of channels in a block, 8 or 16
+ *
+ * \return the converted graph, with the same input nodes in the same order,
+ *  or g itself if no operator can be blocked.
+ */
+Graph ConvertBlockedLayout(Graph g, const std::vector<NDArray>& in_args,
+                           const std::vector<NDArray>& aux_states, int block);
+
+/*!
+ * \brief Fuse BatchNorm, and the Activation following it, into the
+ *  Convolution or FullyConnected producing its input, for inference on cpu.
+ *
+ * With the moving statistics the batch norm is folded into the weights and
+ *  the bias, and bias and activation are applied in one pass over the
+ *  output. Only batch norms whose input is not used elsewhere are fused.
+ *
+ * \param g forward graph without gradients
+ * \param in_args the arguments the graph is bound to
+ * \param aux_states the auxiliary states the graph is bound to
+ *
+ * \return the fused graph, with the same input nodes in the same order, or
+ *  g itself if nothing can be fused.
+ */
+Graph FuseBatchNorm(Graph g, const std::vector<NDArray>& in_args,
+                    const std::vector<NDArray>& aux_states);
+
 }  // namespace exec
 }  // namespace mxnet
 
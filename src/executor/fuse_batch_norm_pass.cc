@@ -0,0 +1,157 @@
+/*!
+ * Copyright (c) 2017 by Contributors
+ * \file fuse_batch_norm_pass.cc
+ * \brief fuse BatchNorm and Activation into the preceding Convolution or
+ *  FullyConnected of an inference graph
+ */
+#include <mxnet/base.h>
+#include <mxnet/ndarray.h>
+#include <mxnet/operator.h>
+#include <nnvm/graph_attr_types.h>
+#include <string>
+#include <unordered_map>
+
+#include "../operator/batch_norm-inl.h"
+#include "../operator/convolution-inl.h"
+#include "./exec_pass.h"
+
+namespace mxnet {
+namespace exec {
+using nnvm::Node;
+using nnvm::NodeEntry;
+using nnvm::NodePtr;
+using nnvm::Op;
+
+Graph FuseBatchNorm(Graph src, const std::vector<NDArray>& in_args,
+                    const std::vector<NDArray>& aux_states) {
+    static const Op* conv_op = Op::Get("Convolution");
+    static const Op* fc_op = Op::Get("FullyConnected");
+    static const Op* bn_op = Op::Get("BatchNorm");
+    static const Op* act_op = Op::Get("Activation");
+    const auto& idx = src.indexed_graph();
+    const auto& mutable_nodes = idx.mutable_input_nodes();
+    Graph g = InferForwardAttrs(src, in_args, aux_states);
+    if (g.GetAttr<size_t>("dtype_num_unknown_nodes") != 0) return src;
+    const auto& dtypes = g.GetAttr<nnvm::DTypeVector>("dtype");
+    // the uses of every entry, and the node of the last use
+    std::vector<uint32_t> ref_count(idx.num_node_entries(), 0);
+    std::vector<uint32_t> consumer(idx.num_node_entries(), 0);
+    for (const auto& e : idx.outputs()) ++ref_count[idx.entry_id(e)];
+    for (uint32_t nid = 0; nid < idx.num_nodes(); ++nid) {
+        for (const auto& e : idx[nid].inputs) {
+            ++ref_count[idx.entry_id(e)];
+            consumer[idx.entry_id(e)] = nid;
+        }
+    }
+
+    // the batch norms to fuse, with the activation fused into each of them
+    std::unordered_map<uint32_t, int> fused_bn;
+    std::unordered_map<uint32_t, uint32_t> fused_act;
+    std::vector<bool> skip(idx.num_nodes(), false);
+    for (uint32_t nid = 0; nid < idx.num_nodes(); ++nid) {
+        const Node* bn = idx[nid].source;
+        if (bn->op() != bn_op) continue;
+        const auto& e = idx[nid].inputs[op::batchnorm::kData];
+        const Node* producer = idx[e.node_id].source;
+        const uint32_t eid = idx.entry_id(e);
+        if (producer->op() != conv_op && producer->op() != fc_op) continue;
+        if (ref_count[eid] != 1) continue;
+        if (dtypes[eid] != mshadow::kFloat32 &&
+            dtypes[eid] != mshadow::kFloat64) {
+            continue;
+        }
+        if (GetLegacyParam<op::BatchNormParam>(*bn).output_mean_var) continue;
+        bool hidden_used = false;
+        for (uint32_t i = 1; i < bn->num_outputs(); ++i) {
+            hidden_used = hidden_used || ref_count[idx.entry_id(nid, i)] != 0;
+        }
+        if (hidden_used) continue;
+        if (producer->op() == conv_op) {
+            // the channels of the output must be its second axis
+            const int layout =
+                GetLegacyParam<op::ConvolutionParam>(*producer).layout.value();
+            if (layout != mshadow::kNCW && layout != mshadow::kNCHW &&
+                layout != mshadow::kNCDHW) {
+                continue;
+            }
+        }
+        fused_bn[nid] = -1;
+        skip[e.node_id] = true;
+        const uint32_t out = idx.entry_id(nid, 0);
+        if (ref_count[out] == 1 && idx[consumer[out]].source->op() == act_op) {
+            fused_bn[nid] = consumer[out];
+            fused_act[consumer[out]] = nid;
+        }
+    }
+    if (fused_bn.size() == 0) return src;
+
+    std::unordered_map<const Node*, NodePtr> mirror;
+    auto mapped = [&](const NodeEntry& e) {
+        return NodeEntry{mirror.at(e.node.get()), e.index, e.version};
+    };
+    nnvm::DFSVisit(src.outputs, [&](const NodePtr& n) {
+        if (n->is_variable()) {
+            mirror[n.get()] = n;
+            return;
+        }
+        const uint32_t nid = idx.node_id(n.get());
+        if (skip[nid]) return;
+        if (fused_act.count(nid)) {
+            mirror[n.get()] = mirror.at(idx[fused_act.at(nid)].source);
+            return;
+        }
+        NodePtr p = Node::Create();
+        if (fused_bn.count(nid)) {
+            const Node* producer = n->inputs[op::batchnorm::kData].node.get();
+            p->attrs.op = Op::Get("_fused_" + producer->op()->name);
+            p->attrs.name = n->attrs.name;
+            p->attrs.dict = producer->attrs.dict;
+            for (const char* key : {"eps", "fix_gamma", "use_global_stats"}) {
+                auto it = n->attrs.dict.find(key);
+                if (it != n->attrs.dict.end()) p->attrs.dict.insert(*it);
+            }
+            if (fused_bn.at(nid) != -1) {
+                const Node* act = idx[fused_bn.at(nid)].source;
+                p->attrs.name = act->attrs.name;
+                p->attrs.dict["act_type"] = act->attrs.dict.at("act_type");
+            }
+            p->op()->attr_parser(&(p->attrs));
+            for (const NodeEntry& e : producer->inputs) {
+                p->inputs.push_back(mapped(e));
+            }
+            for (size_t i = 1; i < n->inputs.size(); ++i) {
+                p->inputs.push_back(mapped(n->inputs[i]));
+            }
+            for (const NodePtr& dep : producer->control_deps) {
+                p->control_deps.push_back(mirror.at(dep.get()));
+            }
+        } else {
+            p->attrs = n->attrs;
+            for (const NodeEntry& e : n->inputs) {
+                p->inputs.push_back(mapped(e));
+            }
+        }
+        for (const NodePtr& dep : n->control_deps) {
+            p->control_deps.push_back(mirror.at(dep.get()));
+        }
+        mirror[n.get()] = p;
+    });
+
+    Graph ret;
+    for (const NodeEntry& e : src.outputs) ret.outputs.push_back(mapped(e));
+    // arguments and auxiliary states are bound by the order of the inputs
+    const auto& new_idx = ret.indexed_graph();
+    const auto& new_mutable_nodes = new_idx.mutable_input_nodes();
+    if (new_idx.input_nodes().size() != idx.input_nodes().size()) return src;
+    for (size_t i = 0; i < idx.input_nodes().size(); ++i) {
+        const uint32_t nid = idx.input_nodes()[i];
+        const uint32_t new_nid = new_idx.input_nodes()[i];
+        if (new_idx[new_nid].source != idx[nid].source ||
+            new_mutable_nodes.count(new_nid) != mutable_nodes.count(nid)) {
+            return src;
+        }
+    }
+    return ret;
+}
+}  // namespace exec
+}  // namespace mxnet
@@ -340,6 +340,32 @@ Graph AssignContext(
     return g;
 }
 
+// pass to infer shapes and types of a forward graph from the bound arrays
+Graph InferForwardAttrs(Graph g, const std::vector<NDArray>& in_args,
+                        const std::vector<NDArray>& aux_states) {
+    const auto& idx = g.indexed_graph();
+    const auto& mutable_nodes = idx.mutable_input_nodes();
+    nnvm::ShapeVector arg_shapes;
+    nnvm::DTypeVector arg_types;
+    size_t arg_top = 0, aux_top = 0;
+    for (uint32_t nid : idx.input_nodes()) {
+        if (mutable_nodes.count(nid)) {
+            CHECK_LT(aux_top, aux_states.size());
+            arg_shapes.push_back(aux_states[aux_top].shape());
+            arg_types.push_back(aux_states[aux_top].dtype());
+            ++aux_top;
+        } else {
+            CHECK_LT(arg_top, in_args.size());
+            arg_shapes.push_back(in_args[arg_top].shape());
+            arg_types.push_back(in_args[arg_top].dtype());
+            ++arg_top;
+        }
+    }
+    g = nnvm::pass::InferShape(g, arg_shapes, "__shape__");
+    g = nnvm::pass::InferType(g, arg_types, "__dtype__");
+    return g;
+}
+
 void GraphExecutor::Init(nnvm::Symbol symbol, const Context& default_ctx,
                          const std::map<std::string, Context>& ctx_map,
                          const std::vector<NDArray>& in_args,
@@ -390,6 +416,17 @@ Graph GraphExecutor::InitGraph(nnvm::Symbol symbol, const Context& default_ctx,
                                const nnvm::NodeEntryMap<NDArray>& feed_dict) {
     // setup gradient
     nnvm::Graph g = InitFullGraph(symbol, grad_req_type, arg_grad_store);
+    if (g.outputs.size() == num_forward_outputs_ && ctx_map.size() == 0 &&
+        default_ctx.dev_mask() == cpu::kDevMask && feed_dict.size() == 0) {
+        // inference on cpu can use rewrites that drop gradient support
+        int block = dmlc::GetEnv("MXNET_CPU_BLOCKED_LAYOUT", 0);
+        if (block != 0) {
+            g = ConvertBlockedLayout(g, in_args, aux_states, block);
+        }
+        if (dmlc::GetEnv("MXNET_EXEC_FUSE_BATCH_NORM", 0)) {
+            g = FuseBatchNorm(g, in_args, aux_states);
+        }
+    }
     g = AssignContext(g, default_ctx, ctx_map, in_args, grad_store_, aux_states,
                       num_forward_inputs_, num_forward_outputs_);
     const auto& idx = g.indexed_graph();
@@ -261,91 +261,31 @@ using Rect = cv::Rect_<float>;
 #define M_PI CV_PI
 #endif
 
-/*! \brief helper class for better detection label handling */
+/*!
+ * \brief helper class for better detection label handling.
+ *  The boxes are transformed in place in the raw label array, all objects
+ *  at once, so no per-object structures are allocated.
+ */
 class ImageDetLabel {
    public:
-    /*! \brief Helper struct to store the coordinates and id for each object */
-    struct ImageDetObject {
-        float id;
-        float left;
-        float top;
-        float right;
-        float bottom;
-        std::vector<float>
-            extra;  // store extra info other than id and coordinates
-
-        /*! \brief Return converted Rect object */
-        Rect ToRect() const {
-            return Rect(left, top, right - left, bottom - top);
-        }
-
-        /*! \brief Return projected coordinates according to new region */
-        ImageDetObject Project(Rect box) const {
-            ImageDetObject ret = *this;
-            ret.left = std::max(0.f, (ret.left - box.x) / box.width);
-            ret.top = std::max(0.f, (ret.top - box.y) / box.height);
-            ret.right = std::min(1.f, (ret.right - box.x) / box.width);
-            ret.bottom = std::min(1.f, (ret.bottom - box.y) / box.height);
-            return ret;
-        }
-
-        /*! \brief Return Horizontally fliped coordinates */
-        ImageDetObject HorizontalFlip() const {
-            ImageDetObject ret = *this;
-            ret.left = 1.f - this->right;
-            ret.right = 1.f - this->left;
-            return ret;
-        }
-    };  // struct ImageDetObject
-
-    /*! \brief constructor from raw array of detection labels */
-    explicit ImageDetLabel(const std::vector<float> &raw_label) {
-        FromArray(raw_label);
-    }
-
     /*! \brief construct from raw array with following format
      * header_width, object_width, (extra_headers...),
      * [id, xmin, ymin, xmax, ymax, (extra_object_info)] x N
      */
-    void FromArray(const std::vector<float> &raw_label) {
-        int label_width = static_cast<int>(raw_label.size());
+    explicit ImageDetLabel(std::vector<float> *raw_label) : raw_(raw_label) {
+        int label_width = static_cast<int>(raw_->size());
         CHECK_GE(label_width, 7);  // at least 2(header) + 5(1 object)
-        int header_width = static_cast<int>(raw_label[0]);
-        CHECK_GE(header_width, 2);
-        object_width_ = static_cast<int>(raw_label[1]);
+        header_width_ = static_cast<int>((*raw_)[0]);
+        CHECK_GE(header_width_, 2);
+        object_width_ = static_cast<int>((*raw_)[1]);
         CHECK_GE(object_width_, 5);  // id, x1, y1, x2, y2...
-        header_.assign(raw_label.begin(), raw_label.begin() + header_width);
-        int num = (label_width - header_width) / object_width_;
-        CHECK_EQ((label_width - header_width) % object_width_, 0);
-        objects_.reserve(num);
-        for (int i = header_width; i < label_width; i += object_width_) {
-            ImageDetObject obj;
-            auto it = raw_label.cbegin() + i;
-            obj.id = *(it++);
-            obj.left = *(it++);
-            obj.top = *(it++);
-            obj.right = *(it++);
-            obj.bottom = *(it++);
-            obj.extra.assign(it, it - 5 + object_width_);
-            objects_.push_back(obj);
-            CHECK_GT(obj.right, obj.left);
-            CHECK_GT(obj.bottom, obj.top);
-        }
-    }
-
-    /*! \brief Convert back to raw array */
-    std::vector<float> ToArray() const {
-        std::vector<float> out(header_);
-        out.reserve(out.size() + objects_.size() * object_width_);
-        for (auto &obj : objects_) {
-            out.push_back(obj.id);
-            out.push_back(obj.left);
-            out.push_back(obj.top);
-            out.push_back(obj.right);
-            out.push_back(obj.bottom);
-            out.insert(out.end(), obj.extra.begin(), obj.extra.end());
+        CHECK_EQ((label_width - header_width_) % object_width_, 0);
+        num_objects_ = (label_width - header_width_) / object_width_;
+        for (int i = 0; i < num_objects_; ++i) {
+            const float *box = Box(i);
+            CHECK_GT(box[2], box[0]);
+            CHECK_GT(box[3], box[1]);
         }
-        return out;
     }
 
     /*! \brief Intersection over Union between two rects */
@@ -366,7 +306,7 @@ class ImageDetLabel {
                  const float min_crop_object_coverage,
                  const float max_crop_object_coverage, const int crop_emit_mode,
                  const float emit_overlap_thresh) {
-        if (objects_.size() < 1) {
+        if (num_objects_ < 1) {
             return true;  // no object, raise error or just skip?
         }
         // check if crop_box valid
@@ -374,8 +314,8 @@ class ImageDetLabel {
         if (min_crop_overlap > 0.f && max_crop_overlap < 1.f &&
             min_crop_sample_coverage > 0.f && max_crop_sample_coverage < 1.f &&
             min_crop_object_coverage > 0.f && max_crop_object_coverage < 1.f) {
-            for (auto &obj : objects_) {
-                Rect gt_box = obj.ToRect();
+            for (int i = 0; i < num_objects_; ++i) {
+                Rect gt_box = ToRect(Box(i));
                 if (min_crop_overlap > 0.f || max_crop_overlap < 1.f) {
                     float ovp = RectIOU(crop_box, gt_box);
                     if (ovp < min_crop_overlap || ovp > max_crop_overlap) {
@@ -406,26 +346,40 @@ class ImageDetLabel {
         }
 
         if (!valid) return false;
-        // transform ground-truth labels
-        std::vector<ImageDetObject> new_objects;
-        for (auto iter = objects_.begin(); iter != objects_.end(); ++iter) {
+        // decide which ground-truths survive before touching the labels
+        keep_.resize(num_objects_);
+        int num_keep = 0;
+        for (int i = 0; i < num_objects_; ++i) {
+            const float *box = Box(i);
             if (image_det_aug_default_enum::kCenter == crop_emit_mode) {
-                float center_x = (iter->left + iter->right) * 0.5f;
-                float center_y = (iter->top + iter->bottom) * 0.5f;
-                if (!crop_box.contains(cv::Point2f(center_x, center_y))) {
-                    continue;
-                }
-                new_objects.push_back(iter->Project(crop_box));
+                float center_x = (box[0] + box[2]) * 0.5f;
+                float center_y = (box[1] + box[3]) * 0.5f;
+                keep_[i] = crop_box.contains(cv::Point2f(center_x, center_y));
             } else if (image_det_aug_default_enum::kOverlap == crop_emit_mode) {
-                Rect gt_box = iter->ToRect();
+                Rect gt_box = ToRect(box);
                 float overlap = (crop_box & gt_box).area() / gt_box.area();
-                if (overlap > emit_overlap_thresh) {
-                    new_objects.push_back(iter->Project(crop_box));
-                }
+                keep_[i] = overlap > emit_overlap_thresh;
+            } else {
+                keep_[i] = false;
             }
+            num_keep += keep_[i];
         }
-        if (new_objects.size() < 1) return false;
-        objects_ = new_objects;  // replace the old objects
+        if (num_keep < 1) return false;
+        // compact the surviving objects and transform them
+        float *base = dmlc::BeginPtr(*raw_) + header_width_;
+        int top = 0;
+        for (int i = 0; i < num_objects_; ++i) {
+            if (!keep_[i]) continue;
+            if (top != i) {
+                std::copy(base + i * object_width_,
+                          base + (i + 1) * object_width_,
+                          base + top * object_width_);
+            }
+            ++top;
+        }
+        num_objects_ = num_keep;
+        raw_->resize(header_width_ + num_objects_ * object_width_);
+        Project(crop_box);
         return true;
     }
 
@@ -433,29 +387,52 @@ class ImageDetLabel {
      * convert all objects afterwards
      */
     bool TryPad(const Rect pad_box) {
-        // update all objects inplace
-        for (auto it = objects_.begin(); it != objects_.end(); ++it) {
-            *it = it->Project(pad_box);
-        }
+        Project(pad_box);
         return true;
     }
 
     /*! \brief flip image and object coordinates horizontally */
     bool TryMirror() {
-        // flip all objects horizontally
-        for (auto it = objects_.begin(); it != objects_.end(); ++it) {
-            *it = it->HorizontalFlip();
+        for (int i = 0; i < num_objects_; ++i) {
+            float *box = Box(i);
+            const float left = box[0];
+            box[0] = 1.f - box[2];
+            box[2] = 1.f - left;
         }
         return true;
     }
 
    private:
+    /*! \brief the [xmin, ymin, xmax, ymax] of the i-th object */
+    inline float *Box(int i) const {
+        return dmlc::BeginPtr(*raw_) + header_width_ + i * object_width_ + 1;
+    }
+    /*! \brief Return converted Rect object */
+    static inline Rect ToRect(const float *box) {
+        return Rect(box[0], box[1], box[2] - box[0], box[3] - box[1]);
+    }
+    /*! \brief project all boxes into the coordinates of region box */
+    inline void Project(const Rect box) {
+        const float sx = 1.f / box.width, sy = 1.f / box.height;
+        for (int i = 0; i < num_objects_; ++i) {
+            float *b = Box(i);
+            b[0] = std::max(0.f, (b[0] - box.x) * sx);
+            b[1] = std::max(0.f, (b[1] - box.y) * sy);
+            b[2] = std::min(1.f, (b[2] - box.x) * sx);
+            b[3] = std::min(1.f, (b[3] - box.y) * sy);
+        }
+    }
+
+    /*! \brief raw label, transformed in place */
+    std::vector<float> *raw_;
+    /*! \brief width of the header */
+    int header_width_;
     /*! \brief width for each object information, 5 at least */
     int object_width_;
-    /*! \brief vector to store original header info */
-    std::vector<float> header_;
-    /*! \brief storing objects in more convenient formats */
-    std::vector<ImageDetObject> objects_;
+    /*! \brief number of objects */
+    int num_objects_;
+    /*! \brief whether each object survives a crop */
+    std::vector<char> keep_;
 };  // class ImageDetLabel
 
 /*! \brief helper class to do image augmentation */
@@ -591,6 +568,95 @@ class DefaultImageDetAugmenter : public ImageAugmenter {
         return Rect(-x0, -y0, new_scale, new_scale);
     }
 
+    /*! \brief Compute the output size of a region of given size */
+    cv::Size GetOutputSize(float width, float height) {
+        const float h = param_.data_shape[1];
+        const float w = param_.data_shape[2];
+        if (image_det_aug_default_enum::kForce == param_.resize_mode) {
+            // force resize to specified data_shape, regardless of aspect ratio
+            return cv::Size(w, h);
+        }
+        float ratio = std::min(h / height, w / width);
+        if (image_det_aug_default_enum::kShrink == param_.resize_mode &&
+            height <= h && width <= w) {
+            // try to keep original size, shrink if too large
+            ratio = 1.f;
+        }
+        return cv::Size(std::max(1, static_cast<int>(ratio * width)),
+                        std::max(1, static_cast<int>(ratio * height)));
+    }
+
+    /*! \brief Apply hue, saturation, illumination and contrast changes */
+    void ColorJitter(cv::Mat *res, int h, int s, int l, float c) {
+        if (h != 0 || s != 0 || l != 0) {
+            const int temp[3] = {h, l, s};
+            const int limit[3] = {180, 255, 255};
+            cv::cvtColor(*res, *res, CV_BGR2HLS);
+            for (int i = 0; i < res->rows; ++i) {
+                uchar *p = res->ptr<uchar>(i);
+                for (int j = 0; j < res->cols * 3; j += 3) {
+                    for (int k = 0; k < 3; ++k) {
+                        int v = p[j + k] + temp[k];
+                        p[j + k] = std::max(0, std::min(limit[k], v));
+                    }
+                }
+            }
+            cv::cvtColor(*res, *res, CV_HLS2BGR);
+        }
+        if (fabs(c) > 1e-3) {
+            res->convertTo(*res, -1, c + 1.f, 0);
+        }
+    }
+
+    /*!
+     * \brief Produce the output image from region roi of src, given in
+     *  coordinates normalized to src, optionally mirrored first.
+     *  Padding, cropping, mirroring and resizing are done by one warp,
+     *  except that area interpolation, which warps can not do, falls back
+     *  to cropping and resizing.
+     */
+    void WarpRegion(const cv::Mat &src, const Rect roi, bool mirror,
+                    cv::Size size, int interpolation_method, cv::Mat *dst) {
+        const cv::Scalar fill(param_.fill_value, param_.fill_value,
+                              param_.fill_value);
+        const float sx = roi.width * src.cols / size.width;
+        const float sy = roi.height * src.rows / size.height;
+        if (interpolation_method != cv::INTER_AREA) {
+            // map output pixel centers back to the source image
+            float tx = roi.x * src.cols + 0.5f * sx - 0.5f;
+            float ty = roi.y * src.rows + 0.5f * sy - 0.5f;
+            float ax = sx;
+            if (mirror) {
+                tx = src.cols - 1 - tx;
+                ax = -sx;
+            }
+            cv::Matx23f trans(ax, 0.f, tx, 0.f, sy, ty);
+            cv::warpAffine(src, *dst, trans, size,
+                           interpolation_method | cv::WARP_INVERSE_MAP,
+                           cv::BORDER_CONSTANT, fill);
+            return;
+        }
+        int left = static_cast<int>(roi.x * src.cols);
+        int top = static_cast<int>(roi.y * src.rows);
+        int width = std::max(1, static_cast<int>(roi.width * src.cols));
+        int height = std::max(1, static_cast<int>(roi.height * src.rows));
+        if (mirror) left = src.cols - left - width;
+        cv::Rect inside = cv::Rect(left, top, width, height) &
+                          cv::Rect(0, 0, src.cols, src.rows);
+        if (inside.width == width && inside.height == height) {
+            cv::resize(src(inside), *dst, size, 0, 0, interpolation_method);
+        } else {
+            // the region reaches into the padding
+            cv::copyMakeBorder(src(inside), temp_, inside.y - top,
+                               top + height - inside.y - inside.height,
+                               inside.x - left,
+                               left + width - inside.x - inside.width,
+                               cv::BORDER_CONSTANT, fill);
+            cv::resize(temp_, *dst, size, 0, 0, interpolation_method);
+        }
+        if (mirror) cv::flip(*dst, *dst, 1);
+    }
+
     cv::Mat Process(const cv::Mat &src, std::vector<float> *label,
                     common::RANDOM_ENGINE *prnd) override {
         using mshadow::index_t;
@@ -607,61 +673,52 @@ class DefaultImageDetAugmenter : public ImageAugmenter {
             int interpolation_method =
                 GetInterMethod(param_.inter_method, src.cols, src.rows,
                                new_width, new_height, prnd);
-            cv::resize(src, res, cv::Size(new_width, new_height), 0, 0,
+            cv::resize(src, resized_, cv::Size(new_width, new_height), 0, 0,
                        interpolation_method);
+            res = resized_;
         } else {
             res = src;
         }
 
         // build a helper class for processing labels
-        ImageDetLabel det_label(*label);
+        ImageDetLabel det_label(label);
         // random engine
         std::uniform_real_distribution<float> rand_uniform(0, 1);
 
-        // color space augmentation
+        // color space augmentation, before the geometric transform so that
+        // the fill_value border of the padding is not jittered
+        int h = 0, s = 0, l = 0;
+        float c = 0.f;
         if (param_.random_hue_prob > 0.f ||
             param_.random_saturation_prob > 0.f ||
             param_.random_illumination_prob > 0.f ||
             param_.random_contrast_prob > 0.f) {
             std::uniform_real_distribution<float> uniform_range(-1.f, 1.f);
-            int h = uniform_range(*prnd) * param_.max_random_hue;
-            int s = uniform_range(*prnd) * param_.max_random_saturation;
-            int l = uniform_range(*prnd) * param_.max_random_illumination;
-            float c = uniform_range(*prnd) * param_.max_random_contrast;
+            h = uniform_range(*prnd) * param_.max_random_hue;
+            s = uniform_range(*prnd) * param_.max_random_saturation;
+            l = uniform_range(*prnd) * param_.max_random_illumination;
+            c = uniform_range(*prnd) * param_.max_random_contrast;
             h = rand_uniform(*prnd) < param_.random_hue_prob ? h : 0;
             s = rand_uniform(*prnd) < param_.random_saturation_prob ? s : 0;
             l = rand_uniform(*prnd) < param_.random_illumination_prob ? l : 0;
             c = rand_uniform(*prnd) < param_.random_contrast_prob ? c : 0;
-            if (h != 0 || s != 0 || l != 0) {
-                int temp[3] = {h, l, s};
-                int limit[3] = {180, 255, 255};
-                cv::cvtColor(res, res, CV_BGR2HLS);
-                for (int i = 0; i < res.rows; ++i) {
-                    for (int j = 0; j < res.cols; ++j) {
-                        for (int k = 0; k < 3; ++k) {
-                            int v = res.at<cv::Vec3b>(i, j)[k];
-                            v += temp[k];
-                            v = std::max(0, std::min(limit[k], v));
-                            res.at<cv::Vec3b>(i, j)[k] = v;
-                        }
-                    }
-                }
-                cv::cvtColor(res, res, CV_HLS2BGR);
-            }
-            if (fabs(c) > 1e-3) {
-                cv::Mat tmp = res;
-                tmp.convertTo(res, -1, c + 1.f, 0);
-            }
+        }
+        if (h != 0 || s != 0 || l != 0 || fabs(c) > 1e-3) {
+            // jitter a copy, never the source image
+            if (res.data != resized_.data) res.copyTo(resized_);
+            ColorJitter(&resized_, h, s, l, c);
+            res = resized_;
         }
 
+        // the region of the (mirrored) image that makes up the output, in
+        // normalized coordinates, which can reach out of the image if padded
+        Rect roi(0, 0, 1, 1);
+
         // random mirror logic
+        bool mirror = false;
         if (param_.rand_mirror_prob > 0 &&
             rand_uniform(*prnd) < param_.rand_mirror_prob) {
-            if (det_label.TryMirror()) {
-                // flip image
-                cv::flip(res, temp_, 1);
-                res = temp_;
-            }
+            mirror = det_label.TryMirror();
         }
 
         // random padding logic
@@ -670,19 +727,7 @@ class DefaultImageDetAugmenter : public ImageAugmenter {
                 Rect pad_box = GeneratePadBox(param_.max_pad_scale, prnd);
                 if (pad_box.area() > 0) {
                     if (det_label.TryPad(pad_box)) {
-                        // pad image
-                        temp_ = res;
-                        int left = static_cast<int>(-pad_box.x * res.cols);
-                        int top = static_cast<int>(-pad_box.y * res.rows);
-                        int right = static_cast<int>(
-                            (pad_box.width + pad_box.x - 1) * res.cols);
-                        int bot = static_cast<int>(
-                            (pad_box.height + pad_box.y - 1) * res.rows);
-                        cv::copyMakeBorder(
-                            temp_, res, top, bot, left, right,
-                            cv::BORDER_ISOLATED,
-                            cv::Scalar(param_.fill_value, param_.fill_value,
-                                       param_.fill_value));
+                        roi = pad_box;
                     }
                 }
             }
@@ -700,6 +745,8 @@ class DefaultImageDetAugmenter : public ImageAugmenter {
                     indices[i] = i;
                 }
                 std::shuffle(indices.begin(), indices.end(), *prnd);
+                const float aspect_ratio =
+                    roi.width * res.cols / (roi.height * res.rows);
                 int num_processed = 0;
                 for (auto idx : indices) {
                     if (num_processed > 0) break;
@@ -709,7 +756,7 @@ class DefaultImageDetAugmenter : public ImageAugmenter {
                             param_.max_crop_scales[idx],
                             param_.min_crop_aspect_ratios[idx],
                             param_.max_crop_aspect_ratios[idx], prnd,
-                            static_cast<float>(res.cols) / res.rows);
+                            aspect_ratio);
                         if (det_label.TryCrop(
                                 crop_box, param_.min_crop_overlaps[idx],
                                 param_.max_crop_overlaps[idx],
@@ -720,14 +767,11 @@ class DefaultImageDetAugmenter : public ImageAugmenter {
                                 param_.crop_emit_mode,
                                 param_.emit_overlap_thresh)) {
                             ++num_processed;
-                            // crop image
-                            int left = static_cast<int>(crop_box.x * res.cols);
-                            int top = static_cast<int>(crop_box.y * res.rows);
-                            int width =
-                                static_cast<int>(crop_box.width * res.cols);
-                            int height =
-                                static_cast<int>(crop_box.height * res.rows);
-                            res = res(cv::Rect(left, top, width, height));
+                            // crop_box is relative to the current region
+                            roi = Rect(roi.x + crop_box.x * roi.width,
+                                       roi.y + crop_box.y * roi.height,
+                                       crop_box.width * roi.width,
+                                       crop_box.height * roi.height);
                             break;
                         }
                     }
@@ -735,49 +779,21 @@ class DefaultImageDetAugmenter : public ImageAugmenter {
             }
         }
 
-        if (image_det_aug_default_enum::kForce == param_.resize_mode) {
-            // force resize to specified data_shape, regardless of aspect ratio
-            int new_height = param_.data_shape[1];
-            int new_width = param_.data_shape[2];
-            int interpolation_method =
-                GetInterMethod(param_.inter_method, res.cols, res.rows,
-                               new_width, new_height, prnd);
-            cv::resize(res, res, cv::Size(new_width, new_height), 0, 0,
-                       interpolation_method);
-        } else if (image_det_aug_default_enum::kShrink == param_.resize_mode) {
-            // try to keep original size, shrink if too large
-            float h = param_.data_shape[1];
-            float w = param_.data_shape[2];
-            if (res.rows > h || res.cols > w) {
-                float ratio = std::min(h / res.rows, w / res.cols);
-                int new_height = ratio * res.rows;
-                int new_width = ratio * res.cols;
-                int interpolation_method =
-                    GetInterMethod(param_.inter_method, res.cols, res.rows,
-                                   new_width, new_height, prnd);
-                cv::resize(res, res, cv::Size(new_width, new_height), 0, 0,
-                           interpolation_method);
-            }
-        } else if (image_det_aug_default_enum::kFit == param_.resize_mode) {
-            float h = param_.data_shape[1];
-            float w = param_.data_shape[2];
-            float ratio = std::min(h / res.rows, w / res.cols);
-            int new_height = ratio * res.rows;
-            int new_width = ratio * res.cols;
-            int interpolation_method =
-                GetInterMethod(param_.inter_method, res.cols, res.rows,
-                               new_width, new_height, prnd);
-            cv::resize(res, res, cv::Size(new_width, new_height), 0, 0,
-                       interpolation_method);
-        }
-
-        *label = det_label.ToArray();  // put back processed labels
-        return res;
+        const float roi_width = roi.width * res.cols;
+        const float roi_height = roi.height * res.rows;
+        const cv::Size size = GetOutputSize(roi_width, roi_height);
+        int interpolation_method =
+            GetInterMethod(param_.inter_method, roi_width, roi_height,
+                           size.width, size.height, prnd);
+        // do not write into the buffer we read from
+        if (out_.data == res.data) out_.release();
+        WarpRegion(res, roi, mirror, size, interpolation_method, &out_);
+        return out_;
     }
 
    private:
-    // temporal space
-    cv::Mat temp_;
+    // per-thread scratch buffers, reused across images
+    cv::Mat temp_, resized_, out_;
     // parameters
     DefaultImageDetAugmentParam param_;
 };
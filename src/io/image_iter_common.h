@@ -94,6 +94,8 @@ struct ImageRecParserParam : public dmlc::Parameter<ImageRecParserParam> {
     TShape data_shape;
     /*! \brief number of threads */
     int preprocess_threads;
+    /*! \brief number of parts a chunk is split into per thread */
+    int preprocess_parts_per_thread;
     /*! \brief whether to remain silent */
     bool verbose;
     /*! \brief partition the data into multiple parts */
@@ -141,6 +143,15 @@ struct ImageRecParserParam : public dmlc::Parameter<ImageRecParserParam> {
             .set_lower_bound(1)
             .set_default(4)
             .describe("The number of threads to do preprocessing.");
+        DMLC_DECLARE_FIELD(preprocess_parts_per_thread)
+            .set_lower_bound(1)
+            .set_default(1)
+            .describe(
+                "Split each chunk into this many parts per preprocessing "
+                "thread and schedule them dynamically, so that a slow part "
+                "does not stall the others. Only used by ImageRecordIter. "
+                "With values larger than 1 the random augmentation is not "
+                "reproducible.");
         DMLC_DECLARE_FIELD(verbose)
             .set_default(true)
             .describe("If or not output verbose information.");
@@ -7,6 +7,7 @@
 #define MXNET_IO_ITER_BATCHLOADER_H_
 
 #include <dmlc/logging.h>
+#include <dmlc/timer.h>
 #include <mshadow/tensor.h>
 #include <mxnet/base.h>
 #include <mxnet/io.h>
@@ -15,6 +16,7 @@
 #include <vector>
 #include "./image_iter_common.h"
 #include "./inst_vector.h"
+#include "./iter_stats.h"
 
 namespace mxnet {
 namespace io {
@@ -59,7 +61,13 @@ class BatchLoader : public IIterator<TBlobBatch> {
         if (num_overflow_ != 0) return false;
         index_t top = 0;
 
+        // the stage times of the batch, added to stats_ once at its end
+        double read_time = 0, batch_time = 0;
+        bool full = false;
+        double start = dmlc::GetTime();
         while (base_->Next()) {
+            const double read = dmlc::GetTime();
+            read_time += read - start;
             const DataInst& d = base_->Value();
             out_.inst_index[top] = d.index;
             if (data_.size() == 0) {
@@ -75,10 +83,16 @@ class BatchLoader : public IIterator<TBlobBatch> {
                             mshadow::Shape1(unit_size_[i])));
                 });
             }
+            start = dmlc::GetTime();
+            batch_time += start - read;
             if (++top >= param_.batch_size) {
-                return true;
+                full = true;
+                break;
             }
         }
+        stats_.Add("read_time", read_time);
+        stats_.Add("batch_time", batch_time);
+        if (full) return true;
         if (top != 0) {
             if (param_.round_batch != 0) {
                 num_overflow_ = 0;
@@ -111,6 +125,23 @@ class BatchLoader : public IIterator<TBlobBatch> {
     }
     virtual const TBlobBatch& Value(void) const { return out_; }
 
+    virtual void GetStats(
+        std::vector<std::pair<std::string, double> >* stats) const {
+        base_->GetStats(stats);
+        stats_.Append(stats);
+    }
+
+    virtual bool SaveState(dmlc::Stream* fo) const {
+        fo->Write(num_overflow_);
+        return base_->SaveState(fo);
+    }
+
+    virtual bool LoadState(dmlc::Stream* fi) {
+        CHECK(fi->Read(&num_overflow_)) << "Invalid data iterator state";
+        head_ = 1;
+        return base_->LoadState(fi);
+    }
+
    private:
     /*! \brief batch parameters */
     BatchParam param_;
@@ -128,6 +159,8 @@ class BatchLoader : public IIterator<TBlobBatch> {
     std::vector<size_t> unit_size_;
     /*! \brief tensor to hold data */
     std::vector<TBlobContainer> data_;
+    /*! \brief time spent reading and batching instances */
+    IterStats stats_;
     // initialize the data holder by using from the first batch.
     inline void InitData(const DataInst& first_batch) {
         shape_.resize(first_batch.data.size());
@@ -5,11 +5,18 @@
  */
 #include <dmlc/base.h>
 #include <dmlc/data.h>
+#include <dmlc/io.h>
 #include <dmlc/logging.h>
+#include <dmlc/omp.h>
 #include <dmlc/parameter.h>
 #include <mxnet/io.h>
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
 #include "./iter_batchloader.h"
 #include "./iter_prefetcher.h"
+#include "./text_iter_common.h"
 
 namespace mxnet {
 namespace io {
@@ -23,6 +30,14 @@ struct CSVIterParam : public dmlc::Parameter<CSVIterParam> {
     std::string label_csv;
     /*! \brief label shape */
     TShape label_shape;
+    /*! \brief columns of data csv to use, empty means all */
+    TShape data_columns;
+    /*! \brief columns of label csv to use, empty means all */
+    TShape label_columns;
+    /*! \brief number of threads used to parse a chunk */
+    int preprocess_threads;
+    /*! \brief the size of a parsing chunk in MB */
+    size_t chunk_size;
     // declare parameters
     DMLC_DECLARE_PARAMETER(CSVIterParam) {
         DMLC_DECLARE_FIELD(data_csv)
@@ -37,9 +52,227 @@ struct CSVIterParam : public dmlc::Parameter<CSVIterParam> {
         DMLC_DECLARE_FIELD(label_shape)
             .set_default(TShape(shape1, shape1 + 1))
             .describe("The shape of one label.");
+        DMLC_DECLARE_FIELD(data_columns)
+            .set_default(TShape())
+            .describe(
+                "Zero-based indices of the columns of data_csv to use, in "
+                "output order. Empty means all columns.");
+        DMLC_DECLARE_FIELD(label_columns)
+            .set_default(TShape())
+            .describe(
+                "Zero-based indices of the columns of label_csv to use, in "
+                "output order. Empty means all columns.");
+        DMLC_DECLARE_FIELD(preprocess_threads)
+            .set_lower_bound(1)
+            .set_default(4)
+            .describe("The number of threads used to parse a chunk.");
+        DMLC_DECLARE_FIELD(chunk_size)
+            .set_lower_bound(1)
+            .set_default(16)
+            .describe(
+                "The size in MB of the text chunk read and parsed at once. "
+                "Files larger than this are streamed chunk by chunk.");
     }
 };
 
+/*!
+ * \brief reads one CSV source chunk by chunk and parses each chunk
+ *  in parallel into a contiguous row-major buffer of the output type.
+ */
+class CSVChunkReader {
+   public:
+    /*!
+     * \brief initialize the reader
+     * \param uri path to the csv file or directory
+     * \param columns the columns to keep, empty means all
+     * \param row_size number of values per row after column selection
+     * \param dtype type of the output values
+     * \param nthread number of parsing threads
+     * \param chunk_size size of a text chunk in bytes
+     */
+    inline void Init(const std::string &uri, const TShape &columns,
+                     size_t row_size, int dtype, int nthread,
+                     size_t chunk_size) {
+        row_size_ = row_size;
+        nthread_ = nthread;
+        col_map_.clear();
+        for (index_t i = 0; i < columns.ndim(); ++i) {
+            if (columns[i] >= col_map_.size()) {
+                col_map_.resize(columns[i] + 1, -1);
+            }
+            CHECK_EQ(col_map_[columns[i]], -1)
+                << "Column " << columns[i] << " is selected twice in " << uri;
+            col_map_[columns[i]] = static_cast<int>(i);
+        }
+        if (columns.ndim() != 0) {
+            CHECK_EQ(columns.ndim(), row_size)
+                << "The number of selected columns do not match size of "
+                << "shape for " << uri;
+        }
+        rows_.resize(mshadow::Shape1(row_size), dtype);
+        source_.reset(dmlc::InputSplit::Create(uri.c_str(), 0, 1, "text"));
+        source_->HintChunkSize(chunk_size);
+        num_rows_ = row_ptr_ = 0;
+        num_chunks_ = 0;
+    }
+
+    inline void BeforeFirst() {
+        source_->BeforeFirst();
+        num_rows_ = row_ptr_ = 0;
+        num_chunks_ = 0;
+    }
+
+    /*! \brief save the position as the number of chunks read and the row */
+    inline void SaveState(dmlc::Stream *fo) const {
+        fo->Write(num_chunks_);
+        fo->Write(static_cast<uint64_t>(row_ptr_));
+    }
+
+    /*!
+     * \brief restore the position, the chunks before the current one are
+     *  skipped without parsing them
+     */
+    inline void LoadState(dmlc::Stream *fi) {
+        uint64_t num_chunks, row_ptr;
+        CHECK(fi->Read(&num_chunks) && fi->Read(&row_ptr))
+            << "Invalid CSVIter state";
+        this->BeforeFirst();
+        dmlc::InputSplit::Blob chunk;
+        for (; num_chunks_ + 1 < num_chunks; ++num_chunks_) {
+            CHECK(source_->NextChunk(&chunk)) << "Invalid CSVIter state";
+        }
+        if (num_chunks != 0) {
+            CHECK(this->ParseNextChunk()) << "Invalid CSVIter state";
+            CHECK_LE(row_ptr, num_rows_) << "Invalid CSVIter state";
+        }
+        row_ptr_ = row_ptr;
+    }
+
+    /*!
+     * \brief get the next row as a TBlob of given shape
+     * \return false if the source is exhausted
+     */
+    inline bool NextRow(const TShape &shape, TBlob *out) {
+        while (row_ptr_ >= num_rows_) {
+            if (!this->ParseNextChunk()) return false;
+        }
+        MSHADOW_TYPE_SWITCH(rows_.type_flag_, DType, {
+            DType *dptr =
+                static_cast<DType *>(rows_.dptr_) + row_ptr_ * row_size_;
+            *out = TBlob(dptr, shape, cpu::kDevMask, rows_.type_flag_, 0);
+        });
+        ++row_ptr_;
+        return true;
+    }
+
+   private:
+    inline bool ParseNextChunk() {
+        dmlc::InputSplit::Blob chunk;
+        if (!source_->NextChunk(&chunk)) return false;
+        ++num_chunks_;
+        const char *begin = static_cast<const char *>(chunk.dptr);
+        const char *end = begin + chunk.size;
+        // split the chunk into line aligned ranges, one per thread
+        std::vector<const char *> range;
+        const int nthread = SplitTextChunk(begin, end, nthread_, &range);
+        // count the rows of each range, then parse them in place
+        std::vector<size_t> offset(nthread + 1, 0);
+#pragma omp parallel for num_threads(nthread)
+        for (int i = 0; i < nthread; ++i) {
+            size_t nrow = 0;
+            for (const char *p = range[i]; p < range[i + 1];
+                 p = SkipTextLine(p, range[i + 1])) {
+                if (IsNonEmptyLine(p, range[i + 1])) ++nrow;
+            }
+            offset[i + 1] = nrow;
+        }
+        for (int i = 0; i < nthread; ++i) offset[i + 1] += offset[i];
+        num_rows_ = offset[nthread];
+        row_ptr_ = 0;
+        if (num_rows_ == 0) return true;
+        rows_.resize(mshadow::Shape1(num_rows_ * row_size_), rows_.type_flag_);
+        std::vector<int64_t> bad_row(nthread, -1);
+        MSHADOW_TYPE_SWITCH(rows_.type_flag_, DType, {
+            this->ParseRanges(range, offset, static_cast<DType *>(rows_.dptr_),
+                              &bad_row);
+        });
+        for (int i = 0; i < nthread; ++i) {
+            CHECK_EQ(bad_row[i], -1)
+                << "The data size in CSV do not match size of shape: "
+                << "expect " << row_size_ << " values per row, "
+                << "the csv row-length=" << bad_row[i];
+        }
+        return true;
+    }
+
+    /*!
+     * \brief parse the rows of the ranges in parallel, those of range i from
+     *  row offset[i] of out
+     * \param bad_row set by ParseRange for every range
+     */
+    template <typename DType>
+    inline void ParseRanges(const std::vector<const char *> &range,
+                            const std::vector<size_t> &offset, DType *out,
+                            std::vector<int64_t> *bad_row) const {
+        const int nthread = static_cast<int>(bad_row->size());
+#pragma omp parallel for num_threads(nthread)
+        for (int i = 0; i < nthread; ++i) {
+            (*bad_row)[i] = this->ParseRange(range[i], range[i + 1],
+                                             out + offset[i] * row_size_);
+        }
+    }
+
+    /*!
+     * \brief parse the rows of [begin, end) into out
+     * \return -1 on success, otherwise the length of the offending row
+     */
+    template <typename DType>
+    inline int64_t ParseRange(const char *begin, const char *end,
+                              DType *out) const {
+        const int ncol_map = static_cast<int>(col_map_.size());
+        for (const char *p = begin; p < end;) {
+            const char *lend = SkipTextLine(p, end);
+            if (!IsNonEmptyLine(p, lend)) {
+                p = lend;
+                continue;
+            }
+            size_t nvalue = 0;
+            int col = 0;
+            while (true) {
+                if (ncol_map == 0 || (col < ncol_map && col_map_[col] >= 0)) {
+                    const double v = ParseTextNumber(&p, lend);
+                    const size_t pos = ncol_map == 0 ? col : col_map_[col];
+                    if (pos < row_size_) out[pos] = static_cast<DType>(v);
+                    ++nvalue;
+                }
+                while (p != lend && *p != ',' && *p != '\n') ++p;
+                if (p == lend || *p == '\n') break;
+                ++p;
+                ++col;
+            }
+            if (nvalue != row_size_) return static_cast<int64_t>(nvalue);
+            out += row_size_;
+            p = lend;
+        }
+        return -1;
+    }
+
+    /*! \brief number of values per row */
+    size_t row_size_{0};
+    /*! \brief number of parsing threads */
+    int nthread_{1};
+    /*! \brief map from column index to output position, -1 to skip */
+    std::vector<int> col_map_;
+    /*! \brief parsed rows of the current chunk */
+    TBlobContainer rows_;
+    /*! \brief number of rows in the current chunk and the cursor */
+    size_t num_rows_{0}, row_ptr_{0};
+    /*! \brief number of chunks read since the beginning */
+    uint64_t num_chunks_{0};
+    /*! \brief text source */
+    std::unique_ptr<dmlc::InputSplit> source_;
+};
+
 class CSVIter : public IIterator<DataInst> {
    public:
     CSVIter() { out_.data.resize(2); }
@@ -49,55 +282,49 @@ class CSVIter : public IIterator<DataInst> {
     virtual void Init(
         const std::vector<std::pair<std::string, std::string> >& kwargs) {
         param_.InitAllowUnknown(kwargs);
-        data_parser_.reset(dmlc::Parser<uint32_t>::Create(
-            param_.data_csv.c_str(), 0, 1, "csv"));
+        // data and labels are parsed into the output type of the prefetcher,
+        // which copies every output blob as that type
+        PrefetcherParam prefetch_param;
+        prefetch_param.InitAllowUnknown(kwargs);
+        const int dtype = prefetch_param.dtype
+                              ? prefetch_param.dtype.value()
+                              : static_cast<int>(mshadow::kFloat32);
+        const size_t chunk_size = param_.chunk_size << 20UL;
+        data_reader_.Init(param_.data_csv, param_.data_columns,
+                          param_.data_shape.Size(), dtype,
+                          param_.preprocess_threads, chunk_size);
         if (param_.label_csv != "NULL") {
-            label_parser_.reset(dmlc::Parser<uint32_t>::Create(
-                param_.label_csv.c_str(), 0, 1, "csv"));
+            label_reader_.reset(new CSVChunkReader());
+            label_reader_->Init(param_.label_csv, param_.label_columns,
+                                param_.label_shape.Size(), dtype,
+                                param_.preprocess_threads, chunk_size);
         } else {
-            dummy_label.set_pad(false);
-            dummy_label.Resize(mshadow::Shape1(1));
-            dummy_label = 0.0f;
+            dummy_label.resize(mshadow::Shape1(1), dtype);
+            MSHADOW_TYPE_SWITCH(dtype, DType,
+                                { *dummy_label.dptr<DType>() = DType(0); });
         }
     }
 
     virtual void BeforeFirst() {
-        data_parser_->BeforeFirst();
-        if (label_parser_.get() != nullptr) {
-            label_parser_->BeforeFirst();
+        data_reader_.BeforeFirst();
+        if (label_reader_.get() != nullptr) {
+            label_reader_->BeforeFirst();
         }
-        data_ptr_ = label_ptr_ = 0;
-        data_size_ = label_size_ = 0;
         inst_counter_ = 0;
         end_ = false;
     }
 
     virtual bool Next() {
         if (end_) return false;
-        while (data_ptr_ >= data_size_) {
-            if (!data_parser_->Next()) {
-                end_ = true;
-                return false;
-            }
-            data_ptr_ = 0;
-            data_size_ = data_parser_->Value().size;
+        if (!data_reader_.NextRow(param_.data_shape, &out_.data[0])) {
+            end_ = true;
+            return false;
         }
         out_.index = inst_counter_++;
-        CHECK_LT(data_ptr_, data_size_);
-        out_.data[0] =
-            AsTBlob(data_parser_->Value()[data_ptr_++], param_.data_shape);
-
-        if (label_parser_.get() != nullptr) {
-            while (label_ptr_ >= label_size_) {
-                CHECK(label_parser_->Next()) << "Data CSV's row is smaller "
-                                                "than the number of rows in "
-                                                "label_csv";
-                label_ptr_ = 0;
-                label_size_ = label_parser_->Value().size;
-            }
-            CHECK_LT(label_ptr_, label_size_);
-            out_.data[1] = AsTBlob(label_parser_->Value()[label_ptr_++],
-                                   param_.label_shape);
+        if (label_reader_.get() != nullptr) {
+            CHECK(label_reader_->NextRow(param_.label_shape, &out_.data[1]))
+                << "Data CSV's row is smaller than the number of rows in "
+                   "label_csv";
         } else {
             out_.data[1] = dummy_label;
         }
@@ -106,16 +333,27 @@ class CSVIter : public IIterator<DataInst> {
 
     virtual const DataInst& Value(void) const { return out_; }
 
-   private:
-    inline TBlob AsTBlob(const dmlc::Row<uint32_t>& row, const TShape& shape) {
-        CHECK_EQ(row.length, shape.Size())
-            << "The data size in CSV do not match size of shape: "
-            << "specified shape=" << shape
-            << ", the csv row-length=" << row.length;
-        const real_t* ptr = row.value;
-        return TBlob((real_t*)ptr, shape, cpu::kDevMask, 0);  // NOLINT(*)
+    virtual bool SaveState(dmlc::Stream* fo) const {
+        fo->Write(inst_counter_);
+        fo->Write(end_);
+        data_reader_.SaveState(fo);
+        if (label_reader_.get() != nullptr) {
+            label_reader_->SaveState(fo);
+        }
+        return true;
     }
 
+    virtual bool LoadState(dmlc::Stream* fi) {
+        CHECK(fi->Read(&inst_counter_) && fi->Read(&end_))
+            << "Invalid CSVIter state";
+        data_reader_.LoadState(fi);
+        if (label_reader_.get() != nullptr) {
+            label_reader_->LoadState(fi);
+        }
+        return true;
+    }
+
+   private:
     CSVIterParam param_;
     // output instance
     DataInst out_;
@@ -124,12 +362,11 @@ class CSVIter : public IIterator<DataInst> {
     // at end
     bool end_{false};
     // dummy label
-    mshadow::TensorContainer<cpu, 1, real_t> dummy_label;
-    // label parser
-    size_t label_ptr_{0}, label_size_{0};
-    size_t data_ptr_{0}, data_size_{0};
-    std::unique_ptr<dmlc::Parser<uint32_t> > label_parser_;
-    std::unique_ptr<dmlc::Parser<uint32_t> > data_parser_;
+    TBlobContainer dummy_label;
+    // label reader
+    std::unique_ptr<CSVChunkReader> label_reader_;
+    // data reader
+    CSVChunkReader data_reader_;
 };
 
 DMLC_REGISTER_PARAMETER(CSVIterParam);
@@ -151,6 +388,12 @@ to set `round_batch` to False.
 
 If ``data_csv = 'data/'`` is set, then all the files in this directory will be read.
 
+The files are read in chunks of `chunk_size` MB, so files larger than memory can be
+streamed. Each chunk is split at line boundaries and parsed by `preprocess_threads`
+threads directly into a buffer of type `dtype`, labels included. Use `data_columns` and `label_columns`
+to read only a subset of the columns, e.g. ``data_columns=(0,2)`` on the row ``1,2,3``
+yields ``[1,3]``.
+
 Examples::
 
   // Contents of CSV file ``data/data.csv``.
@@ -12,6 +12,7 @@
 #include <dmlc/parameter.h>
 #include <dmlc/recordio.h>
 #include <dmlc/threadediter.h>
+#include <dmlc/timer.h>
 #include <mxnet/io.h>
 #include <cstdlib>
 #include <unordered_map>
@@ -23,6 +24,7 @@
 #include "./iter_batchloader.h"
 #include "./iter_normalize.h"
 #include "./iter_prefetcher.h"
+#include "./iter_stats.h"
 
 namespace mxnet {
 namespace io {
@@ -226,6 +228,11 @@ class ImageDetRecordIOParser {
     // parse next set of records, return an array of
     // instance vector to the user
     virtual inline bool ParseNext(std::vector<InstVector<DType>> *out);
+    // append the cumulative stage timings
+    inline void GetStats(
+        std::vector<std::pair<std::string, double>> *stats) const {
+        stats_.Append(stats);
+    }
 
    protected:
     // magic number to see prng
@@ -244,6 +251,8 @@ class ImageDetRecordIOParser {
     std::unique_ptr<ImageDetLabelMap> label_map_;
     /*! \brief temp space */
     mshadow::TensorContainer<cpu, 3> img_;
+    /*! \brief cumulative stage timings */
+    IterStats stats_;
 };
 
 template <typename DType>
@@ -386,7 +395,9 @@ inline bool ImageDetRecordIOParser<DType>::ParseNext(
 #if MXNET_USE_OPENCV
     // save opencv out
     out_vec->resize(param_.preprocess_threads);
-#pragma omp parallel num_threads(param_.preprocess_threads)
+    double decode_time = 0.0, augment_time = 0.0;
+#pragma omp parallel num_threads(param_.preprocess_threads) \
+    reduction(+ : decode_time, augment_time)
     {
         CHECK(omp_get_num_threads() == param_.preprocess_threads);
         int tid = omp_get_thread_num();
@@ -399,6 +410,7 @@ inline bool ImageDetRecordIOParser<DType>::ParseNext(
         while (reader.NextRecord(&blob)) {
             // Opencv decode and augments
             cv::Mat res;
+            const double start = dmlc::GetTime();
             rec.Load(blob.dptr, blob.size);
             cv::Mat buf(1, rec.content_size, CV_8U, rec.content);
             switch (param_.data_shape[0]) {
@@ -420,6 +432,8 @@ inline bool ImageDetRecordIOParser<DType>::ParseNext(
                     LOG(FATAL) << "Invalid output shape " << param_.data_shape;
             }
             const int n_channels = res.channels();
+            const double decoded = dmlc::GetTime();
+            decode_time += decoded - start;
             // load label before augmentations
             std::vector<float> label_buf;
             if (this->label_map_ != nullptr) {
@@ -440,6 +454,7 @@ inline bool ImageDetRecordIOParser<DType>::ParseNext(
             for (auto &aug : this->augmenters_[tid]) {
                 res = aug->Process(res, &label_buf, this->prnds_[tid].get());
             }
+            augment_time += dmlc::GetTime() - decoded;
             out.Push(static_cast<unsigned>(rec.image_index()),
                      mshadow::Shape3(n_channels, param_.data_shape[1],
                                      param_.data_shape[2]),
@@ -477,6 +492,8 @@ inline bool ImageDetRecordIOParser<DType>::ParseNext(
             res.release();
         }
     }
+    stats_.Add("decode_time", decode_time);
+    stats_.Add("augment_time", augment_time);
 #else
     LOG(FATAL) << "Opencv is needed for image decoding and augmenting.";
 #endif
@@ -571,6 +588,11 @@ class ImageDetRecordIter : public IIterator<DataInst> {
 
     virtual const DataInst &Value(void) const { return out_; }
 
+    virtual void GetStats(
+        std::vector<std::pair<std::string, double>> *stats) const {
+        parser_.GetStats(stats);
+    }
+
    private:
     // random magic
     static const int kRandMagic = 233;
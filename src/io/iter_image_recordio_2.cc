@@ -8,18 +8,24 @@
 #include <dmlc/common.h>
 #include <dmlc/input_split_shuffle.h>
 #include <dmlc/io.h>
+#include <dmlc/memory_io.h>
 #include <dmlc/omp.h>
 #include <dmlc/parameter.h>
 #include <dmlc/recordio.h>
 #include <dmlc/threadediter.h>
 #include <dmlc/timer.h>
 #include <mxnet/io.h>
+#include <atomic>
+#include <sstream>
+#include <string>
 #include <type_traits>
 #include "../common/utils.h"
 #include "./image_augmenter.h"
 #include "./image_iter_common.h"
 #include "./image_recordio.h"
 #include "./inst_vector.h"
+#include "./iter_state.h"
+#include "./iter_stats.h"
 
 namespace mxnet {
 namespace io {
@@ -35,7 +41,7 @@ class ImageRecordIOParser2 {
     inline void BeforeFirst(void) {
         if (batch_param_.round_batch == 0 || !overflow) {
             n_parsed_ = 0;
-            return source_->BeforeFirst();
+            this->ResetSource();
         } else {
             overflow = false;
         }
@@ -43,9 +49,34 @@ class ImageRecordIOParser2 {
     // parse next set of records, return an array of
     // instance vector to the user
     inline bool ParseNext(DataBatch* out);
+    // append the cumulative stage timings
+    inline void GetStats(
+        std::vector<std::pair<std::string, double>>* stats) const {
+        stats_.Append(stats);
+    }
+    // save the position after the last parsed batch
+    inline void SaveState(dmlc::Stream* fo) const;
+    // restore the position saved by SaveState
+    inline void LoadState(dmlc::Stream* fi);
 
    private:
+    // create the record source, shuffled by chunks if needed
+    inline void CreateSource(void);
+    // rewind the record source
+    inline void ResetSource(void) {
+        source_->BeforeFirst();
+        ++num_resets_;
+        num_chunks_ = 0;
+    }
+    // decode a chunk and order its instances, return the number of instances
+    inline unsigned ParseInstOrder(dmlc::InputSplit::Blob* chunk);
+    // text form of the states of all random engines
+    inline std::string SaveRandomState(void) const;
+    inline void LoadRandomState(const std::string& state);
     inline void ParseChunk(dmlc::InputSplit::Blob* chunk);
+    // decode and augment one part of a chunk into temp_[part]
+    inline void ParsePart(const dmlc::InputSplit::Blob& chunk, int part,
+                          int nparts, int tid, double* timer);
     inline void CreateMeanImg(void);
 
     // magic number to seed prng
@@ -85,6 +116,14 @@ class ImageRecordIOParser2 {
     mshadow::TensorContainer<cpu, 3> meanimg_;
     // whether mean image is ready.
     bool meanfile_ready_;
+    /*! \brief cumulative stage timings */
+    IterStats stats_;
+    /*! \brief number of rewinds of the source since it was created */
+    uint64_t num_resets_{0};
+    /*! \brief number of chunks read since the last rewind */
+    uint64_t num_chunks_{0};
+    /*! \brief random state before the current chunk was parsed */
+    std::string chunk_rng_;
 };
 
 template <typename DType>
@@ -134,35 +173,17 @@ inline void ImageRecordIOParser2<DType>::Init(
         LOG(INFO) << "ImageRecordIOParser2: " << param_.path_imgrec << ", use "
                   << threadget << " threads for decoding..";
     }
-    source_.reset(dmlc::InputSplit::Create(param_.path_imgrec.c_str(),
-                                           param_.part_index, param_.num_parts,
-                                           "recordio"));
-    if (param_.shuffle_chunk_size > 0) {
-        if (param_.shuffle_chunk_size > 4096) {
-            LOG(INFO) << "Chunk size: " << param_.shuffle_chunk_size
-                      << " MB which is larger than 4096 MB, please set "
-                         "smaller chunk size";
-        }
-        if (param_.shuffle_chunk_size < 4) {
-            LOG(INFO) << "Chunk size: " << param_.shuffle_chunk_size
-                      << " MB which is less than 4 MB, please set "
-                         "larger chunk size";
-        }
-        // 1.1 ratio is for a bit more shuffle parts to avoid boundary issue
-        unsigned num_shuffle_parts =
-            std::ceil(source_->GetTotalSize() * 1.1 /
-                      (param_.num_parts * (param_.shuffle_chunk_size << 20UL)));
-
-        if (num_shuffle_parts > 1) {
-            source_.reset(dmlc::InputSplitShuffle::Create(
-                param_.path_imgrec.c_str(), param_.part_index, param_.num_parts,
-                "recordio", num_shuffle_parts, param_.shuffle_chunk_seed));
-        }
-        source_->HintChunkSize(param_.shuffle_chunk_size << 17UL);
-    } else {
-        // use 64 MB chunk when possible
-        source_->HintChunkSize(8 << 20UL);
+    if (param_.shuffle_chunk_size > 4096) {
+        LOG(INFO) << "Chunk size: " << param_.shuffle_chunk_size
+                  << " MB which is larger than 4096 MB, please set "
+                     "smaller chunk size";
+    }
+    if (param_.shuffle_chunk_size > 0 && param_.shuffle_chunk_size < 4) {
+        LOG(INFO) << "Chunk size: " << param_.shuffle_chunk_size
+                  << " MB which is less than 4 MB, please set "
+                     "larger chunk size";
     }
+    this->CreateSource();
     // Normalize init
     if (!std::is_same<DType, uint8_t>::value) {
         meanimg_.set_pad(false);
@@ -201,6 +222,30 @@ inline void ImageRecordIOParser2<DType>::Init(
 #endif
 }
 
+template <typename DType>
+inline void ImageRecordIOParser2<DType>::CreateSource(void) {
+    source_.reset(dmlc::InputSplit::Create(param_.path_imgrec.c_str(),
+                                           param_.part_index, param_.num_parts,
+                                           "recordio"));
+    if (param_.shuffle_chunk_size > 0) {
+        // 1.1 ratio is for a bit more shuffle parts to avoid boundary issue
+        unsigned num_shuffle_parts =
+            std::ceil(source_->GetTotalSize() * 1.1 /
+                      (param_.num_parts * (param_.shuffle_chunk_size << 20UL)));
+
+        if (num_shuffle_parts > 1) {
+            source_.reset(dmlc::InputSplitShuffle::Create(
+                param_.path_imgrec.c_str(), param_.part_index, param_.num_parts,
+                "recordio", num_shuffle_parts, param_.shuffle_chunk_seed));
+        }
+        source_->HintChunkSize(param_.shuffle_chunk_size << 17UL);
+    } else {
+        // use 64 MB chunk when possible
+        source_->HintChunkSize(8 << 20UL);
+    }
+    num_resets_ = num_chunks_ = 0;
+}
+
 template <typename DType>
 inline bool ImageRecordIOParser2<DType>::ParseNext(DataBatch* out) {
     if (overflow) return false;
@@ -211,32 +256,21 @@ inline bool ImageRecordIOParser2<DType>::ParseNext(DataBatch* out) {
     while (current_size < batch_param_.batch_size) {
         int n_to_copy;
         if (n_parsed_ == 0) {
-            if (source_->NextChunk(&chunk)) {
-                inst_order_.clear();
-                inst_index_ = 0;
-                ParseChunk(&chunk);
-                unsigned n_read = 0;
-                for (unsigned i = 0; i < temp_.size(); ++i) {
-                    const InstVector<DType>& tmp = temp_[i];
-                    for (unsigned j = 0; j < tmp.Size(); ++j) {
-                        inst_order_.push_back(std::make_pair(i, j));
-                    }
-                    n_read += tmp.Size();
-                }
+            const double start = dmlc::GetTime();
+            const bool has_chunk = source_->NextChunk(&chunk);
+            stats_.Add("read_time", dmlc::GetTime() - start);
+            if (has_chunk) {
+                const unsigned n_read = ParseInstOrder(&chunk);
                 n_to_copy =
                     std::min(n_read, batch_param_.batch_size - current_size);
                 n_parsed_ = n_read - n_to_copy;
-                // shuffle instance order if needed
-                if (record_param_.shuffle != 0) {
-                    std::shuffle(inst_order_.begin(), inst_order_.end(), rnd_);
-                }
             } else {
                 if (current_size == 0) return false;
                 CHECK(!overflow) << "number of input images must be bigger "
                                     "than the batch size";
                 if (batch_param_.round_batch != 0) {
                     overflow = true;
-                    source_->BeforeFirst();
+                    this->ResetSource();
                 } else {
                     current_size = batch_param_.batch_size;
                 }
@@ -274,7 +308,8 @@ inline bool ImageRecordIOParser2<DType>::ParseNext(DataBatch* out) {
             }
         }
 
-// Copy
+        // Copy
+        const double copy_start = dmlc::GetTime();
 #pragma omp parallel for num_threads(param_.preprocess_threads)
         for (int i = 0; i < n_to_copy; ++i) {
             std::pair<unsigned, unsigned> place = inst_order_[inst_index_ + i];
@@ -291,172 +326,291 @@ inline bool ImageRecordIOParser2<DType>::ParseNext(DataBatch* out) {
                 });
             }
         }
+        stats_.Add("batch_time", dmlc::GetTime() - copy_start);
         inst_index_ += n_to_copy;
         current_size += n_to_copy;
     }
     return true;
 }
 
+template <typename DType>
+inline unsigned ImageRecordIOParser2<DType>::ParseInstOrder(
+    dmlc::InputSplit::Blob* chunk) {
+    ++num_chunks_;
+    chunk_rng_ = SaveRandomState();
+    inst_order_.clear();
+    inst_index_ = 0;
+    ParseChunk(chunk);
+    unsigned n_read = 0;
+    for (unsigned i = 0; i < temp_.size(); ++i) {
+        const InstVector<DType>& tmp = temp_[i];
+        for (unsigned j = 0; j < tmp.Size(); ++j) {
+            inst_order_.push_back(std::make_pair(i, j));
+        }
+        n_read += tmp.Size();
+    }
+    // shuffle instance order if needed
+    if (record_param_.shuffle != 0) {
+        std::shuffle(inst_order_.begin(), inst_order_.end(), rnd_);
+    }
+    return n_read;
+}
+
+template <typename DType>
+inline std::string ImageRecordIOParser2<DType>::SaveRandomState(void) const {
+    std::ostringstream os;
+    os << rnd_;
+    for (const auto& prnd : prnds_) {
+        os << ' ' << *prnd;
+    }
+    return os.str();
+}
+
+template <typename DType>
+inline void ImageRecordIOParser2<DType>::LoadRandomState(
+    const std::string& state) {
+    std::istringstream is(state);
+    is >> rnd_;
+    for (auto& prnd : prnds_) {
+        is >> *prnd;
+    }
+    CHECK(!is.fail()) << "Invalid ImageRecordIter state, "
+                      << "preprocess_threads must not change";
+}
+
+template <typename DType>
+inline void ImageRecordIOParser2<DType>::SaveState(dmlc::Stream* fo) const {
+    fo->Write(num_resets_);
+    fo->Write(num_chunks_);
+    fo->Write(n_parsed_);
+    fo->Write(inst_index_);
+    fo->Write(overflow);
+    // a partly used chunk is parsed again from the random state before it
+    fo->Write(n_parsed_ != 0 ? chunk_rng_ : SaveRandomState());
+}
+
+template <typename DType>
+inline void ImageRecordIOParser2<DType>::LoadState(dmlc::Stream* fi) {
+    uint64_t num_resets, num_chunks;
+    unsigned n_parsed, inst_index;
+    bool overflow_flag;
+    std::string rng;
+    CHECK(fi->Read(&num_resets) && fi->Read(&num_chunks) &&
+          fi->Read(&n_parsed) && fi->Read(&inst_index) &&
+          fi->Read(&overflow_flag) && fi->Read(&rng))
+        << "Invalid ImageRecordIter state";
+    if (param_.shuffle_chunk_size > 0) {
+        // each rewind reshuffles the chunks, so replay them from the start
+        this->CreateSource();
+        for (uint64_t i = 0; i < num_resets; ++i) this->ResetSource();
+    } else {
+        this->ResetSource();
+        num_resets_ = num_resets;
+    }
+    // skip the chunks before the position without decoding them
+    const uint64_t num_skip = n_parsed != 0 ? num_chunks - 1 : num_chunks;
+    dmlc::InputSplit::Blob chunk;
+    for (; num_chunks_ < num_skip; ++num_chunks_) {
+        CHECK(source_->NextChunk(&chunk)) << "Invalid ImageRecordIter state";
+    }
+    LoadRandomState(rng);
+    if (n_parsed != 0) {
+        CHECK(source_->NextChunk(&chunk)) << "Invalid ImageRecordIter state";
+        CHECK_EQ(ParseInstOrder(&chunk), inst_index + n_parsed)
+            << "Invalid ImageRecordIter state";
+    }
+    n_parsed_ = n_parsed;
+    inst_index_ = inst_index;
+    overflow = overflow_flag;
+}
+
 template <typename DType>
 inline void ImageRecordIOParser2<DType>::ParseChunk(
     dmlc::InputSplit::Blob* chunk) {
-    temp_.resize(param_.preprocess_threads);
+    const int nthread = param_.preprocess_threads;
+    const int nparts = nthread * param_.preprocess_parts_per_thread;
+    temp_.resize(nparts);
 #if MXNET_USE_OPENCV
 // save opencv out
-#pragma omp parallel num_threads(param_.preprocess_threads)
+#pragma omp parallel num_threads(nthread)
     {
-        CHECK(omp_get_num_threads() == param_.preprocess_threads);
+        CHECK(omp_get_num_threads() == nthread);
         int tid = omp_get_thread_num();
-        dmlc::RecordIOChunkReader reader(*chunk, tid,
-                                         param_.preprocess_threads);
-        ImageRecordIO rec;
-        dmlc::InputSplit::Blob blob;
-        // image data
-        InstVector<DType>& out = temp_[tid];
-        out.Clear();
-        while (reader.NextRecord(&blob)) {
-            // Opencv decode and augments
-            cv::Mat res;
-            rec.Load(blob.dptr, blob.size);
-            cv::Mat buf(1, rec.content_size, CV_8U, rec.content);
-            switch (param_.data_shape[0]) {
-                case 1:
-                    res = cv::imdecode(buf, 0);
-                    break;
-                case 3:
-                    res = cv::imdecode(buf, 1);
-                    break;
-                case 4:
-                    // -1 to keep the number of channel of the encoded image,
-                    // and not force gray or color.
-                    res = cv::imdecode(buf, -1);
-                    CHECK_EQ(res.channels(), 4)
-                        << "Invalid image with index " << rec.image_index()
-                        << ". Expected 4 channels, got " << res.channels();
-                    break;
-                default:
-                    LOG(FATAL) << "Invalid output shape " << param_.data_shape;
-            }
-            const int n_channels = res.channels();
-            for (auto& aug : augmenters_[tid]) {
-                res = aug->Process(res, nullptr, prnds_[tid].get());
-            }
-            out.Push(static_cast<unsigned>(rec.image_index()),
-                     mshadow::Shape3(n_channels, res.rows, res.cols),
-                     mshadow::Shape1(param_.label_width));
-
-            mshadow::Tensor<cpu, 3, DType> data = out.data().Back();
-
-            // For RGB or RGBA data, swap the B and R channel:
-            // OpenCV store as BGR (or BGRA) and we want RGB (or RGBA)
-            std::vector<int> swap_indices;
-            if (n_channels == 1) swap_indices = {0};
-            if (n_channels == 3) swap_indices = {2, 1, 0};
-            if (n_channels == 4) swap_indices = {2, 1, 0, 3};
-
-            std::uniform_real_distribution<float> rand_uniform(0, 1);
-            std::bernoulli_distribution coin_flip(0.5);
-            bool is_mirrored =
-                (normalize_param_.rand_mirror && coin_flip(*(prnds_[tid]))) ||
-                normalize_param_.mirror;
-            float contrast_scaled;
-            float illumination_scaled;
-            if (!std::is_same<DType, uint8_t>::value) {
-                contrast_scaled =
-                    (rand_uniform(*(prnds_[tid])) *
-                         normalize_param_.max_random_contrast * 2 -
-                     normalize_param_.max_random_contrast + 1) *
-                    normalize_param_.scale;
-                illumination_scaled =
-                    (rand_uniform(*(prnds_[tid])) *
-                         normalize_param_.max_random_illumination * 2 -
-                     normalize_param_.max_random_illumination) *
-                    normalize_param_.scale;
+        // seconds this thread spent decoding and augmenting
+        double timer[2] = {0.0, 0.0};
+        if (nparts == nthread) {
+            // a fixed part per thread keeps the augmentation deterministic
+            ParsePart(*chunk, tid, nparts, tid, timer);
+        } else {
+            // idle threads pick up the remaining parts of slow threads
+#pragma omp for schedule(dynamic)
+            for (int part = 0; part < nparts; ++part) {
+                ParsePart(*chunk, part, nparts, tid, timer);
             }
-            for (int i = 0; i < res.rows; ++i) {
-                uchar* im_data = res.ptr<uchar>(i);
-                for (int j = 0; j < res.cols; ++j) {
-                    DType RGBA[4];
-                    for (int k = 0; k < n_channels; ++k) {
-                        RGBA[k] = im_data[swap_indices[k]];
+        }
+        stats_.Add("decode_time", timer[0]);
+        stats_.Add("augment_time", timer[1]);
+    }
+#else
+    LOG(FATAL) << "Opencv is needed for image decoding and augmenting.";
+#endif
+}
+
+template <typename DType>
+inline void ImageRecordIOParser2<DType>::ParsePart(
+    const dmlc::InputSplit::Blob& chunk, int part, int nparts, int tid,
+    double* timer) {
+#if MXNET_USE_OPENCV
+    dmlc::RecordIOChunkReader reader(chunk, part, nparts);
+    ImageRecordIO rec;
+    dmlc::InputSplit::Blob blob;
+    // image data
+    InstVector<DType>& out = temp_[part];
+    out.Clear();
+    while (reader.NextRecord(&blob)) {
+        // Opencv decode and augments
+        const double start = dmlc::GetTime();
+        cv::Mat res;
+        rec.Load(blob.dptr, blob.size);
+        cv::Mat buf(1, rec.content_size, CV_8U, rec.content);
+        switch (param_.data_shape[0]) {
+            case 1:
+                res = cv::imdecode(buf, 0);
+                break;
+            case 3:
+                res = cv::imdecode(buf, 1);
+                break;
+            case 4:
+                // -1 to keep the number of channel of the encoded image,
+                // and not force gray or color.
+                res = cv::imdecode(buf, -1);
+                CHECK_EQ(res.channels(), 4)
+                    << "Invalid image with index " << rec.image_index()
+                    << ". Expected 4 channels, got " << res.channels();
+                break;
+            default:
+                LOG(FATAL) << "Invalid output shape " << param_.data_shape;
+        }
+        const double decoded = dmlc::GetTime();
+        timer[0] += decoded - start;
+        const int n_channels = res.channels();
+        for (auto& aug : augmenters_[tid]) {
+            res = aug->Process(res, nullptr, prnds_[tid].get());
+        }
+        out.Push(static_cast<unsigned>(rec.image_index()),
+                 mshadow::Shape3(n_channels, res.rows, res.cols),
+                 mshadow::Shape1(param_.label_width));
+
+        mshadow::Tensor<cpu, 3, DType> data = out.data().Back();
+
+        // For RGB or RGBA data, swap the B and R channel:
+        // OpenCV store as BGR (or BGRA) and we want RGB (or RGBA)
+        std::vector<int> swap_indices;
+        if (n_channels == 1) swap_indices = {0};
+        if (n_channels == 3) swap_indices = {2, 1, 0};
+        if (n_channels == 4) swap_indices = {2, 1, 0, 3};
+
+        std::uniform_real_distribution<float> rand_uniform(0, 1);
+        std::bernoulli_distribution coin_flip(0.5);
+        bool is_mirrored =
+            (normalize_param_.rand_mirror && coin_flip(*(prnds_[tid]))) ||
+            normalize_param_.mirror;
+        float contrast_scaled;
+        float illumination_scaled;
+        if (!std::is_same<DType, uint8_t>::value) {
+            contrast_scaled =
+                (rand_uniform(*(prnds_[tid])) *
+                     normalize_param_.max_random_contrast * 2 -
+                 normalize_param_.max_random_contrast + 1) *
+                normalize_param_.scale;
+            illumination_scaled =
+                (rand_uniform(*(prnds_[tid])) *
+                     normalize_param_.max_random_illumination * 2 -
+                 normalize_param_.max_random_illumination) *
+                normalize_param_.scale;
+        }
+        for (int i = 0; i < res.rows; ++i) {
+            uchar* im_data = res.ptr<uchar>(i);
+            for (int j = 0; j < res.cols; ++j) {
+                DType RGBA[4];
+                for (int k = 0; k < n_channels; ++k) {
+                    RGBA[k] = im_data[swap_indices[k]];
+                }
+                if (!std::is_same<DType, uint8_t>::value) {
+                    // normalize/mirror here to avoid memory copies
+                    // logic from iter_normalize.h, function SetOutImg
+
+                    if (normalize_param_.mean_r > 0.0f ||
+                        normalize_param_.mean_g > 0.0f ||
+                        normalize_param_.mean_b > 0.0f ||
+                        normalize_param_.mean_a > 0.0f) {
+                        // subtract mean per channel
+                        RGBA[0] -= normalize_param_.mean_r;
+                        if (n_channels >= 3) {
+                            RGBA[1] -= normalize_param_.mean_g;
+                            RGBA[2] -= normalize_param_.mean_b;
+                        }
+                        if (n_channels == 4) {
+                            RGBA[3] -= normalize_param_.mean_a;
+                        }
+                        for (int k = 0; k < n_channels; ++k) {
+                            RGBA[k] = RGBA[k] * contrast_scaled +
+                                      illumination_scaled;
+                        }
+                    } else if (!meanfile_ready_ ||
+                               normalize_param_.mean_img.length() == 0) {
+                        // do not subtract anything
+                        for (int k = 0; k < n_channels; ++k) {
+                            RGBA[k] = RGBA[k] * normalize_param_.scale;
+                        }
+                    } else {
+                        CHECK(meanfile_ready_);
+                        for (int k = 0; k < n_channels; ++k) {
+                            RGBA[k] = (RGBA[k] - meanimg_[k][i][j]) *
+                                          contrast_scaled +
+                                      illumination_scaled;
+                        }
                     }
+                }
+                for (int k = 0; k < n_channels; ++k) {
                     if (!std::is_same<DType, uint8_t>::value) {
                         // normalize/mirror here to avoid memory copies
                         // logic from iter_normalize.h, function SetOutImg
-
-                        if (normalize_param_.mean_r > 0.0f ||
-                            normalize_param_.mean_g > 0.0f ||
-                            normalize_param_.mean_b > 0.0f ||
-                            normalize_param_.mean_a > 0.0f) {
-                            // subtract mean per channel
-                            RGBA[0] -= normalize_param_.mean_r;
-                            if (n_channels >= 3) {
-                                RGBA[1] -= normalize_param_.mean_g;
-                                RGBA[2] -= normalize_param_.mean_b;
-                            }
-                            if (n_channels == 4) {
-                                RGBA[3] -= normalize_param_.mean_a;
-                            }
-                            for (int k = 0; k < n_channels; ++k) {
-                                RGBA[k] = RGBA[k] * contrast_scaled +
-                                          illumination_scaled;
-                            }
-                        } else if (!meanfile_ready_ ||
-                                   normalize_param_.mean_img.length() == 0) {
-                            // do not subtract anything
-                            for (int k = 0; k < n_channels; ++k) {
-                                RGBA[k] = RGBA[k] * normalize_param_.scale;
-                            }
-                        } else {
-                            CHECK(meanfile_ready_);
-                            for (int k = 0; k < n_channels; ++k) {
-                                RGBA[k] = (RGBA[k] - meanimg_[k][i][j]) *
-                                              contrast_scaled +
-                                          illumination_scaled;
-                            }
-                        }
-                    }
-                    for (int k = 0; k < n_channels; ++k) {
-                        if (!std::is_same<DType, uint8_t>::value) {
-                            // normalize/mirror here to avoid memory copies
-                            // logic from iter_normalize.h, function SetOutImg
-                            if (is_mirrored) {
-                                data[k][i][res.cols - j - 1] = RGBA[k];
-                            } else {
-                                data[k][i][j] = RGBA[k];
-                            }
+                        if (is_mirrored) {
+                            data[k][i][res.cols - j - 1] = RGBA[k];
                         } else {
-                            // do not do normalization in Uint8 reader
                             data[k][i][j] = RGBA[k];
                         }
+                    } else {
+                        // do not do normalization in Uint8 reader
+                        data[k][i][j] = RGBA[k];
                     }
-                    im_data += n_channels;
                 }
+                im_data += n_channels;
             }
+        }
 
-            mshadow::Tensor<cpu, 1> label = out.label().Back();
-            if (label_map_ != nullptr) {
-                mshadow::Copy(label, label_map_->Find(rec.image_index()));
-            } else if (rec.label != NULL) {
-                CHECK_EQ(param_.label_width, rec.num_label)
-                    << "rec file provide " << rec.num_label
-                    << "-dimensional label "
-                       "but label_width is set to "
-                    << param_.label_width;
-                mshadow::Copy(label,
-                              mshadow::Tensor<cpu, 1>(
-                                  rec.label, mshadow::Shape1(rec.num_label)));
-            } else {
-                CHECK_EQ(param_.label_width, 1)
-                    << "label_width must be 1 unless an imglist is provided "
-                       "or the rec file is packed with multi dimensional label";
-                label[0] = rec.header.label;
-            }
-            res.release();
+        mshadow::Tensor<cpu, 1> label = out.label().Back();
+        if (label_map_ != nullptr) {
+            mshadow::Copy(label, label_map_->Find(rec.image_index()));
+        } else if (rec.label != NULL) {
+            CHECK_EQ(param_.label_width, rec.num_label)
+                << "rec file provide " << rec.num_label
+                << "-dimensional label "
+                   "but label_width is set to "
+                << param_.label_width;
+            mshadow::Copy(label,
+                          mshadow::Tensor<cpu, 1>(
+                              rec.label, mshadow::Shape1(rec.num_label)));
+        } else {
+            CHECK_EQ(param_.label_width, 1)
+                << "label_width must be 1 unless an imglist is provided "
+                   "or the rec file is packed with multi dimensional label";
+            label[0] = rec.header.label;
         }
+        res.release();
+        timer[1] += dmlc::GetTime() - decoded;
     }
-#else
-    LOG(FATAL) << "Opencv is needed for image decoding and augmenting.";
 #endif
 }
 
@@ -529,18 +683,42 @@ class ImageRecordIter2 : public IIterator<DataBatch> {
         const int kMaxPrefetchBuffer = 16;
         // init thread iter
         iter_.set_max_capacity(kMaxPrefetchBuffer);
+        // the position before the first batch
+        this->SaveParserState(&state_);
         // init thread iter
         iter_.Init(
             [this](DataBatch** dptr) {
                 if (*dptr == nullptr) {
                     *dptr = new DataBatch();
                 }
-                return parser_.ParseNext(*dptr);
+                if (!parser_.ParseNext(*dptr)) return false;
+                std::string state;
+                this->SaveParserState(&state);
+                states_.Push(std::move(state));
+                ++num_produced_;
+                return true;
             },
-            [this]() { parser_.BeforeFirst(); });
+            [this]() {
+                if (pending_state_.empty()) {
+                    parser_.BeforeFirst();
+                } else {
+                    dmlc::MemoryFixedSizeStream strm(
+                        const_cast<char*>(pending_state_.data()),
+                        pending_state_.length());
+                    parser_.LoadState(&strm);
+                    pending_state_.clear();
+                }
+                states_.Clear();
+                this->SaveParserState(&reset_state_);
+                num_produced_ = 0;
+            });
     }
 
-    virtual void BeforeFirst(void) { iter_.BeforeFirst(); }
+    virtual void BeforeFirst(void) {
+        iter_.BeforeFirst();
+        state_ = reset_state_;
+        num_consumed_ = 0;
+    }
 
     // From iter_prefetcher.h
     virtual bool Next(void) {
@@ -558,12 +736,45 @@ class ImageRecordIter2 : public IIterator<DataBatch> {
             recycle_queue_.pop();
             iter_.Recycle(&old_batch);
         }
-        return iter_.Next(&out_);
+        // batches ready in the prefetch queue, and how long we wait for one
+        stats_.Add("queued_batches", num_produced_ - num_consumed_);
+        const double start = dmlc::GetTime();
+        if (!iter_.Next(&out_)) return false;
+        state_ = states_.Pop();
+        stats_.Add("wait_time", dmlc::GetTime() - start);
+        stats_.Add("num_batches", 1);
+        ++num_consumed_;
+        return true;
     }
 
     virtual const DataBatch& Value(void) const { return *out_; }
 
+    virtual void GetStats(
+        std::vector<std::pair<std::string, double>>* stats) const {
+        parser_.GetStats(stats);
+        stats_.Append(stats);
+    }
+
+    virtual bool SaveState(dmlc::Stream* fo) const {
+        fo->Write(state_);
+        return true;
+    }
+
+    virtual bool LoadState(dmlc::Stream* fi) {
+        CHECK(fi->Read(&pending_state_) && !pending_state_.empty())
+            << "Invalid ImageRecordIter state";
+        // restored by the prefetch thread in place of rewinding the parser
+        this->BeforeFirst();
+        return true;
+    }
+
    private:
+    inline void SaveParserState(std::string* out) {
+        out->clear();
+        dmlc::MemoryStringStream strm(out);
+        parser_.SaveState(&strm);
+    }
+
     /*! \brief Backend thread */
     dmlc::ThreadedIter<DataBatch> iter_;
     /*! \brief Parameters */
@@ -574,6 +785,18 @@ class ImageRecordIter2 : public IIterator<DataBatch> {
     std::queue<DataBatch*> recycle_queue_;
     /* \brief parser */
     ImageRecordIOParser2<DType> parser_;
+    /*! \brief number of batches produced and consumed in this epoch */
+    std::atomic<int64_t> num_produced_{0}, num_consumed_{0};
+    /*! \brief prefetch statistics */
+    IterStats stats_;
+    /*! \brief states of the parser after each prefetched batch */
+    IterStateQueue states_;
+    /*! \brief state after the last batch taken */
+    std::string state_;
+    /*! \brief state of the parser after it is rewound */
+    std::string reset_state_;
+    /*! \brief state to be restored by the next rewind */
+    std::string pending_state_;
 };
 
 MXNET_REGISTER_IO_ITER(ImageRecordIter)
@@ -0,0 +1,368 @@
+/*!
+ *  Copyright (c) 2017 by Contributors
+ * \file iter_libsvm.cc
+ * \brief define a LibSVM Reader to read in sparse batches
+ */
+#include <dmlc/base.h>
+#include <dmlc/io.h>
+#include <dmlc/logging.h>
+#include <dmlc/omp.h>
+#include <dmlc/parameter.h>
+#include <dmlc/threadediter.h>
+#include <mxnet/io.h>
+#include <mxnet/ndarray.h>
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <queue>
+#include <string>
+#include <utility>
+#include <vector>
+#include "./text_iter_common.h"
+
+namespace mxnet {
+namespace io {
+// LibSVM parameters
+struct LibSVMIterParam : public dmlc::Parameter<LibSVMIterParam> {
+    /*! \brief path to data libsvm file */
+    std::string data_libsvm;
+    /*! \brief data shape */
+    TShape data_shape;
+    /*! \brief batch size */
+    int batch_size;
+    /*! \brief number of prefetched batches */
+    int prefetch_buffer;
+    /*! \brief number of threads used to parse a chunk */
+    int preprocess_threads;
+    /*! \brief the size of a parsing chunk in MB */
+    size_t chunk_size;
+    /*! \brief partition the data into multiple parts */
+    int num_parts;
+    /*! \brief the index of the part will read*/
+    int part_index;
+    // declare parameters
+    DMLC_DECLARE_PARAMETER(LibSVMIterParam) {
+        DMLC_DECLARE_FIELD(data_libsvm)
+            .describe("The input LibSVM file or a directory path.");
+        DMLC_DECLARE_FIELD(data_shape)
+            .set_expect_ndim(1)
+            .enforce_nonzero()
+            .describe(
+                "The shape of one example, i.e. (number of features,).");
+        DMLC_DECLARE_FIELD(batch_size)
+            .set_lower_bound(1)
+            .describe("Batch size.");
+        DMLC_DECLARE_FIELD(prefetch_buffer)
+            .set_lower_bound(1)
+            .set_default(4)
+            .describe("Maximum number of batches to prefetch.");
+        DMLC_DECLARE_FIELD(preprocess_threads)
+            .set_lower_bound(1)
+            .set_default(4)
+            .describe("The number of threads used to parse a chunk.");
+        DMLC_DECLARE_FIELD(chunk_size)
+            .set_lower_bound(1)
+            .set_default(16)
+            .describe("The size in MB of the text chunk parsed at once.");
+        DMLC_DECLARE_FIELD(num_parts)
+            .set_default(1)
+            .describe("Virtually partition the data into these many parts.");
+        DMLC_DECLARE_FIELD(part_index)
+            .set_default(0)
+            .describe("The *i*-th virtual partition to be read.");
+    }
+};
+
+/*! \brief rows of a piece of libsvm text in CSR format */
+struct LibSVMBlock {
+    /*! \brief label of each row */
+    std::vector<real_t> label;
+    /*! \brief row i spans [offset[i], offset[i + 1]) of index and value */
+    std::vector<size_t> offset;
+    /*! \brief feature indices */
+    std::vector<int32_t> index;
+    /*! \brief feature values */
+    std::vector<real_t> value;
+    /*! \brief number of rows */
+    inline size_t Size() const { return label.size(); }
+    inline void Clear() {
+        label.clear();
+        offset.assign(1, 0);
+        index.clear();
+        value.clear();
+    }
+};
+
+class LibSVMIter : public IIterator<DataBatch> {
+   public:
+    LibSVMIter() : out_(nullptr) {}
+    virtual ~LibSVMIter() {
+        while (recycle_queue_.size() != 0) {
+            delete recycle_queue_.front();
+            recycle_queue_.pop();
+        }
+        delete out_;
+        iter_.Destroy();
+    }
+
+    virtual void Init(
+        const std::vector<std::pair<std::string, std::string> >& kwargs) {
+        param_.InitAllowUnknown(kwargs);
+        CHECK_LT(param_.part_index, param_.num_parts)
+            << "part_index must be smaller than num_parts";
+        source_.reset(dmlc::InputSplit::Create(param_.data_libsvm.c_str(),
+                                               param_.part_index,
+                                               param_.num_parts, "text"));
+        source_->HintChunkSize(param_.chunk_size << 20UL);
+        blocks_.resize(param_.preprocess_threads);
+        iter_.set_max_capacity(param_.prefetch_buffer);
+        iter_.Init([this](DataBatch** dptr) { return this->FillBatch(dptr); },
+                   [this]() { this->ResetSource(); });
+    }
+
+    virtual void BeforeFirst() { iter_.BeforeFirst(); }
+
+    virtual bool Next() {
+        if (out_ != nullptr) {
+            recycle_queue_.push(out_);
+            out_ = nullptr;
+        }
+        if (recycle_queue_.size() ==
+            static_cast<size_t>(param_.prefetch_buffer)) {
+            DataBatch* old_batch = recycle_queue_.front();
+            for (NDArray& arr : old_batch->data) {
+                arr.WaitToWrite();
+            }
+            recycle_queue_.pop();
+            iter_.Recycle(&old_batch);
+        }
+        return iter_.Next(&out_);
+    }
+
+    virtual const DataBatch& Value(void) const { return *out_; }
+
+   private:
+    inline void ResetSource() {
+        source_->BeforeFirst();
+        for (LibSVMBlock& blk : blocks_) blk.Clear();
+        num_blocks_ = blk_ptr_ = row_ptr_ = 0;
+        inst_counter_ = 0;
+    }
+
+    /*! \brief parse the next chunk into blocks_, false at the end */
+    inline bool ParseNextChunk() {
+        dmlc::InputSplit::Blob chunk;
+        if (!source_->NextChunk(&chunk)) return false;
+        const char* begin = static_cast<const char*>(chunk.dptr);
+        const char* end = begin + chunk.size;
+        std::vector<const char*> range;
+        const int nthread =
+            SplitTextChunk(begin, end, param_.preprocess_threads, &range);
+        const int64_t num_feature = param_.data_shape[0];
+        std::vector<char> parsed(nthread, 1);
+        std::vector<double> bad_index(nthread, 0.0);
+#pragma omp parallel for num_threads(nthread)
+        for (int i = 0; i < nthread; ++i) {
+            parsed[i] = ParseRange(range[i], range[i + 1], num_feature,
+                                   &blocks_[i], &bad_index[i]);
+        }
+        for (int i = 0; i < nthread; ++i) {
+            CHECK(parsed[i])
+                << "Feature index " << bad_index[i]
+                << " is out of range of data_shape=" << param_.data_shape;
+        }
+        num_blocks_ = nthread;
+        blk_ptr_ = row_ptr_ = 0;
+        return true;
+    }
+
+    /*!
+     * \brief parse the lines of [begin, end) into out.
+     *  each line is `label[:weight] index[:value] index[:value] ...`,
+     *  a missing value means 1.
+     * \param bad_index set to the offending feature index on failure
+     * \return false if a feature index is out of range
+     */
+    static inline bool ParseRange(const char* begin, const char* end,
+                                  int64_t num_feature, LibSVMBlock* out,
+                                  double* bad_index) {
+        out->Clear();
+        for (const char* p = begin; p < end;) {
+            const char* lend = SkipTextLine(p, end);
+            if (!IsNonEmptyLine(p, lend)) {
+                p = lend;
+                continue;
+            }
+            const double label = ParseTextNumber(&p, lend);
+            out->label.push_back(static_cast<real_t>(label));
+            // skip the optional instance weight
+            while (p != lend && !isspace(*p)) ++p;
+            while (true) {
+                while (p != lend && isspace(*p)) ++p;
+                if (p == lend) break;
+                const double index = ParseTextNumber(&p, lend);
+                real_t value = 1.0f;
+                if (p != lend && *p == ':') {
+                    ++p;
+                    value = static_cast<real_t>(ParseTextNumber(&p, lend));
+                }
+                if (index < 0 || index >= num_feature) {
+                    *bad_index = index;
+                    return false;
+                }
+                out->index.push_back(static_cast<int32_t>(index));
+                out->value.push_back(value);
+                while (p != lend && !isspace(*p)) ++p;
+            }
+            out->offset.push_back(out->index.size());
+            p = lend;
+        }
+        return true;
+    }
+
+    /*! \brief gather the next batch_size rows into a CSR batch */
+    inline bool FillBatch(DataBatch** dptr) {
+        const index_t batch_size = param_.batch_size;
+        label_.clear();
+        index_.clear();
+        value_.clear();
+        indptr_.assign(1, 0);
+        while (label_.size() < batch_size) {
+            if (blk_ptr_ >= num_blocks_) {
+                if (!this->ParseNextChunk()) break;
+                continue;
+            }
+            const LibSVMBlock& blk = blocks_[blk_ptr_];
+            if (row_ptr_ >= blk.Size()) {
+                ++blk_ptr_;
+                row_ptr_ = 0;
+                continue;
+            }
+            const size_t nrow =
+                std::min(blk.Size() - row_ptr_, batch_size - label_.size());
+            const size_t begin = blk.offset[row_ptr_];
+            const size_t end = blk.offset[row_ptr_ + nrow];
+            const size_t base = index_.size() - begin;
+            for (size_t i = 1; i <= nrow; ++i) {
+                indptr_.push_back(
+                    static_cast<int32_t>(base + blk.offset[row_ptr_ + i]));
+            }
+            label_.insert(label_.end(), blk.label.begin() + row_ptr_,
+                          blk.label.begin() + row_ptr_ + nrow);
+            index_.insert(index_.end(), blk.index.begin() + begin,
+                          blk.index.begin() + end);
+            value_.insert(value_.end(), blk.value.begin() + begin,
+                          blk.value.begin() + end);
+            row_ptr_ += nrow;
+        }
+        if (label_.size() == 0) return false;
+        // pad the last batch with empty rows
+        const int num_pad = batch_size - label_.size();
+        label_.resize(batch_size, 0.0f);
+        indptr_.resize(batch_size + 1, indptr_.back());
+        // arrays can not be empty, keep at least one stored element
+        const index_t nnz = std::max<index_t>(index_.size(), 1);
+        index_.resize(nnz, 0);
+        value_.resize(nnz, 0.0f);
+
+        if (*dptr == nullptr) {
+            *dptr = new DataBatch();
+            (*dptr)->data.resize(4);
+            (*dptr)->index.resize(batch_size);
+            (*dptr)->data[1] = NDArray(mshadow::Shape1(batch_size),
+                                       Context::CPU(), false, mshadow::kFloat32);
+            (*dptr)->data[3] =
+                NDArray(mshadow::Shape1(batch_size + 1), Context::CPU(), false,
+                        mshadow::kInt32);
+        }
+        DataBatch* batch = *dptr;
+        if (batch->data[0].is_none() || batch->data[0].shape()[0] != nnz) {
+            batch->data[0] = NDArray(mshadow::Shape1(nnz), Context::CPU(),
+                                     false, mshadow::kFloat32);
+            batch->data[2] = NDArray(mshadow::Shape1(nnz), Context::CPU(),
+                                     false, mshadow::kInt32);
+        }
+        CopyTo(value_, &batch->data[0]);
+        CopyTo(label_, &batch->data[1]);
+        CopyTo(index_, &batch->data[2]);
+        CopyTo(indptr_, &batch->data[3]);
+        for (index_t i = 0; i < batch_size; ++i) {
+            batch->index[i] = inst_counter_ + i;
+        }
+        inst_counter_ += batch_size - num_pad;
+        batch->num_batch_padd = num_pad;
+        return true;
+    }
+
+    template <typename DType>
+    static inline void CopyTo(const std::vector<DType>& src, NDArray* dst) {
+        CHECK_EQ(dst->shape().Size(), src.size());
+        std::memcpy(dst->data().dptr<DType>(), dmlc::BeginPtr(src),
+                    src.size() * sizeof(DType));
+    }
+
+    LibSVMIterParam param_;
+    /*! \brief text source */
+    std::unique_ptr<dmlc::InputSplit> source_;
+    /*! \brief parsed rows of the current chunk, one block per thread */
+    std::vector<LibSVMBlock> blocks_;
+    /*! \brief number of valid blocks and the cursor into them */
+    size_t num_blocks_{0}, blk_ptr_{0}, row_ptr_{0};
+    /*! \brief instance counter */
+    uint64_t inst_counter_{0};
+    /*! \brief staging buffers of the batch being built */
+    std::vector<real_t> label_, value_;
+    std::vector<int32_t> index_, indptr_;
+    /*! \brief output data */
+    DataBatch* out_;
+    /*! \brief queue to be recycled */
+    std::queue<DataBatch*> recycle_queue_;
+    /*! \brief backend thread */
+    dmlc::ThreadedIter<DataBatch> iter_;
+};
+
+DMLC_REGISTER_PARAMETER(LibSVMIterParam);
+
+MXNET_REGISTER_IO_ITER(LibSVMIter)
+    .describe(R"code(Returns the LibSVM file iterator, which produces batches in CSR format.
+
+Each line of the input is ``label[:weight] index[:value] index[:value] ...``, a missing value
+means 1. Feature indices are used as they appear in the file and must be smaller than
+``data_shape[0]``.
+
+Instead of a dense data array, every batch holds the compressed sparse rows of the batch:
+
+- ``data``: the values of the stored elements, of shape ``(nnz,)``.
+- ``label``: the labels, of shape ``(batch_size,)``.
+- auxiliary array 0: the ``int32`` feature index of each stored element, of shape ``(nnz,)``.
+- auxiliary array 1: the ``int32`` row pointer of shape ``(batch_size + 1,)``; row ``i``
+  is stored in ``[indptr[i], indptr[i+1])`` of the values and indices.
+
+The auxiliary arrays are returned by ``MXDataIterGetAuxData``. A partial last batch is
+padded with empty rows. Chunks of ``chunk_size`` MB are parsed by ``preprocess_threads``
+threads, and ``num_parts`` and ``part_index`` can be used to shard the input.
+
+Examples::
+
+  // Contents of LibSVM file ``data.t``.
+  1.0 0:0.5 2:1.2
+  -2.0
+  -3.0 0:0.6 1:2.4 2:1.2
+  4 2:-1.2
+
+  // Creates a `LibSVMIter` with `batch_size`=3.
+  LibSVMIter = mx.io.LibSVMIter(data_libsvm = 'data.t', data_shape = (3,),
+  batch_size = 3)
+
+  // The first batch
+  data = [0.5, 1.2, 0.6, 2.4, 1.2]
+  label = [1.0, -2.0, -3.0]
+  indices = [0, 2, 0, 1, 2]
+  indptr = [0, 2, 2, 5]
+
+)code" ADD_FILELINE)
+    .add_arguments(LibSVMIterParam::__FIELDS__())
+    .set_body([]() { return new LibSVMIter(); });
+
+}  // namespace io
+}  // namespace mxnet
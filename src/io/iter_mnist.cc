@@ -130,6 +130,18 @@ class MNISTIter : public IIterator<TBlobBatch> {
         }
     }
     virtual const TBlobBatch& Value(void) const { return out_; }
+    // the shuffle order only depends on the seed, so the cursor is enough
+    virtual bool SaveState(dmlc::Stream* fo) const {
+        fo->Write(static_cast<uint64_t>(loc_));
+        return true;
+    }
+    virtual bool LoadState(dmlc::Stream* fi) {
+        uint64_t loc;
+        CHECK(fi->Read(&loc)) << "Invalid MNISTIter state";
+        CHECK_LE(loc, img_.size(0)) << "Invalid MNISTIter state";
+        loc_ = static_cast<index_t>(loc);
+        return true;
+    }
 
    private:
     inline void GetPart(int count, int* start, int* end) {
@@ -9,11 +9,13 @@
 #include <dmlc/logging.h>
 #include <dmlc/optional.h>
 #include <dmlc/threadediter.h>
+#include <dmlc/timer.h>
 #include <mshadow/tensor.h>
 #include <mxnet/base.h>
 #include <mxnet/io.h>
 #include <mxnet/ndarray.h>
 #include <algorithm>
+#include <atomic>
 #include <climits>
 #include <queue>
 #include <string>
@@ -21,6 +23,8 @@
 #include <vector>
 #include "./image_iter_common.h"
 #include "./inst_vector.h"
+#include "./iter_state.h"
+#include "./iter_stats.h"
 
 namespace mxnet {
 namespace io {
@@ -51,6 +55,8 @@ class PrefetcherIter : public IIterator<DataBatch> {
         const int kMaxPrefetchBuffer = 16;
         // init thread iter
         iter_.set_max_capacity(kMaxPrefetchBuffer);
+        // the position before the first batch
+        SaveIterState(*loader_, &state_);
 
         iter_.Init(
             [this](DataBatch **dptr) {
@@ -85,12 +91,30 @@ class PrefetcherIter : public IIterator<DataBatch> {
                               batch.inst_index + batch.batch_size,
                               (*dptr)->index.begin());
                 }
+                std::string state;
+                SaveIterState(*loader_, &state);
+                states_.Push(std::move(state));
+                ++num_produced_;
                 return true;
             },
-            [this]() { loader_->BeforeFirst(); });
+            [this]() {
+                if (pending_state_.empty()) {
+                    loader_->BeforeFirst();
+                } else {
+                    load_ok_ = LoadIterState(pending_state_, loader_.get());
+                    pending_state_.clear();
+                }
+                states_.Clear();
+                SaveIterState(*loader_, &reset_state_);
+                num_produced_ = 0;
+            });
     }
 
-    virtual void BeforeFirst(void) { iter_.BeforeFirst(); }
+    virtual void BeforeFirst(void) {
+        iter_.BeforeFirst();
+        state_ = reset_state_;
+        num_consumed_ = 0;
+    }
 
     virtual bool Next(void) {
         if (out_ != nullptr) {
@@ -107,10 +131,39 @@ class PrefetcherIter : public IIterator<DataBatch> {
             recycle_queue_.pop();
             iter_.Recycle(&old_batch);
         }
-        return iter_.Next(&out_);
+        // batches ready in the prefetch queue, and how long we wait for one
+        stats_.Add("queued_batches", num_produced_ - num_consumed_);
+        const double start = dmlc::GetTime();
+        if (!iter_.Next(&out_)) return false;
+        state_ = states_.Pop();
+        stats_.Add("wait_time", dmlc::GetTime() - start);
+        stats_.Add("num_batches", 1);
+        ++num_consumed_;
+        return true;
     }
     virtual const DataBatch &Value(void) const { return *out_; }
 
+    virtual void GetStats(
+        std::vector<std::pair<std::string, double> > *stats) const {
+        loader_->GetStats(stats);
+        stats_.Append(stats);
+    }
+
+    virtual bool SaveState(dmlc::Stream *fo) const {
+        if (state_.empty()) return false;
+        fo->Write(state_);
+        return true;
+    }
+
+    virtual bool LoadState(dmlc::Stream *fi) {
+        CHECK(fi->Read(&pending_state_)) << "Invalid data iterator state";
+        if (pending_state_.empty()) return false;
+        // restored by the prefetch thread in place of rewinding the loader
+        load_ok_ = false;
+        this->BeforeFirst();
+        return load_ok_;
+    }
+
    protected:
     /*! \brief prefetcher parameters */
     PrefetcherParam param_;
@@ -124,6 +177,20 @@ class PrefetcherIter : public IIterator<DataBatch> {
     std::queue<DataBatch *> recycle_queue_;
     /*! \brief backend thread */
     dmlc::ThreadedIter<DataBatch> iter_;
+    /*! \brief number of batches produced and consumed in this epoch */
+    std::atomic<int64_t> num_produced_{0}, num_consumed_{0};
+    /*! \brief prefetch statistics */
+    IterStats stats_;
+    /*! \brief states of the loader after each prefetched batch */
+    IterStateQueue states_;
+    /*! \brief state after the last batch taken, empty if not supported */
+    std::string state_;
+    /*! \brief state of the loader after it is rewound */
+    std::string reset_state_;
+    /*! \brief state to be restored by the next rewind */
+    std::string pending_state_;
+    /*! \brief whether the loader accepted the restored state */
+    bool load_ok_{false};
 };
 }  // namespace io
 }  // namespace mxnet
@@ -0,0 +1,69 @@
+/*!
+ *  Copyright (c) 2017 by Contributors
+ * \file iter_state.h
+ * \brief helpers to save and restore the position of data iterators
+ */
+#ifndef MXNET_IO_ITER_STATE_H_
+#define MXNET_IO_ITER_STATE_H_
+
+#include <dmlc/io.h>
+#include <dmlc/logging.h>
+#include <dmlc/memory_io.h>
+#include <mxnet/io.h>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <utility>
+
+namespace mxnet {
+namespace io {
+/*!
+ * \brief save the state of an iterator into a string
+ * \return false, leaving out empty, if the iterator does not support it
+ */
+template <typename DType>
+inline bool SaveIterState(const IIterator<DType> &iter, std::string *out) {
+    out->clear();
+    dmlc::MemoryStringStream strm(out);
+    if (iter.SaveState(&strm)) return true;
+    out->clear();
+    return false;
+}
+
+/*! \brief restore the state of an iterator from a string */
+template <typename DType>
+inline bool LoadIterState(const std::string &state, IIterator<DType> *iter) {
+    dmlc::MemoryFixedSizeStream strm(const_cast<char *>(state.data()),
+                                     state.length());
+    return iter->LoadState(&strm);
+}
+
+/*!
+ * \brief states after each batch made by a prefetch thread, in order, so the
+ *  consumer knows the position after each batch it takes
+ */
+class IterStateQueue {
+   public:
+    inline void Push(std::string &&state) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        queue_.push(std::move(state));
+    }
+    inline std::string Pop() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        CHECK(!queue_.empty()) << "no state for the prefetched batch";
+        std::string state = std::move(queue_.front());
+        queue_.pop();
+        return state;
+    }
+    inline void Clear() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        queue_ = std::queue<std::string>();
+    }
+
+   private:
+    std::mutex mutex_;
+    std::queue<std::string> queue_;
+};
+}  // namespace io
+}  // namespace mxnet
+#endif  // MXNET_IO_ITER_STATE_H_
@@ -0,0 +1,54 @@
+/*!
+ *  Copyright (c) 2017 by Contributors
+ * \file iter_stats.h
+ * \brief thread safe statistics collected by the data iterator pipeline
+ */
+#ifndef MXNET_IO_ITER_STATS_H_
+#define MXNET_IO_ITER_STATS_H_
+
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace mxnet {
+namespace io {
+/*!
+ * \brief named accumulators shared by the producer and consumer threads
+ *  of an iterator, e.g. the seconds spent in each stage.
+ */
+class IterStats {
+   public:
+    /*! \brief add value to the statistic of given name */
+    inline void Add(const std::string &name, double value) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        this->Find(name)->second += value;
+    }
+    /*! \brief overwrite the statistic of given name */
+    inline void Set(const std::string &name, double value) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        this->Find(name)->second = value;
+    }
+    /*! \brief append all statistics to out, in the order first seen */
+    inline void Append(
+        std::vector<std::pair<std::string, double> > *out) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        out->insert(out->end(), stats_.begin(), stats_.end());
+    }
+
+   private:
+    inline std::pair<std::string, double> *Find(const std::string &name) {
+        for (auto &kv : stats_) {
+            if (kv.first == name) return &kv;
+        }
+        stats_.emplace_back(name, 0.0);
+        return &stats_.back();
+    }
+    /*! \brief guards stats_ */
+    mutable std::mutex mutex_;
+    /*! \brief the statistics, there are only a handful of them */
+    std::vector<std::pair<std::string, double> > stats_;
+};
+}  // namespace io
+}  // namespace mxnet
+#endif  // MXNET_IO_ITER_STATS_H_
@@ -0,0 +1,127 @@
+/*!
+ *  Copyright (c) 2017 by Contributors
+ * \file text_iter_common.h
+ * \brief helpers shared by the text format data iterators
+ */
+#ifndef MXNET_IO_TEXT_ITER_COMMON_H_
+#define MXNET_IO_TEXT_ITER_COMMON_H_
+
+#include <dmlc/base.h>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace mxnet {
+namespace io {
+/*! \brief whether c ends a numeric field of a csv or libsvm line */
+inline bool IsTextDelimiter(char c) {
+    return c == ',' || c == ':' || c == ' ' || c == '\t' || c == '\r' ||
+           c == '\n';
+}
+
+/*!
+ * \brief parse a number from [*pp, end) and advance *pp past it.
+ *  The common decimal form is handled without calling libc, anything else
+ *  (inf, nan, hex, very long mantissas) falls back to strtod.
+ *  An empty field is parsed as 0.
+ */
+inline double ParseTextNumber(const char **pp, const char *end) {
+    // 10^0 .. 10^22 are exactly representable in double
+    static const double kPow10[] = {
+        1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+    const char *p = *pp;
+    while (p != end && (*p == ' ' || *p == '\t')) ++p;
+    const char *begin = p;
+    bool neg = false;
+    if (p != end && (*p == '-' || *p == '+')) {
+        neg = (*p == '-');
+        ++p;
+    }
+    uint64_t mantissa = 0;
+    int ndigit = 0, exp10 = 0;
+    for (; p != end && *p >= '0' && *p <= '9'; ++p, ++ndigit) {
+        mantissa = mantissa * 10 + (*p - '0');
+    }
+    if (p != end && *p == '.') {
+        for (++p; p != end && *p >= '0' && *p <= '9'; ++p, ++ndigit) {
+            mantissa = mantissa * 10 + (*p - '0');
+            --exp10;
+        }
+    }
+    if (ndigit != 0 && p != end && (*p == 'e' || *p == 'E')) {
+        const char *q = p + 1;
+        bool eneg = false;
+        if (q != end && (*q == '-' || *q == '+')) {
+            eneg = (*q == '-');
+            ++q;
+        }
+        int e = 0;
+        const char *qbegin = q;
+        for (; q != end && *q >= '0' && *q <= '9'; ++q) {
+            e = std::min(e * 10 + (*q - '0'), 100000);
+        }
+        if (q != qbegin) {
+            exp10 += eneg ? -e : e;
+            p = q;
+        }
+    }
+    const bool done = (p == end || IsTextDelimiter(*p));
+    if (ndigit != 0 && ndigit <= 19 && done && exp10 >= -22 && exp10 <= 22) {
+        double value = static_cast<double>(mantissa);
+        value = exp10 < 0 ? value / kPow10[-exp10] : value * kPow10[exp10];
+        *pp = p;
+        return neg ? -value : value;
+    }
+    if (ndigit == 0 && done) {
+        *pp = p;
+        return 0.0;
+    }
+    // slow path, copy the field so that strtod sees a terminated string
+    const char *fend = begin;
+    while (fend != end && !IsTextDelimiter(*fend)) ++fend;
+    std::string field(begin, fend);
+    *pp = fend;
+    return strtod(field.c_str(), nullptr);
+}
+
+/*! \brief return the first char after the line p points into */
+inline const char *SkipTextLine(const char *p, const char *end) {
+    const char *nl = static_cast<const char *>(memchr(p, '\n', end - p));
+    return nl == nullptr ? end : nl + 1;
+}
+
+/*! \brief whether the line starting at p has any content */
+inline bool IsNonEmptyLine(const char *p, const char *end) {
+    while (p != end && (*p == ' ' || *p == '\t' || *p == '\r')) ++p;
+    return p != end && *p != '\n';
+}
+
+/*!
+ * \brief split a chunk of text into line aligned ranges to be parsed
+ *  by different threads, each range gets at least 64KB of text.
+ * \param begin begin of the chunk
+ * \param end end of the chunk
+ * \param max_nthread maximum number of ranges
+ * \param range output, range i is [range[i], range[i + 1])
+ * \return the number of ranges
+ */
+inline int SplitTextChunk(const char *begin, const char *end, int max_nthread,
+                          std::vector<const char *> *range) {
+    const size_t size = end - begin;
+    const int nthread =
+        std::max(1, std::min(max_nthread, static_cast<int>(size >> 16) + 1));
+    range->assign(nthread + 1, end);
+    (*range)[0] = begin;
+    for (int i = 1; i < nthread; ++i) {
+        const char *p = begin + size * i / nthread;
+        p = (p == begin) ? p : SkipTextLine(p - 1, end);
+        (*range)[i] = std::max((*range)[i - 1], p);
+    }
+    return nthread;
+}
+}  // namespace io
+}  // namespace mxnet
+#endif  // MXNET_IO_TEXT_ITER_COMMON_H_
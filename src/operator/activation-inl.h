@@ -16,6 +16,7 @@
 #include <utility>
 #include <vector>
 #include "./operator_common.h"
+#include "./simd_math.h"
 
 namespace mxnet {
 namespace op {
@@ -56,6 +57,11 @@ class ActivationOp : public Operator {
         using namespace mshadow::expr;
         CHECK_EQ(in_data.size(), 1U);
         CHECK_EQ(out_data.size(), 1U);
+        if (SimdMapTo<xpu, ForwardOp>(in_data[activation::kData],
+                                      req[activation::kOut],
+                                      out_data[activation::kOut])) {
+            return;
+        }
         Stream<xpu> *s = ctx.get_stream<xpu>();
         Tensor<xpu, 2, DType> data =
             in_data[activation::kData].FlatTo2D<xpu, DType>(s);
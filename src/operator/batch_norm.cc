@@ -6,6 +6,8 @@
 */
 
 #include <nnvm/op_attr_types.h>
+#include <algorithm>
+#include <vector>
 #include "batch_norm-inl.h"
 #if MXNET_USE_MKL2017 == 1
 #include <mkl_memory.h>
@@ -67,164 +69,155 @@ class DeviceTensor3 {
     TShape shape_;
 };
 
-/*! \brief offset, given indices such as bn, channel, depth, row, column */
-static inline index_t offset(const TShape &shape, const size_t *indices,
-                             const size_t indicesSize) {
-    const size_t dim = shape.ndim();
-    size_t offset = 0;
-    for (size_t i = 0; i < dim; ++i) {
-        offset *= shape[i];
-        if (indicesSize > i) {
-            offset += indices[i];
-        }
-    }
-    return offset;
-}
+/*! \brief elements of a run of one channel a thread handles at a time */
+static const size_t kTileSize = 4096;
 
-/*! \brief Fast-foreach when you don't care about the position other than
- * channel */
-template <typename DType, typename OnData>
-static inline void ForEachFast(const DeviceTensor3<DType> &tensor,
-                               const size_t channel, OnData onData) {
-    const size_t num = tensor.BatchSize();
-    const size_t matrixSize = tensor.SpatialSize();
-
-    size_t indices[2] = {0, channel};
-
-    for (size_t batchItem = 0; batchItem < num; ++batchItem) {
-        indices[0] = batchItem;
-        DType *data =
-            tensor.dptr_ + offset(tensor.shape_, &indices[0],
-                                  sizeof(indices) / sizeof(indices[0]));
-        for (size_t i = 0; i < matrixSize; ++i) {
-            onData(data++);
-        }
-    }
-}
+/*! \brief independent partial sums, so that the sums vectorize */
+static const int kLanes = 8;
 
-/*! \brief Fast-foreach when you don't care about the position other than
- * channel */
-template <typename DType1, typename DType2, typename OnData>
-static inline void ForEachFast(const DeviceTensor3<DType1> &in_data,
-                               const DeviceTensor3<DType2> &out_data,
-                               const size_t channel, OnData onData) {
-    const size_t num = in_data.BatchSize();
-    const size_t matrixSize = in_data.SpatialSize();
-
-    size_t indices[2] = {0, channel};
-
-    for (size_t batchItem = 0; batchItem < num; ++batchItem) {
-        indices[0] = batchItem;
-        const size_t off = offset(in_data.shape_, &indices[0],
-                                  sizeof(indices) / sizeof(indices[0]));
-        const DType1 *data = in_data.dptr_ + off;
-        DType2 *odata = out_data.dptr_ + off;
-        for (size_t i = 0; i < matrixSize; ++i) {
-            onData(data++, odata++);
-        }
+/*!
+ * \brief The data of every channel, one run of the spatial size per batch
+ *  item, cut into tiles of at most kTileSize elements. The tiles are the unit
+ *  of work of the parallel passes, and those of a channel are consecutive.
+ */
+class ChannelTiles {
+   public:
+    template <typename DType>
+    explicit ChannelTiles(const DeviceTensor3<DType> &tensor)
+        : num_(tensor.BatchSize()),
+          channels_(tensor.ChannelCount()),
+          spatial_(tensor.SpatialSize()),
+          per_run_(std::max<size_t>(1, (spatial_ + kTileSize - 1) /
+                                           kTileSize)) {}
+
+    inline int Count() const {
+        return static_cast<int>(channels_ * num_ * per_run_);
     }
-}
 
-/*! \brief Fast-foreach when you don't care about the position other than
- * channel */
-template <typename DType, typename OnData>
-static inline void ForEachFast(const DeviceTensor3<DType> &tensor,
-                               OnData onData) {
-    const size_t num = tensor.BatchSize();
-    const size_t channels = tensor.ChannelCount();
-    const size_t matrixSize = tensor.SpatialSize();
-
-    for (size_t batchItem = 0; batchItem < num; ++batchItem) {
-#pragma openmp for
-        for (size_t channel = 0; channel < channels; ++channel) {
-            size_t indices[2] = {batchItem, channel};
-            const size_t off = offset(tensor.shape_, &indices[0],
-                                      sizeof(indices) / sizeof(indices[0]));
-            const DType *inData = tensor.dptr_ + off;
-            for (size_t i = 0; i < matrixSize; ++i) {
-                onData(channel, inData++);
-            }
-        }
+    /*! \brief number of tiles of one channel */
+    inline size_t PerChannel() const { return num_ * per_run_; }
+
+    /*! \brief channel, offset in the data and length of tile i */
+    inline void Get(const size_t i, size_t *channel, size_t *offset,
+                    size_t *length) const {
+        *channel = i / PerChannel();
+        const size_t item = i % PerChannel() / per_run_;
+        const size_t start = i % per_run_ * kTileSize;
+        *offset = (item * channels_ + *channel) * spatial_ + start;
+        *length = std::min(kTileSize, spatial_ - std::min(start, spatial_));
     }
-}
 
-/*! \brief Fast-foreach when you don't care about the position other than
- * channel */
-template <typename DType, typename OnData>
-static inline void ForEachFast(const DeviceTensor3<DType> &in_data,
-                               const DeviceTensor3<DType> &out_data,
-                               OnData onData) {
-    const size_t num = in_data.BatchSize();
-    const size_t channels = in_data.ChannelCount();
-    const size_t matrixSize = in_data.SpatialSize();
-
-    for (size_t batchItem = 0; batchItem < num; ++batchItem) {
-#pragma omp parallel for
-        for (int channel = 0; channel < channels; ++channel) {
-            size_t indices[2] = {batchItem, static_cast<size_t>(channel)};
-            const size_t off = offset(in_data.shape_, &indices[0],
-                                      sizeof(indices) / sizeof(indices[0]));
-            const DType *inData = in_data.dptr_ + off;
-            DType *outData = out_data.dptr_ + off;
-            for (size_t i = 0; i < matrixSize; ++i) {
-                onData(channel, inData++, outData++);
-            }
+   private:
+    size_t num_, channels_, spatial_, per_run_;
+};
+
+/*! \brief sum of f(i) for i in [0, n) */
+template <typename AccReal, typename F>
+static inline AccReal LaneSum(const size_t n, F f) {
+    AccReal lanes[kLanes] = {0};
+    size_t i = 0;
+    for (; i + kLanes <= n; i += kLanes) {
+        for (int j = 0; j < kLanes; ++j) {
+            lanes[j] += f(i + j);
         }
     }
+    AccReal sum = 0;
+    for (; i < n; ++i) {
+        sum += f(i);
+    }
+    for (int j = 0; j < kLanes; ++j) {
+        sum += lanes[j];
+    }
+    return sum;
 }
 
-/*! \brief Compute the mean of each input channel */
-template <typename DType, typename AccReal>
-static inline void ComputeMean(const DeviceTensor3<DType> &tensor,
-                               AccReal *save_mean) {
-    const size_t channelCount = tensor.ChannelCount();
-
-    for (size_t i = 0; i < channelCount; ++i) {
-        save_mean[i] = 0;
+/*! \brief count, mean and sum of squared deviations of a set of values */
+template <typename AccReal>
+struct WelfordStat {
+    AccReal count, mean, m2;
+
+    /*! \brief the statistics of the values of a tile, read from cache twice */
+    template <typename DType>
+    static inline WelfordStat Of(const DType *data, const size_t n) {
+        WelfordStat ret = {AccReal(n), AccReal(0), AccReal(0)};
+        if (n == 0) return ret;
+        ret.mean = LaneSum<AccReal>(n, [data](size_t i) {
+                       return static_cast<AccReal>(data[i]);
+                   }) /
+                   n;
+        const AccReal mean = ret.mean;
+        ret.m2 = LaneSum<AccReal>(n, [data, mean](size_t i) {
+            const AccReal d = static_cast<AccReal>(data[i]) - mean;
+            return d * d;
+        });
+        return ret;
     }
 
-    ForEachFast(tensor,
-                [&save_mean](const size_t channel, const DType *in_data) {
-                    save_mean[channel] += *in_data;
-                });
-
-    const size_t itemCount = tensor.Size() / channelCount;
-    for (size_t i = 0, n = channelCount; i < n; ++i) {
-        save_mean[i] /= itemCount;
+    /*! \brief add the values of other, by the pairwise update of Chan et al. */
+    inline void Merge(const WelfordStat &other) {
+        if (other.count == 0) return;
+        const AccReal total = count + other.count;
+        const AccReal delta = other.mean - mean;
+        mean += delta * other.count / total;
+        m2 += other.m2 + delta * delta * count * other.count / total;
+        count = total;
     }
-}
+};
 
-/*! \brief Compute the variance of each input channel, as well as update moving
- * mean/variants */
+/*!
+ * \brief The mean and inverse standard deviation of each input channel, in
+ *  one pass over the data: the statistics of all the tiles in parallel, then
+ *  those of every channel merged from its tiles.
+ */
 template <typename DType, typename AccReal>
-static inline void ComputeVariance(const DeviceTensor3<DType> &tensor,
-                                   const AccReal *mean_data, const DType eps,
-                                   const TShape &oshape, AccReal *save_std) {
-    const size_t channels = tensor.ChannelCount();
-    for (size_t i = 0; i < channels; ++i) {
-        save_std[i] = 0;
+static inline void ComputeMeanInvstd(const DeviceTensor3<DType> &tensor,
+                                     const DType eps, AccReal *save_mean,
+                                     AccReal *save_invstd) {
+    const ChannelTiles tiles(tensor);
+    const int count = tiles.Count();
+    std::vector<WelfordStat<AccReal> > stats(count);
+#pragma omp parallel for
+    for (int i = 0; i < count; ++i) {
+        size_t channel, off, length;
+        tiles.Get(i, &channel, &off, &length);
+        stats[i] = WelfordStat<AccReal>::Of(tensor.dptr_ + off, length);
     }
-    ForEachFast(tensor, [&save_std, &mean_data](const index_t channel,
-                                                const DType *current_in_data) {
-        const AccReal mean = mean_data[channel];
-        const AccReal current = *current_in_data;
-        save_std[channel] += (current - mean) * (current - mean);
-    });
-
-    const size_t itemCount = tensor.Size() / channels;
+    const int channels = static_cast<int>(tensor.ChannelCount());
+    const size_t per_channel = tiles.PerChannel();
 #pragma omp parallel for
     for (int channel = 0; channel < channels; ++channel) {
-        const AccReal sum = save_std[channel];
-
-        AccReal invstd;
-        if (sum == 0 && eps == 0.0) {
+        WelfordStat<AccReal> stat = {AccReal(0), AccReal(0), AccReal(0)};
+        for (size_t i = 0; i < per_channel; ++i) {
+            stat.Merge(stats[channel * per_channel + i]);
+        }
+        save_mean[channel] = stat.mean;
+        if (stat.m2 == 0 && eps == 0.0) {
             // Nobody likes to divide by zero
-            invstd = 0;
+            save_invstd[channel] = 0;
         } else {
-            const AccReal variance = sum / itemCount;
-            invstd = VARIANCE_TO_INVSTD(variance, eps);
+            const AccReal variance = stat.m2 / stat.count;
+            save_invstd[channel] = VARIANCE_TO_INVSTD(variance, eps);
+        }
+    }
+}
+
+/*! \brief out = in * scale[channel] + shift[channel] */
+template <typename DType, typename AccReal>
+static inline void ScaleShift(const DeviceTensor3<DType> &in_data,
+                              const DeviceTensor3<DType> &out_data,
+                              const AccReal *scale, const AccReal *shift) {
+    const ChannelTiles tiles(in_data);
+    const int count = tiles.Count();
+#pragma omp parallel for
+    for (int i = 0; i < count; ++i) {
+        size_t channel, off, length;
+        tiles.Get(i, &channel, &off, &length);
+        const DType *in = in_data.dptr_ + off;
+        DType *out = out_data.dptr_ + off;
+        const AccReal a = scale[channel], b = shift[channel];
+        for (size_t j = 0; j < length; ++j) {
+            out[j] = static_cast<DType>(static_cast<AccReal>(in[j]) * a + b);
         }
-        save_std[channel] = invstd;
     }
 }
 
@@ -257,13 +250,9 @@ void BatchNormOp<xpu, DType, AccReal>::DoForward(
         ctx.is_train && !param_.use_global_stats;
 
     if (is_train_and_not_global_stats) {
-        // compute mean per input
-        ComputeMean(inputData, meanVector.dptr<AccReal>());
-
-        // compute variance per input
-        ComputeVariance(inputData, meanVector.dptr<AccReal>(),
-                        static_cast<DType>(param_.eps), varianceVector.shape_,
-                        var);  // var is actually returned as invstd
+        // mean and variance per input, var is actually returned as invstd
+        ComputeMeanInvstd(inputData, static_cast<DType>(param_.eps), mean,
+                          var);
     } else {
         const AccReal *rm = runningMean.dptr<AccReal>();
         const AccReal *rv = runningVariance.dptr<AccReal>();
@@ -278,33 +267,21 @@ void BatchNormOp<xpu, DType, AccReal>::DoForward(
     AccReal *w = weights.dptr<AccReal>();
     const AccReal *b = bias.dptr<AccReal>();
 
-    // note that var is still invstd
-    if (!param_.fix_gamma) {
-        if (IsWriting(req[batchnorm::kData])) {
-            ForEachFast(inputData, outputData, [w, b, mean, var](
-                                                   const size_t channel,
-                                                   const DType *in_data,
-                                                   DType *out_data) {
-                *out_data = static_cast<DType>(
-                    ((*in_data - mean[channel]) * var[channel]) * w[channel] +
-                    b[channel]);
-            });
-        }
-    } else {
-        if (IsWriting(req[batchnorm::kGamma])) {
-            for (size_t i = 0, n = weights.Size(); i < n; ++i) {
-                w[i] = AccReal(1);
-            }
+    if (param_.fix_gamma && IsWriting(req[batchnorm::kGamma])) {
+        for (size_t i = 0, n = weights.Size(); i < n; ++i) {
+            w[i] = AccReal(1);
         }
-        if (IsWriting(req[batchnorm::kData])) {
-            ForEachFast(inputData, outputData, [w, b, mean, var](
-                                                   const size_t channel,
-                                                   const DType *in_data,
-                                                   DType *out_data) {
-                *out_data = static_cast<DType>(
-                    ((*in_data - mean[channel]) * var[channel]) + b[channel]);
-            });
+    }
+    if (IsWriting(req[batchnorm::kData])) {
+        // normalization, scale and shift fold into one affine map per
+        // channel; note that var is still invstd
+        const size_t channelCount = inputData.ChannelCount();
+        std::vector<AccReal> scale(channelCount), shift(channelCount);
+        for (size_t i = 0; i < channelCount; ++i) {
+            scale[i] = param_.fix_gamma ? var[i] : var[i] * w[i];
+            shift[i] = b[i] - mean[i] * scale[i];
         }
+        ScaleShift(inputData, outputData, scale.data(), shift.data());
     }
 }
 
@@ -346,10 +323,10 @@ void BatchNormOp<xpu, DType, AccReal>::DoBackward(
     const bool is_train_and_not_global_stats =
         ctx.is_train && !param_.use_global_stats;
 
-#pragma omp parallel for
-    for (int channel = 0; channel < static_cast<int>(channelCount); ++channel) {
-        AccReal *weight = weights.dptr<AccReal>();
-        const AccReal w = weight ? weight[channel] : AccReal(1);
+    const int channels = static_cast<int>(channelCount);
+    const AccReal *weight = weights.dptr<AccReal>();
+    std::vector<AccReal> means(channelCount), invstds(channelCount);
+    for (int channel = 0; channel < channels; ++channel) {
         AccReal mean, invstd;
         if (is_train_and_not_global_stats) {
             mean = saveMeanDataPtr[channel];
@@ -369,75 +346,102 @@ void BatchNormOp<xpu, DType, AccReal>::DoBackward(
             mean = runningMeanDataPtr[channel];
             invstd = VARIANCE_TO_INVSTD(runningVarDataPtr[channel], param_.eps);
         }
+        means[channel] = mean;
+        invstds[channel] = invstd;
+    }
 
-        // sumGradOut over all gradOutput in feature plane
-        AccReal sumGradOut = 0;
-        ForEachFast(gradOut, static_cast<size_t>(channel),
-                    [&sumGradOut](const DType *gradOut_data) {
-                        sumGradOut += *gradOut_data;
-                    });
-
-        // dot product of the Q(X) and gradOuput
-        AccReal dotp = 0;
-        ForEachFast(inputData, gradOut, static_cast<size_t>(channel),
-                    [&dotp, mean](const DType *thisInputData,
-                                  const DType *gradOut_data) {
-                        dotp += (*thisInputData - mean) * (*gradOut_data);
-                    });
-
-        if (gradIn.shape_.ndim() &&
-            IsWriting(req[batchnorm::kData])) {  // if there's a grad input
-            if (is_train_and_not_global_stats) {
-                // when in training mode
-                // Q(X) = X - E[x] ; i.e. input centered to zero mean
-                // Y = Q(X) / σ    ; i.e. BN output before weight and bias
-                // dL/dX = (Q(dL/dY) - dot(Y, dL/dY) * Y) / σ * w
+    // first pass: sumGradOut over all gradOutput in feature plane, and the
+    // dot product of the Q(X) and gradOuput, per tile then per channel
+    const batchnorm::ChannelTiles tiles(inputData);
+    const int count = tiles.Count();
+    std::vector<AccReal> tileSum(count), tileDot(count);
+#pragma omp parallel for
+    for (int i = 0; i < count; ++i) {
+        size_t channel, off, length;
+        tiles.Get(i, &channel, &off, &length);
+        const DType *in = inputData.dptr_ + off;
+        const DType *gout = gradOut.dptr_ + off;
+        const AccReal mean = means[channel];
+        tileSum[i] = batchnorm::LaneSum<AccReal>(length, [gout](size_t j) {
+            return static_cast<AccReal>(gout[j]);
+        });
+        tileDot[i] =
+            batchnorm::LaneSum<AccReal>(length, [in, gout, mean](size_t j) {
+                return (static_cast<AccReal>(in[j]) - mean) *
+                       static_cast<AccReal>(gout[j]);
+            });
+    }
+    const size_t perChannel = tiles.PerChannel();
+    std::vector<AccReal> sumGradOut(channelCount), dotp(channelCount);
+    for (int channel = 0; channel < channels; ++channel) {
+        AccReal sum = 0, dot = 0;
+        for (size_t i = 0; i < perChannel; ++i) {
+            sum += tileSum[channel * perChannel + i];
+            dot += tileDot[channel * perChannel + i];
+        }
+        sumGradOut[channel] = sum;
+        dotp[channel] = dot;
+    }
 
+    if (gradIn.shape_.ndim() &&
+        IsWriting(req[batchnorm::kData])) {  // if there's a grad input
+        // second pass: dL/dX = gradOut * iw - (k * Q(X) + gradMean) * iw,
+        // with k and gradMean zero in evaluation mode
+        // when in training mode
+        // Q(X) = X - E[x] ; i.e. input centered to zero mean
+        // Y = Q(X) / σ    ; i.e. BN output before weight and bias
+        // dL/dX = (Q(dL/dY) - dot(Y, dL/dY) * Y) / σ * w
+        // when in evaluation mode
+        // dL/dX = w / running_std
+        std::vector<AccReal> iws(channelCount), ks(channelCount),
+            gradMeans(channelCount);
+        for (int channel = 0; channel < channels; ++channel) {
+            const AccReal w = weight ? weight[channel] : AccReal(1);
+            const AccReal invstd = invstds[channel];
+            iws[channel] = invstd * w;
+            if (is_train_and_not_global_stats) {
                 // projection of gradOutput on to output scaled by std
-                const AccReal k = dotp * invstd * invstd / itemCount;
-                ForEachFast(
-                    inputData, gradIn, static_cast<size_t>(channel),
-                    [&mean, &k](const DType *inputDataPtr, DType *gradIn_data) {
-                        *gradIn_data = (*inputDataPtr - mean) * k;
-                    });
-
-                const AccReal iw = invstd * w;
-                const AccReal gradMean = sumGradOut / itemCount;
-                ForEachFast(gradOut, gradIn, static_cast<size_t>(channel),
-                            [iw, gradMean](const DType *gradOut_data,
-                                           DType *gradIn_data) {
-                                *gradIn_data =
-                                    (*gradOut_data - gradMean - *gradIn_data) *
-                                    iw;
-                            });
+                ks[channel] = dotp[channel] * invstd * invstd / itemCount;
+                gradMeans[channel] = sumGradOut[channel] / itemCount;
             } else {
-                // when in evaluation mode
-                // Q(X) = X - running_mean  ; i.e. input centered to zero mean
-                // Y = Q(X) / running_std    ; i.e. BN output before weight and
-                // bias
-                // dL/dX = w / running_std
-                const AccReal iw = invstd * w;
-                ForEachFast(
-                    gradOut, gradIn, static_cast<size_t>(channel),
-                    [iw](const DType *gradOut_data, DType *gradIn_data) {
-                        *gradIn_data = *gradOut_data * iw;
-                    });
+                ks[channel] = 0;
+                gradMeans[channel] = 0;
             }
         }
+#pragma omp parallel for
+        for (int i = 0; i < count; ++i) {
+            size_t channel, off, length;
+            tiles.Get(i, &channel, &off, &length);
+            const DType *in = inputData.dptr_ + off;
+            const DType *gout = gradOut.dptr_ + off;
+            DType *gin = gradIn.dptr_ + off;
+            const AccReal iw = iws[channel], k = ks[channel];
+            const AccReal mean = means[channel];
+            const AccReal gradMean = gradMeans[channel];
+            for (size_t j = 0; j < length; ++j) {
+                gin[j] = static_cast<DType>(
+                    (static_cast<AccReal>(gout[j]) - gradMean -
+                     (static_cast<AccReal>(in[j]) - mean) * k) *
+                    iw);
+            }
+        }
+    }
 
-        // May want to make this a param eventually
-        const AccReal scale = 1.0f;
+    // May want to make this a param eventually
+    const AccReal scale = 1.0f;
 
+    for (int channel = 0; channel < channels; ++channel) {
         if (IsWriting(req[batchnorm::kGamma])) {
             if (!param_.fix_gamma) {
-                gradWeightData[channel] = scale * dotp * invstd;
+                gradWeightData[channel] =
+                    scale * dotp[channel] * invstds[channel];
             } else {
                 gradWeightData[channel] = AccReal(0);
             }
         }
 
         if (IsWriting(req[batchnorm::kBeta])) {
-            gradBiasData[channel] = scale * sumGradOut;
+            gradBiasData[channel] = scale * sumGradOut[channel];
         }
     }
 }
@@ -5,65 +5,24 @@
  * \author Xu Dong
 */
 
+#include <vector>
 #include "./bilinear_sampler-inl.h"
+#include "./nn/bilinear_sampling.h"
 
 namespace mshadow {
 template <typename DType>
-bool between(DType value, int lowerBound, int upperBound) {
-    return (value >= lowerBound && value <= upperBound);
-}
-template <typename DType>
 inline void BilinearSamplerForward(const Tensor<cpu, 4, DType> &output,
                                    const Tensor<cpu, 4, DType> &input,
                                    const Tensor<cpu, 4, DType> &grid_src) {
-    DType *out = output.dptr_;
-    const DType *data = input.dptr_;
-    const DType *grid = grid_src.dptr_;
-    int o_n = output.size(0), o_c = output.size(1), o_h = output.size(2),
-        o_w = output.size(3);
-    int i_c = input.size(1), i_h = input.size(2), i_w = input.size(3);
-    for (index_t n = 0; n < o_n; ++n) {
-        for (index_t c = 0; c < o_c; ++c) {
-            for (index_t h = 0; h < o_h; ++h) {
-                for (index_t w = 0; w < o_w; ++w) {
-                    index_t out_index =
-                        n * o_c * o_h * o_w + c * o_h * o_w + h * o_w + w;
-                    index_t grid_index = n * o_h * o_w * 2 + h * o_w + w;
-                    DType y_real =
-                        (*(grid + grid_index + o_h * o_w) + 1) * (i_h - 1) / 2;
-                    DType x_real = (*(grid + grid_index) + 1) * (i_w - 1) / 2;
-                    int top_left_y = static_cast<int>(floor(y_real));
-                    int top_left_x = static_cast<int>(floor(x_real));
-                    DType top_left_y_w = 1.0 - (y_real - top_left_y);
-                    DType top_left_x_w = 1.0 - (x_real - top_left_x);
-                    int data_index = n * i_c * i_h * i_w + c * i_h * i_w +
-                                     top_left_y * i_w + top_left_x;
-                    DType top_left_v = 0;
-                    DType top_right_v = 0;
-                    DType bottom_left_v = 0;
-                    DType bottom_right_v = 0;
-                    if (between(top_left_x, 0, i_w - 1) &&
-                        between(top_left_y, 0, i_h - 1))
-                        top_left_v = *(data + data_index);
-                    if (between(top_left_x + 1, 0, i_w - 1) &&
-                        between(top_left_y, 0, i_h - 1))
-                        top_right_v = *(data + data_index + 1);
-                    if (between(top_left_x, 0, i_w - 1) &&
-                        between(top_left_y + 1, 0, i_h - 1))
-                        bottom_left_v = *(data + data_index + i_w);
-                    if (between(top_left_x + 1, 0, i_w - 1) &&
-                        between(top_left_y + 1, 0, i_h - 1))
-                        bottom_right_v = *(data + data_index + i_w + 1);
-                    *(out + out_index) =
-                        top_left_v * top_left_y_w * top_left_x_w +
-                        top_right_v * top_left_y_w * (1.0 - top_left_x_w) +
-                        bottom_left_v * (1.0 - top_left_y_w) * top_left_x_w +
-                        bottom_right_v * (1.0 - top_left_y_w) *
-                            (1.0 - top_left_x_w);
-                }
-            }
-        }
-    }
+    using mxnet::op::BilinearTap;
+    int o_n = output.size(0), o_c = output.size(1),
+        o_hw = output.size(2) * output.size(3);
+    int i_h = input.size(2), i_w = input.size(3);
+    std::vector<BilinearTap<DType> > taps(o_n * o_hw);
+    mxnet::op::BilinearTaps(grid_src.dptr_, o_n, o_hw, i_h, i_w, false,
+                            taps.data());
+    mxnet::op::BilinearGather(input.dptr_, taps.data(), o_n, o_c, i_h * i_w,
+                              o_hw, output.dptr_);
 }
 
 template <typename DType>
@@ -72,87 +31,18 @@ inline void BilinearSamplerBackward(const Tensor<cpu, 4, DType> &gdata,
                                     const Tensor<cpu, 4, DType> &output_grad,
                                     const Tensor<cpu, 4, DType> &input_data,
                                     const Tensor<cpu, 4, DType> &grid) {
-    DType *g_input = gdata.dptr_;
-    DType *grad_grid = ggrid.dptr_;
-    const DType *grid_src = grid.dptr_;
-    const DType *grad = output_grad.dptr_;
-    const DType *data = input_data.dptr_;
+    using mxnet::op::BilinearTap;
     int o_n = output_grad.size(0), o_c = output_grad.size(1),
-        o_h = output_grad.size(2), o_w = output_grad.size(3);
-    int i_c = input_data.size(1), i_h = input_data.size(2),
-        i_w = input_data.size(3);
-    for (index_t n = 0; n < o_n; ++n) {
-        for (index_t h = 0; h < o_h; ++h) {
-            for (index_t w = 0; w < o_w; ++w) {
-                DType top_left_y_gw = 0.0;
-                DType top_left_x_gw = 0.0;
-                index_t grid_src_index = n * o_h * o_w * 2 + h * o_w + w;
-                DType y_real = (*(grid_src + grid_src_index + o_h * o_w) + 1) *
-                               (i_h - 1) / 2;
-                DType x_real =
-                    (*(grid_src + grid_src_index) + 1) * (i_w - 1) / 2;
-                int top_left_y = static_cast<int>(floor(y_real));
-                int top_left_x = static_cast<int>(floor(x_real));
-                DType top_left_y_w = 1.0 - (y_real - top_left_y);
-                DType top_left_x_w = 1.0 - (x_real - top_left_x);
-                for (index_t c = 0; c < o_c; ++c) {
-                    index_t grad_index =
-                        n * o_c * o_h * o_w + c * o_h * o_w + h * o_w + w;
-                    int data_index = n * i_c * i_h * i_w + c * i_h * i_w +
-                                     top_left_y * i_w + top_left_x;
-                    // calc 4 vertex value in input data
-                    DType top_left_v = 0;
-                    DType top_right_v = 0;
-                    DType bottom_left_v = 0;
-                    DType bottom_right_v = 0;
-                    // calc input grad
-                    if (between(top_left_x, 0, i_w - 1) &&
-                        between(top_left_y, 0, i_h - 1)) {
-                        *(g_input + data_index) +=
-                            *(grad + grad_index) * top_left_y_w * top_left_x_w;
-                        top_left_v = *(data + data_index);
-                    }
-                    if (between(top_left_x + 1, 0, i_w - 1) &&
-                        between(top_left_y, 0, i_h - 1)) {
-                        *(g_input + data_index + 1) += *(grad + grad_index) *
-                                                       top_left_y_w *
-                                                       (1.0 - top_left_x_w);
-                        top_right_v = *(data + data_index + 1);
-                    }
-                    if (between(top_left_x, 0, i_w - 1) &&
-                        between(top_left_y + 1, 0, i_h - 1)) {
-                        *(g_input + data_index + i_w) += *(grad + grad_index) *
-                                                         (1.0 - top_left_y_w) *
-                                                         top_left_x_w;
-                        bottom_left_v = *(data + data_index + i_w);
-                    }
-                    if (between(top_left_x + 1, 0, i_w - 1) &&
-                        between(top_left_y + 1, 0, i_h - 1)) {
-                        *(g_input + data_index + i_w + 1) +=
-                            *(grad + grad_index) * (1.0 - top_left_y_w) *
-                            (1.0 - top_left_x_w);
-                        bottom_right_v = *(data + data_index + i_w + 1);
-                    }
-                    // calc weight grad of top_left_w, then multiple -1 is the
-                    // grad of grid_src
-                    top_left_y_gw -= *(grad + grad_index) *
-                                     (top_right_v - bottom_right_v +
-                                      (top_left_v - top_right_v -
-                                       bottom_left_v + bottom_right_v) *
-                                          top_left_x_w);
-                    top_left_x_gw -= *(grad + grad_index) *
-                                     (bottom_left_v - bottom_right_v +
-                                      (top_left_v - top_right_v -
-                                       bottom_left_v + bottom_right_v) *
-                                          top_left_y_w);
-                }
-                // calc grad of grid
-                *(grad_grid + grid_src_index + o_h * o_w) +=
-                    top_left_y_gw * (i_h - 1) / 2;
-                *(grad_grid + grid_src_index) += top_left_x_gw * (i_w - 1) / 2;
-            }
-        }
-    }
+        o_hw = output_grad.size(2) * output_grad.size(3);
+    int i_h = input_data.size(2), i_w = input_data.size(3);
+    std::vector<BilinearTap<DType> > taps(o_n * o_hw);
+    mxnet::op::BilinearTaps(grid.dptr_, o_n, o_hw, i_h, i_w, false,
+                            taps.data());
+    mxnet::op::BilinearScatter(output_grad.dptr_, taps.data(), o_n, o_c,
+                               i_h * i_w, o_hw, gdata.dptr_);
+    mxnet::op::BilinearGridGrad(output_grad.dptr_, input_data.dptr_,
+                                taps.data(), o_n, o_c, i_h, i_w, o_hw, true,
+                                ggrid.dptr_);
 }
 }  // namespace mshadow
 
@@ -5,13 +5,63 @@
  * \author Chen Zhu
 */
 #include "./count_sketch-inl.h"
+namespace mshadow {
+// CountSketch Forward, in parallel over the samples
+template <typename DType>
+inline void CountSketchForward(const Tensor<cpu, 2, DType> &out,
+                               const Tensor<cpu, 2, DType> &in,
+                               const Tensor<cpu, 1, DType> &h,
+                               const Tensor<cpu, 1, DType> &s,
+                               const int n_samples,
+                               const int processing_batch_size,
+                               const int in_dim, const int out_dim) {
+#pragma omp parallel for
+    for (int i = 0; i < n_samples; ++i) {
+        DType *out_row = out.dptr_ + static_cast<size_t>(i) * out_dim;
+        const DType *in_row = in.dptr_ + static_cast<size_t>(i) * in_dim;
+        for (int j = 0; j < in_dim; ++j) {
+            out_row[static_cast<int>(h.dptr_[j])] += s.dptr_[j] * in_row[j];
+        }
+    }
+}
+
+template <typename DType>
+inline void CountSketchBackward(const Tensor<cpu, 2, DType> &in_grad,
+                                const Tensor<cpu, 2, DType> &out_grad,
+                                const Tensor<cpu, 1, DType> &h,
+                                const Tensor<cpu, 1, DType> &s,
+                                const int n_samples,
+                                const int processing_batch_size,
+                                const int in_dim, const int out_dim) {
+#pragma omp parallel for
+    for (int i = 0; i < n_samples; ++i) {
+        DType *in_row = in_grad.dptr_ + static_cast<size_t>(i) * in_dim;
+        const DType *out_row =
+            out_grad.dptr_ + static_cast<size_t>(i) * out_dim;
+        for (int j = 0; j < in_dim; ++j) {
+            in_row[j] = out_row[static_cast<int>(h.dptr_[j])] * s.dptr_[j];
+        }
+    }
+}
+}  // namespace mshadow
+
 namespace mxnet {
 namespace op {
 
 template <>
 Operator *CreateOp<cpu>(CountSketchParam param, int dtype) {
-    LOG(FATAL) << "CountSketch is only available for GPU.";
-    return NULL;
+    Operator *op = NULL;
+    switch (dtype) {
+        case mshadow::kFloat32:
+            op = new CountSketchOp<cpu, float>(param);
+            break;
+        case mshadow::kFloat64:
+            op = new CountSketchOp<cpu, double>(param);
+            break;
+        default:
+            LOG(FATAL) << "Unsupported type " << dtype;
+    }
+    return op;
 }
 Operator *CountSketchProp::CreateOperatorEx(Context ctx,
                                             std::vector<TShape> *in_shape,
@@ -28,8 +78,6 @@ MXNET_REGISTER_OP_PROPERTY(_contrib_count_sketch, CountSketchProp)
     .describe(
         R"code(Apply CountSketch to input: map a d-dimension data to k-dimension data"
 
-.. note:: `count_sketch` is only available on GPU.
-
 Assume input data has shape (N, d), sign hash table s has shape (N, d),
 index hash table h has shape (N, d) and mapping dimension out_dim = k,
 each element in s is either +1 or -1, each element in h is random integer from 0 to k-1. 
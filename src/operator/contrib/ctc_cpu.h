@@ -0,0 +1,300 @@
+/*!
+ * Copyright (c) 2017 by Contributors
+ * \file ctc_cpu.h
+ * \brief Connectionist temporal classification loss on cpu. The forward and
+ *  backward variables stay in log space; every time step updates all the
+ *  states of an utterance at once, through vectorized exp and log over the
+ *  arrays of states. The utterances of a minibatch run in parallel, longest
+ *  first, taken by the threads as they become free.
+ */
+#ifndef MXNET_OPERATOR_CONTRIB_CTC_CPU_H_
+#define MXNET_OPERATOR_CONTRIB_CTC_CPU_H_
+
+#include <dmlc/omp.h>
+#include <mxnet/base.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <vector>
+#include "../nn/online_softmax.h"
+#include "../simd_math.h"
+
+namespace mxnet {
+namespace op {
+
+/*! \brief out[i] = exp(in[i]) */
+template <typename DType>
+inline void CTCExp(const DType* in, DType* out, int size) {
+    for (int i = 0; i < size; ++i) out[i] = std::exp(in[i]);
+}
+
+inline void CTCExp(const float* in, float* out, int size) {
+    if (!simd::Enabled() || size < kSoftmaxSimdMin) {
+        CTCExp<float>(in, out, size);
+    } else {
+        simd::Exp(in, out, size);
+    }
+}
+
+/*! \brief out[i] = log(in[i]) */
+template <typename DType>
+inline void CTCLog(const DType* in, DType* out, int size) {
+    for (int i = 0; i < size; ++i) out[i] = std::log(in[i]);
+}
+
+inline void CTCLog(const float* in, float* out, int size) {
+    if (!simd::Enabled() || size < kSoftmaxSimdMin) {
+        CTCLog<float>(in, out, size);
+    } else {
+        simd::Log(in, out, size);
+    }
+}
+
+/*! \brief out = log_softmax(in) over one row of size elements */
+template <typename DType>
+inline void CTCLogSoftmaxRow(const DType* in, DType* out, int size) {
+    const DType lse = SoftmaxRowStat(in, size).LogSumExp();
+    for (int i = 0; i < size; ++i) out[i] = in[i] - lse;
+}
+
+/*!
+ * \brief Per-thread arrays of the recursions, sized for the largest
+ *  utterance the thread has seen.
+ */
+template <typename DType>
+struct CTCScratch {
+    /*! \brief labels with blanks, and whether state s may skip from s - 2 */
+    std::vector<int> labels, skip;
+    /*! \brief log probabilities of the states at one time step */
+    std::vector<DType> emit;
+    /*! \brief the largest of the three terms of every state */
+    std::vector<DType> top;
+    /*! \brief the three terms less top, then their exps */
+    std::vector<DType> terms;
+    /*! \brief the sums of the exps, then their logs */
+    std::vector<DType> sums;
+    /*! \brief beta at the current and the next time step */
+    std::vector<DType> beta, next;
+    /*! \brief expected count of every symbol at one time step */
+    std::vector<DType> occupancy;
+};
+
+/*!
+ * \brief out[s] = log(exp(a[s]) + exp(a[s + d]) + [skip[s]] exp(a[s + 2d]))
+ *  + emit[s] over the S states, where terms outside [0, S) are zero; d is -1
+ *  for the forward variables and 1 for the backward ones.
+ */
+template <typename DType>
+inline void CTCLogSumStep(const DType* a, int S, int d, CTCScratch<DType>* w,
+                          DType* out) {
+    const DType neg_inf = -std::numeric_limits<DType>::infinity();
+    DType* top = w->top.data();
+    DType* t0 = w->terms.data();
+    DType* t1 = t0 + S;
+    DType* t2 = t1 + S;
+    const int* skip = w->skip.data();
+    for (int s = 0; s < S; ++s) {
+        const int s1 = s + d, s2 = s + 2 * d;
+        const DType a0 = a[s];
+        const DType a1 = s1 >= 0 && s1 < S ? a[s1] : neg_inf;
+        const DType a2 = skip[s] ? a[s2] : neg_inf;
+        DType m = a0 > a1 ? a0 : a1;
+        m = m > a2 ? m : a2;
+        // a state no path reaches stays at -inf
+        const bool dead = m == neg_inf;
+        top[s] = m;
+        t0[s] = dead ? neg_inf : a0 - m;
+        t1[s] = dead ? neg_inf : a1 - m;
+        t2[s] = dead ? neg_inf : a2 - m;
+    }
+    CTCExp(t0, t0, 3 * S);
+    DType* sums = w->sums.data();
+    for (int s = 0; s < S; ++s) sums[s] = t0[s] + t1[s] + t2[s];
+    CTCLog(sums, sums, S);
+    const DType* emit = w->emit.data();
+    for (int s = 0; s < S; ++s) out[s] = top[s] + sums[s] + emit[s];
+}
+
+/*! \brief log(exp(a) + exp(b)) */
+template <typename DType>
+inline DType CTCLogAdd(DType a, DType b) {
+    const DType m = std::max(a, b);
+    if (m == -std::numeric_limits<DType>::infinity()) return m;
+    return m + std::log(std::exp(a - m) + std::exp(b - m));
+}
+
+/*!
+ * \brief The loss of one utterance, and the gradient with respect to its
+ *  activations before the softmax if grad is not NULL.
+ * \param log_probs log softmax of the activations at time 0, the next time
+ *  step stride elements further
+ * \param alpha S * T elements, S = 2 * L + 1
+ * \param grad the gradient at time 0, laid out as log_probs
+ */
+template <typename DType>
+inline DType CTCUtterance(const DType* log_probs, int stride, int alphabet,
+                          const int* labels, int L, int T, DType* alpha,
+                          CTCScratch<DType>* w, DType* grad) {
+    const DType neg_inf = -std::numeric_limits<DType>::infinity();
+    const int S = 2 * L + 1;
+    const int blank = 0;
+    w->labels.resize(S);
+    w->skip.resize(S);
+    w->emit.resize(S);
+    w->top.resize(S);
+    w->terms.resize(3 * S);
+    w->sums.resize(S);
+    int repeats = 0;
+    for (int s = 0; s < S; ++s) {
+        w->labels[s] = s % 2 == 0 ? blank : labels[s / 2];
+        w->skip[s] = 0;
+    }
+    for (int i = 1; i < L; ++i) repeats += labels[i] == labels[i - 1];
+    if (T == 0 || L + repeats > T) {
+        // no alignment fits in the input, or there is no input at all and
+        // alpha has no element
+        if (grad != NULL) {
+            for (int t = 0; t < T; ++t) {
+                std::fill(grad + t * stride, grad + t * stride + alphabet,
+                          DType(0));
+            }
+        }
+        return DType(0);
+    }
+    const int* label = w->labels.data();
+    DType* emit = w->emit.data();
+
+    // forward variables; state s may come from s - 2 past a blank between
+    // two different labels
+    for (int s = 2; s < S; ++s) {
+        w->skip[s] = label[s] != blank && label[s] != label[s - 2];
+    }
+    std::fill(alpha, alpha + S, neg_inf);
+    alpha[0] = log_probs[blank];
+    if (S > 1) alpha[1] = log_probs[label[1]];
+    for (int t = 1; t < T; ++t) {
+        const DType* lp = log_probs + t * stride;
+        for (int s = 0; s < S; ++s) emit[s] = lp[label[s]];
+        CTCLogSumStep(alpha + (t - 1) * S, S, -1, w, alpha + t * S);
+    }
+    const DType* last = alpha + (T - 1) * S;
+    const DType loglike =
+        S > 1 ? CTCLogAdd(last[S - 1], last[S - 2]) : last[S - 1];
+    if (grad == NULL) return -loglike;
+
+    // backward variables; state s may go on to s + 2 if s + 2 may skip
+    for (int s = 0; s < S; ++s) {
+        w->skip[s] = s + 2 < S && label[s + 2] != blank &&
+                     label[s + 2] != label[s];
+    }
+    w->beta.assign(S, neg_inf);
+    w->next.resize(S);
+    w->occupancy.resize(alphabet);
+    DType* beta = w->beta.data();
+    DType* occupancy = w->occupancy.data();
+    for (int t = T - 1; t >= 0; --t) {
+        const DType* lp = log_probs + t * stride;
+        for (int s = 0; s < S; ++s) emit[s] = lp[label[s]];
+        if (t == T - 1) {
+            beta[S - 1] = emit[S - 1];
+            if (S > 1) beta[S - 2] = emit[S - 2];
+        } else {
+            std::swap(w->beta, w->next);
+            beta = w->beta.data();
+            CTCLogSumStep(w->next.data(), S, 1, w, beta);
+        }
+        // posterior of every state; alpha and beta both hold the emission
+        DType* post = w->sums.data();
+        const DType* a = alpha + t * S;
+        for (int s = 0; s < S; ++s) {
+            const DType v = a[s] + beta[s] - emit[s] - loglike;
+            post[s] = v != v ? neg_inf : v;
+        }
+        CTCExp(post, post, S);
+        std::fill(occupancy, occupancy + alphabet, DType(0));
+        for (int s = 0; s < S; ++s) occupancy[label[s]] += post[s];
+        DType* g = grad + t * stride;
+        CTCExp(lp, g, alphabet);
+        for (int k = 0; k < alphabet; ++k) g[k] -= occupancy[k];
+    }
+    return -loglike;
+}
+
+/*! \brief elements of workspace CTCLossCpu needs */
+inline size_t CTCLossCpuWorkspaceSize(const int* label_lengths,
+                                      const int* input_lengths,
+                                      int minibatch, int alphabet) {
+    const int max_T = *std::max_element(input_lengths,
+                                        input_lengths + minibatch);
+    size_t size = static_cast<size_t>(max_T) * minibatch * alphabet;
+    for (int b = 0; b < minibatch; ++b) {
+        size += static_cast<size_t>(2 * label_lengths[b] + 1) *
+                input_lengths[b];
+    }
+    return size;
+}
+
+/*!
+ * \brief The ctc loss of a minibatch of activations laid out as (time,
+ *  minibatch, alphabet), blank 0.
+ * \param flat_labels the labels of every utterance one after the other
+ * \param workspace CTCLossCpuWorkspaceSize elements
+ * \param grads the gradient of every cost with respect to the activations,
+ *  zero past the end of an utterance; NULL to only compute the costs
+ */
+template <typename DType>
+inline void CTCLossCpu(const DType* activations, const int* flat_labels,
+                       const int* label_lengths, const int* input_lengths,
+                       int minibatch, int alphabet, DType* workspace,
+                       DType* costs, DType* grads) {
+    const int max_T = *std::max_element(input_lengths,
+                                        input_lengths + minibatch);
+    const int stride = minibatch * alphabet;
+    DType* log_probs = workspace;
+    const int rows = max_T * minibatch;
+#pragma omp parallel for
+    for (int r = 0; r < rows; ++r) {
+        CTCLogSoftmaxRow(activations + static_cast<size_t>(r) * alphabet,
+                         log_probs + static_cast<size_t>(r) * alphabet,
+                         alphabet);
+    }
+    std::vector<int> label_offset(minibatch + 1, 0);
+    std::vector<size_t> alpha_offset(minibatch + 1, 0);
+    for (int b = 0; b < minibatch; ++b) {
+        label_offset[b + 1] = label_offset[b] + label_lengths[b];
+        alpha_offset[b + 1] =
+            alpha_offset[b] +
+            static_cast<size_t>(2 * label_lengths[b] + 1) * input_lengths[b];
+    }
+    DType* alphas = log_probs + static_cast<size_t>(rows) * alphabet;
+    // the longest utterances first, so that the short ones fill in the end
+    std::vector<int> order(minibatch);
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](int a, int b) {
+        return alpha_offset[a + 1] - alpha_offset[a] >
+               alpha_offset[b + 1] - alpha_offset[b];
+    });
+#pragma omp parallel
+    {
+        CTCScratch<DType> scratch;
+#pragma omp for schedule(dynamic, 1)
+        for (int i = 0; i < minibatch; ++i) {
+            const int b = order[i];
+            const int T = input_lengths[b];
+            DType* grad = grads == NULL ? NULL : grads + b * alphabet;
+            costs[b] = CTCUtterance(
+                log_probs + b * alphabet, stride, alphabet,
+                flat_labels + label_offset[b], label_lengths[b], T,
+                alphas + alpha_offset[b], &scratch, grad);
+            for (int t = T; grad != NULL && t < max_T; ++t) {
+                std::fill(grad + t * stride, grad + t * stride + alphabet,
+                          DType(0));
+            }
+        }
+    }
+}
+
+}  // namespace op
+}  // namespace mxnet
+#endif  // MXNET_OPERATOR_CONTRIB_CTC_CPU_H_
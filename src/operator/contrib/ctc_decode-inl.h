@@ -0,0 +1,239 @@
+/*!
+ *  Copyright (c) 2017 by Contributors
+ * \file ctc_decode-inl.h
+ * \brief greedy and prefix beam search decoding of the outputs of a network
+ *  trained with the ctc loss
+ */
+#ifndef MXNET_OPERATOR_CONTRIB_CTC_DECODE_INL_H_
+#define MXNET_OPERATOR_CONTRIB_CTC_DECODE_INL_H_
+
+#include <dmlc/parameter.h>
+#include <mxnet/operator_util.h>
+#include <stdint.h>
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <unordered_map>
+#include <vector>
+#include "../elemwise_op_common.h"
+#include "../operator_common.h"
+#include "./ctc_cpu.h"
+
+namespace mxnet {
+namespace op {
+
+struct CTCBeamDecodeParam : public dmlc::Parameter<CTCBeamDecodeParam> {
+    int beam_size;
+    DMLC_DECLARE_PARAMETER(CTCBeamDecodeParam) {
+        DMLC_DECLARE_FIELD(beam_size)
+            .set_default(10)
+            .set_lower_bound(1)
+            .describe("Number of prefixes kept at every time step.");
+    }
+};
+
+/*! \brief data (sequence_length, batch_size, alphabet_size + 1) */
+inline bool CTCDecodeShape(const nnvm::NodeAttrs& attrs,
+                           std::vector<TShape>* in_attrs,
+                           std::vector<TShape>* out_attrs) {
+    const TShape& dshape = (*in_attrs)[0];
+    if (dshape.ndim() == 0) return false;
+    CHECK_EQ(dshape.ndim(), 3U) << "The data array must be of rank 3.";
+    SHAPE_ASSIGN_CHECK(*out_attrs, 0, mshadow::Shape2(dshape[1], dshape[0]));
+    return true;
+}
+
+/*! \brief write labels to out, then pad it with 0 up to size */
+template <typename DType>
+inline void CTCWriteLabels(const std::vector<int>& labels, int size,
+                           DType* out) {
+    for (int i = 0; i < size; ++i) {
+        out[i] = DType(i < static_cast<int>(labels.size()) ? labels[i] : 0);
+    }
+}
+
+/*!
+ * \brief The label of highest activation at every time step, with repeats
+ *  merged and blanks removed.
+ */
+template <typename DType>
+inline void CTCGreedyDecode(const DType* data, int seq_len, int batch,
+                            int alphabet, DType* out) {
+#pragma omp parallel for
+    for (int b = 0; b < batch; ++b) {
+        std::vector<int> labels;
+        int prev = 0;
+        for (int t = 0; t < seq_len; ++t) {
+            const DType* row =
+                data + (static_cast<size_t>(t) * batch + b) * alphabet;
+            const int k = std::max_element(row, row + alphabet) - row;
+            if (k != 0 && k != prev) labels.push_back(k);
+            prev = k;
+        }
+        CTCWriteLabels(labels, seq_len, out + static_cast<size_t>(b) * seq_len);
+    }
+}
+
+/*!
+ * \brief A prefix of the beam search, and the log probabilities of the
+ *  paths that collapse to it and end in a blank or in its last label.
+ */
+template <typename DType>
+struct CTCPrefix {
+    /*! \brief node of the prefix in the trie, -1 if it is not there yet */
+    int node;
+    /*! \brief the prefix it extends by label, for a prefix not in the trie */
+    int parent, label;
+    DType end_blank, end_label;
+    inline DType Score() const { return CTCLogAdd(end_blank, end_label); }
+};
+
+/*!
+ * \brief The likeliest labelling of one sequence by prefix beam search,
+ *  without a language model.
+ * \param data the activations at time 0, the next time step stride elements
+ *  further
+ */
+template <typename DType>
+inline void CTCBeamDecodeOne(const DType* data, int stride, int seq_len,
+                             int alphabet, int beam_size,
+                             std::vector<int>* labels) {
+    typedef CTCPrefix<DType> Prefix;
+    const DType neg_inf = -std::numeric_limits<DType>::infinity();
+    // the trie of all the prefixes ever kept, node 0 is the empty prefix;
+    // the last label of the empty prefix is the blank
+    std::vector<int> parent(1, -1), last(1, 0);
+    std::unordered_map<int64_t, int> child;
+    std::vector<Prefix> beams(1, Prefix{0, -1, 0, DType(0), neg_inf});
+    std::vector<Prefix> cands;
+    // a candidate is keyed by its node, or by -1 - (parent * alphabet +
+    // label) while it is not in the trie
+    std::unordered_map<int64_t, int> index;
+    std::vector<DType> lp(alphabet);
+    std::vector<int> top(alphabet - 1), extend;
+    std::iota(top.begin(), top.end(), 1);
+    // a new prefix whose last label is not among the beam_size + 1 likeliest
+    // has beam_size likelier siblings, so it cannot be kept
+    const int num_top = std::min(alphabet - 1, beam_size + 1);
+    auto find = [&](int node, int par, int label) -> Prefix& {
+        if (node < 0) {
+            auto it = child.find(static_cast<int64_t>(par) * alphabet + label);
+            if (it != child.end()) node = it->second;
+        }
+        const int64_t key =
+            node >= 0 ? node
+                      : -1 - (static_cast<int64_t>(par) * alphabet + label);
+        auto res = index.emplace(key, static_cast<int>(cands.size()));
+        if (res.second) {
+            cands.push_back(Prefix{node, par, label, neg_inf, neg_inf});
+        }
+        return cands[res.first->second];
+    };
+    for (int t = 0; t < seq_len; ++t) {
+        CTCLogSoftmaxRow(data + static_cast<size_t>(t) * stride, lp.data(),
+                         alphabet);
+        if (num_top > 0) {
+            std::nth_element(top.begin(), top.begin() + (num_top - 1),
+                             top.end(),
+                             [&](int a, int b) { return lp[a] > lp[b]; });
+        }
+        cands.clear();
+        index.clear();
+        for (const Prefix& beam : beams) {
+            const DType total = beam.Score();
+            const int n = beam.node;
+            {
+                // a blank, or the last label again, keep the prefix
+                Prefix& same = find(n, -1, 0);
+                same.end_blank = CTCLogAdd(same.end_blank, total + lp[0]);
+                same.end_label =
+                    CTCLogAdd(same.end_label, beam.end_label + lp[last[n]]);
+            }
+            // the likeliest labels, and those leading to other kept prefixes
+            extend.assign(top.begin(), top.begin() + num_top);
+            for (const Prefix& other : beams) {
+                if (parent[other.node] == n) extend.push_back(last[other.node]);
+            }
+            std::sort(extend.begin(), extend.end());
+            extend.erase(std::unique(extend.begin(), extend.end()),
+                         extend.end());
+            for (int c : extend) {
+                Prefix& next = find(-1, n, c);
+                // the last label again only extends after a blank
+                const DType from = c == last[n] ? beam.end_blank : total;
+                next.end_label = CTCLogAdd(next.end_label, from + lp[c]);
+            }
+        }
+        const int num_keep =
+            std::min(beam_size, static_cast<int>(cands.size()));
+        std::partial_sort(cands.begin(), cands.begin() + num_keep, cands.end(),
+                          [](const Prefix& a, const Prefix& b) {
+                              return a.Score() > b.Score();
+                          });
+        beams.assign(cands.begin(), cands.begin() + num_keep);
+        for (Prefix& beam : beams) {
+            if (beam.node >= 0) continue;
+            beam.node = static_cast<int>(parent.size());
+            parent.push_back(beam.parent);
+            last.push_back(beam.label);
+            child[static_cast<int64_t>(beam.parent) * alphabet + beam.label] =
+                beam.node;
+        }
+    }
+    labels->clear();
+    for (int n = beams[0].node; n != 0; n = parent[n]) {
+        labels->push_back(last[n]);
+    }
+    std::reverse(labels->begin(), labels->end());
+}
+
+template <typename DType>
+inline void CTCBeamDecode(const DType* data, int seq_len, int batch,
+                          int alphabet, int beam_size, DType* out) {
+#pragma omp parallel for schedule(dynamic, 1)
+    for (int b = 0; b < batch; ++b) {
+        std::vector<int> labels;
+        CTCBeamDecodeOne(data + static_cast<size_t>(b) * alphabet,
+                         batch * alphabet, seq_len, alphabet, beam_size,
+                         &labels);
+        CTCWriteLabels(labels, seq_len, out + static_cast<size_t>(b) * seq_len);
+    }
+}
+
+/*! \brief float16 has no beam search */
+inline void CTCBeamDecode(const mshadow::half::half_t* data, int seq_len,
+                          int batch, int alphabet, int beam_size,
+                          mshadow::half::half_t* out) {
+    LOG(FATAL) << "ctc_beam_decode does not support float16";
+}
+
+inline void CTCGreedyDecodeCompute(const nnvm::NodeAttrs& attrs,
+                                   const OpContext& ctx,
+                                   const std::vector<TBlob>& inputs,
+                                   const std::vector<OpReqType>& req,
+                                   const std::vector<TBlob>& outputs) {
+    const TBlob& data = inputs[0];
+    MSHADOW_REAL_TYPE_SWITCH(data.type_flag_, DType, {
+        CTCGreedyDecode(data.dptr<DType>(), data.shape_[0], data.shape_[1],
+                        data.shape_[2], outputs[0].dptr<DType>());
+    });
+}
+
+inline void CTCBeamDecodeCompute(const nnvm::NodeAttrs& attrs,
+                                 const OpContext& ctx,
+                                 const std::vector<TBlob>& inputs,
+                                 const std::vector<OpReqType>& req,
+                                 const std::vector<TBlob>& outputs) {
+    const CTCBeamDecodeParam& param =
+        nnvm::get<CTCBeamDecodeParam>(attrs.parsed);
+    const TBlob& data = inputs[0];
+    MSHADOW_REAL_TYPE_SWITCH(data.type_flag_, DType, {
+        CTCBeamDecode(data.dptr<DType>(), data.shape_[0], data.shape_[1],
+                      data.shape_[2], param.beam_size,
+                      outputs[0].dptr<DType>());
+    });
+}
+
+}  // namespace op
+}  // namespace mxnet
+#endif  // MXNET_OPERATOR_CONTRIB_CTC_DECODE_INL_H_
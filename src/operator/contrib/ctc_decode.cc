@@ -0,0 +1,52 @@
+/*!
+ *  Copyright (c) 2017 by Contributors
+ * \file ctc_decode.cc
+ * \brief decoders of the outputs of a network trained with the ctc loss
+ */
+#include "./ctc_decode-inl.h"
+
+namespace mxnet {
+namespace op {
+DMLC_REGISTER_PARAMETER(CTCBeamDecodeParam);
+
+NNVM_REGISTER_OP(_contrib_ctc_greedy_decode)
+    .describe(R"code(Decodes the activations of a network trained with the
+connectionist temporal classification loss by taking the label of highest
+activation at every time step, merging repeated labels and removing blanks.
+
+The input has the layout of the data of ``ctc_loss``, (sequence_length,
+batch_size, alphabet_size + 1) with the blank at index 0. The output is
+(batch_size, sequence_length), the labels of every sequence followed by zeros.
+)code" ADD_FILELINE)
+    .set_num_inputs(1)
+    .set_num_outputs(1)
+    .set_attr<nnvm::FInferShape>("FInferShape", CTCDecodeShape)
+    .set_attr<nnvm::FInferType>("FInferType", ElemwiseType<1, 1>)
+    .set_attr<FCompute>("FCompute<cpu>", CTCGreedyDecodeCompute)
+    .set_attr<nnvm::FGradient>("FGradient", MakeZeroGradNodes)
+    .add_argument("data", "NDArray-or-Symbol", "Input data to the decoder.");
+
+NNVM_REGISTER_OP(_contrib_ctc_beam_decode)
+    .describe(R"code(Decodes the activations of a network trained with the
+connectionist temporal classification loss by prefix beam search: the
+``beam_size`` likeliest label sequences are kept at every time step, each
+scored by the probability of all the alignments that collapse to it, and the
+likeliest at the end is returned. No language model is applied.
+
+The input has the layout of the data of ``ctc_loss``, (sequence_length,
+batch_size, alphabet_size + 1) with the blank at index 0; a softmax over the
+last axis is applied. The output is (batch_size, sequence_length), the labels
+of every sequence followed by zeros. Only float32 and float64 are supported.
+)code" ADD_FILELINE)
+    .set_attr_parser(ParamParser<CTCBeamDecodeParam>)
+    .set_num_inputs(1)
+    .set_num_outputs(1)
+    .set_attr<nnvm::FInferShape>("FInferShape", CTCDecodeShape)
+    .set_attr<nnvm::FInferType>("FInferType", ElemwiseType<1, 1>)
+    .set_attr<FCompute>("FCompute<cpu>", CTCBeamDecodeCompute)
+    .set_attr<nnvm::FGradient>("FGradient", MakeZeroGradNodes)
+    .add_argument("data", "NDArray-or-Symbol", "Input data to the decoder.")
+    .add_arguments(CTCBeamDecodeParam::__FIELDS__());
+
+}  // namespace op
+}  // namespace mxnet
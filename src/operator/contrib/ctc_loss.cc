@@ -5,7 +5,6 @@
  * \author Sebastian Bodenstein
 */
 
-#include "./ctc_include/detail/cpu_ctc.h"
 #include "./ctc_loss-inl.h"
 
 namespace mshadow {
@@ -17,14 +16,11 @@ ctcStatus_t compute_ctc_cost(const Tensor<cpu, 3, DType> activations,
                              void *workspace, int train) {
     int minibatch = static_cast<int>(activations.size(1));
     int alphabet_size = static_cast<int>(activations.size(2));
-    int blank_label = 0;
-    CpuCTC<DType> ctc(alphabet_size, minibatch, workspace, blank_label);
-    if (train)
-        return ctc.cost_and_grad(activations.dptr_, grads, costs, labels,
-                                 label_lengths, input_lengths);
-    else
-        return ctc.score_forward(activations.dptr_, costs, labels,
-                                 label_lengths, input_lengths);
+    mxnet::op::CTCLossCpu(activations.dptr_, labels, label_lengths,
+                          input_lengths, minibatch, alphabet_size,
+                          static_cast<DType *>(workspace), costs,
+                          train ? grads : NULL);
+    return CTC_STATUS_SUCCESS;
 }
 
 }  // namespace mshadow
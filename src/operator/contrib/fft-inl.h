@@ -15,6 +15,7 @@
 #include <vector>
 #include "../mshadow_op.h"
 #include "../operator_common.h"
+#include "./fft_plan.h"
 
 #if MXNET_USE_CUDA
 #include <cufft.h>
@@ -86,6 +87,11 @@ class FFTOp : public Operator {
             out_data[fft::kOutComplex].get_with_shape<xpu, 2, DType>(
                 Shape2(n_ffts, dim_ * 2), s);
 
+        if (xpu::kDevCPU) {
+            RealFFTRows(data.dptr_, out.dptr_, n_ffts, dim_,
+                        req[fft::kOutComplex]);
+            return;
+        }
         // need temp space to pad the data into complex numbers due to cufft
         // interface
         Tensor<xpu, 1, DType> workspace =
@@ -159,6 +165,11 @@ class FFTOp : public Operator {
         Tensor<xpu, 2, DType> grad =
             out_grad[fft::kOutComplex].get_with_shape<xpu, 2, DType>(
                 Shape2(n_ffts, dim_ * 2), s);
+        if (xpu::kDevCPU) {
+            ComplexIFFTRealRows(grad.dptr_, gdata.dptr_, n_ffts, dim_,
+                                req[fft::kData]);
+            return;
+        }
         // need temp space to pad the data into complex numbers due to cufft
         // interface
         Tensor<xpu, 1, DType> workspace =
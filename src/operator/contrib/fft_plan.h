@@ -0,0 +1,271 @@
+/*!
+ * Copyright (c) 2017 by Contributors
+ * \file fft_plan.h
+ * \brief Mixed-radix fast Fourier transform on cpu for the fft, ifft
+ *  operators. A plan holds the factors and twiddles of one size; plans are
+ *  created on first use and cached per size for the life of the process.
+ */
+#ifndef MXNET_OPERATOR_CONTRIB_FFT_PLAN_H_
+#define MXNET_OPERATOR_CONTRIB_FFT_PLAN_H_
+
+#include <dmlc/logging.h>
+#include <mshadow/base.h>
+#include <mxnet/base.h>
+#include <mxnet/operator.h>
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace mxnet {
+namespace op {
+
+/*!
+ * \brief a * b, without the checks for infinite and nan parts that make
+ *  operator* of std::complex a library call
+ */
+template <typename DType>
+inline std::complex<DType> ComplexMul(const std::complex<DType>& a,
+                                      const std::complex<DType>& b) {
+    return std::complex<DType>(a.real() * b.real() - a.imag() * b.imag(),
+                               a.real() * b.imag() + a.imag() * b.real());
+}
+
+template <typename DType>
+class FFTPlan {
+   public:
+    typedef std::complex<DType> Complex;
+    /*! \brief the shared plan of size n, safe to call from any thread */
+    static const FFTPlan* Get(int n) {
+        static std::mutex mutex;
+        static std::map<int, std::unique_ptr<FFTPlan> > plans;
+        std::lock_guard<std::mutex> lock(mutex);
+        std::unique_ptr<FFTPlan>& plan = plans[n];
+        if (!plan) plan.reset(new FFTPlan(n));
+        return plan.get();
+    }
+    inline int size() const { return n_; }
+    /*! \brief the number of scratch elements Forward needs */
+    inline int scratch_size() const { return max_radix_; }
+    /*! \brief exp(-2 pi i k / n) */
+    inline const Complex& twiddle(int k) const { return twiddles_[k]; }
+    /*!
+     * \brief out[k] = sum_j in[j * stride] exp(-2 pi i j k / n), without
+     *  normalization. out must not overlap in.
+     */
+    inline void Forward(const Complex* in, int stride, Complex* out,
+                        Complex* scratch) const {
+        Work(out, in, 1, stride, factors_.data(), scratch);
+    }
+
+   private:
+    explicit FFTPlan(int n) : n_(n), max_radix_(1), twiddles_(n) {
+        CHECK_GT(n, 0) << "fft size must be positive";
+        const double pi = 3.14159265358979323846;
+        for (int k = 0; k < n; ++k) {
+            const double phase = -2.0 * pi * k / n;
+            twiddles_[k] = Complex(DType(std::cos(phase)),
+                                   DType(std::sin(phase)));
+        }
+        // radix 4 first, then 2, then the odd factors in increasing order;
+        // a prime left over above sqrt(n) is a single generic stage
+        const int sqrt_n = static_cast<int>(std::sqrt(static_cast<double>(n)));
+        int p = 4;
+        do {
+            while (n % p != 0) {
+                p = p == 4 ? 2 : (p == 2 ? 3 : p + 2);
+                if (p > sqrt_n) p = n;
+            }
+            n /= p;
+            factors_.push_back(p);
+            factors_.push_back(n);
+            max_radix_ = std::max(max_radix_, p);
+        } while (n > 1);
+    }
+    /*!
+     * \brief Decimation in time: the p interleaved subsequences of length m
+     *  are transformed into consecutive blocks of out, then combined by the
+     *  butterflies of radix p.
+     */
+    void Work(Complex* out, const Complex* in, int fstride, int in_stride,
+              const int* factors, Complex* scratch) const {
+        const int p = factors[0], m = factors[1];
+        const int step = fstride * in_stride;
+        if (m == 1) {
+            for (int q = 0; q < p; ++q) out[q] = in[q * step];
+        } else {
+            for (int q = 0; q < p; ++q) {
+                Work(out + q * m, in + q * step, fstride * p, in_stride,
+                     factors + 2, scratch);
+            }
+        }
+        switch (p) {
+            case 2:
+                Radix2(out, fstride, m);
+                break;
+            case 4:
+                Radix4(out, fstride, m);
+                break;
+            default:
+                RadixGeneric(out, fstride, m, p, scratch);
+        }
+    }
+    void Radix2(Complex* out, int fstride, int m) const {
+        for (int k = 0; k < m; ++k) {
+            const Complex t = ComplexMul(out[k + m], twiddles_[k * fstride]);
+            out[k + m] = out[k] - t;
+            out[k] += t;
+        }
+    }
+    void Radix4(Complex* out, int fstride, int m) const {
+        for (int k = 0; k < m; ++k) {
+            const Complex s0 = ComplexMul(out[k + m], twiddles_[k * fstride]);
+            const Complex s1 =
+                ComplexMul(out[k + 2 * m], twiddles_[2 * k * fstride]);
+            const Complex s2 =
+                ComplexMul(out[k + 3 * m], twiddles_[3 * k * fstride]);
+            const Complex s3 = s0 + s2, s4 = s0 - s2, s5 = out[k] - s1;
+            const Complex s6 = out[k] + s1;
+            // s4 * -i
+            const Complex s7(s4.imag(), -s4.real());
+            out[k] = s6 + s3;
+            out[k + 2 * m] = s6 - s3;
+            out[k + m] = s5 + s7;
+            out[k + 3 * m] = s5 - s7;
+        }
+    }
+    void RadixGeneric(Complex* out, int fstride, int m, int p,
+                      Complex* scratch) const {
+        for (int u = 0; u < m; ++u) {
+            for (int q = 0; q < p; ++q) scratch[q] = out[u + q * m];
+            for (int q = 0; q < p; ++q) {
+                const int k = u + q * m;
+                Complex sum = scratch[0];
+                int t = 0;
+                for (int r = 1; r < p; ++r) {
+                    t += fstride * k;
+                    t %= n_;
+                    sum += ComplexMul(scratch[r], twiddles_[t]);
+                }
+                out[k] = sum;
+            }
+        }
+    }
+
+    int n_;
+    int max_radix_;
+    std::vector<Complex> twiddles_;
+    /*! \brief pairs of (radix p, length m of the subsequences) */
+    std::vector<int> factors_;
+};
+
+/*!
+ * \brief The fft of the real in of even size n, from one complex fft of size
+ *  n / 2 over the pairs (in[2j], in[2j + 1]).
+ * \param scratch n / 2 + half.scratch_size() elements
+ */
+template <typename DType>
+inline void RealFFT(const FFTPlan<DType>& full, const FFTPlan<DType>& half,
+                    const DType* in, std::complex<DType>* out,
+                    std::complex<DType>* scratch) {
+    typedef std::complex<DType> Complex;
+    const int h = half.size();
+    Complex* z = out + h;
+    half.Forward(reinterpret_cast<const Complex*>(in), 1, z, scratch);
+    // the fft of the even and of the odd elements are
+    // (z[k] + conj(z[h - k])) / 2 and (z[k] - conj(z[h - k])) / 2i
+    std::copy(z, z + h, scratch);
+    for (int k = 0; k <= h; ++k) {
+        const Complex a = scratch[k % h], b = std::conj(scratch[(h - k) % h]);
+        const Complex even = DType(0.5) * (a + b);
+        // (a - b) / 2i
+        const Complex odd(DType(0.5) * (a.imag() - b.imag()),
+                          DType(-0.5) * (a.real() - b.real()));
+        out[k] = even + ComplexMul(full.twiddle(k), odd);
+    }
+    for (int k = h + 1; k < 2 * h; ++k) out[k] = std::conj(out[2 * h - k]);
+}
+
+/*!
+ * \brief The rows of out are the ffts of the real rows of in, of length n,
+ *  as interleaved [real, imag] pairs. The rows are spread over the threads.
+ */
+template <typename DType>
+inline void RealFFTRows(const DType* in, DType* out, int num_rows, int n,
+                        OpReqType req) {
+    typedef std::complex<DType> Complex;
+    if (req == kNullOp) return;
+    const FFTPlan<DType>* full = FFTPlan<DType>::Get(n);
+    const FFTPlan<DType>* half = n % 2 == 0 ? FFTPlan<DType>::Get(n / 2) : NULL;
+    const int scratch_size =
+        half ? half->size() + half->scratch_size() : n + full->scratch_size();
+#pragma omp parallel
+    {
+        std::vector<Complex> scratch(scratch_size), sum(n);
+#pragma omp for
+        for (int i = 0; i < num_rows; ++i) {
+            const DType* row = in + static_cast<size_t>(i) * n;
+            Complex* row_out = reinterpret_cast<Complex*>(
+                out + static_cast<size_t>(i) * 2 * n);
+            Complex* res = req == kAddTo ? sum.data() : row_out;
+            if (half) {
+                RealFFT(*full, *half, row, res, scratch.data());
+            } else {
+                for (int j = 0; j < n; ++j) scratch[j] = Complex(row[j]);
+                full->Forward(scratch.data(), 1, res, scratch.data() + n);
+            }
+            if (req == kAddTo) {
+                for (int j = 0; j < n; ++j) row_out[j] += res[j];
+            }
+        }
+    }
+}
+
+/*!
+ * \brief The rows of out are the real parts of the unnormalized inverse ffts
+ *  of the complex rows of in, of length n as interleaved [real, imag] pairs.
+ *  Uses Re(ifft(x)) = Re(fft(conj(x))).
+ */
+template <typename DType>
+inline void ComplexIFFTRealRows(const DType* in, DType* out, int num_rows,
+                                int n, OpReqType req) {
+    typedef std::complex<DType> Complex;
+    if (req == kNullOp) return;
+    const FFTPlan<DType>* plan = FFTPlan<DType>::Get(n);
+#pragma omp parallel
+    {
+        std::vector<Complex> buf(2 * n + plan->scratch_size());
+#pragma omp for
+        for (int i = 0; i < num_rows; ++i) {
+            const Complex* row = reinterpret_cast<const Complex*>(
+                in + static_cast<size_t>(i) * 2 * n);
+            DType* row_out = out + static_cast<size_t>(i) * n;
+            for (int j = 0; j < n; ++j) buf[j] = std::conj(row[j]);
+            plan->Forward(buf.data(), 1, buf.data() + n, buf.data() + 2 * n);
+            for (int j = 0; j < n; ++j) {
+                const DType value = buf[n + j].real();
+                row_out[j] = req == kAddTo ? row_out[j] + value : value;
+            }
+        }
+    }
+}
+
+/*! \brief float16 has no cpu fft */
+inline void RealFFTRows(const mshadow::half::half_t* in,
+                        mshadow::half::half_t* out, int num_rows, int n,
+                        OpReqType req) {
+    LOG(FATAL) << "float16 fft is not supported on cpu";
+}
+
+inline void ComplexIFFTRealRows(const mshadow::half::half_t* in,
+                                mshadow::half::half_t* out, int num_rows,
+                                int n, OpReqType req) {
+    LOG(FATAL) << "float16 fft is not supported on cpu";
+}
+
+}  // namespace op
+}  // namespace mxnet
+#endif  // MXNET_OPERATOR_CONTRIB_FFT_PLAN_H_
@@ -15,6 +15,7 @@
 #include <vector>
 #include "../mshadow_op.h"
 #include "../operator_common.h"
+#include "./fft_plan.h"
 
 #if MXNET_USE_CUDA
 #include <cufft.h>
@@ -81,6 +82,11 @@ class IFFTOp : public Operator {
         Tensor<xpu, 2, DType> out =
             out_data[ifft::kOut].get_with_shape<xpu, 2, DType>(
                 Shape2(n_iffts, dim_), s);
+        if (xpu::kDevCPU) {
+            ComplexIFFTRealRows(data.dptr_, out.dptr_, n_iffts, dim_,
+                                req[ifft::kOut]);
+            return;
+        }
         // need temp space to store the intermediate complex matrices
         Tensor<xpu, 1, DType> workspace =
             ctx.requested[ifft::kTempSpace].get_space_typed<xpu, 1, DType>(
@@ -155,6 +161,11 @@ class IFFTOp : public Operator {
         Tensor<xpu, 2, DType> grad =
             out_grad[ifft::kOut].get_with_shape<xpu, 2, DType>(
                 Shape2(n_iffts, dim_), s);
+        if (xpu::kDevCPU) {
+            RealFFTRows(grad.dptr_, gdata.dptr_, n_iffts, dim_,
+                        req[ifft::kData]);
+            return;
+        }
         // need temp space to pad the data into complex numbers due to cufft
         // interface
         Tensor<xpu, 1, DType> workspace =
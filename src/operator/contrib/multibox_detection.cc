@@ -5,24 +5,11 @@
  * \author Joshua Zhang
 */
 #include <algorithm>
+#include <vector>
 #include "./multibox_detection-inl.h"
+#include "./nms.h"
 
 namespace mshadow {
-template <typename DType>
-struct SortElemDescend {
-    DType value;
-    int index;
-
-    SortElemDescend(DType v, int i) {
-        value = v;
-        index = i;
-    }
-
-    bool operator<(const SortElemDescend &other) const {
-        return value > other.value;
-    }
-};
-
 template <typename DType>
 inline void TransformLocations(DType *out, const DType *anchors,
                                const DType *loc_pred, const bool clip,
@@ -51,15 +38,6 @@ inline void TransformLocations(DType *out, const DType *anchors,
     out[3] = clip ? std::max(DType(0), std::min(DType(1), oy + oh)) : (oy + oh);
 }
 
-template <typename DType>
-inline DType CalculateOverlap(const DType *a, const DType *b) {
-    DType w = std::max(DType(0), std::min(a[2], b[2]) - std::max(a[0], b[0]));
-    DType h = std::max(DType(0), std::min(a[3], b[3]) - std::max(a[1], b[1]));
-    DType i = w * h;
-    DType u = (a[2] - a[0]) * (a[3] - a[1]) + (b[2] - b[0]) * (b[3] - b[1]) - i;
-    return u <= 0.f ? static_cast<DType>(0) : static_cast<DType>(i / u);
-}
-
 template <typename DType>
 inline void MultiBoxDetectionForward(
     const Tensor<cpu, 3, DType> &out, const Tensor<cpu, 3, DType> &cls_prob,
@@ -72,6 +50,9 @@ inline void MultiBoxDetectionForward(
     const int num_anchors = cls_prob.size(2);
     const int num_batches = cls_prob.size(0);
     const DType *p_anchor = anchors.dptr_;
+    // the images of a batch are handled concurrently; a single image
+    // leaves the threads to the overlaps of its nms instead
+#pragma omp parallel for if (num_batches > 1)
     for (int nbatch = 0; nbatch < num_batches; ++nbatch) {
         const DType *p_cls_prob =
             cls_prob.dptr_ + nbatch * num_classes * num_anchors;
@@ -110,40 +91,40 @@ inline void MultiBoxDetectionForward(
             continue;
 
         // sort and apply NMS
-        Copy(temp_space[nbatch], out[nbatch], out.stream_);
-        // sort confidence in descend order
-        std::vector<SortElemDescend<DType>> sorter;
-        sorter.reserve(valid_count);
-        for (int i = 0; i < valid_count; ++i) {
-            sorter.push_back(SortElemDescend<DType>(p_out[i * 6 + 1], i));
-        }
-        std::stable_sort(sorter.begin(), sorter.end());
-        // re-order output
         DType *ptemp = temp_space.dptr_ + nbatch * num_anchors * 6;
-        int nkeep = static_cast<int>(sorter.size());
+        std::copy(p_out, p_out + valid_count * 6, ptemp);
+        // sort confidence in descend order, the nms_topk first
+        int nkeep = valid_count;
         if (nms_topk > 0 && nms_topk < nkeep) {
             nkeep = nms_topk;
         }
-        for (int i = 0; i < nkeep; ++i) {
+        std::vector<int> order;
+        mxnet::op::NMSTopK(ptemp + 1, 6, valid_count, nkeep, &order);
+        // re-order output, detections after the top k are eliminated
+        for (int i = 0; i < valid_count; ++i) {
             for (int j = 0; j < 6; ++j) {
-                p_out[i * 6 + j] = ptemp[sorter[i].index * 6 + j];
+                p_out[i * 6 + j] = ptemp[order[i] * 6 + j];
             }
+            if (i >= nkeep) p_out[i * 6] = -1;
         }
-        // apply nms
-        for (int i = 0; i < valid_count; ++i) {
-            int offset_i = i * 6;
-            if (p_out[offset_i] < 0) continue;  // skip eliminated
-            for (int j = i + 1; j < valid_count; ++j) {
-                int offset_j = j * 6;
-                if (p_out[offset_j] < 0) continue;  // skip eliminated
-                if (force_suppress || (p_out[offset_i] == p_out[offset_j])) {
-                    // when foce_suppress == true or class_id equals
-                    DType iou = CalculateOverlap(p_out + offset_i + 2,
-                                                 p_out + offset_j + 2);
-                    if (iou >= nms_threshold) {
-                        p_out[offset_j] = -1;
-                    }
-                }
+        // apply nms, within each class unless force_suppress == true
+        std::vector<int> class_id;
+        if (!force_suppress) {
+            class_id.resize(nkeep);
+            for (int i = 0; i < nkeep; ++i) {
+                class_id[i] = static_cast<int>(p_out[i * 6]);
+            }
+        }
+        std::vector<int> keep(nkeep);
+        const int num_keep = mxnet::op::NonMaximumSuppression(
+            p_out + 2, 6, force_suppress ? NULL : class_id.data(), nkeep,
+            nms_threshold, DType(0), true, nkeep, keep.data());
+        // mark the suppressed detections as eliminated
+        for (int i = 0, k = 0; i < nkeep; ++i) {
+            if (k < num_keep && keep[k] == i) {
+                ++k;
+            } else {
+                p_out[i * 6] = -1;
             }
         }
     }  // end iter batch
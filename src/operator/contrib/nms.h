@@ -0,0 +1,148 @@
+/*!
+ * Copyright (c) 2017 by Contributors
+ * \file nms.h
+ * \brief Non-maximum suppression on cpu for the proposal and
+ *  multibox_detection operators. The overlaps of a candidate with all the
+ *  following ones are tested at once into a row of bits, the rows of many
+ *  candidates in parallel, and the greedy pass only ORs the rows of the
+ *  boxes it keeps.
+ */
+#ifndef MXNET_OPERATOR_CONTRIB_NMS_H_
+#define MXNET_OPERATOR_CONTRIB_NMS_H_
+
+#include <dmlc/logging.h>
+#include <dmlc/omp.h>
+#include <mxnet/base.h>
+#include <stdint.h>
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
+namespace mxnet {
+namespace op {
+
+/*!
+ * \brief Order the n candidates whose scores are score[i * stride] so the k
+ *  highest come first, by decreasing score and then increasing index. The
+ *  order of the others is unspecified. k <= 0 or k >= n sorts them all.
+ */
+template <typename DType>
+inline void NMSTopK(const DType* score, int stride, int n, int k,
+                    std::vector<int>* order) {
+    order->resize(n);
+    std::iota(order->begin(), order->end(), 0);
+    auto greater = [score, stride](int a, int b) {
+        const DType sa = score[a * stride], sb = score[b * stride];
+        return sa > sb || (sa == sb && a < b);
+    };
+    if (k > 0 && k < n) {
+        std::partial_sort(order->begin(), order->begin() + k, order->end(),
+                          greater);
+    } else {
+        std::sort(order->begin(), order->end(), greater);
+    }
+}
+
+/*!
+ * \brief Greedy non-maximum suppression of n boxes sorted by decreasing
+ *  score: a box is kept unless it overlaps a kept box of higher score by
+ *  more than thresh, which is positive.
+ * \param boxes [x1, y1, x2, y2] of box i at boxes + i * stride
+ * \param classes class of every box, only boxes of one class suppress each
+ *  other; NULL to suppress across classes
+ * \param offset 1 for boxes in pixels whose x2 and y2 are inclusive, 0 for
+ *  boxes in normalized coordinates
+ * \param inclusive whether an overlap of exactly thresh suppresses
+ * \param max_keep stop once this many boxes are kept
+ * \param keep indices of the kept boxes, in order
+ * \return number of kept boxes
+ */
+template <typename DType>
+inline int NonMaximumSuppression(const DType* boxes, int stride,
+                                 const int* classes, int n, float thresh,
+                                 DType offset, bool inclusive, int max_keep,
+                                 int* keep) {
+    if (n <= 0 || max_keep <= 0) return 0;
+    // the coordinates as separate arrays, so the overlaps of one box with
+    // the following ones vectorize
+    std::vector<DType> x1(n), y1(n), x2(n), y2(n), area(n);
+    for (int i = 0; i < n; ++i) {
+        const DType* box = boxes + static_cast<size_t>(i) * stride;
+        x1[i] = box[0];
+        y1[i] = box[1];
+        x2[i] = box[2];
+        y2[i] = box[3];
+        area[i] = (x2[i] - x1[i] + offset) * (y2[i] - y1[i] + offset);
+    }
+    const DType th = DType(thresh);
+    const int words = (n + 63) / 64;
+    // bit j of mask row r: the r-th box of the block suppresses box j > i
+    std::vector<uint64_t> removed(words, 0), mask(64 * words);
+    std::vector<int> rows;
+    int num_keep = 0;
+    // The boxes go in blocks of 64. The rows of the boxes of a block that are
+    // not suppressed yet are built in parallel, then the greedy pass over the
+    // block ORs the rows of those it keeps into the removed set.
+    for (int start = 0; start < n && num_keep < max_keep; start += 64) {
+        const int stop = std::min(start + 64, n);
+        const int first_word = start / 64;
+        rows.clear();
+        for (int i = start; i < stop; ++i) {
+            if (!((removed[i / 64] >> (i % 64)) & 1)) rows.push_back(i);
+        }
+        const int num_rows = static_cast<int>(rows.size());
+#pragma omp parallel if (num_rows > 1 && n - start > 256)
+        {
+            std::vector<uint8_t> over(n);
+#pragma omp for schedule(dynamic)
+            for (int r = 0; r < num_rows; ++r) {
+                const int i = rows[r];
+                const DType bx1 = x1[i], by1 = y1[i], bx2 = x2[i],
+                            by2 = y2[i], barea = area[i];
+                for (int j = i + 1; j < n; ++j) {
+                    const DType iw = std::max(
+                        DType(0),
+                        std::min(bx2, x2[j]) - std::max(bx1, x1[j]) + offset);
+                    const DType ih = std::max(
+                        DType(0),
+                        std::min(by2, y2[j]) - std::max(by1, y1[j]) + offset);
+                    const DType inter = iw * ih;
+                    const DType uni = barea + area[j] - inter;
+                    // inter / uni against thresh without the division; an
+                    // empty union is no overlap
+                    const DType bound = th * uni;
+                    over[j] = uni > DType(0) &&
+                              (inclusive ? inter >= bound : inter > bound);
+                }
+                if (classes != NULL) {
+                    for (int j = i + 1; j < n; ++j) {
+                        over[j] = over[j] && classes[j] == classes[i];
+                    }
+                }
+                uint64_t* row = &mask[static_cast<size_t>(i - start) * words];
+                for (int w = first_word; w < words; ++w) {
+                    const int begin = std::max(w * 64, i + 1);
+                    const int end = std::min(w * 64 + 64, n);
+                    uint64_t bits = 0;
+                    for (int j = begin; j < end; ++j) {
+                        bits |= static_cast<uint64_t>(over[j]) << (j - w * 64);
+                    }
+                    row[w] = bits;
+                }
+            }
+        }
+        for (int r = 0; r < num_rows && num_keep < max_keep; ++r) {
+            const int i = rows[r];
+            if ((removed[i / 64] >> (i % 64)) & 1) continue;
+            keep[num_keep++] = i;
+            const uint64_t* row =
+                &mask[static_cast<size_t>(i - start) * words];
+            for (int w = first_word; w < words; ++w) removed[w] |= row[w];
+        }
+    }
+    return num_keep;
+}
+
+}  // namespace op
+}  // namespace mxnet
+#endif  // MXNET_OPERATOR_CONTRIB_NMS_H_
@@ -6,6 +6,7 @@
 */
 
 #include "./proposal-inl.h"
+#include "./nms.h"
 
 //============================
 // Bounding Box Transform Utils
@@ -144,38 +145,17 @@ namespace mxnet {
 namespace op {
 namespace utils {
 
-struct ReverseArgsortCompl {
-    const float *val_;
-    explicit ReverseArgsortCompl(float *val) : val_(val) {}
-    bool operator()(float i, float j) {
-        return (val_[static_cast<index_t>(i)] > val_[static_cast<index_t>(j)]);
-    }
-};
-
-// copy score and init order
-inline void CopyScore(const mshadow::Tensor<cpu, 2> &dets,
-                      mshadow::Tensor<cpu, 1> *score,
-                      mshadow::Tensor<cpu, 1> *order) {
-    for (index_t i = 0; i < dets.size(0); i++) {
-        (*score)[i] = dets[i][4];
-        (*order)[i] = i;
-    }
-}
-
-// sort order array according to score
-inline void ReverseArgsort(const mshadow::Tensor<cpu, 1> &score,
-                           mshadow::Tensor<cpu, 1> *order) {
-    ReverseArgsortCompl cmpl(score.dptr_);
-    std::sort(order->dptr_, order->dptr_ + score.size(0), cmpl);
-}
-
-// reorder proposals according to order and keep the pre_nms_top_n proposals
+// reorder proposals so the pre_nms_top_n of highest score come first, by
+// decreasing score, and keep them
 // dets.size(0) == pre_nms_top_n
 inline void ReorderProposals(const mshadow::Tensor<cpu, 2> &prev_dets,
-                             const mshadow::Tensor<cpu, 1> &order,
                              const index_t pre_nms_top_n,
                              mshadow::Tensor<cpu, 2> *dets) {
     CHECK_EQ(dets->size(0), pre_nms_top_n);
+    CHECK_EQ(prev_dets.CheckContiguous(), true);
+    std::vector<int> order;
+    NMSTopK(prev_dets.dptr_ + 4, prev_dets.size(1), prev_dets.size(0),
+            pre_nms_top_n, &order);
     for (index_t i = 0; i < dets->size(0); i++) {
         const index_t index = order[i];
         for (index_t j = 0; j < dets->size(1); j++) {
@@ -188,53 +168,15 @@ inline void ReorderProposals(const mshadow::Tensor<cpu, 2> &prev_dets,
 inline void NonMaximumSuppression(const mshadow::Tensor<cpu, 2> &dets,
                                   const float thresh,
                                   const index_t post_nms_top_n,
-                                  mshadow::Tensor<cpu, 1> *area,
-                                  mshadow::Tensor<cpu, 1> *suppressed,
-                                  mshadow::Tensor<cpu, 1> *keep,
+                                  std::vector<int> *keep,
                                   index_t *out_size) {
     CHECK_EQ(dets.shape_[1], 5) << "dets: [x1, y1, x2, y2, score]";
     CHECK_GT(dets.shape_[0], 0);
     CHECK_EQ(dets.CheckContiguous(), true);
-    CHECK_EQ(area->CheckContiguous(), true);
-    CHECK_EQ(suppressed->CheckContiguous(), true);
-    CHECK_EQ(keep->CheckContiguous(), true);
-    // calculate area
-    for (index_t i = 0; i < dets.size(0); ++i) {
-        (*area)[i] =
-            (dets[i][2] - dets[i][0] + 1) * (dets[i][3] - dets[i][1] + 1);
-    }
-
-    // calculate nms
-    *out_size = 0;
-    for (index_t i = 0; i < dets.size(0) && (*out_size) < post_nms_top_n; ++i) {
-        float ix1 = dets[i][0];
-        float iy1 = dets[i][1];
-        float ix2 = dets[i][2];
-        float iy2 = dets[i][3];
-        float iarea = (*area)[i];
-
-        if ((*suppressed)[i] > 0.0f) {
-            continue;
-        }
-
-        (*keep)[(*out_size)++] = i;
-        for (index_t j = i + 1; j < dets.size(0); j++) {
-            if ((*suppressed)[j] > 0.0f) {
-                continue;
-            }
-            float xx1 = std::max(ix1, dets[j][0]);
-            float yy1 = std::max(iy1, dets[j][1]);
-            float xx2 = std::min(ix2, dets[j][2]);
-            float yy2 = std::min(iy2, dets[j][3]);
-            float w = std::max(0.0f, xx2 - xx1 + 1.0f);
-            float h = std::max(0.0f, yy2 - yy1 + 1.0f);
-            float inter = w * h;
-            float ovr = inter / (iarea + (*area)[j] - inter);
-            if (ovr > thresh) {
-                (*suppressed)[j] = 1.0f;
-            }
-        }
-    }
+    keep->resize(post_nms_top_n);
+    *out_size = op::NonMaximumSuppression(dets.dptr_, 5, NULL, dets.size(0),
+                                          thresh, 1.0f, false, post_nms_top_n,
+                                          keep->data());
 }
 
 }  // namespace utils
@@ -293,8 +235,7 @@ class ProposalOp : public Operator {
         int rpn_post_nms_top_n =
             std::min(param_.rpn_post_nms_top_n, rpn_pre_nms_top_n);
 
-        int workspace_size = count * 5 + 2 * count + rpn_pre_nms_top_n * 5 +
-                             3 * rpn_pre_nms_top_n;
+        int workspace_size = count * 5 + rpn_pre_nms_top_n * 5;
         Tensor<cpu, 1> workspace =
             ctx.requested[proposal::kTempResource].get_space<cpu>(
                 Shape1(workspace_size), s);
@@ -302,15 +243,9 @@ class ProposalOp : public Operator {
         Tensor<cpu, 2> workspace_proposals(workspace.dptr_ + start,
                                            Shape2(count, 5));
         start += count * 5;
-        Tensor<cpu, 2> workspace_pre_nms(workspace.dptr_ + start,
-                                         Shape2(2, count));
-        start += 2 * count;
         Tensor<cpu, 2> workspace_ordered_proposals(
             workspace.dptr_ + start, Shape2(rpn_pre_nms_top_n, 5));
         start += rpn_pre_nms_top_n * 5;
-        Tensor<cpu, 2> workspace_nms(workspace.dptr_ + start,
-                                     Shape2(3, rpn_pre_nms_top_n));
-        start += 3 * rpn_pre_nms_top_n;
         CHECK_EQ(workspace_size, start) << workspace_size << " " << start
                                         << std::endl;
 
@@ -368,23 +303,14 @@ class ProposalOp : public Operator {
         utils::FilterBox(&workspace_proposals,
                          param_.rpn_min_size * im_info[0][2]);
 
-        Tensor<cpu, 1> score = workspace_pre_nms[0];
-        Tensor<cpu, 1> order = workspace_pre_nms[1];
-
-        utils::CopyScore(workspace_proposals, &score, &order);
-        utils::ReverseArgsort(score, &order);
-        utils::ReorderProposals(workspace_proposals, order, rpn_pre_nms_top_n,
+        utils::ReorderProposals(workspace_proposals, rpn_pre_nms_top_n,
                                 &workspace_ordered_proposals);
 
         index_t out_size = 0;
-        Tensor<cpu, 1> area = workspace_nms[0];
-        Tensor<cpu, 1> suppressed = workspace_nms[1];
-        Tensor<cpu, 1> keep = workspace_nms[2];
-        suppressed = 0;  // surprised!
-
+        std::vector<int> keep;
         utils::NonMaximumSuppression(workspace_ordered_proposals,
                                      param_.threshold, rpn_post_nms_top_n,
-                                     &area, &suppressed, &keep, &out_size);
+                                     &keep, &out_size);
 
         // fill in output rois
         for (index_t i = 0; i < out.size(0); ++i) {
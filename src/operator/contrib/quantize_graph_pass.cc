@@ -0,0 +1,250 @@
+/*!
+ *  Copyright (c) 2017 by Contributors
+ * \file quantize_graph_pass.cc
+ * \brief replace the float operators of a graph that have quantized
+ *  versions, quantizing and dequantizing only where quantized and float
+ *  operators meet
+ */
+#include <mxnet/operator.h>
+#include <nnvm/graph.h>
+#include <nnvm/pass.h>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include "../../executor/exec_pass.h"
+#include "../activation-inl.h"
+#include "../convolution-inl.h"
+#include "../pooling-inl.h"
+
+namespace mxnet {
+namespace op {
+using nnvm::Graph;
+using nnvm::Node;
+using nnvm::NodeEntry;
+using nnvm::NodePtr;
+using nnvm::Op;
+using exec::GetLegacyParam;
+
+/*! \brief names of nodes and variables, as the pass attributes hold them */
+typedef std::unordered_set<std::string> NameSet;
+/*! \brief the calibrated range of the outputs named in the table */
+typedef std::unordered_map<std::string, std::pair<float, float> > CalibTable;
+
+inline std::string FloatToString(float value) {
+    std::ostringstream os;
+    os << std::setprecision(std::numeric_limits<float>::max_digits10)
+       << value;
+    return os.str();
+}
+
+template <typename T>
+inline T GetPassAttr(const Graph& g, const char* key) {
+    return g.attrs.count(key) ? g.GetAttr<T>(key) : T();
+}
+
+Graph QuantizeGraph(Graph src) {
+    static const Op* conv_op = Op::Get("Convolution");
+    static const Op* fc_op = Op::Get("FullyConnected");
+    static const Op* pool_op = Op::Get("Pooling");
+    static const Op* flatten_op = Op::Get("Flatten");
+    static const Op* act_op = Op::Get("Activation");
+    const NameSet excluded = GetPassAttr<NameSet>(src, "excluded_nodes");
+    const NameSet offline = GetPassAttr<NameSet>(src, "offline_params");
+    const CalibTable calib = GetPassAttr<CalibTable>(src, "calib_table");
+    const auto& idx = src.indexed_graph();
+    std::vector<uint32_t> ref_count(idx.num_node_entries(), 0);
+    for (const auto& e : idx.outputs()) ++ref_count[idx.entry_id(e)];
+    for (uint32_t nid = 0; nid < idx.num_nodes(); ++nid) {
+        for (const auto& e : idx[nid].inputs) ++ref_count[idx.entry_id(e)];
+    }
+
+    std::unordered_map<const Node*, NodePtr> mirror;
+    // nodes of the new graph whose outputs are quantized data and range
+    std::unordered_set<const Node*> quantized;
+    std::unordered_map<uint32_t, std::vector<NodeEntry> > quantize_memo;
+    std::unordered_map<uint32_t, NodeEntry> dequantize_memo;
+    auto create_node = [](const std::string& op, const std::string& name,
+                          std::vector<NodeEntry> inputs) -> NodePtr {
+        NodePtr n = Node::Create();
+        n->attrs.op = Op::Get(op);
+        n->attrs.name = name;
+        n->inputs = std::move(inputs);
+        return n;
+    };
+    auto is_quantized = [&](const NodeEntry& e) {
+        return quantized.count(mirror.at(e.node.get()).get()) != 0;
+    };
+    // the float value of entry e in the new graph
+    auto float_entry = [&](const NodeEntry& e) -> NodeEntry {
+        const NodePtr& m = mirror.at(e.node.get());
+        if (!quantized.count(m.get())) return NodeEntry{m, e.index, e.version};
+        const uint32_t eid = idx.entry_id(e);
+        auto it = dequantize_memo.find(eid);
+        if (it != dequantize_memo.end()) return it->second;
+        NodePtr n = create_node(
+            "_contrib_dequantize", e.node->attrs.name + "_dequantize",
+            {NodeEntry{m, 0, 0}, NodeEntry{m, 1, 0}, NodeEntry{m, 2, 0}});
+        n->attrs.dict["out_type"] = "float32";
+        n->op()->attr_parser(&(n->attrs));
+        return dequantize_memo[eid] = NodeEntry{n, 0, 0};
+    };
+    // the quantized value of entry e and its range, quantizing at most once
+    auto quantized_entries = [&](const NodeEntry& e) -> std::vector<NodeEntry> {
+        const NodePtr& m = mirror.at(e.node.get());
+        if (quantized.count(m.get())) {
+            return std::vector<NodeEntry>{NodeEntry{m, 0, 0},
+                                          NodeEntry{m, 1, 0},
+                                          NodeEntry{m, 2, 0}};
+        }
+        const uint32_t eid = idx.entry_id(e);
+        auto it = quantize_memo.find(eid);
+        if (it != quantize_memo.end()) return it->second;
+        const std::string& name = e.node->attrs.name;
+        std::vector<NodeEntry> ret;
+        if (e.node->is_variable() && offline.count(name)) {
+            // parameters are quantized once, ahead of time
+            for (const char* suffix : {"_quantize", "_min", "_max"}) {
+                NodePtr var = Node::Create();
+                var->attrs.name = name + suffix;
+                ret.push_back(NodeEntry{var, 0, 0});
+            }
+        } else {
+            // the range always holds zero, so that the padding of a
+            // quantized convolution is exact
+            const NodeEntry data{m, e.index, e.version};
+            NodePtr min_node = create_node("min", name + "_min", {data});
+            NodePtr max_node = create_node("max", name + "_max", {data});
+            min_node->op()->attr_parser(&(min_node->attrs));
+            max_node->op()->attr_parser(&(max_node->attrs));
+            min_node = create_node("_minimum_scalar", name + "_min_zero",
+                                   {NodeEntry{min_node, 0, 0}});
+            max_node = create_node("_maximum_scalar", name + "_max_zero",
+                                   {NodeEntry{max_node, 0, 0}});
+            for (const NodePtr& bound : {min_node, max_node}) {
+                bound->attrs.dict["scalar"] = "0";
+                bound->op()->attr_parser(&(bound->attrs));
+            }
+            NodePtr n = create_node(
+                "_contrib_quantize", name + "_quantize",
+                {data, NodeEntry{min_node, 0, 0}, NodeEntry{max_node, 0, 0}});
+            n->attrs.dict["out_type"] = "uint8";
+            n->op()->attr_parser(&(n->attrs));
+            ret = {NodeEntry{n, 0, 0}, NodeEntry{n, 1, 0}, NodeEntry{n, 2, 0}};
+        }
+        return quantize_memo[eid] = ret;
+    };
+    // hidden outputs such as the pooling mask have no quantized version
+    auto only_first_output_used = [&](const Node* n) -> bool {
+        const uint32_t nid = idx.node_id(n);
+        for (uint32_t i = 1; i < n->num_outputs(); ++i) {
+            if (ref_count[idx.entry_id(nid, i)] != 0) return false;
+        }
+        return true;
+    };
+
+    // convolution and fully connected layers start quantized runs, which
+    // pooling, flatten and relu continue
+    auto quantized_op_of = [&](const Node* n, bool* has_weight) -> const char* {
+        *has_weight = n->op() == conv_op || n->op() == fc_op;
+        if (excluded.count(n->attrs.name)) return nullptr;
+        if (n->op() == conv_op) {
+            const auto param = GetLegacyParam<ConvolutionParam>(*n);
+            if (param.kernel.ndim() == 2 &&
+                param.layout.value() == mshadow::kNCHW) {
+                return "_contrib_quantized_conv";
+            }
+        } else if (n->op() == fc_op) {
+            return "_contrib_quantized_fully_connected";
+        } else if (n->op() != pool_op && n->op() != flatten_op &&
+                   n->op() != act_op) {
+            return nullptr;
+        } else if (!is_quantized(n->inputs[0]) || !only_first_output_used(n)) {
+            return nullptr;
+        } else if (n->op() == pool_op) {
+            const auto param = GetLegacyParam<PoolingParam>(*n);
+            if (param.kernel.ndim() == 2 &&
+                param.pool_type == pool_enum::kMaxPooling) {
+                return "_contrib_quantized_pooling";
+            }
+        } else if (n->op() == flatten_op) {
+            return "_contrib_quantized_flatten";
+        } else if (n->op() == act_op) {
+            const auto param = GetLegacyParam<ActivationParam>(*n);
+            if (param.act_type == activation::kReLU) {
+                return "_contrib_quantized_relu";
+            }
+        }
+        return nullptr;
+    };
+
+    nnvm::DFSVisit(src.outputs, [&](const NodePtr& n) {
+        if (n->is_variable()) {
+            mirror[n.get()] = n;
+            return;
+        }
+        bool has_weight = false;
+        const char* quantized_op = quantized_op_of(n.get(), &has_weight);
+        NodePtr p = Node::Create();
+        if (quantized_op != nullptr) {
+            p->attrs.op = Op::Get(quantized_op);
+            p->attrs.name = "quantized_" + n->attrs.name;
+            if (p->op()->attr_parser != nullptr) {
+                p->attrs.dict = n->attrs.dict;
+                auto it = calib.find(n->attrs.name + "_output");
+                if (has_weight && it != calib.end()) {
+                    p->attrs.dict["min_calib_range"] =
+                        FloatToString(it->second.first);
+                    p->attrs.dict["max_calib_range"] =
+                        FloatToString(it->second.second);
+                }
+                p->op()->attr_parser(&(p->attrs));
+            }
+            // quantized data and weight, then the float bias, then the ranges
+            const std::vector<NodeEntry> data = quantized_entries(n->inputs[0]);
+            p->inputs.push_back(data[0]);
+            std::vector<NodeEntry> weight;
+            if (has_weight) {
+                weight = quantized_entries(n->inputs[1]);
+                p->inputs.push_back(weight[0]);
+                for (size_t i = 2; i < n->inputs.size(); ++i) {
+                    p->inputs.push_back(float_entry(n->inputs[i]));
+                }
+            }
+            p->inputs.insert(p->inputs.end(), data.begin() + 1, data.end());
+            if (has_weight) {
+                p->inputs.insert(p->inputs.end(), weight.begin() + 1,
+                                 weight.end());
+            }
+            quantized.insert(p.get());
+        } else {
+            p->attrs = n->attrs;
+            for (const NodeEntry& e : n->inputs) {
+                p->inputs.push_back(float_entry(e));
+            }
+        }
+        for (const NodePtr& dep : n->control_deps) {
+            p->control_deps.push_back(mirror.at(dep.get()));
+        }
+        mirror[n.get()] = p;
+    });
+
+    Graph ret;
+    for (const NodeEntry& e : src.outputs) {
+        ret.outputs.push_back(float_entry(e));
+    }
+    return ret;
+}
+
+NNVM_REGISTER_PASS(QuantizeGraph)
+    .describe(
+        "Return a graph computing Convolution, FullyConnected and the "
+        "Pooling, Flatten and relu following them on quantized data")
+    .set_body(QuantizeGraph)
+    .set_change_graph(true);
+
+}  // namespace op
+}  // namespace mxnet
@@ -0,0 +1,223 @@
+/*!
+ *  Copyright (c) 2017 by Contributors
+ * \file quantized_ops-inl.h
+ * \brief helpers of the operators computing on uint8 data quantized by
+ *  `quantize`, where q represents min + q * (max - min) / 255
+ */
+#ifndef MXNET_OPERATOR_CONTRIB_QUANTIZED_OPS_INL_H_
+#define MXNET_OPERATOR_CONTRIB_QUANTIZED_OPS_INL_H_
+
+#include <dmlc/optional.h>
+#include <mxnet/operator.h>
+#include <mxnet/operator_util.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include "../operator_common.h"
+
+namespace mxnet {
+namespace op {
+
+namespace quantized {
+// every quantized operator returns its data with the range it represents
+enum QuantizedOpOutputs { kOut, kMinOut, kMaxOut };
+}  // namespace quantized
+
+struct QuantizedRangeParam : public dmlc::Parameter<QuantizedRangeParam> {
+    dmlc::optional<float> min_calib_range;
+    dmlc::optional<float> max_calib_range;
+    DMLC_DECLARE_PARAMETER(QuantizedRangeParam) {
+        DMLC_DECLARE_FIELD(min_calib_range)
+            .set_default(dmlc::optional<float>())
+            .describe(
+                "The minimum of the output collected by calibration. The "
+                "range of each output is computed at run time if absent.");
+        DMLC_DECLARE_FIELD(max_calib_range)
+            .set_default(dmlc::optional<float>())
+            .describe("The maximum of the output collected by calibration.");
+    }
+};
+
+/*!
+ * \brief attributes of a quantized operator: the property of the float
+ *  operator it replaces, which does the shape inference, its parameters
+ *  with the defaults the property fills in, and the calibrated range
+ */
+template <typename PType>
+struct QuantizedOpAttrs {
+    std::shared_ptr<OperatorProperty> prop;
+    PType param;
+    QuantizedRangeParam range;
+};
+
+template <typename PType>
+inline const QuantizedOpAttrs<PType>& GetQuantizedOpAttrs(
+    const nnvm::NodeAttrs& attrs) {
+    return nnvm::get<QuantizedOpAttrs<PType> >(attrs.parsed);
+}
+
+template <typename PType>
+inline void QuantizedOpAttrParser(nnvm::NodeAttrs* attrs,
+                                  const char* float_op) {
+    QuantizedOpAttrs<PType> ret;
+    ret.prop.reset(OperatorProperty::Create(float_op));
+    ret.prop->Init(ret.range.InitAllowUnknown(attrs->dict));
+    ret.param.Init(ret.prop->GetParams());
+    attrs->parsed = std::move(ret);
+}
+
+/*! \brief the step between two quantized values of a range */
+inline float quantized_step(float min_range, float max_range) {
+    return (max_range - min_range) / 255.0f;
+}
+
+/*! \brief the quantized value closest to x in a range */
+inline uint8_t quantize_value(float x, float min_range, float max_range) {
+    const float step = quantized_step(min_range, max_range);
+    if (step <= 0.0f) return 0;
+    const float q = (x - min_range) / step + 0.5f;
+    return static_cast<uint8_t>(std::min(std::max(q, 0.0f), 255.0f));
+}
+
+/*!
+ * \brief quantize float data into the calibrated range, or into the range
+ *  of the data itself when the operator was not calibrated, widened to hold
+ *  zero so that the output pads exactly when it feeds a convolution
+ */
+inline void quantize_to_range(const float* in, size_t size,
+                              const QuantizedRangeParam& range, uint8_t* out,
+                              float* min_out, float* max_out) {
+    float lo, hi;
+    if (range.min_calib_range.has_value() &&
+        range.max_calib_range.has_value()) {
+        lo = range.min_calib_range.value();
+        hi = range.max_calib_range.value();
+    } else {
+        lo = size != 0 ? in[0] : 0.0f;
+        hi = lo;
+        for (size_t i = 1; i < size; ++i) {
+            lo = std::min(lo, in[i]);
+            hi = std::max(hi, in[i]);
+        }
+    }
+    lo = std::min(lo, 0.0f);
+    hi = std::max(hi, 0.0f);
+    const float scale = hi > lo ? 255.0f / (hi - lo) : 0.0f;
+    const index_t n = static_cast<index_t>(size);
+#pragma omp parallel for
+    for (index_t i = 0; i < n; ++i) {
+        const float q = (in[i] - lo) * scale + 0.5f;
+        out[i] = static_cast<uint8_t>(std::min(std::max(q, 0.0f), 255.0f));
+    }
+    *min_out = lo;
+    *max_out = hi;
+}
+
+/*!
+ * \brief c = a * b^T with int32 accumulation, for a of shape (m, k) and b of
+ *  shape (n, k). Both operands are read along k, and four columns of c
+ *  share each row of a, so the inner loops vectorize into widening
+ *  multiply-adds.
+ */
+inline void quantized_gemm(const uint8_t* a, const uint8_t* b, int m, int n,
+                           int k, int32_t* c) {
+    const int nblock = (n + 3) / 4;
+#pragma omp parallel for
+    for (int t = 0; t < m * nblock; ++t) {
+        const int i = t / nblock;
+        const int j = t % nblock * 4;
+        const uint8_t* ai = a + static_cast<size_t>(i) * k;
+        int32_t* ci = c + static_cast<size_t>(i) * n;
+        if (j + 4 <= n) {
+            const uint8_t* b0 = b + static_cast<size_t>(j) * k;
+            const uint8_t* b1 = b0 + k;
+            const uint8_t* b2 = b1 + k;
+            const uint8_t* b3 = b2 + k;
+            int32_t s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+            for (int p = 0; p < k; ++p) {
+                const int32_t x = ai[p];
+                s0 += x * b0[p];
+                s1 += x * b1[p];
+                s2 += x * b2[p];
+                s3 += x * b3[p];
+            }
+            ci[j] = s0;
+            ci[j + 1] = s1;
+            ci[j + 2] = s2;
+            ci[j + 3] = s3;
+        } else {
+            for (int jj = j; jj < n; ++jj) {
+                const uint8_t* bj = b + static_cast<size_t>(jj) * k;
+                int32_t s = 0;
+                for (int p = 0; p < k; ++p) s += int32_t(ai[p]) * bj[p];
+                ci[jj] = s;
+            }
+        }
+    }
+}
+
+/*! \brief sums[i] = the sum of row i of the (m, k) matrix a */
+inline void quantized_row_sums(const uint8_t* a, int m, int k,
+                               int32_t* sums) {
+    for (int i = 0; i < m; ++i) {
+        const uint8_t* ai = a + static_cast<size_t>(i) * k;
+        int32_t s = 0;
+        for (int p = 0; p < k; ++p) s += ai[p];
+        sums[i] = s;
+    }
+}
+
+/*!
+ * \brief Turn the dot products of quantized rows into the float dot products
+ *  of the values they represent. With x = min_a + qa * da and
+ *  w = min_b + qb * db, the dot product over k elements is
+ *  k * min_a * min_b + min_a * db * sum(qb) + min_b * da * sum(qa)
+ *  + da * db * sum(qa * qb).
+ */
+struct QuantizedDot {
+    float min_a, step_a, min_b, step_b;
+    int k;
+    float operator()(int32_t acc, int32_t sum_a, int32_t sum_b) const {
+        return k * min_a * min_b + min_a * step_b * sum_b +
+               min_b * step_a * sum_a + step_a * step_b * acc;
+    }
+};
+
+/*!
+ * \brief unfold one group of a 2D NCHW image into rows, one per output
+ *  position, holding the patch of every channel under the kernel. Padding
+ *  is filled with pad_value, the quantized zero.
+ */
+inline void quantized_im2row(const uint8_t* data, int channels, int height,
+                             int width, int kernel_h, int kernel_w, int pad_h,
+                             int pad_w, int stride_h, int stride_w,
+                             int dilate_h, int dilate_w, int out_h, int out_w,
+                             uint8_t pad_value, uint8_t* rows) {
+    const int row_size = channels * kernel_h * kernel_w;
+#pragma omp parallel for
+    for (int p = 0; p < out_h * out_w; ++p) {
+        const int oh = p / out_w, ow = p % out_w;
+        uint8_t* row = rows + static_cast<size_t>(p) * row_size;
+        for (int c = 0; c < channels; ++c) {
+            const uint8_t* plane =
+                data + static_cast<size_t>(c) * height * width;
+            for (int kh = 0; kh < kernel_h; ++kh) {
+                const int h = oh * stride_h - pad_h + kh * dilate_h;
+                for (int kw = 0; kw < kernel_w; ++kw) {
+                    const int w = ow * stride_w - pad_w + kw * dilate_w;
+                    *row++ = h >= 0 && h < height && w >= 0 && w < width
+                                 ? plane[h * width + w]
+                                 : pad_value;
+                }
+            }
+        }
+    }
+}
+
+}  // namespace op
+}  // namespace mxnet
+#endif  // MXNET_OPERATOR_CONTRIB_QUANTIZED_OPS_INL_H_
@@ -0,0 +1,469 @@
+/*!
+ *  Copyright (c) 2017 by Contributors
+ * \file quantized_ops.cc
+ * \brief FullyConnected, Convolution, Pooling, Flatten and relu on uint8
+ *  data quantized by `quantize`. The graph pass `QuantizeGraph` substitutes
+ *  them for the float operators of a network.
+ */
+#include <cstring>
+#include "../convolution-inl.h"
+#include "../fully_connected-inl.h"
+#include "../nn/pool.h"
+#include "../pooling-inl.h"
+#include "./quantized_ops-inl.h"
+
+namespace mxnet {
+namespace op {
+DMLC_REGISTER_PARAMETER(QuantizedRangeParam);
+
+template <typename PType>
+uint32_t QuantizedOpNumInputs(const nnvm::NodeAttrs& attrs) {
+    // the ranges of data and weight follow the arguments
+    return GetQuantizedOpAttrs<PType>(attrs).prop->ListArguments().size() + 4;
+}
+
+template <typename PType>
+std::vector<std::string> QuantizedOpInputNames(const nnvm::NodeAttrs& attrs) {
+    std::vector<std::string> ret =
+        GetQuantizedOpAttrs<PType>(attrs).prop->ListArguments();
+    for (const char* name :
+         {"min_data", "max_data", "min_weight", "max_weight"}) {
+        ret.push_back(name);
+    }
+    return ret;
+}
+
+std::vector<std::string> QuantizedDataInputNames(
+    const nnvm::NodeAttrs& attrs) {
+    return {"data", "min_data", "max_data"};
+}
+
+std::vector<std::string> QuantizedOutputNames(const nnvm::NodeAttrs& attrs) {
+    return {"output", "min_output", "max_output"};
+}
+
+/*!
+ * \brief infer the shapes by running the inference of the float operator;
+ *  every range is a scalar
+ */
+template <typename PType>
+bool QuantizedOpInferShape(const nnvm::NodeAttrs& attrs,
+                           std::vector<TShape>* in_shape,
+                           std::vector<TShape>* out_shape) {
+    const OperatorProperty* prop =
+        GetQuantizedOpAttrs<PType>(attrs).prop.get();
+    const size_t num_args = prop->ListArguments().size();
+    std::vector<TShape> args(in_shape->begin(),
+                             in_shape->begin() + num_args);
+    std::vector<TShape> outs, aux;
+    if (!prop->InferShape(&args, &outs, &aux)) return false;
+    for (size_t i = 0; i < num_args; ++i) {
+        SHAPE_ASSIGN_CHECK(*in_shape, i, args[i]);
+    }
+    for (size_t i = num_args; i < in_shape->size(); ++i) {
+        SHAPE_ASSIGN_CHECK(*in_shape, i, TShape{1});
+    }
+    SHAPE_ASSIGN_CHECK(*out_shape, quantized::kOut, outs[0]);
+    SHAPE_ASSIGN_CHECK(*out_shape, quantized::kMinOut, TShape{1});
+    SHAPE_ASSIGN_CHECK(*out_shape, quantized::kMaxOut, TShape{1});
+    return true;
+}
+
+/*! \brief data and weight are quantized, the bias and the ranges float */
+template <typename PType>
+bool QuantizedOpInferType(const nnvm::NodeAttrs& attrs,
+                          std::vector<int>* in_type,
+                          std::vector<int>* out_type) {
+    const size_t num_args =
+        GetQuantizedOpAttrs<PType>(attrs).prop->ListArguments().size();
+    CHECK_EQ(in_type->size(), num_args + 4);
+    for (size_t i = 0; i < in_type->size(); ++i) {
+        TYPE_ASSIGN_CHECK(*in_type, i,
+                          i < 2 ? mshadow::kUint8 : mshadow::kFloat32);
+    }
+    TYPE_ASSIGN_CHECK(*out_type, quantized::kOut, mshadow::kUint8);
+    TYPE_ASSIGN_CHECK(*out_type, quantized::kMinOut, mshadow::kFloat32);
+    TYPE_ASSIGN_CHECK(*out_type, quantized::kMaxOut, mshadow::kFloat32);
+    return true;
+}
+
+bool QuantizedDataInferType(const nnvm::NodeAttrs& attrs,
+                            std::vector<int>* in_type,
+                            std::vector<int>* out_type) {
+    CHECK_EQ(in_type->size(), 3U);
+    TYPE_ASSIGN_CHECK(*in_type, 0, mshadow::kUint8);
+    TYPE_ASSIGN_CHECK(*in_type, 1, mshadow::kFloat32);
+    TYPE_ASSIGN_CHECK(*in_type, 2, mshadow::kFloat32);
+    TYPE_ASSIGN_CHECK(*out_type, quantized::kOut, mshadow::kUint8);
+    TYPE_ASSIGN_CHECK(*out_type, quantized::kMinOut, mshadow::kFloat32);
+    TYPE_ASSIGN_CHECK(*out_type, quantized::kMaxOut, mshadow::kFloat32);
+    return true;
+}
+
+bool QuantizedFlattenShape(const nnvm::NodeAttrs& attrs,
+                           std::vector<TShape>* in_shape,
+                           std::vector<TShape>* out_shape) {
+    CHECK_EQ(in_shape->size(), 3U);
+    const TShape& dshape = (*in_shape)[0];
+    if (dshape.ndim() == 0) return false;
+    SHAPE_ASSIGN_CHECK(*in_shape, 1, TShape{1});
+    SHAPE_ASSIGN_CHECK(*in_shape, 2, TShape{1});
+    SHAPE_ASSIGN_CHECK(*out_shape, quantized::kOut,
+                       mshadow::Shape2(dshape[0], dshape.Size() / dshape[0]));
+    SHAPE_ASSIGN_CHECK(*out_shape, quantized::kMinOut, TShape{1});
+    SHAPE_ASSIGN_CHECK(*out_shape, quantized::kMaxOut, TShape{1});
+    return true;
+}
+
+bool QuantizedElemwiseShape(const nnvm::NodeAttrs& attrs,
+                            std::vector<TShape>* in_shape,
+                            std::vector<TShape>* out_shape) {
+    CHECK_EQ(in_shape->size(), 3U);
+    const TShape& dshape = (*in_shape)[0];
+    if (dshape.ndim() == 0) return false;
+    SHAPE_ASSIGN_CHECK(*in_shape, 1, TShape{1});
+    SHAPE_ASSIGN_CHECK(*in_shape, 2, TShape{1});
+    SHAPE_ASSIGN_CHECK(*out_shape, quantized::kOut, dshape);
+    SHAPE_ASSIGN_CHECK(*out_shape, quantized::kMinOut, TShape{1});
+    SHAPE_ASSIGN_CHECK(*out_shape, quantized::kMaxOut, TShape{1});
+    return true;
+}
+
+void QuantizedFullyConnectedCompute(const nnvm::NodeAttrs& attrs,
+                                    const OpContext& ctx,
+                                    const std::vector<TBlob>& inputs,
+                                    const std::vector<OpReqType>& req,
+                                    const std::vector<TBlob>& outputs) {
+    using namespace mshadow;
+    const auto& qattrs = GetQuantizedOpAttrs<FullyConnectedParam>(attrs);
+    if (req[quantized::kOut] == kNullOp) return;
+    CHECK_EQ(req[quantized::kOut], kWriteTo)
+        << "quantized_fully_connected only supports write";
+    const size_t num_args = qattrs.param.no_bias ? 2 : 3;
+    const float min_data = *inputs[num_args].dptr<float>();
+    const float max_data = *inputs[num_args + 1].dptr<float>();
+    const float min_weight = *inputs[num_args + 2].dptr<float>();
+    const float max_weight = *inputs[num_args + 3].dptr<float>();
+    const TBlob& data = inputs[fullc::kData];
+    const int num = data.shape_[0];
+    const int k = data.Size() / num;
+    const int hidden = qattrs.param.num_hidden;
+    const float* bias =
+        qattrs.param.no_bias ? NULL : inputs[fullc::kBias].dptr<float>();
+    // float results first, then the int32 accumulators
+    const size_t size = static_cast<size_t>(num) * hidden;
+    Tensor<cpu, 1, uint8_t> workspace =
+        ctx.requested[0].get_space_typed<cpu, 1, uint8_t>(
+            Shape1(size * (sizeof(float) + sizeof(int32_t))),
+            ctx.get_stream<cpu>());
+    float* result = reinterpret_cast<float*>(workspace.dptr_);
+    int32_t* acc = reinterpret_cast<int32_t*>(result + size);
+    const uint8_t* x = data.dptr<uint8_t>();
+    const uint8_t* w = inputs[fullc::kWeight].dptr<uint8_t>();
+    std::vector<int32_t> sum_x(num), sum_w(hidden);
+    quantized_row_sums(x, num, k, sum_x.data());
+    quantized_row_sums(w, hidden, k, sum_w.data());
+    quantized_gemm(x, w, num, hidden, k, acc);
+    const QuantizedDot dot{min_data, quantized_step(min_data, max_data),
+                           min_weight, quantized_step(min_weight, max_weight),
+                           k};
+    const index_t total = static_cast<index_t>(size);
+#pragma omp parallel for
+    for (index_t i = 0; i < total; ++i) {
+        const int n = i / hidden, j = i % hidden;
+        result[i] = dot(acc[i], sum_x[n], sum_w[j]) + (bias ? bias[j] : 0.0f);
+    }
+    quantize_to_range(result, size, qattrs.range,
+                      outputs[quantized::kOut].dptr<uint8_t>(),
+                      outputs[quantized::kMinOut].dptr<float>(),
+                      outputs[quantized::kMaxOut].dptr<float>());
+}
+
+void QuantizedConvolutionCompute(const nnvm::NodeAttrs& attrs,
+                                 const OpContext& ctx,
+                                 const std::vector<TBlob>& inputs,
+                                 const std::vector<OpReqType>& req,
+                                 const std::vector<TBlob>& outputs) {
+    using namespace mshadow;
+    const auto& qattrs = GetQuantizedOpAttrs<ConvolutionParam>(attrs);
+    const ConvolutionParam& param = qattrs.param;
+    if (req[quantized::kOut] == kNullOp) return;
+    CHECK_EQ(req[quantized::kOut], kWriteTo)
+        << "quantized_conv only supports write";
+    CHECK_EQ(param.kernel.ndim(), 2U) << "quantized_conv only supports 2D";
+    CHECK_EQ(param.layout.value(), kNCHW)
+        << "quantized_conv only supports NCHW";
+    const size_t num_args = param.no_bias ? 2 : 3;
+    const float min_data = *inputs[num_args].dptr<float>();
+    const float max_data = *inputs[num_args + 1].dptr<float>();
+    const float min_weight = *inputs[num_args + 2].dptr<float>();
+    const float max_weight = *inputs[num_args + 3].dptr<float>();
+    const TShape& ishape = inputs[conv::kData].shape_;
+    const TShape& oshape = outputs[quantized::kOut].shape_;
+    const int groups = param.num_group;
+    const int channels = ishape[1] / groups;
+    const int filters = oshape[1] / groups;
+    const int image = ishape[2] * ishape[3];
+    const int positions = oshape[2] * oshape[3];
+    const int row_size = channels * param.kernel[0] * param.kernel[1];
+    const float* bias =
+        param.no_bias ? NULL : inputs[conv::kBias].dptr<float>();
+    // float results, then the int32 accumulators and the rows of one group
+    const size_t size = oshape.Size();
+    const size_t acc_size = static_cast<size_t>(filters) * positions;
+    const size_t rows_size = static_cast<size_t>(positions) * row_size;
+    Tensor<cpu, 1, uint8_t> workspace =
+        ctx.requested[0].get_space_typed<cpu, 1, uint8_t>(
+            Shape1(size * sizeof(float) + acc_size * sizeof(int32_t) +
+                   rows_size),
+            ctx.get_stream<cpu>());
+    float* result = reinterpret_cast<float*>(workspace.dptr_);
+    int32_t* acc = reinterpret_cast<int32_t*>(result + size);
+    uint8_t* rows = reinterpret_cast<uint8_t*>(acc + acc_size);
+    const uint8_t* x = inputs[conv::kData].dptr<uint8_t>();
+    const uint8_t* w = inputs[conv::kWeight].dptr<uint8_t>();
+    std::vector<int32_t> sum_w(oshape[1]), sum_rows(positions);
+    quantized_row_sums(w, oshape[1], row_size, sum_w.data());
+    // padding holds the quantized zero of the data
+    const uint8_t pad_value = quantize_value(0.0f, min_data, max_data);
+    const QuantizedDot dot{min_weight, quantized_step(min_weight, max_weight),
+                           min_data, quantized_step(min_data, max_data),
+                           row_size};
+    for (index_t n = 0; n < ishape[0]; ++n) {
+        for (int g = 0; g < groups; ++g) {
+            quantized_im2row(
+                x + (n * groups + g) * static_cast<size_t>(channels) * image,
+                channels, ishape[2], ishape[3], param.kernel[0],
+                param.kernel[1], param.pad[0], param.pad[1], param.stride[0],
+                param.stride[1], param.dilate[0], param.dilate[1], oshape[2],
+                oshape[3], pad_value, rows);
+            quantized_row_sums(rows, positions, row_size, sum_rows.data());
+            const int f0 = g * filters;
+            quantized_gemm(w + static_cast<size_t>(f0) * row_size, rows,
+                           filters, positions, row_size, acc);
+            float* out = result + (n * oshape[1] + f0) *
+                                      static_cast<size_t>(positions);
+#pragma omp parallel for
+            for (int f = 0; f < filters; ++f) {
+                const float b = bias ? bias[f0 + f] : 0.0f;
+                for (int p = 0; p < positions; ++p) {
+                    out[f * positions + p] =
+                        dot(acc[f * positions + p], sum_w[f0 + f],
+                            sum_rows[p]) +
+                        b;
+                }
+            }
+        }
+    }
+    quantize_to_range(result, size, qattrs.range,
+                      outputs[quantized::kOut].dptr<uint8_t>(),
+                      outputs[quantized::kMinOut].dptr<float>(),
+                      outputs[quantized::kMaxOut].dptr<float>());
+}
+
+/*! \brief the range of the data is passed through unchanged */
+inline void CopyRange(const std::vector<TBlob>& inputs,
+                      const std::vector<TBlob>& outputs) {
+    *outputs[quantized::kMinOut].dptr<float>() = *inputs[1].dptr<float>();
+    *outputs[quantized::kMaxOut].dptr<float>() = *inputs[2].dptr<float>();
+}
+
+void QuantizedPoolingCompute(const nnvm::NodeAttrs& attrs,
+                             const OpContext& ctx,
+                             const std::vector<TBlob>& inputs,
+                             const std::vector<OpReqType>& req,
+                             const std::vector<TBlob>& outputs) {
+    const PoolingParam& param =
+        GetQuantizedOpAttrs<PoolingParam>(attrs).param;
+    if (req[quantized::kOut] == kNullOp) return;
+    // the maximum of quantized values represents the maximum of the values
+    CHECK_EQ(param.pool_type, pool_enum::kMaxPooling)
+        << "quantized_pooling only supports max pooling";
+    const TShape& ishape = inputs[0].shape_;
+    const int nspatial = param.kernel.ndim();
+    pool(ctx.get_stream<cpu>(), inputs[0].dptr<uint8_t>(), ishape,
+         outputs[quantized::kOut].shape_,
+         param.global_pool ? TShape(ishape.data() + ishape.ndim() - nspatial,
+                                    ishape.data() + ishape.ndim())
+                           : param.kernel,
+         param.pad, param.global_pool ? TShape(nspatial) : param.stride,
+         param.pool_type, req[quantized::kOut],
+         outputs[quantized::kOut].dptr<uint8_t>());
+    CopyRange(inputs, outputs);
+}
+
+void QuantizedFlattenCompute(const nnvm::NodeAttrs& attrs,
+                             const OpContext& ctx,
+                             const std::vector<TBlob>& inputs,
+                             const std::vector<OpReqType>& req,
+                             const std::vector<TBlob>& outputs) {
+    if (req[quantized::kOut] == kNullOp) return;
+    if (req[quantized::kOut] != kWriteInplace) {
+        std::memcpy(outputs[quantized::kOut].dptr_, inputs[0].dptr_,
+                    inputs[0].Size());
+    }
+    CopyRange(inputs, outputs);
+}
+
+void QuantizedReluCompute(const nnvm::NodeAttrs& attrs, const OpContext& ctx,
+                          const std::vector<TBlob>& inputs,
+                          const std::vector<OpReqType>& req,
+                          const std::vector<TBlob>& outputs) {
+    if (req[quantized::kOut] == kNullOp) return;
+    const float min_data = *inputs[1].dptr<float>();
+    const float max_data = *inputs[2].dptr<float>();
+    const uint8_t* in = inputs[0].dptr<uint8_t>();
+    uint8_t* out = outputs[quantized::kOut].dptr<uint8_t>();
+    const index_t size = inputs[0].Size();
+    if (max_data <= 0.0f) {
+        // every value is clipped to zero, which the range [0, 0] represents
+        std::memset(out, 0, size);
+        *outputs[quantized::kMinOut].dptr<float>() = 0.0f;
+        *outputs[quantized::kMaxOut].dptr<float>() = 0.0f;
+        return;
+    }
+    // values below the quantized zero are raised to it
+    const uint8_t zero = quantize_value(0.0f, min_data, max_data);
+#pragma omp parallel for
+    for (index_t i = 0; i < size; ++i) {
+        out[i] = std::max(in[i], zero);
+    }
+    CopyRange(inputs, outputs);
+}
+
+std::vector<ResourceRequest> QuantizedTempSpace(const nnvm::NodeAttrs& attrs) {
+    return {ResourceRequest::kTempSpace};
+}
+
+NNVM_REGISTER_OP(_contrib_quantized_fully_connected)
+    .describe(R"code(FullyConnected on uint8 data and weight quantized by
+`quantize`, with int32 accumulation.
+
+The bias stays float. The output is quantized into
+[min_calib_range, max_calib_range] when given, or into its own range.
+)code" ADD_FILELINE)
+    .set_num_inputs(QuantizedOpNumInputs<FullyConnectedParam>)
+    .set_num_outputs(3)
+    .set_attr_parser([](nnvm::NodeAttrs* attrs) {
+        QuantizedOpAttrParser<FullyConnectedParam>(attrs, "FullyConnected");
+    })
+    .set_attr<nnvm::FListInputNames>(
+        "FListInputNames", QuantizedOpInputNames<FullyConnectedParam>)
+    .set_attr<nnvm::FListOutputNames>("FListOutputNames",
+                                      QuantizedOutputNames)
+    .set_attr<nnvm::FInferShape>("FInferShape",
+                                 QuantizedOpInferShape<FullyConnectedParam>)
+    .set_attr<nnvm::FInferType>("FInferType",
+                                QuantizedOpInferType<FullyConnectedParam>)
+    .set_attr<FResourceRequest>("FResourceRequest", QuantizedTempSpace)
+    .set_attr<FCompute>("FCompute<cpu>", QuantizedFullyConnectedCompute)
+    .add_argument("data", "NDArray-or-Symbol", "Quantized input data.")
+    .add_argument("weight", "NDArray-or-Symbol", "Quantized weight.")
+    .add_argument("bias", "NDArray-or-Symbol", "Float bias.")
+    .add_argument("min_data", "NDArray-or-Symbol", "Minimum of data.")
+    .add_argument("max_data", "NDArray-or-Symbol", "Maximum of data.")
+    .add_argument("min_weight", "NDArray-or-Symbol", "Minimum of weight.")
+    .add_argument("max_weight", "NDArray-or-Symbol", "Maximum of weight.")
+    .add_arguments(FullyConnectedParam::__FIELDS__())
+    .add_arguments(QuantizedRangeParam::__FIELDS__());
+
+NNVM_REGISTER_OP(_contrib_quantized_conv)
+    .describe(R"code(2D NCHW Convolution on uint8 data and weight quantized by
+`quantize`, with int32 accumulation.
+
+The bias stays float. The output is quantized into
+[min_calib_range, max_calib_range] when given, or into its own range.
+)code" ADD_FILELINE)
+    .set_num_inputs(QuantizedOpNumInputs<ConvolutionParam>)
+    .set_num_outputs(3)
+    .set_attr_parser([](nnvm::NodeAttrs* attrs) {
+        QuantizedOpAttrParser<ConvolutionParam>(attrs, "Convolution");
+    })
+    .set_attr<nnvm::FListInputNames>("FListInputNames",
+                                     QuantizedOpInputNames<ConvolutionParam>)
+    .set_attr<nnvm::FListOutputNames>("FListOutputNames",
+                                      QuantizedOutputNames)
+    .set_attr<nnvm::FInferShape>("FInferShape",
+                                 QuantizedOpInferShape<ConvolutionParam>)
+    .set_attr<nnvm::FInferType>("FInferType",
+                                QuantizedOpInferType<ConvolutionParam>)
+    .set_attr<FResourceRequest>("FResourceRequest", QuantizedTempSpace)
+    .set_attr<FCompute>("FCompute<cpu>", QuantizedConvolutionCompute)
+    .add_argument("data", "NDArray-or-Symbol", "Quantized input data.")
+    .add_argument("weight", "NDArray-or-Symbol", "Quantized weight.")
+    .add_argument("bias", "NDArray-or-Symbol", "Float bias.")
+    .add_argument("min_data", "NDArray-or-Symbol", "Minimum of data.")
+    .add_argument("max_data", "NDArray-or-Symbol", "Maximum of data.")
+    .add_argument("min_weight", "NDArray-or-Symbol", "Minimum of weight.")
+    .add_argument("max_weight", "NDArray-or-Symbol", "Maximum of weight.")
+    .add_arguments(ConvolutionParam::__FIELDS__())
+    .add_arguments(QuantizedRangeParam::__FIELDS__());
+
+NNVM_REGISTER_OP(_contrib_quantized_pooling)
+    .describe(R"code(Max Pooling on uint8 data quantized by `quantize`.
+The output keeps the range of the data.
+)code" ADD_FILELINE)
+    .set_num_inputs(3)
+    .set_num_outputs(3)
+    .set_attr_parser([](nnvm::NodeAttrs* attrs) {
+        QuantizedOpAttrParser<PoolingParam>(attrs, "Pooling");
+    })
+    .set_attr<nnvm::FListInputNames>("FListInputNames",
+                                     QuantizedDataInputNames)
+    .set_attr<nnvm::FListOutputNames>("FListOutputNames",
+                                      QuantizedOutputNames)
+    .set_attr<nnvm::FInferShape>("FInferShape",
+                                 QuantizedOpInferShape<PoolingParam>)
+    .set_attr<nnvm::FInferType>("FInferType", QuantizedDataInferType)
+    .set_attr<FCompute>("FCompute<cpu>", QuantizedPoolingCompute)
+    .add_argument("data", "NDArray-or-Symbol", "Quantized input data.")
+    .add_argument("min_data", "NDArray-or-Symbol", "Minimum of data.")
+    .add_argument("max_data", "NDArray-or-Symbol", "Maximum of data.")
+    .add_arguments(PoolingParam::__FIELDS__());
+
+NNVM_REGISTER_OP(_contrib_quantized_flatten)
+    .describe(R"code(Flatten uint8 data quantized by `quantize`.
+The output keeps the range of the data.
+)code" ADD_FILELINE)
+    .set_num_inputs(3)
+    .set_num_outputs(3)
+    .set_attr<nnvm::FListInputNames>("FListInputNames",
+                                     QuantizedDataInputNames)
+    .set_attr<nnvm::FListOutputNames>("FListOutputNames",
+                                      QuantizedOutputNames)
+    .set_attr<nnvm::FInferShape>("FInferShape", QuantizedFlattenShape)
+    .set_attr<nnvm::FInferType>("FInferType", QuantizedDataInferType)
+    .set_attr<nnvm::FInplaceOption>("FInplaceOption",
+                                    [](const NodeAttrs& attrs) {
+                                        return std::vector<
+                                            std::pair<int, int> >{{0, 0}};
+                                    })
+    .set_attr<FCompute>("FCompute<cpu>", QuantizedFlattenCompute)
+    .add_argument("data", "NDArray-or-Symbol", "Quantized input data.")
+    .add_argument("min_data", "NDArray-or-Symbol", "Minimum of data.")
+    .add_argument("max_data", "NDArray-or-Symbol", "Maximum of data.");
+
+NNVM_REGISTER_OP(_contrib_quantized_relu)
+    .describe(R"code(relu on uint8 data quantized by `quantize`.
+The output keeps the range of the data unless the data is all negative.
+)code" ADD_FILELINE)
+    .set_num_inputs(3)
+    .set_num_outputs(3)
+    .set_attr<nnvm::FListInputNames>("FListInputNames",
+                                     QuantizedDataInputNames)
+    .set_attr<nnvm::FListOutputNames>("FListOutputNames",
+                                      QuantizedOutputNames)
+    .set_attr<nnvm::FInferShape>("FInferShape", QuantizedElemwiseShape)
+    .set_attr<nnvm::FInferType>("FInferType", QuantizedDataInferType)
+    .set_attr<nnvm::FInplaceOption>("FInplaceOption",
+                                    [](const NodeAttrs& attrs) {
+                                        return std::vector<
+                                            std::pair<int, int> >{{0, 0}};
+                                    })
+    .set_attr<FCompute>("FCompute<cpu>", QuantizedReluCompute)
+    .add_argument("data", "NDArray-or-Symbol", "Quantized input data.")
+    .add_argument("min_data", "NDArray-or-Symbol", "Minimum of data.")
+    .add_argument("max_data", "NDArray-or-Symbol", "Maximum of data.");
+
+}  // namespace op
+}  // namespace mxnet
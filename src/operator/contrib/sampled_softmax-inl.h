@@ -0,0 +1,510 @@
+/*!
+ *  Copyright (c) 2017 by Contributors
+ * \file sampled_softmax-inl.h
+ * \brief candidate sampling, and the logits of sampled softmax, which trains
+ *  a softmax over many classes from the true class and a few sampled ones
+ */
+#ifndef MXNET_OPERATOR_CONTRIB_SAMPLED_SOFTMAX_INL_H_
+#define MXNET_OPERATOR_CONTRIB_SAMPLED_SOFTMAX_INL_H_
+
+#include <dmlc/parameter.h>
+#include <mxnet/operator_util.h>
+#include <mxnet/random_generator.h>
+#include <algorithm>
+#include <cmath>
+#include <unordered_set>
+#include <vector>
+#include "../elemwise_op_common.h"
+#include "../mshadow_op.h"
+#include "../mxnet_op.h"
+#include "../operator_common.h"
+#include "../tensor/indexing_op.h"
+#include "../tensor/parallel_sampler.h"
+
+namespace mxnet {
+namespace op {
+
+namespace sampled_logits {
+enum SampledLogitsOpInputs {
+    kData,
+    kWeight,
+    kBias,
+    kLabel,
+    kSampled,
+    kTrueCount,
+    kSampledCount
+};
+}  // namespace sampled_logits
+
+struct LogUniformSamplerParam
+    : public dmlc::Parameter<LogUniformSamplerParam> {
+    int num_sampled;
+    int range_max;
+    bool unique;
+    DMLC_DECLARE_PARAMETER(LogUniformSamplerParam) {
+        DMLC_DECLARE_FIELD(num_sampled)
+            .set_lower_bound(1)
+            .describe("Number of classes to sample.");
+        DMLC_DECLARE_FIELD(range_max)
+            .set_lower_bound(1)
+            .describe("Number of classes, sampled from [0, range_max).");
+        DMLC_DECLARE_FIELD(unique)
+            .set_default(true)
+            .describe("Whether the sampled classes are distinct.");
+    }
+};
+
+struct UnigramSamplerParam : public dmlc::Parameter<UnigramSamplerParam> {
+    int num_sampled;
+    bool unique;
+    float distortion;
+    DMLC_DECLARE_PARAMETER(UnigramSamplerParam) {
+        DMLC_DECLARE_FIELD(num_sampled)
+            .set_lower_bound(1)
+            .describe("Number of classes to sample.");
+        DMLC_DECLARE_FIELD(unique)
+            .set_default(true)
+            .describe("Whether the sampled classes are distinct.");
+        DMLC_DECLARE_FIELD(distortion)
+            .set_default(1.0f)
+            .describe(
+                "Class k is drawn with probability proportional to "
+                "counts[k] ^ distortion.");
+    }
+};
+
+struct SampledLogitsParam : public dmlc::Parameter<SampledLogitsParam> {
+    bool remove_accidental_hits;
+    bool subtract_log_q;
+    DMLC_DECLARE_PARAMETER(SampledLogitsParam) {
+        DMLC_DECLARE_FIELD(remove_accidental_hits)
+            .set_default(true)
+            .describe(
+                "Whether to mask the sampled classes that equal the true "
+                "class of a row.");
+        DMLC_DECLARE_FIELD(subtract_log_q)
+            .set_default(true)
+            .describe(
+                "Whether to subtract the log of the expected counts from the "
+                "logits, which corrects for the sampling.");
+    }
+};
+
+/*!
+ * \brief P(k) = log((k + 2) / (k + 1)) / log(range_max + 1), which is close
+ *  to the frequency of the k-th most frequent word
+ */
+class LogUniformDistribution {
+   public:
+    explicit LogUniformDistribution(index_t range_max)
+        : range_max_(range_max), log_range_(std::log(range_max + 1.0)) {}
+    inline index_t size() const { return range_max_; }
+    inline index_t Sample(RandomSampler<double>* sampler) const {
+        const double k = std::exp(sampler->Uniform() * log_range_) - 1.0;
+        return std::min(static_cast<index_t>(k), range_max_ - 1);
+    }
+    inline double Probability(index_t k) const {
+        return std::log((k + 2.0) / (k + 1.0)) / log_range_;
+    }
+
+   private:
+    index_t range_max_;
+    double log_range_;
+};
+
+/*! \brief P(k) proportional to counts[k] ^ distortion */
+class UnigramDistribution {
+   public:
+    template <typename DType>
+    UnigramDistribution(const DType* counts, index_t size, double distortion)
+        : cdf_(size) {
+        double total = 0.0;
+        for (index_t k = 0; k < size; ++k) {
+            const double count = static_cast<double>(counts[k]);
+            CHECK_GE(count, 0.0) << "unigram counts must not be negative";
+            total += std::pow(count, distortion);
+            cdf_[k] = total;
+        }
+        CHECK_GT(total, 0.0) << "unigram counts must not all be zero";
+        for (index_t k = 0; k < size; ++k) cdf_[k] /= total;
+    }
+    inline index_t size() const { return cdf_.size(); }
+    inline index_t Sample(RandomSampler<double>* sampler) const {
+        const index_t k =
+            std::upper_bound(cdf_.begin(), cdf_.end(), sampler->Uniform()) -
+            cdf_.begin();
+        return std::min(k, size() - 1);
+    }
+    inline double Probability(index_t k) const {
+        return k == 0 ? cdf_[0] : cdf_[k] - cdf_[k - 1];
+    }
+
+   private:
+    std::vector<double> cdf_;
+};
+
+/*! \brief the class of a label, clipped to [0, num_class) as by take */
+template <typename DType>
+MSHADOW_XINLINE int ClipClass(DType label, int num_class) {
+    const int k = static_cast<int>(label);
+    return k <= 0 ? 0 : (k >= num_class ? num_class - 1 : k);
+}
+
+/*!
+ * \brief Draw the candidates and the number of times each candidate and each
+ *  true class is expected to be drawn: num_sampled * P(k), or with unique
+ *  sampling the probability that one of the draws made until num_sampled
+ *  distinct classes came up is k.
+ */
+template <typename Distribution, typename DType>
+inline void SampleCandidates(const Distribution& dist,
+                             const random::Philox4x32& gen,
+                             index_t num_sampled, bool unique,
+                             const DType* true_classes, index_t num_true,
+                             DType* sampled, DType* true_count,
+                             DType* sampled_count) {
+    RandomSampler<double> sampler(gen);
+    double num_tries = 0.0;
+    if (unique) {
+        CHECK_LE(num_sampled, dist.size())
+            << "cannot sample " << num_sampled << " distinct classes out of "
+            << dist.size();
+        std::unordered_set<index_t> seen;
+        for (index_t i = 0; i < num_sampled; num_tries += 1.0) {
+            const index_t k = dist.Sample(&sampler);
+            if (seen.insert(k).second) sampled[i++] = DType(k);
+        }
+    } else {
+        for (index_t i = 0; i < num_sampled; ++i) {
+            sampled[i] = DType(dist.Sample(&sampler));
+        }
+    }
+    const int num_class = dist.size();
+    auto expected = [&](DType label) {
+        const double p = dist.Probability(ClipClass(label, num_class));
+        return DType(unique ? -std::expm1(num_tries * std::log1p(-p))
+                            : num_sampled * p);
+    };
+    for (index_t i = 0; i < num_sampled; ++i) {
+        sampled_count[i] = expected(sampled[i]);
+    }
+    for (index_t i = 0; i < num_true; ++i) {
+        true_count[i] = expected(true_classes[i]);
+    }
+}
+
+template <typename Distribution>
+inline void SampleCandidatesCompute(const Distribution& dist,
+                                    int num_sampled, bool unique,
+                                    const OpContext& ctx,
+                                    const std::vector<TBlob>& inputs,
+                                    const std::vector<TBlob>& outputs) {
+    // one stream per call, as the draws of unique sampling are sequential
+    random::ParallelRandom* rnd = ctx.requested[0].get_parallel_random();
+    const random::Philox4x32 gen = rnd->Stream(rnd->Reserve(1));
+    MSHADOW_REAL_TYPE_SWITCH(outputs[0].type_flag_, DType, {
+        SampleCandidates(dist, gen, num_sampled, unique,
+                         inputs[0].dptr<DType>(), inputs[0].Size(),
+                         outputs[0].dptr<DType>(), outputs[1].dptr<DType>(),
+                         outputs[2].dptr<DType>());
+    });
+}
+
+inline void LogUniformSamplerCompute(const nnvm::NodeAttrs& attrs,
+                                     const OpContext& ctx,
+                                     const std::vector<TBlob>& inputs,
+                                     const std::vector<OpReqType>& req,
+                                     const std::vector<TBlob>& outputs) {
+    const LogUniformSamplerParam& param =
+        nnvm::get<LogUniformSamplerParam>(attrs.parsed);
+    SampleCandidatesCompute(LogUniformDistribution(param.range_max),
+                            param.num_sampled, param.unique, ctx, inputs,
+                            outputs);
+}
+
+inline void UnigramSamplerCompute(const nnvm::NodeAttrs& attrs,
+                                  const OpContext& ctx,
+                                  const std::vector<TBlob>& inputs,
+                                  const std::vector<OpReqType>& req,
+                                  const std::vector<TBlob>& outputs) {
+    const UnigramSamplerParam& param =
+        nnvm::get<UnigramSamplerParam>(attrs.parsed);
+    MSHADOW_REAL_TYPE_SWITCH(inputs[1].type_flag_, CType, {
+        SampleCandidatesCompute(
+            UnigramDistribution(inputs[1].dptr<CType>(), inputs[1].Size(),
+                                param.distortion),
+            param.num_sampled, param.unique, ctx, inputs, outputs);
+    });
+}
+
+/*! \brief the shapes of the sampled classes and of the expected counts */
+template <typename PType>
+inline bool CandidateSamplerShape(const nnvm::NodeAttrs& attrs,
+                                  std::vector<TShape>* in_attrs,
+                                  std::vector<TShape>* out_attrs) {
+    const PType& param = nnvm::get<PType>(attrs.parsed);
+    if ((*in_attrs)[0].ndim() == 0) return false;
+    SHAPE_ASSIGN_CHECK(*out_attrs, 0, mshadow::Shape1(param.num_sampled));
+    SHAPE_ASSIGN_CHECK(*out_attrs, 1, (*in_attrs)[0]);
+    SHAPE_ASSIGN_CHECK(*out_attrs, 2, mshadow::Shape1(param.num_sampled));
+    if (in_attrs->size() > 1 && (*in_attrs)[1].ndim() != 0) {
+        CHECK_EQ((*in_attrs)[1].ndim(), 1U) << "counts must be 1D";
+    }
+    return true;
+}
+
+/*! \brief the outputs have the type of the true classes */
+inline bool CandidateSamplerType(const nnvm::NodeAttrs& attrs,
+                                 std::vector<int>* in_attrs,
+                                 std::vector<int>* out_attrs) {
+    if ((*in_attrs)[0] == -1) return false;
+    if (in_attrs->size() > 1 && (*in_attrs)[1] == -1) {
+        (*in_attrs)[1] = (*in_attrs)[0];
+    }
+    for (size_t i = 0; i < out_attrs->size(); ++i) {
+        TYPE_ASSIGN_CHECK(*out_attrs, i, (*in_attrs)[0]);
+    }
+    return true;
+}
+
+inline bool SampledLogitsShape(const nnvm::NodeAttrs& attrs,
+                               std::vector<TShape>* in_attrs,
+                               std::vector<TShape>* out_attrs) {
+    using namespace sampled_logits;
+    const TShape& dshape = (*in_attrs)[kData];
+    const TShape& wshape = (*in_attrs)[kWeight];
+    const TShape& sshape = (*in_attrs)[kSampled];
+    if (dshape.ndim() == 0 || wshape.ndim() == 0 || sshape.ndim() == 0) {
+        return false;
+    }
+    CHECK_EQ(dshape.ndim(), 2U) << "data must be (batch, dim)";
+    CHECK_EQ(wshape.ndim(), 2U) << "weight must be (num_class, dim)";
+    CHECK_EQ(sshape.ndim(), 1U) << "sampled must be 1D";
+    CHECK_EQ(dshape[1], wshape[1]) << "data and weight dim mismatch";
+    SHAPE_ASSIGN_CHECK(*in_attrs, kBias, mshadow::Shape1(wshape[0]));
+    SHAPE_ASSIGN_CHECK(*in_attrs, kLabel, mshadow::Shape1(dshape[0]));
+    SHAPE_ASSIGN_CHECK(*in_attrs, kTrueCount, mshadow::Shape1(dshape[0]));
+    SHAPE_ASSIGN_CHECK(*in_attrs, kSampledCount, sshape);
+    SHAPE_ASSIGN_CHECK(*out_attrs, 0,
+                       mshadow::Shape2(dshape[0], sshape[0] + 1));
+    return true;
+}
+
+/*! \brief logit of the true class of row i, into column 0 of out */
+struct sampled_logits_true {
+    template <typename DType>
+    MSHADOW_XINLINE static void Map(int i, DType* out, const DType* data,
+                                    const DType* w_true, const DType* bias,
+                                    const DType* label, const DType* count,
+                                    int dim, int num_col, int num_class,
+                                    bool subtract_log_q) {
+        DType sum = DType(0);
+        for (int k = 0; k < dim; ++k) {
+            sum += data[i * dim + k] * w_true[i * dim + k];
+        }
+        sum += bias[ClipClass(label[i], num_class)];
+        if (subtract_log_q) sum -= DType(logf(count[i]));
+        out[i * num_col] = sum;
+    }
+};
+
+/*! \brief logit of element i of the (batch, num_sampled) dot products */
+struct sampled_logits_sampled {
+    template <typename DType>
+    MSHADOW_XINLINE static void Map(int i, DType* out, const DType* dots,
+                                    const DType* bias, const DType* label,
+                                    const DType* sampled, const DType* count,
+                                    int num_sampled, int num_class,
+                                    bool subtract_log_q, bool remove_hits) {
+        const int row = i / num_sampled, j = i % num_sampled;
+        const int k = ClipClass(sampled[j], num_class);
+        DType logit = dots[i] + bias[k];
+        if (subtract_log_q) logit -= DType(logf(count[j]));
+        if (remove_hits && k == ClipClass(label[row], num_class)) {
+            logit = DType(-1e30f);
+        }
+        out[row * (num_sampled + 1) + 1 + j] = logit;
+    }
+};
+
+/*!
+ * \brief split the gradient of the logits into the true column and the
+ *  sampled columns, in which the accidental hits get no gradient
+ */
+struct sampled_logits_grad {
+    template <typename DType>
+    MSHADOW_XINLINE static void Map(int i, DType* grad_true,
+                                    DType* grad_sampled, const DType* ograd,
+                                    const DType* label, const DType* sampled,
+                                    int num_sampled, int num_class,
+                                    bool remove_hits) {
+        const int row = i / num_sampled, j = i % num_sampled;
+        const int num_col = num_sampled + 1;
+        if (j == 0) grad_true[row] = ograd[row * num_col];
+        const bool hit = remove_hits && ClipClass(sampled[j], num_class) ==
+                                            ClipClass(label[row], num_class);
+        grad_sampled[i] = hit ? DType(0) : ograd[row * num_col + 1 + j];
+    }
+};
+
+/*!
+ * \brief the classes of the rows of the gathered weight: the true classes
+ *  followed by the sampled ones, clipped as by take
+ */
+template <typename xpu, typename DType>
+inline void SampledLogitsClasses(mshadow::Stream<xpu>* s, const TBlob& label,
+                                 const TBlob& sampled, int num_class,
+                                 mshadow::Tensor<xpu, 1, DType> classes) {
+    using namespace mxnet_op;
+    const index_t batch = label.Size();
+    Kernel<tcast_clip, xpu>::Launch(s, batch, classes.dptr_,
+                                    label.dptr<DType>(), DType(num_class));
+    Kernel<tcast_clip, xpu>::Launch(s, sampled.Size(), classes.dptr_ + batch,
+                                    sampled.dptr<DType>(), DType(num_class));
+}
+
+template <typename xpu>
+void SampledLogitsForward(const nnvm::NodeAttrs& attrs, const OpContext& ctx,
+                          const std::vector<TBlob>& inputs,
+                          const std::vector<OpReqType>& req,
+                          const std::vector<TBlob>& outputs) {
+    using namespace mshadow;
+    using namespace mshadow::expr;
+    using namespace mxnet_op;
+    using namespace sampled_logits;
+    CHECK_EQ(req[0], kWriteTo);
+    const SampledLogitsParam& param =
+        nnvm::get<SampledLogitsParam>(attrs.parsed);
+    Stream<xpu>* s = ctx.get_stream<xpu>();
+    const int batch = inputs[kData].shape_[0], dim = inputs[kData].shape_[1];
+    const int num_class = inputs[kWeight].shape_[0];
+    const int num_sampled = inputs[kSampled].Size();
+    const int num_rows = batch + num_sampled;
+    MSHADOW_REAL_TYPE_SWITCH(outputs[0].type_flag_, DType, {
+        Tensor<xpu, 1, DType> workspace =
+            ctx.requested[0].get_space_typed<xpu, 1, DType>(
+                Shape1(num_rows * (dim + 1) + batch * num_sampled), s);
+        Tensor<xpu, 1, DType> classes(workspace.dptr_, Shape1(num_rows), s);
+        Tensor<xpu, 2, DType> rows(workspace.dptr_ + num_rows,
+                                   Shape2(num_rows, dim), s);
+        Tensor<xpu, 2, DType> dots(workspace.dptr_ + num_rows * (dim + 1),
+                                   Shape2(batch, num_sampled), s);
+        Tensor<xpu, 2, DType> data = inputs[kData].get<xpu, 2, DType>(s);
+        // gather the weight of the true and the sampled classes
+        SampledLogitsClasses(s, inputs[kLabel], inputs[kSampled], num_class,
+                             classes);
+        Kernel<Take, xpu>::Launch(s, num_rows * dim, rows.dptr_,
+                                  inputs[kWeight].dptr<DType>(),
+                                  classes.dptr_, dim, num_class);
+        dots = dot(data, rows.Slice(batch, num_rows).T());
+        DType* out = outputs[0].dptr<DType>();
+        Kernel<sampled_logits_true, xpu>::Launch(
+            s, batch, out, data.dptr_, rows.dptr_, inputs[kBias].dptr<DType>(),
+            inputs[kLabel].dptr<DType>(), inputs[kTrueCount].dptr<DType>(),
+            dim, num_sampled + 1, num_class, param.subtract_log_q);
+        Kernel<sampled_logits_sampled, xpu>::Launch(
+            s, batch * num_sampled, out, dots.dptr_,
+            inputs[kBias].dptr<DType>(), inputs[kLabel].dptr<DType>(),
+            inputs[kSampled].dptr<DType>(), inputs[kSampledCount].dptr<DType>(),
+            num_sampled, num_class, param.subtract_log_q,
+            param.remove_accidental_hits);
+    });
+}
+
+/*!
+ * \brief The gradients of data, weight and bias. Only the rows of weight and
+ *  bias of the true and the sampled classes are added to, so with grad_req
+ *  'add' a step touches num_sampled + batch rows rather than num_class.
+ */
+template <typename xpu>
+void SampledLogitsBackward(const nnvm::NodeAttrs& attrs, const OpContext& ctx,
+                           const std::vector<TBlob>& inputs,
+                           const std::vector<OpReqType>& req,
+                           const std::vector<TBlob>& outputs) {
+    using namespace mshadow;
+    using namespace mshadow::expr;
+    using namespace mxnet_op;
+    using namespace sampled_logits;
+    const SampledLogitsParam& param =
+        nnvm::get<SampledLogitsParam>(attrs.parsed);
+    Stream<xpu>* s = ctx.get_stream<xpu>();
+    // the inputs are the gradient of the logits followed by the inputs of
+    // the forward
+    const TBlob& ograd = inputs[0];
+    const TBlob& data_blob = inputs[1 + kData];
+    const int batch = data_blob.shape_[0], dim = data_blob.shape_[1];
+    const int num_class = inputs[1 + kWeight].shape_[0];
+    const int num_sampled = inputs[1 + kSampled].Size();
+    const int num_rows = batch + num_sampled;
+    MSHADOW_REAL_TYPE_SWITCH(ograd.type_flag_, DType, {
+        Tensor<xpu, 1, DType> workspace =
+            ctx.requested[0].get_space_typed<xpu, 1, DType>(
+                Shape1(num_rows * (2 * dim + 2) + batch * num_sampled), s);
+        DType* ptr = workspace.dptr_;
+        Tensor<xpu, 1, DType> classes(ptr, Shape1(num_rows), s);
+        ptr += num_rows;
+        Tensor<xpu, 2, DType> rows(ptr, Shape2(num_rows, dim), s);
+        ptr += num_rows * dim;
+        Tensor<xpu, 2, DType> row_grad(ptr, Shape2(num_rows, dim), s);
+        ptr += num_rows * dim;
+        // the gradient of the logit of each row of the gathered weight
+        Tensor<xpu, 2, DType> logit_grad(ptr, Shape2(num_rows, 1), s);
+        ptr += num_rows;
+        Tensor<xpu, 2, DType> sampled_grad(ptr, Shape2(batch, num_sampled), s);
+        Tensor<xpu, 1, DType> true_grad(logit_grad.dptr_, Shape1(batch), s);
+        Tensor<xpu, 2, DType> data = data_blob.get<xpu, 2, DType>(s);
+
+        SampledLogitsClasses(s, inputs[1 + kLabel], inputs[1 + kSampled],
+                             num_class, classes);
+        Kernel<sampled_logits_grad, xpu>::Launch(
+            s, batch * num_sampled, true_grad.dptr_, sampled_grad.dptr_,
+            ograd.dptr<DType>(), inputs[1 + kLabel].dptr<DType>(),
+            inputs[1 + kSampled].dptr<DType>(), num_sampled, num_class,
+            param.remove_accidental_hits);
+        Tensor<xpu, 1, DType> sampled_bias_grad(logit_grad.dptr_ + batch,
+                                                Shape1(num_sampled), s);
+        sampled_bias_grad = sumall_except_dim<1>(sampled_grad);
+
+        if (req[kData] != kNullOp) {
+            Kernel<Take, xpu>::Launch(s, num_rows * dim, rows.dptr_,
+                                      inputs[1 + kWeight].dptr<DType>(),
+                                      classes.dptr_, dim, num_class);
+            Tensor<xpu, 2, DType> data_grad =
+                outputs[kData].get<xpu, 2, DType>(s);
+            if (req[kData] == kAddTo) {
+                data_grad += dot(sampled_grad, rows.Slice(batch, num_rows));
+            } else {
+                data_grad = dot(sampled_grad, rows.Slice(batch, num_rows));
+            }
+            data_grad += broadcast<0>(true_grad, data_grad.shape_) *
+                         rows.Slice(0, batch);
+        }
+        if (req[kWeight] != kNullOp) {
+            Tensor<xpu, 2, DType> weight_grad =
+                outputs[kWeight].get<xpu, 2, DType>(s);
+            row_grad.Slice(0, batch) =
+                broadcast<0>(true_grad, data.shape_) * data;
+            row_grad.Slice(batch, num_rows) = dot(sampled_grad.T(), data);
+            if (req[kWeight] != kAddTo) weight_grad = scalar<DType>(0.0f);
+            AddTakeGrad(weight_grad, classes, row_grad);
+        }
+        if (req[kBias] != kNullOp) {
+            Tensor<xpu, 2, DType> bias_grad =
+                outputs[kBias].get_with_shape<xpu, 2, DType>(
+                    Shape2(num_class, 1), s);
+            if (req[kBias] != kAddTo) bias_grad = scalar<DType>(0.0f);
+            AddTakeGrad(bias_grad, classes, logit_grad);
+        }
+        // the classes and the counts are not differentiated
+        for (int i = kLabel; i <= kSampledCount; ++i) {
+            if (req[i] == kWriteTo || req[i] == kWriteInplace) {
+                Tensor<xpu, 1, DType> grad = outputs[i].FlatTo1D<xpu, DType>(s);
+                grad = scalar<DType>(0.0f);
+            }
+        }
+    });
+}
+
+}  // namespace op
+}  // namespace mxnet
+#endif  // MXNET_OPERATOR_CONTRIB_SAMPLED_SOFTMAX_INL_H_
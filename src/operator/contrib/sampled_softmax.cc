@@ -0,0 +1,165 @@
+/*!
+ *  Copyright (c) 2017 by Contributors
+ * \file sampled_softmax.cc
+ * \brief candidate samplers and sampled softmax logits
+ */
+#include "./sampled_softmax-inl.h"
+
+namespace mxnet {
+namespace op {
+DMLC_REGISTER_PARAMETER(LogUniformSamplerParam);
+DMLC_REGISTER_PARAMETER(UnigramSamplerParam);
+DMLC_REGISTER_PARAMETER(SampledLogitsParam);
+
+inline std::vector<ResourceRequest> CandidateSamplerResource(
+    const NodeAttrs& attrs) {
+    return {ResourceRequest::kParallelRandom};
+}
+
+inline std::vector<std::string> CandidateSamplerOutputNames(
+    const NodeAttrs& attrs) {
+    return {"sampled", "true_expected_count", "sampled_expected_count"};
+}
+
+NNVM_REGISTER_OP(_contrib_log_uniform_sampler)
+    .describe(R"code(Draw candidate classes for sampled softmax from the
+log-uniform (Zipfian) distribution over [0, range_max),
+
+.. math:: P(k) = \frac{\log(k + 2) - \log(k + 1)}{\log(range\_max + 1)}
+
+which fits classes sorted by decreasing frequency, such as the words of a
+vocabulary.
+
+Returns the sampled classes, and the number of times each true class and
+each sampled class is expected to be drawn. With ``unique=True`` the classes
+are drawn until ``num_sampled`` distinct ones came up, and the expected count
+of a class is the probability that it is among them.
+
+Example::
+
+  sampled, true_count, sampled_count = log_uniform_sampler(
+      label, num_sampled=8192, range_max=800000)
+
+)code" ADD_FILELINE)
+    .set_num_inputs(1)
+    .set_num_outputs(3)
+    .set_attr_parser(ParamParser<LogUniformSamplerParam>)
+    .set_attr<nnvm::FListOutputNames>("FListOutputNames",
+                                      CandidateSamplerOutputNames)
+    .set_attr<nnvm::FInferShape>("FInferShape",
+                                 CandidateSamplerShape<LogUniformSamplerParam>)
+    .set_attr<nnvm::FInferType>("FInferType", CandidateSamplerType)
+    .set_attr<FResourceRequest>("FResourceRequest", CandidateSamplerResource)
+    .set_attr<FCompute>("FCompute<cpu>", LogUniformSamplerCompute)
+    .set_attr<nnvm::FGradient>("FGradient", MakeZeroGradNodes)
+    .add_argument("true_classes", "NDArray-or-Symbol",
+                  "The true classes, which get their expected counts.")
+    .add_arguments(LogUniformSamplerParam::__FIELDS__());
+
+NNVM_REGISTER_OP(_contrib_unigram_sampler)
+    .describe(R"code(Draw candidate classes for sampled softmax with
+probabilities proportional to ``counts[k] ^ distortion``, such as the
+frequencies of the words of a vocabulary.
+
+Returns the sampled classes, and the number of times each true class and
+each sampled class is expected to be drawn, as ``log_uniform_sampler``.
+
+)code" ADD_FILELINE)
+    .set_num_inputs(2)
+    .set_num_outputs(3)
+    .set_attr_parser(ParamParser<UnigramSamplerParam>)
+    .set_attr<nnvm::FListInputNames>(
+        "FListInputNames",
+        [](const NodeAttrs& attrs) {
+            return std::vector<std::string>{"true_classes", "counts"};
+        })
+    .set_attr<nnvm::FListOutputNames>("FListOutputNames",
+                                      CandidateSamplerOutputNames)
+    .set_attr<nnvm::FInferShape>("FInferShape",
+                                 CandidateSamplerShape<UnigramSamplerParam>)
+    .set_attr<nnvm::FInferType>("FInferType", CandidateSamplerType)
+    .set_attr<FResourceRequest>("FResourceRequest", CandidateSamplerResource)
+    .set_attr<FCompute>("FCompute<cpu>", UnigramSamplerCompute)
+    .set_attr<nnvm::FGradient>("FGradient", MakeZeroGradNodes)
+    .add_argument("true_classes", "NDArray-or-Symbol",
+                  "The true classes, which get their expected counts.")
+    .add_argument("counts", "NDArray-or-Symbol",
+                  "The count of every class, of shape (num_class,).")
+    .add_arguments(UnigramSamplerParam::__FIELDS__());
+
+NNVM_REGISTER_OP(_contrib_sampled_logits)
+    .describe(R"code(The logits of sampled softmax: for every row of data,
+the logit of its true class followed by the logits of the sampled classes,
+
+.. math:: out[i, 0] = data[i] \cdot weight[label[i]] + bias[label[i]]
+          - \log(true\_expected\_count[i])
+.. math:: out[i, 1 + j] = data[i] \cdot weight[sampled[j]] + bias[sampled[j]]
+          - \log(sampled\_expected\_count[j])
+
+The rows of weight are gathered as by ``take``, and only the rows of the
+true and sampled classes receive gradient. A sampled class equal to the true
+class of a row is an accidental hit, whose logit is set to -1e30 for that
+row. Training minimizes ``softmax_cross_entropy(out, zeros)``, or uses
+``SoftmaxOutput`` with label 0; the full softmax over
+``FullyConnected(data, weight, bias)`` remains the exact output for
+evaluation.
+
+Example::
+
+  sampled, true_count, sampled_count = contrib.log_uniform_sampler(
+      label, num_sampled=8192, range_max=800000)
+  logits = contrib.sampled_logits(hidden, weight, bias, label, sampled,
+                                  true_count, sampled_count)
+  loss = SoftmaxOutput(logits, zeros)
+
+)code" ADD_FILELINE)
+    .set_num_inputs(7)
+    .set_num_outputs(1)
+    .set_attr_parser(ParamParser<SampledLogitsParam>)
+    .set_attr<nnvm::FListInputNames>(
+        "FListInputNames",
+        [](const NodeAttrs& attrs) {
+            return std::vector<std::string>{
+                "data",    "weight",         "bias",
+                "label",   "sampled",        "true_expected_count",
+                "sampled_expected_count"};
+        })
+    .set_attr<nnvm::FInferShape>("FInferShape", SampledLogitsShape)
+    .set_attr<nnvm::FInferType>("FInferType", ElemwiseType<7, 1>)
+    .set_attr<FResourceRequest>("FResourceRequest",
+                                [](const NodeAttrs& attrs) {
+                                    return std::vector<ResourceRequest>{
+                                        ResourceRequest::kTempSpace};
+                                })
+    .set_attr<FCompute>("FCompute<cpu>", SampledLogitsForward<cpu>)
+    .set_attr<nnvm::FGradient>("FGradient",
+                               ElemwiseGradUseIn{"_backward_sampled_logits"})
+    .add_argument("data", "NDArray-or-Symbol", "Input of shape (batch, dim).")
+    .add_argument("weight", "NDArray-or-Symbol",
+                  "Output embedding of shape (num_class, dim).")
+    .add_argument("bias", "NDArray-or-Symbol",
+                  "Output bias of shape (num_class,).")
+    .add_argument("label", "NDArray-or-Symbol",
+                  "True class of every row, of shape (batch,).")
+    .add_argument("sampled", "NDArray-or-Symbol",
+                  "Sampled classes, of shape (num_sampled,).")
+    .add_argument("true_expected_count", "NDArray-or-Symbol",
+                  "Expected count of the true class of every row.")
+    .add_argument("sampled_expected_count", "NDArray-or-Symbol",
+                  "Expected count of every sampled class.")
+    .add_arguments(SampledLogitsParam::__FIELDS__());
+
+NNVM_REGISTER_OP(_backward_sampled_logits)
+    .set_num_inputs(8)
+    .set_num_outputs(7)
+    .set_attr_parser(ParamParser<SampledLogitsParam>)
+    .set_attr<FResourceRequest>("FResourceRequest",
+                                [](const NodeAttrs& attrs) {
+                                    return std::vector<ResourceRequest>{
+                                        ResourceRequest::kTempSpace};
+                                })
+    .set_attr<nnvm::TIsBackward>("TIsBackward", true)
+    .set_attr<FCompute>("FCompute<cpu>", SampledLogitsBackward<cpu>);
+
+}  // namespace op
+}  // namespace mxnet
@@ -0,0 +1,18 @@
+/*!
+ *  Copyright (c) 2017 by Contributors
+ * \file sampled_softmax.cu
+ * \brief sampled softmax logits on gpu; the samplers only run on cpu
+ */
+#include "./sampled_softmax-inl.h"
+
+namespace mxnet {
+namespace op {
+
+NNVM_REGISTER_OP(_contrib_sampled_logits)
+.set_attr<FCompute>("FCompute<gpu>", SampledLogitsForward<gpu>);
+
+NNVM_REGISTER_OP(_backward_sampled_logits)
+.set_attr<FCompute>("FCompute<gpu>", SampledLogitsBackward<gpu>);
+
+}  // namespace op
+}  // namespace mxnet
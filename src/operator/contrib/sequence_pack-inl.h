@@ -0,0 +1,254 @@
+/*!
+ *  Copyright (c) 2017 by Contributors
+ * \file sequence_pack-inl.h
+ * \brief conversion of padded batches of variable-length sequences to and
+ *  from the packed layout of SequencePacking
+ */
+#ifndef MXNET_OPERATOR_CONTRIB_SEQUENCE_PACK_INL_H_
+#define MXNET_OPERATOR_CONTRIB_SEQUENCE_PACK_INL_H_
+
+#include <mxnet/operator_util.h>
+#include <string>
+#include <vector>
+#include "../elemwise_op_common.h"
+#include "../mxnet_op.h"
+#include "../operator_common.h"
+#include "../sequence_op_common.h"
+
+namespace mxnet {
+namespace op {
+
+namespace seq_pack {
+enum SequencePackOpInputs { kData, kSequenceLength };
+enum SequencePackOpOutputs { kOut, kBatchSizes, kSortedIndices };
+}
+
+/*! \brief the packing of the batch whose sequence lengths are lengths */
+template <typename xpu, typename DType>
+inline SequencePacking SequencePackingOf(mshadow::Stream<xpu> *s,
+                                         const TBlob &lengths,
+                                         index_t max_seq_len) {
+    std::vector<index_t> lens(lengths.Size());
+    IndexTensorToVector(lengths.get<xpu, 1, DType>(s), &lens);
+    return SequencePacking(lens, max_seq_len);
+}
+
+/*! \brief the padded row of every packed row, -1 past packing.Rows() */
+inline std::vector<int> PackedRowSources(const SequencePacking &packing,
+                                         index_t batch) {
+    const index_t max_seq_len = packing.batch_sizes.size();
+    std::vector<int> rows(max_seq_len * batch, -1);
+    for (index_t t = 0; t < max_seq_len; ++t) {
+        for (index_t j = 0; j < packing.batch_sizes[t]; ++j) {
+            rows[packing.offsets[t] + j] = t * batch + packing.order[j];
+        }
+    }
+    return rows;
+}
+
+/*! \brief the packed row of every padded row, -1 in the padding */
+inline std::vector<int> PaddedRowSources(const SequencePacking &packing,
+                                         index_t batch) {
+    const index_t max_seq_len = packing.batch_sizes.size();
+    std::vector<int> rows(max_seq_len * batch, -1);
+    for (index_t t = 0; t < max_seq_len; ++t) {
+        for (index_t j = 0; j < packing.batch_sizes[t]; ++j) {
+            rows[t * batch + packing.order[j]] = packing.offsets[t] + j;
+        }
+    }
+    return rows;
+}
+
+/*!
+ * \brief dst row i of width elements is src row rows[i], or zero if rows[i]
+ *  is negative
+ */
+struct SequenceRowGather {
+    template <typename DType>
+    MSHADOW_XINLINE static void Map(int i, DType *dst, const DType *src,
+                                    const int *rows, const int width,
+                                    const OpReqType req) {
+        const int row = rows[i / width];
+        KERNEL_ASSIGN(dst[i], req,
+                      row < 0 ? DType(0) : src[row * width + i % width]);
+    }
+};
+
+/*!
+ * \brief Gather the rows of dst from src as SequenceRowGather does, with the
+ *  row map copied to temp space first. Only the rows of src in it are read.
+ */
+template <typename xpu, typename DType>
+inline void SequenceGatherRows(const OpContext &ctx,
+                               const std::vector<int> &rows, index_t width,
+                               const DType *src, OpReqType req, DType *dst) {
+    using namespace mshadow;
+    if (req == kNullOp || rows.empty() || width == 0) return;
+    Stream<xpu> *s = ctx.get_stream<xpu>();
+    Tensor<xpu, 1, int> row_map = ctx.requested[0].get_space_typed<xpu, 1, int>(
+        Shape1(rows.size()), s);
+    Copy(row_map,
+         Tensor<cpu, 1, int>(const_cast<int *>(rows.data()),
+                             Shape1(rows.size())),
+         s);
+    mxnet_op::Kernel<SequenceRowGather, xpu>::Launch(
+        s, rows.size() * width, dst, src, row_map.dptr_,
+        static_cast<int>(width), req);
+}
+
+/*! \brief write values to out, a vector of their length */
+template <typename xpu, typename DType>
+inline void SequenceIndexOutput(mshadow::Stream<xpu> *s,
+                                const std::vector<index_t> &values,
+                                const TBlob &out) {
+    using namespace mshadow;
+    std::vector<DType> host(values.size());
+    for (size_t i = 0; i < values.size(); ++i) host[i] = DType(values[i]);
+    Copy(out.get<xpu, 1, DType>(s),
+         Tensor<cpu, 1, DType>(host.data(), Shape1(host.size())), s);
+}
+
+/*! \brief the gradient of sequence_length, which is none */
+template <typename xpu>
+inline void SequenceLengthZeroGrad(mshadow::Stream<xpu> *s, const TBlob &grad,
+                                   OpReqType req) {
+    if (req == kNullOp || req == kAddTo) return;
+    MSHADOW_REAL_TYPE_SWITCH(grad.type_flag_, DType, {
+        mshadow::Tensor<xpu, 1, DType> g = grad.FlatTo1D<xpu, DType>(s);
+        g = DType(0);
+    });
+}
+
+/*! \brief data (max_seq_len, batch, ...), sequence_length (batch,) */
+inline bool PackSequenceShape(const nnvm::NodeAttrs &attrs,
+                              std::vector<TShape> *in_attrs,
+                              std::vector<TShape> *out_attrs) {
+    const TShape &dshape = (*in_attrs)[seq_pack::kData];
+    if (dshape.ndim() == 0) return false;
+    CHECK_GE(dshape.ndim(), 2U)
+        << "The data array must be of rank 2 or greater.";
+    SHAPE_ASSIGN_CHECK(*in_attrs, seq_pack::kSequenceLength,
+                       mshadow::Shape1(dshape[1]));
+    TShape oshape(dshape.ndim() - 1);
+    oshape[0] = dshape[0] * dshape[1];
+    for (index_t i = 2; i < dshape.ndim(); ++i) oshape[i - 1] = dshape[i];
+    SHAPE_ASSIGN_CHECK(*out_attrs, seq_pack::kOut, oshape);
+    SHAPE_ASSIGN_CHECK(*out_attrs, seq_pack::kBatchSizes,
+                       mshadow::Shape1(dshape[0]));
+    SHAPE_ASSIGN_CHECK(*out_attrs, seq_pack::kSortedIndices,
+                       mshadow::Shape1(dshape[1]));
+    return true;
+}
+
+/*! \brief data (max_seq_len * batch, ...), sequence_length (batch,) */
+inline bool UnpackSequenceShape(const nnvm::NodeAttrs &attrs,
+                                std::vector<TShape> *in_attrs,
+                                std::vector<TShape> *out_attrs) {
+    const TShape &pshape = (*in_attrs)[seq_pack::kData];
+    const TShape &lshape = (*in_attrs)[seq_pack::kSequenceLength];
+    if (pshape.ndim() == 0 || lshape.ndim() == 0) return false;
+    CHECK_EQ(lshape.ndim(), 1U) << "sequence_length must be a vector.";
+    CHECK(lshape[0] > 0 && pshape[0] % lshape[0] == 0)
+        << "The packed rows must be max_seq_len * batch, got " << pshape[0]
+        << " rows for a batch of " << lshape[0];
+    TShape oshape(pshape.ndim() + 1);
+    oshape[0] = pshape[0] / lshape[0];
+    oshape[1] = lshape[0];
+    for (index_t i = 1; i < pshape.ndim(); ++i) oshape[i + 1] = pshape[i];
+    SHAPE_ASSIGN_CHECK(*out_attrs, seq_pack::kOut, oshape);
+    return true;
+}
+
+template <typename xpu>
+inline void PackSequenceCompute(const nnvm::NodeAttrs &attrs,
+                                const OpContext &ctx,
+                                const std::vector<TBlob> &inputs,
+                                const std::vector<OpReqType> &req,
+                                const std::vector<TBlob> &outputs) {
+    mshadow::Stream<xpu> *s = ctx.get_stream<xpu>();
+    const TBlob &data = inputs[seq_pack::kData];
+    const index_t max_seq_len = data.shape_[0], batch = data.shape_[1];
+    if (data.Size() == 0) return;
+    const index_t width = data.Size() / max_seq_len / batch;
+    MSHADOW_REAL_TYPE_SWITCH(data.type_flag_, DType, {
+        const SequencePacking packing = SequencePackingOf<xpu, DType>(
+            s, inputs[seq_pack::kSequenceLength], max_seq_len);
+        SequenceGatherRows<xpu>(ctx, PackedRowSources(packing, batch), width,
+                                data.dptr<DType>(), req[seq_pack::kOut],
+                                outputs[seq_pack::kOut].dptr<DType>());
+        SequenceIndexOutput<xpu, DType>(s, packing.batch_sizes,
+                                        outputs[seq_pack::kBatchSizes]);
+        SequenceIndexOutput<xpu, DType>(s, packing.order,
+                                        outputs[seq_pack::kSortedIndices]);
+    });
+}
+
+/*! \brief inputs: the gradients of the 3 outputs, data, sequence_length */
+template <typename xpu>
+inline void PackSequenceBackward(const nnvm::NodeAttrs &attrs,
+                                 const OpContext &ctx,
+                                 const std::vector<TBlob> &inputs,
+                                 const std::vector<OpReqType> &req,
+                                 const std::vector<TBlob> &outputs) {
+    mshadow::Stream<xpu> *s = ctx.get_stream<xpu>();
+    const TBlob &grad = outputs[seq_pack::kData];
+    const index_t max_seq_len = grad.shape_[0], batch = grad.shape_[1];
+    SequenceLengthZeroGrad(s, outputs[seq_pack::kSequenceLength],
+                           req[seq_pack::kSequenceLength]);
+    if (grad.Size() == 0) return;
+    const index_t width = grad.Size() / max_seq_len / batch;
+    MSHADOW_REAL_TYPE_SWITCH(grad.type_flag_, DType, {
+        const SequencePacking packing =
+            SequencePackingOf<xpu, DType>(s, inputs[4], max_seq_len);
+        SequenceGatherRows<xpu>(ctx, PaddedRowSources(packing, batch), width,
+                                inputs[0].dptr<DType>(), req[seq_pack::kData],
+                                grad.dptr<DType>());
+    });
+}
+
+template <typename xpu>
+inline void UnpackSequenceCompute(const nnvm::NodeAttrs &attrs,
+                                  const OpContext &ctx,
+                                  const std::vector<TBlob> &inputs,
+                                  const std::vector<OpReqType> &req,
+                                  const std::vector<TBlob> &outputs) {
+    mshadow::Stream<xpu> *s = ctx.get_stream<xpu>();
+    const TBlob &out = outputs[seq_pack::kOut];
+    const index_t max_seq_len = out.shape_[0], batch = out.shape_[1];
+    if (out.Size() == 0) return;
+    const index_t width = out.Size() / max_seq_len / batch;
+    MSHADOW_REAL_TYPE_SWITCH(out.type_flag_, DType, {
+        const SequencePacking packing = SequencePackingOf<xpu, DType>(
+            s, inputs[seq_pack::kSequenceLength], max_seq_len);
+        SequenceGatherRows<xpu>(ctx, PaddedRowSources(packing, batch), width,
+                                inputs[seq_pack::kData].dptr<DType>(),
+                                req[seq_pack::kOut], out.dptr<DType>());
+    });
+}
+
+/*! \brief inputs: the gradient of the output, data, sequence_length */
+template <typename xpu>
+inline void UnpackSequenceBackward(const nnvm::NodeAttrs &attrs,
+                                   const OpContext &ctx,
+                                   const std::vector<TBlob> &inputs,
+                                   const std::vector<OpReqType> &req,
+                                   const std::vector<TBlob> &outputs) {
+    mshadow::Stream<xpu> *s = ctx.get_stream<xpu>();
+    const TBlob &ograd = inputs[0];
+    const index_t max_seq_len = ograd.shape_[0], batch = ograd.shape_[1];
+    SequenceLengthZeroGrad(s, outputs[seq_pack::kSequenceLength],
+                           req[seq_pack::kSequenceLength]);
+    if (ograd.Size() == 0) return;
+    const index_t width = ograd.Size() / max_seq_len / batch;
+    MSHADOW_REAL_TYPE_SWITCH(ograd.type_flag_, DType, {
+        const SequencePacking packing =
+            SequencePackingOf<xpu, DType>(s, inputs[2], max_seq_len);
+        SequenceGatherRows<xpu>(ctx, PackedRowSources(packing, batch), width,
+                                ograd.dptr<DType>(), req[seq_pack::kData],
+                                outputs[seq_pack::kData].dptr<DType>());
+    });
+}
+
+}  // namespace op
+}  // namespace mxnet
+#endif  // MXNET_OPERATOR_CONTRIB_SEQUENCE_PACK_INL_H_
@@ -0,0 +1,133 @@
+/*!
+ *  Copyright (c) 2017 by Contributors
+ * \file sequence_pack.cc
+ * \brief packing of padded batches of variable-length sequences
+ */
+#include "./sequence_pack-inl.h"
+
+namespace mxnet {
+namespace op {
+
+NNVM_REGISTER_OP(_contrib_pack_sequence)
+    .describe(R"code(Packs a padded batch of variable-length sequences so that
+later layers skip the padding.
+
+The input has the layout of the data of ``SequenceMask``,
+(max_sequence_length, batch_size, other_feature_dims), and the valid length of
+every sequence is given by ``sequence_length``. The first output holds the
+rows of time step 0, then those of time step 1, and so on; at every step the
+sequences still running come longest first. This is the packed input layout
+of the cudnn recurrent layers. The output keeps the
+(max_sequence_length * batch_size, other_feature_dims) shape of the padded
+data, and its rows after the packed ones are zero. Only the rows of the
+sequences are read.
+
+The second output is the number of sequences at every time step, and the third
+is the batch index of the sequence at every position of a step.
+
+Example::
+
+   x = [[[ 1.], [ 2.]],
+        [[ 3.], [ 4.]],
+        [[ 5.], [ 6.]]]
+
+   pack_sequence(x, sequence_length=[1, 3]) =
+       [[ 2.], [ 1.], [ 4.], [ 6.], [ 0.], [ 0.]],
+       [ 2., 1., 1.],
+       [ 1., 0.]
+
+)code" ADD_FILELINE)
+    .set_num_inputs(2)
+    .set_num_outputs(3)
+    .set_attr<nnvm::FListInputNames>("FListInputNames",
+                                     [](const NodeAttrs &attrs) {
+                                         return std::vector<std::string>{
+                                             "data", "sequence_length"};
+                                     })
+    .set_attr<nnvm::FListOutputNames>(
+        "FListOutputNames",
+        [](const NodeAttrs &attrs) {
+            return std::vector<std::string>{"output", "batch_sizes",
+                                            "sorted_indices"};
+        })
+    .set_attr<nnvm::FInferShape>("FInferShape", PackSequenceShape)
+    .set_attr<nnvm::FInferType>("FInferType", ElemwiseType<2, 3>)
+    .set_attr<FResourceRequest>("FResourceRequest",
+                                [](const NodeAttrs &attrs) {
+                                    return std::vector<ResourceRequest>{
+                                        ResourceRequest::kTempSpace};
+                                })
+    .set_attr<FCompute>("FCompute<cpu>", PackSequenceCompute<cpu>)
+    .set_attr<nnvm::FGradient>("FGradient",
+                               ElemwiseGradUseIn{"_backward_pack_sequence"})
+    .add_argument("data", "NDArray-or-Symbol",
+                  "n-dimensional input array of the form [max_sequence_length,"
+                  " batch_size, other_feature_dims] where n>1")
+    .add_argument("sequence_length", "NDArray-or-Symbol",
+                  "vector of sequence lengths of the form [batch_size]");
+
+NNVM_REGISTER_OP(_backward_pack_sequence)
+    .set_num_inputs(5)
+    .set_num_outputs(2)
+    .set_attr<nnvm::TIsBackward>("TIsBackward", true)
+    .set_attr<FResourceRequest>("FResourceRequest",
+                                [](const NodeAttrs &attrs) {
+                                    return std::vector<ResourceRequest>{
+                                        ResourceRequest::kTempSpace};
+                                })
+    .set_attr<FCompute>("FCompute<cpu>", PackSequenceBackward<cpu>);
+
+NNVM_REGISTER_OP(_contrib_unpack_sequence)
+    .describe(R"code(Unpacks the output of ``pack_sequence`` back to a padded
+batch of shape (max_sequence_length, batch_size, other_feature_dims), with
+zeros in the padding.
+
+The packed data is (max_sequence_length * batch_size, other_feature_dims),
+and ``sequence_length`` is the one given to ``pack_sequence``.
+
+Example::
+
+   y = [[ 2.], [ 1.], [ 4.], [ 6.], [ 0.], [ 0.]]
+
+   unpack_sequence(y, sequence_length=[1, 3]) =
+       [[[ 1.], [ 2.]],
+        [[ 0.], [ 4.]],
+        [[ 0.], [ 6.]]]
+
+)code" ADD_FILELINE)
+    .set_num_inputs(2)
+    .set_num_outputs(1)
+    .set_attr<nnvm::FListInputNames>("FListInputNames",
+                                     [](const NodeAttrs &attrs) {
+                                         return std::vector<std::string>{
+                                             "data", "sequence_length"};
+                                     })
+    .set_attr<nnvm::FInferShape>("FInferShape", UnpackSequenceShape)
+    .set_attr<nnvm::FInferType>("FInferType", ElemwiseType<2, 1>)
+    .set_attr<FResourceRequest>("FResourceRequest",
+                                [](const NodeAttrs &attrs) {
+                                    return std::vector<ResourceRequest>{
+                                        ResourceRequest::kTempSpace};
+                                })
+    .set_attr<FCompute>("FCompute<cpu>", UnpackSequenceCompute<cpu>)
+    .set_attr<nnvm::FGradient>("FGradient",
+                               ElemwiseGradUseIn{"_backward_unpack_sequence"})
+    .add_argument("data", "NDArray-or-Symbol",
+                  "packed array of the form [max_sequence_length * "
+                  "batch_size, other_feature_dims]")
+    .add_argument("sequence_length", "NDArray-or-Symbol",
+                  "vector of sequence lengths of the form [batch_size]");
+
+NNVM_REGISTER_OP(_backward_unpack_sequence)
+    .set_num_inputs(3)
+    .set_num_outputs(2)
+    .set_attr<nnvm::TIsBackward>("TIsBackward", true)
+    .set_attr<FResourceRequest>("FResourceRequest",
+                                [](const NodeAttrs &attrs) {
+                                    return std::vector<ResourceRequest>{
+                                        ResourceRequest::kTempSpace};
+                                })
+    .set_attr<FCompute>("FCompute<cpu>", UnpackSequenceBackward<cpu>);
+
+}  // namespace op
+}  // namespace mxnet
@@ -0,0 +1,24 @@
+/*!
+ *  Copyright (c) 2017 by Contributors
+ * \file sequence_pack.cu
+ * \brief packing of padded batches of variable-length sequences
+ */
+#include "./sequence_pack-inl.h"
+
+namespace mxnet {
+namespace op {
+
+NNVM_REGISTER_OP(_contrib_pack_sequence)
+.set_attr<FCompute>("FCompute<gpu>", PackSequenceCompute<gpu>);
+
+NNVM_REGISTER_OP(_backward_pack_sequence)
+.set_attr<FCompute>("FCompute<gpu>", PackSequenceBackward<gpu>);
+
+NNVM_REGISTER_OP(_contrib_unpack_sequence)
+.set_attr<FCompute>("FCompute<gpu>", UnpackSequenceCompute<gpu>);
+
+NNVM_REGISTER_OP(_backward_unpack_sequence)
+.set_attr<FCompute>("FCompute<gpu>", UnpackSequenceBackward<gpu>);
+
+}  // namespace op
+}  // namespace mxnet
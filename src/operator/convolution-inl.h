@@ -18,9 +18,12 @@
 #include <algorithm>
 #include <map>
 #include <string>
+#include <type_traits>
 #include <utility>
 #include <vector>
+#include "./nn/depthwise_conv.h"
 #include "./nn/im2col.h"
+#include "./nn/winograd.h"
 #include "./operator_common.h"
 
 namespace mxnet {
@@ -31,6 +34,9 @@ enum ConvolutionOpInputs { kData, kWeight, kBias };
 enum ConvolutionOpOutputs { kOut };
 enum ConvolutionOpResource { kTempSpace };
 enum ConvolutionOpCudnnTune { kOff, kLimited, kFastest };
+enum ConvolutionOpCpuAlgo { kIm2col, kWinograd, kDepthwise };
+// minimum number of input and output channels to use winograd
+const index_t kWinogradMinChannels = 8;
 }
 
 struct ConvolutionParam : public dmlc::Parameter<ConvolutionParam> {
@@ -110,6 +116,7 @@ class ConvolutionOp : public Operator {
               param_.layout.value() == mshadow::kNCHW ||
               param_.layout.value() == mshadow::kNCDHW)
             << "Only support NCW, NCHW and NCDHW layout";
+        fast_algo_ = dmlc::GetEnv("MXNET_CPU_CONV_FAST_ALGO", 1) != 0;
     }
 
     virtual void Forward(const OpContext &ctx,
@@ -126,10 +133,90 @@ class ConvolutionOp : public Operator {
         CHECK_EQ(req[conv::kOut], kWriteTo);
         LayerSetUp(in_data[conv::kData].shape_, out_data[conv::kOut].shape_);
         Stream<xpu> *s = ctx.get_stream<xpu>();
-        // allocate workspace for col_buffer
-        Tensor<xpu, 1, DType> workspace =
-            ctx.requested[conv::kTempSpace].get_space_typed<xpu, 1, DType>(
-                Shape1(col_buffer_size_), s);
+        if (algo_ == conv::kWinograd) {
+            Tensor<xpu, 1, DType> workspace =
+                ctx.requested[conv::kTempSpace].get_space_typed<xpu, 1, DType>(
+                    Shape1(WinogradWorkspaceSize(winograd_step_)), s);
+            ForwardWinograd(s, in_data, out_data, workspace.dptr_);
+        } else if (algo_ == conv::kDepthwise) {
+            ForwardDepthwise(s, in_data, out_data);
+        } else if (nstep_ > 1) {
+            Tensor<xpu, 1, DType> workspace =
+                ctx.requested[conv::kTempSpace].get_space_typed<xpu, 1, DType>(
+                    Shape1(nstep_ * (col_buffer_size_ + output_dim_)), s);
+            ForwardBatch(s, in_data, out_data, workspace.dptr_);
+        } else {
+            // allocate workspace for col_buffer
+            Tensor<xpu, 1, DType> workspace =
+                ctx.requested[conv::kTempSpace].get_space_typed<xpu, 1, DType>(
+                    Shape1(col_buffer_size_), s);
+            ForwardSample(s, in_data, req, out_data, workspace.dptr_);
+        }
+        if (bias_term_) {
+            Tensor<xpu, 1, DType> bias =
+                in_data[conv::kBias].get<xpu, 1, DType>(s);
+            Tensor<xpu, 3, DType> output_3d =
+                out_data[conv::kOut].get_with_shape<xpu, 3, DType>(
+                    Shape3(num_, conv_out_channels_, conv_out_spatial_dim_), s);
+            // has bias term, broadcast it to the same shape of output_3d in
+            // channel dim
+            output_3d += mshadow::expr::broadcast<1>(bias, output_3d.shape_);
+        }
+    }
+
+    virtual void Backward(const OpContext &ctx,
+                          const std::vector<TBlob> &out_grad,
+                          const std::vector<TBlob> &in_data,
+                          const std::vector<TBlob> &out_data,
+                          const std::vector<OpReqType> &req,
+                          const std::vector<TBlob> &in_grad,
+                          const std::vector<TBlob> &aux_args) {
+        using namespace mshadow;
+        using namespace mshadow::expr;
+        CHECK_EQ(out_grad.size(), 1U);
+        size_t expected = param_.no_bias == 0 ? 3 : 2;
+        CHECK(in_data.size() == expected && in_grad.size() == expected);
+        CHECK_EQ(req.size(), expected);
+        CHECK_EQ(in_data[conv::kWeight].CheckContiguous(), true);
+        LayerSetUp(in_grad[conv::kData].shape_, out_grad[conv::kOut].shape_);
+        Stream<xpu> *s = ctx.get_stream<xpu>();
+        // winograd is only used for the forward pass
+        if (algo_ == conv::kDepthwise) {
+            BackwardDepthwise(s, out_grad, in_data, req, in_grad);
+        } else if (nstep_ > 1) {
+            Tensor<xpu, 1, DType> workspace =
+                ctx.requested[conv::kTempSpace].get_space_typed<xpu, 1, DType>(
+                    Shape1(nstep_ * (col_buffer_size_ + output_dim_)), s);
+            BackwardBatch(s, out_grad, in_data, req, in_grad, workspace.dptr_);
+        } else {
+            // allocate workspace for col_buffer
+            Tensor<xpu, 1, DType> workspace =
+                ctx.requested[conv::kTempSpace].get_space_typed<xpu, 1, DType>(
+                    Shape1(col_buffer_size_), s);
+            BackwardSample(s, out_grad, in_data, req, in_grad,
+                           workspace.dptr_);
+        }
+
+        // gradient w.r.t bias
+        if (bias_term_) {
+            Tensor<xpu, 1, DType> dbias =
+                in_grad[conv::kBias].get<xpu, 1, DType>(s);
+            Tensor<xpu, 3, DType> dout =
+                out_grad[conv::kOut].get_with_shape<xpu, 3, DType>(
+                    Shape3(num_, conv_out_channels_, conv_out_spatial_dim_), s);
+            ASSIGN_DISPATCH(dbias, req[conv::kBias],
+                            sumall_except_dim<1>(dout));
+        }
+    }
+
+   private:
+    // forward one sample at a time, with a gemm per sample and group
+    void ForwardSample(mshadow::Stream<xpu> *s,
+                       const std::vector<TBlob> &in_data,
+                       const std::vector<OpReqType> &req,
+                       const std::vector<TBlob> &out_data, DType *workspace) {
+        using namespace mshadow;
+        using namespace mshadow::expr;
         // calculate the shape of col_buffer
         TShape col_buffer_shape(num_spatial_axes_ + 1);
         col_buffer_shape[0] = conv_in_channels_ * param_.kernel.Size();
@@ -137,7 +224,7 @@ class ConvolutionOp : public Operator {
             col_buffer_shape[i] = out_data[0].shape_[i + 1];
         }
         // create a column buffer using workspace and col_buffer_shape
-        TBlob col_buffer(workspace.dptr_, col_buffer_shape, xpu::kDevMask,
+        TBlob col_buffer(workspace, col_buffer_shape, xpu::kDevMask,
                          DataType<DType>::kFlag);
 
         // initialize weight and col_buffer 3D tensors for using gemm
@@ -164,38 +251,16 @@ class ConvolutionOp : public Operator {
                                 dot(weight_3d[g], col_buffer_3d[g]));
             }
         }
-        if (bias_term_) {
-            Tensor<xpu, 1, DType> bias =
-                in_data[conv::kBias].get<xpu, 1, DType>(s);
-            Tensor<xpu, 3, DType> output_3d =
-                out_data[conv::kOut].get_with_shape<xpu, 3, DType>(
-                    Shape3(num_, conv_out_channels_, conv_out_spatial_dim_), s);
-            // has bias term, broadcast it to the same shape of output_3d in
-            // channel dim
-            output_3d += mshadow::expr::broadcast<1>(bias, output_3d.shape_);
-        }
     }
 
-    virtual void Backward(const OpContext &ctx,
-                          const std::vector<TBlob> &out_grad,
-                          const std::vector<TBlob> &in_data,
-                          const std::vector<TBlob> &out_data,
-                          const std::vector<OpReqType> &req,
-                          const std::vector<TBlob> &in_grad,
-                          const std::vector<TBlob> &aux_args) {
+    // backward one sample at a time, with gemms per sample and group
+    void BackwardSample(mshadow::Stream<xpu> *s,
+                        const std::vector<TBlob> &out_grad,
+                        const std::vector<TBlob> &in_data,
+                        const std::vector<OpReqType> &req,
+                        const std::vector<TBlob> &in_grad, DType *workspace) {
         using namespace mshadow;
         using namespace mshadow::expr;
-        CHECK_EQ(out_grad.size(), 1U);
-        size_t expected = param_.no_bias == 0 ? 3 : 2;
-        CHECK(in_data.size() == expected && in_grad.size() == expected);
-        CHECK_EQ(req.size(), expected);
-        CHECK_EQ(in_data[conv::kWeight].CheckContiguous(), true);
-        LayerSetUp(in_grad[conv::kData].shape_, out_grad[conv::kOut].shape_);
-        Stream<xpu> *s = ctx.get_stream<xpu>();
-        // allocate workspace for col_buffer
-        Tensor<xpu, 1, DType> workspace =
-            ctx.requested[conv::kTempSpace].get_space_typed<xpu, 1, DType>(
-                Shape1(col_buffer_size_), s);
         // calculate the shape of col_buffer
         TShape col_buffer_shape(num_spatial_axes_ + 1);
         col_buffer_shape[0] = conv_in_channels_ * param_.kernel.Size();
@@ -203,7 +268,7 @@ class ConvolutionOp : public Operator {
             col_buffer_shape[i] = out_grad[conv::kData].shape_[i + 1];
         }
         // create a column buffer using workspace and col_buffer_shape
-        TBlob col_buffer(workspace.dptr_, col_buffer_shape, xpu::kDevMask,
+        TBlob col_buffer(workspace, col_buffer_shape, xpu::kDevMask,
                          DataType<DType>::kFlag);
 
         // initialize weight and col_buffer 3D tensors for using gemm
@@ -251,20 +316,244 @@ class ConvolutionOp : public Operator {
                 }
             }
         }
+    }
 
-        // gradient w.r.t bias
-        if (bias_term_) {
-            Tensor<xpu, 1, DType> dbias =
-                in_grad[conv::kBias].get<xpu, 1, DType>(s);
-            Tensor<xpu, 3, DType> dout =
-                out_grad[conv::kOut].get_with_shape<xpu, 3, DType>(
-                    Shape3(num_, conv_out_channels_, conv_out_spatial_dim_), s);
-            ASSIGN_DISPATCH(dbias, req[conv::kBias],
-                            sumall_except_dim<1>(dout));
+    /*!
+     * \brief forward nstep_ samples at a time on cpu: the samples are
+     *  unrolled into one column buffer so that each group is a single gemm
+     */
+    void ForwardBatch(mshadow::Stream<cpu> *s,
+                      const std::vector<TBlob> &in_data,
+                      const std::vector<TBlob> &out_data, DType *workspace) {
+        using namespace mshadow;
+        using namespace mshadow::expr;
+        const index_t M = conv_out_channels_ / group_;
+        const index_t N = conv_out_spatial_dim_;
+        const index_t K = kernel_dim_;
+        Tensor<cpu, 3, DType> weight_3d =
+            in_data[conv::kWeight].get_with_shape<cpu, 3, DType>(
+                Shape3(group_, M, K), s);
+        Tensor<cpu, 3, DType> output_3d =
+            out_data[conv::kOut].get_with_shape<cpu, 3, DType>(
+                Shape3(num_, conv_out_channels_, N), s);
+        for (index_t i = 0; i < num_; i += nstep_) {
+            const index_t step = std::min(nstep_, num_ - i);
+            Tensor<cpu, 3, DType> col_3d(workspace,
+                                         Shape3(group_, K, step * N), s);
+            Tensor<cpu, 3, DType> dst_3d(workspace + col_3d.MSize(),
+                                         Shape3(group_, M, step * N), s);
+            const DType *data = in_data[conv::kData].dptr<DType>();
+            im2col_batch(s, data + i * input_dim_, step,
+                         in_data[conv::kData].shape_, param_.kernel,
+                         param_.pad, param_.stride, param_.dilate,
+                         col_3d.dptr_);
+            for (index_t g = 0; g < group_; ++g) {
+                dst_3d[g] = dot(weight_3d[g], col_3d[g]);
+            }
+            // (group * M, step, N) to (step, group * M, N)
+            output_3d.Slice(i, i + step) = swapaxis<1, 0>(
+                reshape(dst_3d, Shape3(conv_out_channels_, step, N)));
         }
     }
 
-   private:
+    void ForwardBatch(mshadow::Stream<gpu> *s,
+                      const std::vector<TBlob> &in_data,
+                      const std::vector<TBlob> &out_data, DType *workspace) {
+        LOG(FATAL) << "batched convolution is only implemented on cpu";
+    }
+
+    /*!
+     * \brief backward nstep_ samples at a time on cpu, each group is a single
+     *  gemm for the weight gradient and one for the data gradient
+     */
+    void BackwardBatch(mshadow::Stream<cpu> *s,
+                       const std::vector<TBlob> &out_grad,
+                       const std::vector<TBlob> &in_data,
+                       const std::vector<OpReqType> &req,
+                       const std::vector<TBlob> &in_grad, DType *workspace) {
+        using namespace mshadow;
+        using namespace mshadow::expr;
+        const index_t M = kernel_dim_;
+        const index_t N = conv_out_spatial_dim_;
+        const index_t K = conv_out_channels_ / group_;
+        Tensor<cpu, 3, DType> weight_3d =
+            in_data[conv::kWeight].get_with_shape<cpu, 3, DType>(
+                Shape3(group_, K, M), s);
+        Tensor<cpu, 3, DType> dweight_3d =
+            in_grad[conv::kWeight].get_with_shape<cpu, 3, DType>(
+                Shape3(group_, K, M), s);
+        Tensor<cpu, 3, DType> out_grad_3d =
+            out_grad[conv::kOut].get_with_shape<cpu, 3, DType>(
+                Shape3(num_, conv_out_channels_, N), s);
+        for (index_t i = 0; i < num_; i += nstep_) {
+            const index_t step = std::min(nstep_, num_ - i);
+            Tensor<cpu, 3, DType> col_3d(workspace,
+                                         Shape3(group_, M, step * N), s);
+            Tensor<cpu, 3, DType> dst_3d(workspace + col_3d.MSize(),
+                                         Shape3(group_, K, step * N), s);
+            // (step, group * K, N) to (group * K, step, N)
+            dst_3d = reshape(swapaxis<1, 0>(out_grad_3d.Slice(i, i + step)),
+                             dst_3d.shape_);
+            // gradient w.r.t. weight, accumulated across the batch
+            const DType *data = in_data[conv::kData].dptr<DType>();
+            im2col_batch(s, data + i * input_dim_, step,
+                         in_data[conv::kData].shape_, param_.kernel,
+                         param_.pad, param_.stride, param_.dilate,
+                         col_3d.dptr_);
+            for (index_t g = 0; g < group_; ++g) {
+                if (0 == i) {
+                    ASSIGN_DISPATCH(dweight_3d[g], req[conv::kWeight],
+                                    dot(dst_3d[g], col_3d[g].T()));
+                } else {
+                    dweight_3d[g] += dot(dst_3d[g], col_3d[g].T());
+                }
+            }
+            // gradient w.r.t. input data
+            for (index_t g = 0; g < group_; ++g) {
+                col_3d[g] = dot(weight_3d[g].T(), dst_3d[g]);
+            }
+            col2im_batch(s, col_3d.dptr_, step, in_grad[conv::kData].shape_,
+                         param_.kernel, param_.pad, param_.stride,
+                         param_.dilate,
+                         in_grad[conv::kData].dptr<DType>() + i * input_dim_,
+                         req[conv::kData]);
+        }
+    }
+
+    void BackwardBatch(mshadow::Stream<gpu> *s,
+                       const std::vector<TBlob> &out_grad,
+                       const std::vector<TBlob> &in_data,
+                       const std::vector<OpReqType> &req,
+                       const std::vector<TBlob> &in_grad, DType *workspace) {
+        LOG(FATAL) << "batched convolution is only implemented on cpu";
+    }
+
+    /*!
+     * \brief forward of a stride-1 3x3 convolution with winograd F(2x2, 3x3)
+     *  on cpu. The filters are transformed once, then winograd_step_ tiles
+     *  at a time are transformed and multiplied with one gemm per element
+     *  of the 4x4 transform domain.
+     */
+    void ForwardWinograd(mshadow::Stream<cpu> *s,
+                         const std::vector<TBlob> &in_data,
+                         const std::vector<TBlob> &out_data,
+                         DType *workspace) {
+        using namespace mshadow;
+        using namespace mshadow::expr;
+        using winograd::kDomain;
+        using winograd::num_tiles;
+        const TShape &ishape = in_data[conv::kData].shape_;
+        const TShape &oshape = out_data[conv::kOut].shape_;
+        const index_t C = conv_in_channels_, K = conv_out_channels_;
+        const index_t tiles =
+            num_ * num_tiles(oshape[2]) * num_tiles(oshape[3]);
+        Tensor<cpu, 3, DType> u(workspace, Shape3(kDomain, K, C), s);
+        winograd_filter_transform(in_data[conv::kWeight].dptr<DType>(), K, C,
+                                  u.dptr_);
+        for (index_t i = 0; i < tiles; i += winograd_step_) {
+            const index_t step = std::min(winograd_step_, tiles - i);
+            Tensor<cpu, 3, DType> v(u.dptr_ + u.MSize(),
+                                    Shape3(kDomain, C, step), s);
+            Tensor<cpu, 3, DType> m(v.dptr_ + v.MSize(),
+                                    Shape3(kDomain, K, step), s);
+            winograd_input_transform(in_data[conv::kData].dptr<DType>(), C,
+                                     ishape[2], ishape[3], param_.pad[0],
+                                     param_.pad[1], i, step, v.dptr_);
+            for (int t = 0; t < kDomain; ++t) {
+                m[t] = dot(u[t], v[t]);
+            }
+            winograd_output_transform(m.dptr_, K, oshape[2], oshape[3], i,
+                                      step, out_data[conv::kOut].dptr<DType>());
+        }
+    }
+
+    void ForwardWinograd(mshadow::Stream<gpu> *s,
+                         const std::vector<TBlob> &in_data,
+                         const std::vector<TBlob> &out_data,
+                         DType *workspace) {
+        LOG(FATAL) << "winograd convolution is only implemented on cpu";
+    }
+
+    void ForwardDepthwise(mshadow::Stream<cpu> *s,
+                          const std::vector<TBlob> &in_data,
+                          const std::vector<TBlob> &out_data) {
+        depthwise_conv_forward(in_data[conv::kData].dptr<DType>(),
+                               in_data[conv::kWeight].dptr<DType>(), num_,
+                               in_data[conv::kData].shape_, param_.kernel,
+                               param_.pad, param_.stride, param_.dilate,
+                               out_data[conv::kOut].dptr<DType>());
+    }
+
+    void ForwardDepthwise(mshadow::Stream<gpu> *s,
+                          const std::vector<TBlob> &in_data,
+                          const std::vector<TBlob> &out_data) {
+        LOG(FATAL) << "direct depthwise convolution is only implemented on cpu";
+    }
+
+    void BackwardDepthwise(mshadow::Stream<cpu> *s,
+                           const std::vector<TBlob> &out_grad,
+                           const std::vector<TBlob> &in_data,
+                           const std::vector<OpReqType> &req,
+                           const std::vector<TBlob> &in_grad) {
+        depthwise_conv_backward(
+            out_grad[conv::kOut].dptr<DType>(),
+            in_data[conv::kData].dptr<DType>(),
+            in_data[conv::kWeight].dptr<DType>(), num_,
+            in_data[conv::kData].shape_, param_.kernel, param_.pad,
+            param_.stride, param_.dilate, in_grad[conv::kData].dptr<DType>(),
+            req[conv::kData], in_grad[conv::kWeight].dptr<DType>(),
+            req[conv::kWeight]);
+    }
+
+    void BackwardDepthwise(mshadow::Stream<gpu> *s,
+                           const std::vector<TBlob> &out_grad,
+                           const std::vector<TBlob> &in_data,
+                           const std::vector<OpReqType> &req,
+                           const std::vector<TBlob> &in_grad) {
+        LOG(FATAL) << "direct depthwise convolution is only implemented on cpu";
+    }
+
+    // workspace of winograd: the transformed filters, plus the transformed
+    // inputs and the products of `step` tiles
+    index_t WinogradWorkspaceSize(index_t step) const {
+        return winograd::kDomain *
+               (conv_out_channels_ * conv_in_channels_ +
+                (conv_in_channels_ + conv_out_channels_) * step);
+    }
+
+    /*!
+     * \brief choose the cpu algorithm. Depthwise convolutions are computed
+     *  directly, stride-1 3x3 convolutions with enough channels use winograd
+     *  when its workspace fits, everything else im2col + gemm. Winograd is
+     *  skipped for half precision, where the transforms lose too much
+     *  accuracy.
+     */
+    int SelectAlgo(const TShape &oshape) {
+        if (!xpu::kDevCPU || !fast_algo_ || num_spatial_axes_ > 2) {
+            return conv::kIm2col;
+        }
+        if (group_ == conv_in_channels_ && group_ == conv_out_channels_) {
+            return conv::kDepthwise;
+        }
+        if (num_spatial_axes_ != 2 || group_ != 1 ||
+            param_.kernel[0] != 3 || param_.kernel[1] != 3 ||
+            param_.stride[0] != 1 || param_.stride[1] != 1 ||
+            param_.dilate[0] != 1 || param_.dilate[1] != 1 ||
+            std::is_same<DType, mshadow::half::half_t>::value ||
+            conv_in_channels_ < conv::kWinogradMinChannels ||
+            conv_out_channels_ < conv::kWinogradMinChannels ||
+            param_.workspace < WinogradWorkspaceSize(1)) {
+            return conv::kIm2col;
+        }
+        const index_t tiles = num_ * winograd::num_tiles(oshape[2]) *
+                              winograd::num_tiles(oshape[3]);
+        winograd_step_ = std::min<index_t>(
+            (param_.workspace - WinogradWorkspaceSize(0)) /
+                (winograd::kDomain * (conv_in_channels_ + conv_out_channels_)),
+            tiles);
+        return conv::kWinograd;
+    }
+
     void LayerSetUp(const TShape &ishape, const TShape &oshape) {
         channel_axis_ = 1;  // hard code channel axis
         const index_t first_spatial_axis = channel_axis_ + 1;
@@ -297,6 +586,16 @@ class ConvolutionOp : public Operator {
         output_dim_ = oshape.ProdShape(1, oshape.ndim());
         num_kernels_im2col_ = conv_in_channels_ * conv_out_spatial_dim_;
         num_kernels_col2im_ = input_dim_;
+        // on cpu, unroll as many samples as the workspace holds into one
+        // column buffer, so that each group is one large gemm instead of a
+        // small one per sample
+        nstep_ = 1;
+        if (xpu::kDevCPU && num_spatial_axes_ <= 2) {
+            const index_t unit = col_buffer_size_ + output_dim_;
+            nstep_ = std::max<index_t>(
+                std::min<index_t>(param_.workspace / unit, num_), 1);
+        }
+        algo_ = SelectAlgo(oshape);
     }
 
    private:
@@ -322,6 +621,10 @@ class ConvolutionOp : public Operator {
     index_t num_kernels_col2im_;
     bool bias_term_;  // has bias term?
     bool is_1x1_;
+    index_t nstep_;  // number of samples unrolled into one column buffer
+    bool fast_algo_;  // whether specialised cpu kernels may be selected
+    int algo_;        // cpu algorithm, one of conv::ConvolutionOpCpuAlgo
+    index_t winograd_step_;  // number of tiles transformed at a time
 };  // class ConvolutionOp
 
 template <typename xpu>
@@ -17,45 +17,17 @@
 #include <vector>
 #include "./mshadow_op.h"
 #include "./operator_common.h"
-
-#if defined(USE_MKL) && defined(_OPENMP)
-#include <omp.h>
-
-#include <mkl_vml_functions.h>
-#include <mkl_vsl.h>
-#endif  // USE_MKL && _OPENMP
+#include "./tensor/parallel_sampler.h"
 
 namespace dropout {
 enum DropoutOpInputs { kData };
 enum DropoutOpOutputs { kOut, kMask };
-enum DropoutOpForwardResource { kRandom };
+enum DropoutOpForwardResource { kRandom, kParallelRandom };
 }  // namespace dropout
 
 namespace mxnet {
 namespace op {
 
-#if defined(USE_MKL) && defined(_OPENMP)
-static void bernoulli_generate(int n, double p, int *r) {
-    int seed = 17 + rand() % 4096;  // NOLINT(runtime/threadsafe_fn)
-    int nthr = omp_get_max_threads();
-#pragma omp parallel num_threads(nthr)
-    {
-        const int ithr = omp_get_thread_num();
-        const int avg_amount = (n + nthr - 1) / nthr;
-        const int my_offset = ithr * avg_amount;
-        const int my_amount = std::min(my_offset + avg_amount, n) - my_offset;
-        if (my_amount > 0) {
-            VSLStreamStatePtr stream;
-            vslNewStream(&stream, VSL_BRNG_MCG31, seed);
-            vslSkipAheadStream(stream, my_offset);
-            viRngBernoulli(VSL_RNG_METHOD_BERNOULLI_ICDF, stream, my_amount,
-                           r + my_offset, p);
-            vslDeleteStream(&stream);
-        }
-    }
-}
-#endif  // USE_MKL && _OPENMP
-
 struct DropoutParam : public dmlc::Parameter<DropoutParam> {
     float p;
     DMLC_DECLARE_PARAMETER(DropoutParam) {
@@ -92,24 +64,8 @@ class DropoutOp : public Operator {
         if (ctx.is_train) {
             Tensor<xpu, 2, DType> mask =
                 out_data[dropout::kMask].FlatTo2D<xpu, DType>(s);
-#if defined(USE_MKL) && defined(_OPENMP)
-            DType *outptr = out.dptr_;
-            DType *dataptr = data.dptr_;
-            int *maskptr = reinterpret_cast<int *>(mask.dptr_);
-            int count = mask.shape_[0] * mask.shape_[1];
-            bernoulli_generate(count, this->pkeep_, maskptr);
-#pragma omp parallel for
-            for (int i = 0; i < count; ++i) {
-                outptr[i] = dataptr[i] * maskptr[i];
-            }
-#else
-            Random<xpu> *prnd =
-                ctx.requested[dropout::kRandom].get_random<xpu, real_t>(s);
-            mask = tcast<DType>(
-                F<mshadow_op::threshold>(prnd->uniform(mask.shape_), pkeep_) *
-                (1.0f / pkeep_));
+            this->GenerateMask(ctx, mask);
             Assign(out, req[dropout::kOut], data * mask);
-#endif  // USE_MKL && _OPENMP
         } else {
             Assign(out, req[dropout::kOut], F<mshadow_op::identity>(data));
         }
@@ -133,23 +89,37 @@ class DropoutOp : public Operator {
             out_data[dropout::kMask].FlatTo2D<xpu, DType>(s);
         Tensor<xpu, 2, DType> gdata =
             in_grad[dropout::kData].FlatTo2D<xpu, DType>(s);
-#if defined(USE_MKL) && defined(_OPENMP)
-        DType *ingradptr = gdata.dptr_;
-        DType *outgradptr = grad.dptr_;
-        int *maskptr = reinterpret_cast<int *>(mask.dptr_);
-
-        int count = mask.shape_[0] * mask.shape_[1];
-
-#pragma omp parallel for
-        for (int i = 0; i < count; ++i) {
-            ingradptr[i] = outgradptr[i] * maskptr[i];
-        }
-#else  // USE_MKL && _OPENMP
         Assign(gdata, req[dropout::kData], grad * mask);
-#endif  // USE_MKL && _OPENMP
     }
 
    private:
+    // on cpu, draw the mask in parallel from the counter-based generator, so
+    // that it only depends on the seed and not on the number of threads
+    inline void GenerateMask(const OpContext &ctx,
+                             mshadow::Tensor<cpu, 2, DType> mask) {
+        const real_t pkeep = pkeep_;
+        const DType scale = DType(1.0f / pkeep_);
+        DType *ptr = mask.dptr_;
+        ParallelSample<float>(
+            ctx.requested[dropout::kParallelRandom].get_parallel_random(),
+            mask.shape_.Size(), [&](RandomSampler<float> *sampler, index_t i) {
+                ptr[i] = sampler->Uniform() < pkeep ? scale : DType(0);
+            });
+    }
+
+    // elsewhere, use the generator of the device
+    template <typename Device>
+    inline void GenerateMask(const OpContext &ctx,
+                             mshadow::Tensor<Device, 2, DType> mask) {
+        using namespace mshadow::expr;
+        mshadow::Random<Device> *prnd =
+            ctx.requested[dropout::kRandom].get_random<Device, real_t>(
+                mask.stream_);
+        mask = tcast<DType>(
+            F<mshadow_op::threshold>(prnd->uniform(mask.shape_), pkeep_) *
+            (1.0f / pkeep_));
+    }
+
     real_t pkeep_;
 };  // class DropoutOp
 
@@ -226,7 +196,7 @@ class DropoutProp : public OperatorProperty {
 
     std::vector<ResourceRequest> ForwardResource(
         const std::vector<TShape> &in_shape) const override {
-        return {ResourceRequest::kRandom};
+        return {ResourceRequest::kRandom, ResourceRequest::kParallelRandom};
     }
 
     int NumVisibleOutputs() const override { return 1; }
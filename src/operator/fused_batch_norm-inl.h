@@ -0,0 +1,223 @@
+/*!
+ * Copyright (c) 2017 by Contributors
+ * \file fused_batch_norm-inl.h
+ * \brief Convolution or FullyConnected followed by BatchNorm and an optional
+ *  Activation, computed as one operator for inference on cpu
+ */
+#ifndef MXNET_OPERATOR_FUSED_BATCH_NORM_INL_H_
+#define MXNET_OPERATOR_FUSED_BATCH_NORM_INL_H_
+
+#include <dmlc/logging.h>
+#include <dmlc/optional.h>
+#include <dmlc/parameter.h>
+#include <mxnet/operator.h>
+#include <cmath>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include "./activation-inl.h"
+#include "./mshadow_op.h"
+#include "./operator_common.h"
+
+namespace mxnet {
+namespace op {
+
+namespace fusedbn {
+// inputs of the wrapped operator come first, then these
+enum FusedBatchNormOpInputs { kGamma, kBeta };
+enum FusedBatchNormOpAuxiliary { kMovingMean, kMovingVar };
+}  // namespace fusedbn
+
+struct FusedBatchNormParam : public dmlc::Parameter<FusedBatchNormParam> {
+    float eps;
+    bool fix_gamma;
+    bool use_global_stats;
+    dmlc::optional<int> act_type;
+    DMLC_DECLARE_PARAMETER(FusedBatchNormParam) {
+        DMLC_DECLARE_FIELD(eps).set_default(1e-3f).describe(
+            "Epsilon of the batch norm.");
+        DMLC_DECLARE_FIELD(fix_gamma)
+            .set_default(true)
+            .describe("Whether gamma of the batch norm is fixed to 1.");
+        DMLC_DECLARE_FIELD(use_global_stats)
+            .set_default(false)
+            .describe(
+                "Whether the batch norm uses the moving statistics in "
+                "training mode as well.");
+        DMLC_DECLARE_FIELD(act_type)
+            .add_enum("relu", activation::kReLU)
+            .add_enum("sigmoid", activation::kSigmoid)
+            .add_enum("tanh", activation::kTanh)
+            .add_enum("softrelu", activation::kSoftReLU)
+            .set_default(dmlc::optional<int>())
+            .describe("Activation applied after the batch norm, if any.");
+    }
+};
+
+/*!
+ * \brief out = OP(out * scale[c] + shift[c]) for every channel c of an
+ *  (N, C, ...) output, in place
+ */
+template <typename OP, typename DType>
+inline void fused_scale_shift(DType* out, int num, int channels, int spatial,
+                              const DType* scale, const DType* shift) {
+    const int nunit = num * channels;
+#pragma omp parallel for
+    for (int i = 0; i < nunit; ++i) {
+        const DType a = scale[i % channels], b = shift[i % channels];
+        DType* dst = out + i * spatial;
+        for (int s = 0; s < spatial; ++s) {
+            dst[s] = OP::Map(DType(dst[s] * a + b));
+        }
+    }
+}
+
+/*!
+ * \brief Runs the wrapped operator without bias and folds bias, batch norm
+ *  and activation into a single pass over its output. With the moving
+ *  statistics the batch norm scale is folded into the weights beforehand;
+ *  in training mode without global statistics the batch statistics of the
+ *  output are used, as BatchNorm does.
+ */
+template <typename DType, typename AccReal>
+class FusedBatchNormOp : public Operator {
+   public:
+    FusedBatchNormOp(FusedBatchNormParam param, Operator* op, bool has_bias)
+        : param_(param), op_(op), has_bias_(has_bias) {}
+
+    virtual void Forward(const OpContext& ctx,
+                         const std::vector<TBlob>& in_data,
+                         const std::vector<OpReqType>& req,
+                         const std::vector<TBlob>& out_data,
+                         const std::vector<TBlob>& aux_args) {
+        using namespace mshadow;
+        const size_t num_args = has_bias_ ? 3U : 2U;
+        CHECK_EQ(in_data.size(), num_args + 2);
+        CHECK_EQ(aux_args.size(), 2U);
+        CHECK_EQ(out_data.size(), 1U);
+        if (req[0] == kNullOp) return;
+        CHECK_EQ(req[0], kWriteTo);
+        const TBlob& weight = in_data[1];
+        const TShape& oshape = out_data[0].shape_;
+        const int channels = weight.shape_[0];
+        CHECK_EQ(oshape[1], static_cast<index_t>(channels));
+        const DType* gamma = in_data[num_args + fusedbn::kGamma].dptr<DType>();
+        const DType* beta = in_data[num_args + fusedbn::kBeta].dptr<DType>();
+        const DType* bias = has_bias_ ? in_data[2].dptr<DType>() : NULL;
+        const bool batch_stats = ctx.is_train && !param_.use_global_stats;
+        std::vector<DType> scale(channels, DType(1)), shift(channels);
+        std::vector<TBlob> args{in_data[0], weight};
+        if (!batch_stats) {
+            const DType* mean = aux_args[fusedbn::kMovingMean].dptr<DType>();
+            const DType* var = aux_args[fusedbn::kMovingVar].dptr<DType>();
+            // w' = w * scale, b' = (b - mean) * scale + beta
+            folded_weight_.resize(weight.Size());
+            const index_t row = weight.Size() / channels;
+            const DType* w = weight.dptr<DType>();
+            DType* folded = folded_weight_.data();
+#pragma omp parallel for
+            for (int k = 0; k < channels; ++k) {
+                const DType a = Scale(gamma, var, k);
+                for (index_t j = 0; j < row; ++j) {
+                    folded[k * row + j] = w[k * row + j] * a;
+                }
+                const DType b = bias ? bias[k] : DType(0);
+                shift[k] = (b - mean[k]) * a + beta[k];
+            }
+            args[1] = TBlob(folded, weight.shape_, cpu::kDevMask);
+        }
+        op_->Forward(ctx, args, req, out_data, std::vector<TBlob>());
+        const int num = oshape[0];
+        const int spatial = oshape.ProdShape(2, oshape.ndim());
+        DType* out = out_data[0].dptr<DType>();
+        if (batch_stats) {
+            // the bias cancels against the batch mean
+            std::vector<DType> mean(channels), var(channels);
+            BatchMoments(out, num, channels, spatial, &mean, &var);
+            for (int k = 0; k < channels; ++k) {
+                scale[k] = Scale(gamma, var.data(), k);
+                shift[k] = beta[k] - mean[k] * scale[k];
+            }
+        }
+        if (!param_.act_type.has_value()) {
+            fused_scale_shift<mshadow_op::identity>(
+                out, num, channels, spatial, scale.data(), shift.data());
+            return;
+        }
+        switch (param_.act_type.value()) {
+            case activation::kReLU:
+                fused_scale_shift<mshadow_op::relu>(
+                    out, num, channels, spatial, scale.data(), shift.data());
+                break;
+            case activation::kSigmoid:
+                fused_scale_shift<mshadow_op::sigmoid>(
+                    out, num, channels, spatial, scale.data(), shift.data());
+                break;
+            case activation::kTanh:
+                fused_scale_shift<mshadow_op::tanh>(
+                    out, num, channels, spatial, scale.data(), shift.data());
+                break;
+            case activation::kSoftReLU:
+                fused_scale_shift<mshadow_op::softrelu>(
+                    out, num, channels, spatial, scale.data(), shift.data());
+                break;
+            default:
+                LOG(FATAL) << "unknown activation type";
+        }
+    }
+
+    virtual void Backward(const OpContext& ctx,
+                          const std::vector<TBlob>& out_grad,
+                          const std::vector<TBlob>& in_data,
+                          const std::vector<TBlob>& out_data,
+                          const std::vector<OpReqType>& req,
+                          const std::vector<TBlob>& in_grad,
+                          const std::vector<TBlob>& aux_args) {
+        LOG(FATAL) << "fused batch norm is only used for inference";
+    }
+
+    ExecType exec_type() const override { return op_->exec_type(); }
+
+   private:
+    // gamma / sqrt(var + eps) of channel k
+    DType Scale(const DType* gamma, const DType* var, int k) const {
+        const AccReal invstd =
+            AccReal(1) / std::sqrt(static_cast<AccReal>(var[k]) +
+                                   static_cast<AccReal>(param_.eps));
+        const AccReal g =
+            param_.fix_gamma ? AccReal(1) : static_cast<AccReal>(gamma[k]);
+        return DType(g * invstd);
+    }
+
+    static void BatchMoments(const DType* out, int num, int channels,
+                             int spatial, std::vector<DType>* mean,
+                             std::vector<DType>* var) {
+        const DType count = DType(num * spatial);
+#pragma omp parallel for
+        for (int k = 0; k < channels; ++k) {
+            DType sum = 0, sqr = 0;
+            for (int n = 0; n < num; ++n) {
+                const DType* src = out + (n * channels + k) * spatial;
+                for (int s = 0; s < spatial; ++s) sum += src[s];
+            }
+            const DType m = sum / count;
+            for (int n = 0; n < num; ++n) {
+                const DType* src = out + (n * channels + k) * spatial;
+                for (int s = 0; s < spatial; ++s) {
+                    sqr += (src[s] - m) * (src[s] - m);
+                }
+            }
+            (*mean)[k] = m;
+            (*var)[k] = sqr / count;
+        }
+    }
+
+    FusedBatchNormParam param_;
+    std::unique_ptr<Operator> op_;
+    bool has_bias_;
+    std::vector<DType> folded_weight_;
+};  // class FusedBatchNormOp
+}  // namespace op
+}  // namespace mxnet
+#endif  // MXNET_OPERATOR_FUSED_BATCH_NORM_INL_H_
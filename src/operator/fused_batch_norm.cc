@@ -0,0 +1,137 @@
+/*!
+ * Copyright (c) 2017 by Contributors
+ * \file fused_batch_norm.cc
+ * \brief Convolution and FullyConnected fused with the BatchNorm and
+ *  Activation that follow them. The executor substitutes these operators
+ *  when it binds an inference graph on cpu.
+ */
+#include <cstring>
+#include "./elemwise_op_common.h"
+#include "./fused_batch_norm-inl.h"
+
+namespace mxnet {
+namespace op {
+DMLC_REGISTER_PARAMETER(FusedBatchNormParam);
+
+/*!
+ * \brief attributes of a fused operator: the property of the wrapped
+ *  operator, the arguments it is created with, and the batch norm and
+ *  activation parameters
+ */
+struct FusedBatchNormAttrs {
+    std::shared_ptr<OperatorProperty> prop;
+    std::vector<std::pair<std::string, std::string> > kwargs;
+    FusedBatchNormParam param;
+};
+
+inline const FusedBatchNormAttrs& GetFusedAttrs(const nnvm::NodeAttrs& attrs) {
+    return nnvm::get<FusedBatchNormAttrs>(attrs.parsed);
+}
+
+void FusedBatchNormAttrParser(nnvm::NodeAttrs* attrs) {
+    // _fused_Convolution wraps Convolution, etc.
+    const std::string name = attrs->op->name.substr(std::strlen("_fused_"));
+    FusedBatchNormAttrs ret;
+    ret.kwargs = ret.param.InitAllowUnknown(attrs->dict);
+    ret.prop.reset(OperatorProperty::Create(name.c_str()));
+    ret.prop->Init(ret.kwargs);
+    attrs->parsed = std::move(ret);
+}
+
+uint32_t FusedBatchNormNumInputs(const nnvm::NodeAttrs& attrs) {
+    return GetFusedAttrs(attrs).prop->ListArguments().size() + 4;
+}
+
+std::vector<std::string> FusedBatchNormInputNames(
+    const nnvm::NodeAttrs& attrs) {
+    std::vector<std::string> ret = GetFusedAttrs(attrs).prop->ListArguments();
+    for (const char* name : {"gamma", "beta", "moving_mean", "moving_var"}) {
+        ret.push_back(name);
+    }
+    return ret;
+}
+
+bool FusedBatchNormInferShape(const nnvm::NodeAttrs& attrs,
+                              std::vector<TShape>* in_shape,
+                              std::vector<TShape>* out_shape) {
+    const OperatorProperty* prop = GetFusedAttrs(attrs).prop.get();
+    const size_t num_args = prop->ListArguments().size();
+    std::vector<TShape> args(in_shape->begin(),
+                             in_shape->begin() + num_args);
+    std::vector<TShape> outs, aux;
+    if (!prop->InferShape(&args, &outs, &aux)) return false;
+    for (size_t i = 0; i < num_args; ++i) {
+        SHAPE_ASSIGN_CHECK(*in_shape, i, args[i]);
+    }
+    const TShape cshape = mshadow::Shape1(outs[0][1]);
+    for (size_t i = num_args; i < in_shape->size(); ++i) {
+        SHAPE_ASSIGN_CHECK(*in_shape, i, cshape);
+    }
+    SHAPE_ASSIGN_CHECK(*out_shape, 0, outs[0]);
+    return true;
+}
+
+bool FusedBatchNormInferType(const nnvm::NodeAttrs& attrs,
+                             std::vector<int>* in_type,
+                             std::vector<int>* out_type) {
+    return ElemwiseAttr<int, type_is_none, type_assign, true, type_string>(
+        attrs, in_type, out_type, -1);
+}
+
+std::vector<ResourceRequest> FusedBatchNormResource(
+    const nnvm::NodeAttrs& attrs) {
+    return GetFusedAttrs(attrs).prop->ForwardResource(std::vector<TShape>());
+}
+
+Operator* CreateFusedBatchNormOp(const nnvm::NodeAttrs& attrs, Context ctx,
+                                 const std::vector<TShape>& in_shape,
+                                 const std::vector<int>& in_type) {
+    CHECK_EQ(ctx.dev_mask(), cpu::kDevMask)
+        << attrs.op->name << " is only implemented on cpu";
+    const FusedBatchNormAttrs& fused = GetFusedAttrs(attrs);
+    const size_t num_args = fused.prop->ListArguments().size();
+    // the bias is added together with the batch norm shift
+    std::vector<std::pair<std::string, std::string> > kwargs;
+    for (const auto& kv : fused.kwargs) {
+        if (kv.first != "no_bias") kwargs.push_back(kv);
+    }
+    kwargs.push_back({"no_bias", "True"});
+    std::unique_ptr<OperatorProperty> prop(
+        OperatorProperty::Create(fused.prop->TypeString().c_str()));
+    prop->Init(kwargs);
+    std::vector<TShape> ishape(in_shape.begin(), in_shape.begin() + 2);
+    std::vector<int> itype(in_type.begin(), in_type.begin() + 2);
+    Operator* wrapped = prop->CreateOperatorEx(ctx, &ishape, &itype);
+    Operator* op = NULL;
+    MSHADOW_REAL_TYPE_SWITCH_EX(in_type[0], DType, AccReal, {
+        op = new FusedBatchNormOp<DType, AccReal>(fused.param, wrapped,
+                                                  num_args == 3);
+    });
+    return op;
+}
+
+#define MXNET_REGISTER_FUSED_BATCH_NORM(name)                                \
+    NNVM_REGISTER_OP(_fused_##name)                                          \
+        .describe(#name " followed by BatchNorm and an optional Activation, " \
+                  "forward only.")                                          \
+        .set_num_inputs(FusedBatchNormNumInputs)                             \
+        .set_num_outputs(1)                                                  \
+        .set_attr_parser(FusedBatchNormAttrParser)                           \
+        .set_attr<nnvm::FListInputNames>("FListInputNames",                  \
+                                         FusedBatchNormInputNames)           \
+        .set_attr<nnvm::FInferShape>("FInferShape", FusedBatchNormInferShape) \
+        .set_attr<nnvm::FInferType>("FInferType", FusedBatchNormInferType)   \
+        .set_attr<nnvm::FMutateInputs>(                                      \
+            "FMutateInputs",                                                 \
+            [](const nnvm::NodeAttrs& attrs) {                               \
+                const uint32_t n = FusedBatchNormNumInputs(attrs);           \
+                return std::vector<uint32_t>{n - 2, n - 1};                  \
+            })                                                               \
+        .set_attr<FResourceRequest>("FResourceRequest",                      \
+                                    FusedBatchNormResource)                  \
+        .set_attr<FCreateLayerOp>("FCreateLayerOp", CreateFusedBatchNormOp)
+
+MXNET_REGISTER_FUSED_BATCH_NORM(Convolution);
+MXNET_REGISTER_FUSED_BATCH_NORM(FullyConnected);
+}  // namespace op
+}  // namespace mxnet
@@ -4,9 +4,84 @@
  * \brief loss function that takes a data and label
 */
 #include "./loss_binary_op-inl.h"
+#include <algorithm>
+#include <cmath>
+#include "./nn/online_softmax.h"
 
 namespace mxnet {
 namespace op {
+// On cpu the loss and the gradient are computed from the maximum and the sum
+// of exponentials of every row, without a temporary softmax matrix.
+template <>
+void SoftmaxCrossEntropyForward<cpu>(const nnvm::NodeAttrs& attrs,
+                                     const OpContext& ctx,
+                                     const std::vector<TBlob>& inputs,
+                                     const std::vector<OpReqType>& req,
+                                     const std::vector<TBlob>& outputs) {
+    CHECK_EQ(outputs[0].type_flag_, inputs[0].type_flag_)
+        << "Binary function only support input/output with the same type";
+    CHECK_EQ(outputs[0].type_flag_, inputs[1].type_flag_)
+        << "Binary function only support input/output with the same type";
+    if (req[0] == kNullOp) return;
+    const index_t n = inputs[0].shape_[0], m = inputs[0].shape_[1];
+    MSHADOW_REAL_TYPE_SWITCH(outputs[0].type_flag_, DType, {
+        const DType* data = inputs[0].dptr<DType>();
+        const DType* label = inputs[1].dptr<DType>();
+        std::vector<SoftmaxStat<DType> > stats(n);
+        SoftmaxRowStats(data, n, m, stats.data());
+        // -log(max(p, 1e-8)) with log(p) = x - log(sum(exp(x)))
+        const double bound = -std::log(1e-8);
+        double loss = 0;
+        for (index_t i = 0; i < n; ++i) {
+            const index_t k = static_cast<index_t>(label[i]);
+            CHECK_LT(k, m) << "SoftmaxCrossEntropy: label out of range";
+            const double nll = static_cast<double>(stats[i].LogSumExp()) -
+                               static_cast<double>(data[i * m + k]);
+            loss += std::min(nll, bound);
+        }
+        DType* out = outputs[0].dptr<DType>();
+        out[0] = req[0] == kAddTo ? DType(out[0] + DType(loss)) : DType(loss);
+    });
+}
+
+template <>
+void SoftmaxCrossEntropyBackward<cpu>(const nnvm::NodeAttrs& attrs,
+                                      const OpContext& ctx,
+                                      const std::vector<TBlob>& inputs,
+                                      const std::vector<OpReqType>& req,
+                                      const std::vector<TBlob>& outputs) {
+    CHECK_EQ(req[1], kNullOp)
+        << "SoftmaxCrossEntropy: Cannot take gradient wrt label";
+    if (req[0] == kNullOp) return;
+    const index_t n = inputs[1].shape_[0], m = inputs[1].shape_[1];
+    const bool add = req[0] == kAddTo;
+    MSHADOW_REAL_TYPE_SWITCH(outputs[0].type_flag_, DType, {
+        const DType scale = inputs[0].dptr<DType>()[0];
+        const DType* data = inputs[1].dptr<DType>();
+        const DType* label = inputs[2].dptr<DType>();
+        DType* grad = outputs[0].dptr<DType>();
+        // grad = scale * (softmax(data) - one_hot(label))
+        SoftmaxRows(data, n, m, [&](index_t i, index_t begin, index_t size,
+                                    const SoftmaxStat<DType>& stat) {
+            const DType* x = data + i * m + begin;
+            DType* g = grad + i * m + begin;
+            const DType p_scale = DType(scale / stat.sum);
+            if (add) {
+                for (index_t j = 0; j < size; ++j) {
+                    g[j] = DType(g[j] +
+                                 DType(std::exp(x[j] - stat.max)) * p_scale);
+                }
+            } else {
+                SoftmaxExpScale(x, stat.max, p_scale, g, size);
+            }
+            const index_t k = static_cast<index_t>(label[i]);
+            if (k >= begin && k - begin < size) {
+                g[k - begin] = DType(g[k - begin] - scale);
+            }
+        });
+    });
+}
+
 
 NNVM_REGISTER_OP(softmax_cross_entropy)
     .describe(
@@ -0,0 +1,150 @@
+/*!
+ * Copyright (c) 2017 by Contributors
+ * \file bilinear_sampling.h
+ * \brief bilinear sampling of feature maps at the points of a grid on cpu,
+ *  shared by the BilinearSampler and SpatialTransformer operators. Where an
+ *  output pixel reads its input depends only on the grid, so its four
+ *  neighbours and their weights are found once per pixel and reused by every
+ *  channel. Each (sample, channel) plane of the input gradient is written by
+ *  one thread only, so the scatters of the backward pass need no atomics.
+ */
+#ifndef MXNET_OPERATOR_NN_BILINEAR_SAMPLING_H_
+#define MXNET_OPERATOR_NN_BILINEAR_SAMPLING_H_
+
+#include <dmlc/omp.h>
+#include <mxnet/base.h>
+#include <algorithm>
+#include <cmath>
+
+namespace mxnet {
+namespace op {
+
+/*! \brief the input pixels an output pixel reads, and how much of each */
+template <typename DType>
+struct BilinearTap {
+    /*!
+     * \brief offsets in an input channel of the top left, top right, bottom
+     *  left and bottom right neighbours, -1 for a neighbour that is not read
+     */
+    int index[4];
+    /*! \brief weight of the top row and of the left column */
+    DType wy, wx;
+    /*! \brief value of neighbour k in the channel data, 0 when not read */
+    inline DType Value(const DType* data, int k) const {
+        return index[k] >= 0 ? data[index[k]] : DType(0);
+    }
+};
+
+/*!
+ * \brief The taps of the o_hw output pixels of num samples. grid holds the
+ *  x then the y plane of every sample, in [-1, 1] across the input.
+ * \param clamp if true the top left neighbour is clamped to [0, i_h] x
+ *  [0, i_w] and all four neighbours are read, as the SpatialTransformer
+ *  gpu kernels do; otherwise neighbours outside the input count as zero.
+ */
+template <typename DType>
+inline void BilinearTaps(const DType* grid, int num, int o_hw, int i_h,
+                         int i_w, bool clamp, BilinearTap<DType>* taps) {
+    const int total = num * o_hw;
+#pragma omp parallel for
+    for (int i = 0; i < total; ++i) {
+        const DType* g = grid + (i / o_hw) * 2 * o_hw + i % o_hw;
+        const DType y_real = (g[o_hw] + 1) * (i_h - 1) / 2;
+        const DType x_real = (g[0] + 1) * (i_w - 1) / 2;
+        int y = static_cast<int>(std::floor(y_real));
+        int x = static_cast<int>(std::floor(x_real));
+        BilinearTap<DType>& tap = taps[i];
+        if (clamp) {
+            y = std::min(i_h, std::max(0, y));
+            x = std::min(i_w, std::max(0, x));
+        }
+        tap.wy = static_cast<DType>(1.0 - (y_real - y));
+        tap.wx = static_cast<DType>(1.0 - (x_real - x));
+        for (int k = 0; k < 4; ++k) {
+            const int ny = y + k / 2, nx = x + k % 2;
+            const bool inside = ny >= 0 && ny < i_h && nx >= 0 && nx < i_w;
+            tap.index[k] = clamp || inside ? ny * i_w + nx : -1;
+        }
+    }
+}
+
+/*! \brief out (num, channels, o_hw) sampled from data (num, channels, i_hw) */
+template <typename DType>
+inline void BilinearGather(const DType* data,
+                           const BilinearTap<DType>* taps, int num,
+                           int channels, int i_hw, int o_hw, DType* out) {
+    const int planes = num * channels;
+#pragma omp parallel for
+    for (int i = 0; i < planes; ++i) {
+        const DType* plane = data + static_cast<size_t>(i) * i_hw;
+        const BilinearTap<DType>* tap = taps + (i / channels) * o_hw;
+        DType* dst = out + static_cast<size_t>(i) * o_hw;
+        for (int j = 0; j < o_hw; ++j) {
+            const BilinearTap<DType>& t = tap[j];
+            dst[j] = t.Value(plane, 0) * t.wy * t.wx +
+                     t.Value(plane, 1) * t.wy * (1 - t.wx) +
+                     t.Value(plane, 2) * (1 - t.wy) * t.wx +
+                     t.Value(plane, 3) * (1 - t.wy) * (1 - t.wx);
+        }
+    }
+}
+
+/*! \brief gdata += the gradient of BilinearGather with respect to data */
+template <typename DType>
+inline void BilinearScatter(const DType* grad,
+                            const BilinearTap<DType>* taps, int num,
+                            int channels, int i_hw, int o_hw, DType* gdata) {
+    const int planes = num * channels;
+#pragma omp parallel for
+    for (int i = 0; i < planes; ++i) {
+        const DType* g = grad + static_cast<size_t>(i) * o_hw;
+        const BilinearTap<DType>* tap = taps + (i / channels) * o_hw;
+        DType* plane = gdata + static_cast<size_t>(i) * i_hw;
+        for (int j = 0; j < o_hw; ++j) {
+            const BilinearTap<DType>& t = tap[j];
+            const DType w[4] = {t.wy * t.wx, t.wy * (1 - t.wx),
+                                (1 - t.wy) * t.wx, (1 - t.wy) * (1 - t.wx)};
+            for (int k = 0; k < 4; ++k) {
+                if (t.index[k] >= 0) plane[t.index[k]] += g[j] * w[k];
+            }
+        }
+    }
+}
+
+/*!
+ * \brief The gradient of BilinearGather with respect to the grid, summed
+ *  over the channels, in the layout of the grid.
+ * \param accumulate add to ggrid if true, overwrite it otherwise
+ */
+template <typename DType>
+inline void BilinearGridGrad(const DType* grad, const DType* data,
+                             const BilinearTap<DType>* taps, int num,
+                             int channels, int i_h, int i_w, int o_hw,
+                             bool accumulate, DType* ggrid) {
+    const int total = num * o_hw;
+    const int i_hw = i_h * i_w;
+#pragma omp parallel for
+    for (int i = 0; i < total; ++i) {
+        const int n = i / o_hw, j = i % o_hw;
+        const BilinearTap<DType>& t = taps[i];
+        const DType* g = grad + static_cast<size_t>(n) * channels * o_hw + j;
+        const DType* plane = data + static_cast<size_t>(n) * channels * i_hw;
+        DType gy = 0, gx = 0;
+        for (int c = 0; c < channels; ++c, g += o_hw, plane += i_hw) {
+            const DType tl = t.Value(plane, 0), tr = t.Value(plane, 1);
+            const DType bl = t.Value(plane, 2), br = t.Value(plane, 3);
+            // the gradients of the weights, negated for the coordinates
+            gy -= *g * (tr - br + (tl - tr - bl + br) * t.wx);
+            gx -= *g * (bl - br + (tl - tr - bl + br) * t.wy);
+        }
+        DType* dst = ggrid + static_cast<size_t>(n) * 2 * o_hw + j;
+        gy = gy * (i_h - 1) / 2;
+        gx = gx * (i_w - 1) / 2;
+        dst[o_hw] = accumulate ? dst[o_hw] + gy : gy;
+        dst[0] = accumulate ? dst[0] + gx : gx;
+    }
+}
+
+}  // namespace op
+}  // namespace mxnet
+#endif  // MXNET_OPERATOR_NN_BILINEAR_SAMPLING_H_
@@ -0,0 +1,332 @@
+/*!
+ * Copyright (c) 2017 by Contributors
+ * \file blocked_layout.cc
+ * \brief CPU operators on tensors in a channel-blocked layout. They are not
+ *  meant to be used directly: the executor substitutes them for Convolution,
+ *  Pooling and BatchNorm when MXNET_CPU_BLOCKED_LAYOUT is set.
+ */
+#include <cstring>
+#include <memory>
+#include "../batch_norm-inl.h"
+#include "../convolution-inl.h"
+#include "../elemwise_op_common.h"
+#include "../operator_common.h"
+#include "../pooling-inl.h"
+#include "./blocked_layout.h"
+
+namespace mxnet {
+namespace op {
+DMLC_REGISTER_PARAMETER(BlockedLayoutParam);
+
+/*!
+ * \brief attributes of a blocked operator: the property of the operator it
+ *  replaces, which does the shape inference, and its parameters with the
+ *  defaults the property fills in
+ */
+template <typename PType>
+struct BlockedOpAttrs {
+    std::shared_ptr<OperatorProperty> prop;
+    PType param;
+};
+
+template <typename PType>
+inline const BlockedOpAttrs<PType>& GetBlockedOpAttrs(
+    const nnvm::NodeAttrs& attrs) {
+    return nnvm::get<BlockedOpAttrs<PType> >(attrs.parsed);
+}
+
+template <typename PType>
+void BlockedOpAttrParser(nnvm::NodeAttrs* attrs) {
+    // _blocked_Convolution replaces Convolution, etc.
+    const std::string name =
+        attrs->op->name.substr(std::strlen("_blocked_"));
+    BlockedOpAttrs<PType> ret;
+    ret.prop.reset(OperatorProperty::Create(name.c_str()));
+    std::vector<std::pair<std::string, std::string> > kwargs(
+        attrs->dict.begin(), attrs->dict.end());
+    ret.prop->Init(kwargs);
+    ret.param.Init(ret.prop->GetParams());
+    attrs->parsed = std::move(ret);
+}
+
+template <typename PType>
+uint32_t BlockedOpNumInputs(const nnvm::NodeAttrs& attrs) {
+    const OperatorProperty* prop = GetBlockedOpAttrs<PType>(attrs).prop.get();
+    return prop->ListArguments().size() + prop->ListAuxiliaryStates().size();
+}
+
+template <typename PType>
+std::vector<std::string> BlockedOpInputNames(const nnvm::NodeAttrs& attrs) {
+    const OperatorProperty* prop = GetBlockedOpAttrs<PType>(attrs).prop.get();
+    std::vector<std::string> ret = prop->ListArguments();
+    for (const std::string& aux : prop->ListAuxiliaryStates()) {
+        ret.push_back(aux);
+    }
+    return ret;
+}
+
+/*!
+ * \brief infer the shapes by running the inference of the replaced operator
+ *  on the unblocked shape of the data
+ */
+template <typename PType>
+bool BlockedOpInferShape(const nnvm::NodeAttrs& attrs,
+                         std::vector<TShape>* in_shape,
+                         std::vector<TShape>* out_shape) {
+    const OperatorProperty* prop = GetBlockedOpAttrs<PType>(attrs).prop.get();
+    const TShape& dshape = (*in_shape)[0];
+    if (dshape.ndim() == 0) return false;
+    const size_t num_args = prop->ListArguments().size();
+    std::vector<TShape> args(in_shape->begin(),
+                             in_shape->begin() + num_args);
+    std::vector<TShape> aux(in_shape->begin() + num_args, in_shape->end());
+    std::vector<TShape> outs;
+    args[0] = unblocked_shape(dshape);
+    if (!prop->InferShape(&args, &outs, &aux)) return false;
+    for (size_t i = 1; i < num_args; ++i) {
+        SHAPE_ASSIGN_CHECK(*in_shape, i, args[i]);
+    }
+    for (size_t i = 0; i < aux.size(); ++i) {
+        SHAPE_ASSIGN_CHECK(*in_shape, num_args + i, aux[i]);
+    }
+    SHAPE_ASSIGN_CHECK(*out_shape, 0,
+                       blocked_shape(outs[0], dshape[dshape.ndim() - 1]));
+    return true;
+}
+
+inline bool BlockedOpInferType(const nnvm::NodeAttrs& attrs,
+                               std::vector<int>* in_type,
+                               std::vector<int>* out_type) {
+    return ElemwiseAttr<int, type_is_none, type_assign, true, type_string>(
+        attrs, in_type, out_type, -1);
+}
+
+inline bool ToBlockedShape(const nnvm::NodeAttrs& attrs,
+                           std::vector<TShape>* in_shape,
+                           std::vector<TShape>* out_shape) {
+    const BlockedLayoutParam& param =
+        nnvm::get<BlockedLayoutParam>(attrs.parsed);
+    CHECK_EQ(in_shape->size(), 1U);
+    const TShape& dshape = (*in_shape)[0];
+    if (dshape.ndim() == 0) return false;
+    SHAPE_ASSIGN_CHECK(*out_shape, 0, blocked_shape(dshape, param.block));
+    return true;
+}
+
+inline bool FromBlockedShape(const nnvm::NodeAttrs& attrs,
+                             std::vector<TShape>* in_shape,
+                             std::vector<TShape>* out_shape) {
+    CHECK_EQ(in_shape->size(), 1U);
+    const TShape& dshape = (*in_shape)[0];
+    if (dshape.ndim() == 0) return false;
+    SHAPE_ASSIGN_CHECK(*out_shape, 0, unblocked_shape(dshape));
+    return true;
+}
+
+void ToBlockedCompute(const nnvm::NodeAttrs& attrs, const OpContext& ctx,
+                      const std::vector<TBlob>& inputs,
+                      const std::vector<OpReqType>& req,
+                      const std::vector<TBlob>& outputs) {
+    if (req[0] == kNullOp) return;
+    CHECK_EQ(req[0], kWriteTo) << "_layout_to_blocked only supports write";
+    const TShape& ishape = inputs[0].shape_;
+    const int block = outputs[0].shape_[outputs[0].ndim() - 1];
+    MSHADOW_TYPE_SWITCH(inputs[0].type_flag_, DType, {
+        to_blocked(inputs[0].dptr<DType>(), ishape[0], ishape[1],
+                   ishape.ProdShape(2, ishape.ndim()), block,
+                   outputs[0].dptr<DType>());
+    });
+}
+
+void FromBlockedCompute(const nnvm::NodeAttrs& attrs, const OpContext& ctx,
+                        const std::vector<TBlob>& inputs,
+                        const std::vector<OpReqType>& req,
+                        const std::vector<TBlob>& outputs) {
+    if (req[0] == kNullOp) return;
+    CHECK_EQ(req[0], kWriteTo) << "_layout_from_blocked only supports write";
+    const TShape& oshape = outputs[0].shape_;
+    const int block = inputs[0].shape_[inputs[0].ndim() - 1];
+    MSHADOW_TYPE_SWITCH(inputs[0].type_flag_, DType, {
+        from_blocked(inputs[0].dptr<DType>(), oshape[0], oshape[1],
+                     oshape.ProdShape(2, oshape.ndim()), block,
+                     outputs[0].dptr<DType>());
+    });
+}
+
+void BlockedConvolutionCompute(const nnvm::NodeAttrs& attrs,
+                               const OpContext& ctx,
+                               const std::vector<TBlob>& inputs,
+                               const std::vector<OpReqType>& req,
+                               const std::vector<TBlob>& outputs) {
+    using namespace mshadow;
+    const ConvolutionParam& param =
+        GetBlockedOpAttrs<ConvolutionParam>(attrs).param;
+    if (req[0] == kNullOp) return;
+    CHECK_EQ(req[0], kWriteTo) << "_blocked_Convolution only supports write";
+    CHECK_EQ(param.kernel.ndim(), 2U);
+    CHECK_EQ(param.num_group, 1U);
+    Stream<cpu>* s = ctx.get_stream<cpu>();
+    const TShape& ishape = inputs[conv::kData].shape_;
+    const TShape& wshape = inputs[conv::kWeight].shape_;
+    const int block = ishape[ishape.ndim() - 1];
+    MSHADOW_REAL_TYPE_SWITCH(inputs[conv::kData].type_flag_, DType, {
+        Tensor<cpu, 1, DType> weight =
+            ctx.requested[0].get_space_typed<cpu, 1, DType>(
+                Shape1(wshape.Size()), s);
+        const DType* bias =
+            param.no_bias ? NULL : inputs[conv::kBias].dptr<DType>();
+        MXNET_BLOCK_SWITCH(block, kBlock, {
+            blocked_conv_weight<kBlock>(inputs[conv::kWeight].dptr<DType>(),
+                                        wshape[0], wshape[1],
+                                        wshape[2] * wshape[3], weight.dptr_);
+            blocked_conv_forward<kBlock>(
+                inputs[conv::kData].dptr<DType>(), weight.dptr_, bias, ishape,
+                outputs[conv::kOut].shape_, param.kernel, param.pad,
+                param.stride, param.dilate, outputs[conv::kOut].dptr<DType>());
+        });
+    });
+}
+
+void BlockedPoolingCompute(const nnvm::NodeAttrs& attrs, const OpContext& ctx,
+                           const std::vector<TBlob>& inputs,
+                           const std::vector<OpReqType>& req,
+                           const std::vector<TBlob>& outputs) {
+    const PoolingParam& param = GetBlockedOpAttrs<PoolingParam>(attrs).param;
+    if (req[0] == kNullOp) return;
+    CHECK_EQ(req[0], kWriteTo) << "_blocked_Pooling only supports write";
+    CHECK_EQ(param.kernel.ndim(), 2U);
+    const TShape& ishape = inputs[pool_enum::kData].shape_;
+    const int block = ishape[ishape.ndim() - 1];
+    const TShape kernel =
+        param.global_pool ? TShape(ishape.data() + 2, ishape.data() + 4)
+                          : param.kernel;
+    const TShape stride =
+        param.global_pool ? TShape(mshadow::Shape2(1, 1)) : param.stride;
+    MSHADOW_REAL_TYPE_SWITCH(inputs[pool_enum::kData].type_flag_, DType, {
+        MXNET_BLOCK_SWITCH(block, kBlock, {
+            blocked_pool_forward<kBlock>(
+                inputs[pool_enum::kData].dptr<DType>(), ishape,
+                outputs[pool_enum::kOut].shape_, kernel, param.pad, stride,
+                param.pool_type, outputs[pool_enum::kOut].dptr<DType>());
+        });
+    });
+}
+
+void BlockedBatchNormCompute(const nnvm::NodeAttrs& attrs,
+                             const OpContext& ctx,
+                             const std::vector<TBlob>& inputs,
+                             const std::vector<OpReqType>& req,
+                             const std::vector<TBlob>& outputs) {
+    using namespace batchnorm;
+    const BatchNormParam& param =
+        GetBlockedOpAttrs<BatchNormParam>(attrs).param;
+    if (req[kOut] == kNullOp) return;
+    CHECK_EQ(req[kOut], kWriteTo) << "_blocked_BatchNorm only supports write";
+    const TShape& ishape = inputs[kData].shape_;
+    const int block = ishape[ishape.ndim() - 1];
+    const int blocks = ishape[1];
+    const int channels = blocks * block;
+    const int spatial = ishape.ProdShape(2, ishape.ndim() - 1);
+    // the moving statistics follow the inputs
+    const TBlob& moving_mean = inputs[3 + kMovingMean];
+    const TBlob& moving_var = inputs[3 + kMovingVar];
+    MSHADOW_REAL_TYPE_SWITCH(inputs[kData].type_flag_, DType, {
+        std::vector<DType> mean(channels), var(channels);
+        if (ctx.is_train && !param.use_global_stats) {
+            MXNET_BLOCK_SWITCH(block, kBlock, {
+                blocked_channel_moments<kBlock>(inputs[kData].dptr<DType>(),
+                                                ishape[0], blocks, spatial,
+                                                mean.data(), var.data());
+            });
+        } else {
+            std::copy(moving_mean.dptr<DType>(),
+                      moving_mean.dptr<DType>() + channels, mean.begin());
+            std::copy(moving_var.dptr<DType>(),
+                      moving_var.dptr<DType>() + channels, var.begin());
+        }
+        // fold the statistics, gamma and beta into one scale and shift
+        const DType* gamma = inputs[kGamma].dptr<DType>();
+        const DType* beta = inputs[kBeta].dptr<DType>();
+        std::vector<DType> scale(channels), shift(channels);
+        for (int c = 0; c < channels; ++c) {
+            const float invstd =
+                1.0f / std::sqrt(static_cast<float>(var[c]) + param.eps);
+            scale[c] = (param.fix_gamma ? DType(1) : gamma[c]) * DType(invstd);
+            shift[c] = beta[c] - mean[c] * scale[c];
+        }
+        MXNET_BLOCK_SWITCH(block, kBlock, {
+            blocked_scale_shift<kBlock>(
+                inputs[kData].dptr<DType>(), ishape[0], blocks, spatial,
+                scale.data(), shift.data(), outputs[kOut].dptr<DType>());
+        });
+    });
+}
+
+NNVM_REGISTER_OP(_layout_to_blocked)
+    .describe(R"code(Convert an (N, C, ...) array into the channel-blocked
+layout (N, C / block, ..., block). C must be a multiple of block.
+)code" ADD_FILELINE)
+    .set_num_inputs(1)
+    .set_num_outputs(1)
+    .set_attr_parser(ParamParser<BlockedLayoutParam>)
+    .set_attr<nnvm::FInferShape>("FInferShape", ToBlockedShape)
+    .set_attr<nnvm::FInferType>("FInferType", ElemwiseType<1, 1>)
+    .set_attr<FCompute>("FCompute<cpu>", ToBlockedCompute)
+    .add_argument("data", "NDArray-or-Symbol", "Input array.")
+    .add_arguments(BlockedLayoutParam::__FIELDS__());
+
+NNVM_REGISTER_OP(_layout_from_blocked)
+    .describe(R"code(Convert an array in the channel-blocked layout
+(N, C / block, ..., block) back into (N, C, ...).
+)code" ADD_FILELINE)
+    .set_num_inputs(1)
+    .set_num_outputs(1)
+    .set_attr<nnvm::FInferShape>("FInferShape", FromBlockedShape)
+    .set_attr<nnvm::FInferType>("FInferType", ElemwiseType<1, 1>)
+    .set_attr<FCompute>("FCompute<cpu>", FromBlockedCompute)
+    .add_argument("data", "NDArray-or-Symbol", "Input array.");
+
+NNVM_REGISTER_OP(_blocked_Convolution)
+    .describe("2D Convolution of channel-blocked data, forward only.")
+    .set_num_inputs(BlockedOpNumInputs<ConvolutionParam>)
+    .set_num_outputs(1)
+    .set_attr_parser(BlockedOpAttrParser<ConvolutionParam>)
+    .set_attr<nnvm::FListInputNames>("FListInputNames",
+                                     BlockedOpInputNames<ConvolutionParam>)
+    .set_attr<nnvm::FInferShape>("FInferShape",
+                                 BlockedOpInferShape<ConvolutionParam>)
+    .set_attr<nnvm::FInferType>("FInferType", BlockedOpInferType)
+    .set_attr<FResourceRequest>("FResourceRequest",
+                                [](const nnvm::NodeAttrs& attrs) {
+                                    return std::vector<ResourceRequest>{
+                                        ResourceRequest::kTempSpace};
+                                })
+    .set_attr<FCompute>("FCompute<cpu>", BlockedConvolutionCompute);
+
+NNVM_REGISTER_OP(_blocked_Pooling)
+    .describe("2D Pooling of channel-blocked data, forward only.")
+    .set_num_inputs(1)
+    .set_num_outputs(1)
+    .set_attr_parser(BlockedOpAttrParser<PoolingParam>)
+    .set_attr<nnvm::FInferShape>("FInferShape",
+                                 BlockedOpInferShape<PoolingParam>)
+    .set_attr<nnvm::FInferType>("FInferType", ElemwiseType<1, 1>)
+    .set_attr<FCompute>("FCompute<cpu>", BlockedPoolingCompute);
+
+NNVM_REGISTER_OP(_blocked_BatchNorm)
+    .describe("BatchNorm of channel-blocked data, forward only.")
+    .set_num_inputs(5)
+    .set_num_outputs(1)
+    .set_attr_parser(BlockedOpAttrParser<BatchNormParam>)
+    .set_attr<nnvm::FListInputNames>("FListInputNames",
+                                     BlockedOpInputNames<BatchNormParam>)
+    .set_attr<nnvm::FInferShape>("FInferShape",
+                                 BlockedOpInferShape<BatchNormParam>)
+    .set_attr<nnvm::FInferType>("FInferType", BlockedOpInferType)
+    .set_attr<nnvm::FMutateInputs>("FMutateInputs",
+                                   [](const nnvm::NodeAttrs& attrs) {
+                                       return std::vector<uint32_t>{3, 4};
+                                   })
+    .set_attr<FCompute>("FCompute<cpu>", BlockedBatchNormCompute);
+}  // namespace op
+}  // namespace mxnet
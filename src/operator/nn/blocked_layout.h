@@ -0,0 +1,330 @@
+/*!
+ * Copyright (c) 2017 by Contributors
+ * \file blocked_layout.h
+ * \brief cpu kernels for tensors in a channel-blocked layout. An (N, C, ...)
+ *  tensor is stored as (N, C / b, ..., b) so that the b channels of a block
+ *  are contiguous, which lets the innermost loop of convolution, pooling and
+ *  batch norm run over a fixed number of adjacent channels.
+ */
+#ifndef MXNET_OPERATOR_NN_BLOCKED_LAYOUT_H_
+#define MXNET_OPERATOR_NN_BLOCKED_LAYOUT_H_
+
+#include <dmlc/parameter.h>
+#include <mxnet/base.h>
+#include <algorithm>
+#include <cmath>
+#include "./im2col.h"
+#include "./pool.h"
+
+namespace mxnet {
+namespace op {
+/*!
+ * \brief Only instantiate the code inside the switch for the block sizes the
+ *  kernels are specialized for.
+ * \param block the number of channels in a block
+ * \param kBlock the name of the compile time block size
+ */
+#define MXNET_BLOCK_SWITCH(block, kBlock, ...)                     \
+    switch (block) {                                               \
+        case 8: {                                                  \
+            const int kBlock = 8;                                  \
+            { __VA_ARGS__ }                                        \
+        } break;                                                   \
+        case 16: {                                                 \
+            const int kBlock = 16;                                 \
+            { __VA_ARGS__ }                                        \
+        } break;                                                   \
+        default:                                                   \
+            LOG(FATAL) << "channel block of " << block             \
+                       << " is not supported, use 8 or 16";        \
+    }
+
+struct BlockedLayoutParam : public dmlc::Parameter<BlockedLayoutParam> {
+    int block;
+    DMLC_DECLARE_PARAMETER(BlockedLayoutParam) {
+        DMLC_DECLARE_FIELD(block).set_default(8).describe(
+            "Number of channels stored contiguously in a block, 8 or 16.");
+    }
+};
+
+/*! \brief shape of the blocked layout of an (N, C, ...) tensor */
+inline TShape blocked_shape(const TShape& shape, index_t block) {
+    CHECK_GE(shape.ndim(), 2U);
+    CHECK_EQ(shape[1] % block, 0U)
+        << "channels (" << shape[1] << ") must be a multiple of the block ("
+        << block << ")";
+    TShape ret(shape.ndim() + 1);
+    for (index_t i = 0; i < shape.ndim(); ++i) ret[i] = shape[i];
+    ret[1] = shape[1] / block;
+    ret[shape.ndim()] = block;
+    return ret;
+}
+
+/*! \brief shape of the (N, C, ...) tensor stored in a blocked layout */
+inline TShape unblocked_shape(const TShape& shape) {
+    CHECK_GE(shape.ndim(), 3U);
+    TShape ret(shape.ndim() - 1);
+    for (index_t i = 0; i < ret.ndim(); ++i) ret[i] = shape[i];
+    ret[1] = shape[1] * shape[shape.ndim() - 1];
+    return ret;
+}
+
+/*!
+ * \brief convert an (N, C, S) tensor into (N, C / block, S, block). Every
+ *  unit of block channels is transposed independently.
+ */
+template <typename DType>
+inline void to_blocked(const DType* in, int num, int channels, int spatial,
+                       int block, DType* out) {
+    const int nunit = num * (channels / block);
+    const int unit_size = block * spatial;
+#pragma omp parallel for
+    for (int i = 0; i < nunit; ++i) {
+        const DType* src = in + i * unit_size;
+        DType* dst = out + i * unit_size;
+        for (int s = 0; s < spatial; ++s) {
+            for (int c = 0; c < block; ++c) {
+                dst[s * block + c] = src[c * spatial + s];
+            }
+        }
+    }
+}
+
+/*! \brief convert an (N, C / block, S, block) tensor back into (N, C, S) */
+template <typename DType>
+inline void from_blocked(const DType* in, int num, int channels, int spatial,
+                         int block, DType* out) {
+    const int nunit = num * (channels / block);
+    const int unit_size = block * spatial;
+#pragma omp parallel for
+    for (int i = 0; i < nunit; ++i) {
+        const DType* src = in + i * unit_size;
+        DType* dst = out + i * unit_size;
+        for (int c = 0; c < block; ++c) {
+            for (int s = 0; s < spatial; ++s) {
+                dst[c * spatial + s] = src[s * block + c];
+            }
+        }
+    }
+}
+
+/*!
+ * \brief rearrange (K, C, kernel_h, kernel_w) filters into
+ *  (K / kBlock, C / kBlock, kernel_h, kernel_w, kBlock_in, kBlock_out), so
+ *  that the filters of one output block for one input channel are
+ *  contiguous.
+ */
+template <int kBlock, typename DType>
+inline void blocked_conv_weight(const DType* weight, int out_channels,
+                                int in_channels, int kernel_size,
+                                DType* out) {
+    const int in_blocks = in_channels / kBlock;
+    const int nunit = out_channels * in_channels;
+#pragma omp parallel for
+    for (int i = 0; i < nunit; ++i) {
+        const int k = i / in_channels, c = i % in_channels;
+        const DType* src = weight + i * kernel_size;
+        DType* dst = out +
+                     ((k / kBlock) * in_blocks + c / kBlock) * kernel_size *
+                         kBlock * kBlock +
+                     (c % kBlock) * kBlock + k % kBlock;
+        for (int j = 0; j < kernel_size; ++j) {
+            dst[j * kBlock * kBlock] = src[j];
+        }
+    }
+}
+
+/*!
+ * \brief direct 2-D convolution of blocked tensors, parallel over output
+ *  rows. Each output pixel accumulates all kBlock channels of its output
+ *  block at once.
+ * \param data input of shape (N, C / kBlock, H, W, kBlock)
+ * \param weight filters rearranged by blocked_conv_weight
+ * \param bias bias of the K output channels, or NULL
+ * \param out output of shape (N, K / kBlock, output_h, output_w, kBlock)
+ */
+template <int kBlock, typename DType>
+inline void blocked_conv_forward(const DType* data, const DType* weight,
+                                 const DType* bias, const TShape& ishape,
+                                 const TShape& oshape, const TShape& kernel,
+                                 const TShape& pad, const TShape& stride,
+                                 const TShape& dilation, DType* out) {
+    const int num = ishape[0], in_blocks = ishape[1];
+    const int height = ishape[2], width = ishape[3];
+    const int out_blocks = oshape[1];
+    const int output_h = oshape[2], output_w = oshape[3];
+    const int kernel_h = kernel[0], kernel_w = kernel[1];
+    const int pad_h = pad[0], pad_w = pad[1];
+    const int stride_h = stride[0], stride_w = stride[1];
+    const int dilation_h = dilation[0], dilation_w = dilation[1];
+    const int block_size = kernel_h * kernel_w * kBlock * kBlock;
+    const int nrows = num * out_blocks * output_h;
+#pragma omp parallel for
+    for (int i = 0; i < nrows; ++i) {
+        const int oh = i % output_h;
+        const int kb = i / output_h % out_blocks;
+        const int n = i / (output_h * out_blocks);
+        const DType* im = data + n * in_blocks * height * width * kBlock;
+        const DType* w = weight + kb * in_blocks * block_size;
+        DType* dst = out + i * output_w * kBlock;
+        for (int ow = 0; ow < output_w; ++ow) {
+            DType acc[kBlock];
+            for (int co = 0; co < kBlock; ++co) {
+                acc[co] = bias ? bias[kb * kBlock + co] : DType(0);
+            }
+            for (int cb = 0; cb < in_blocks; ++cb) {
+                const DType* plane = im + cb * height * width * kBlock;
+                const DType* wb = w + cb * block_size;
+                for (int kh = 0; kh < kernel_h; ++kh) {
+                    const int h = oh * stride_h - pad_h + kh * dilation_h;
+                    if (!is_a_ge_zero_and_a_lt_b(h, height)) continue;
+                    for (int kw = 0; kw < kernel_w; ++kw) {
+                        const int x = ow * stride_w - pad_w + kw * dilation_w;
+                        if (!is_a_ge_zero_and_a_lt_b(x, width)) continue;
+                        const DType* src = plane + (h * width + x) * kBlock;
+                        const DType* wk =
+                            wb + (kh * kernel_w + kw) * kBlock * kBlock;
+                        for (int ci = 0; ci < kBlock; ++ci) {
+                            const DType v = src[ci];
+                            const DType* wr = wk + ci * kBlock;
+                            for (int co = 0; co < kBlock; ++co) {
+                                acc[co] += v * wr[co];
+                            }
+                        }
+                    }
+                }
+            }
+            for (int co = 0; co < kBlock; ++co) {
+                dst[ow * kBlock + co] = acc[co];
+            }
+        }
+    }
+}
+
+/*!
+ * \brief 2-D max, avg or sum pooling of blocked tensors, parallel over
+ *  output rows. Windows are clipped the same way as in pool().
+ * \param data input of shape (N, C / kBlock, H, W, kBlock)
+ * \param out output of shape (N, C / kBlock, pooled_h, pooled_w, kBlock)
+ */
+template <int kBlock, typename DType>
+inline void blocked_pool_forward(const DType* data, const TShape& ishape,
+                                 const TShape& oshape, const TShape& kernel,
+                                 const TShape& pad, const TShape& stride,
+                                 int pool_type, DType* out) {
+    using mshadow::red::limits::MinValue;
+    const int height = ishape[2], width = ishape[3];
+    const int pooled_height = oshape[2], pooled_width = oshape[3];
+    const int kernel_h = kernel[0], kernel_w = kernel[1];
+    const int pad_h = pad[0], pad_w = pad[1];
+    const int stride_h = stride[0], stride_w = stride[1];
+    const bool is_max = pool_type == pool_enum::kMaxPooling;
+    const bool get_avg = pool_type == pool_enum::kAvgPooling;
+    // avg and sum windows count the padding, max windows do not
+    const int hlimit = height + (is_max ? 0 : pad_h);
+    const int wlimit = width + (is_max ? 0 : pad_w);
+    const int nrows = oshape[0] * oshape[1] * pooled_height;
+#pragma omp parallel for
+    for (int i = 0; i < nrows; ++i) {
+        const int ph = i % pooled_height;
+        const DType* plane =
+            data + i / pooled_height * height * width * kBlock;
+        DType* dst = out + i * pooled_width * kBlock;
+        for (int pw = 0; pw < pooled_width; ++pw) {
+            int hstart = ph * stride_h - pad_h;
+            int wstart = pw * stride_w - pad_w;
+            int hend = std::min(hstart + kernel_h, hlimit);
+            int wend = std::min(wstart + kernel_w, wlimit);
+            const int pool_size = (hend - hstart) * (wend - wstart);
+            hstart = std::max(hstart, 0);
+            wstart = std::max(wstart, 0);
+            hend = std::min(hend, height);
+            wend = std::min(wend, width);
+            DType acc[kBlock];
+            for (int c = 0; c < kBlock; ++c) {
+                acc[c] = is_max ? MinValue<DType>() : DType(0);
+            }
+            for (int h = hstart; h < hend; ++h) {
+                for (int w = wstart; w < wend; ++w) {
+                    const DType* src = plane + (h * width + w) * kBlock;
+                    if (is_max) {
+                        for (int c = 0; c < kBlock; ++c) {
+                            acc[c] = src[c] > acc[c] ? src[c] : acc[c];
+                        }
+                    } else {
+                        for (int c = 0; c < kBlock; ++c) acc[c] += src[c];
+                    }
+                }
+            }
+            for (int c = 0; c < kBlock; ++c) {
+                dst[pw * kBlock + c] =
+                    get_avg ? acc[c] / DType(pool_size) : acc[c];
+            }
+        }
+    }
+}
+
+/*!
+ * \brief per channel mean and biased variance of a blocked tensor,
+ *  parallel over channel blocks
+ * \param data input of shape (N, C / kBlock, S, kBlock)
+ * \param mean output of the C means
+ * \param var output of the C variances
+ */
+template <int kBlock, typename DType>
+inline void blocked_channel_moments(const DType* data, int num, int blocks,
+                                    int spatial, DType* mean, DType* var) {
+    const int count = num * spatial;
+#pragma omp parallel for
+    for (int cb = 0; cb < blocks; ++cb) {
+        DType sum[kBlock], sqr[kBlock];
+        for (int c = 0; c < kBlock; ++c) sum[c] = sqr[c] = DType(0);
+        for (int n = 0; n < num; ++n) {
+            const DType* src = data + (n * blocks + cb) * spatial * kBlock;
+            for (int s = 0; s < spatial; ++s) {
+                for (int c = 0; c < kBlock; ++c) sum[c] += src[s * kBlock + c];
+            }
+        }
+        for (int c = 0; c < kBlock; ++c) sum[c] /= DType(count);
+        for (int n = 0; n < num; ++n) {
+            const DType* src = data + (n * blocks + cb) * spatial * kBlock;
+            for (int s = 0; s < spatial; ++s) {
+                for (int c = 0; c < kBlock; ++c) {
+                    const DType d = src[s * kBlock + c] - sum[c];
+                    sqr[c] += d * d;
+                }
+            }
+        }
+        for (int c = 0; c < kBlock; ++c) {
+            mean[cb * kBlock + c] = sum[c];
+            var[cb * kBlock + c] = sqr[c] / DType(count);
+        }
+    }
+}
+
+/*!
+ * \brief out = data * scale[c] + shift[c] for every channel c of a blocked
+ *  tensor, which is batch norm once the statistics are folded into scale
+ *  and shift
+ */
+template <int kBlock, typename DType>
+inline void blocked_scale_shift(const DType* data, int num, int blocks,
+                                int spatial, const DType* scale,
+                                const DType* shift, DType* out) {
+    const int nunit = num * blocks;
+#pragma omp parallel for
+    for (int i = 0; i < nunit; ++i) {
+        const DType* a = scale + i % blocks * kBlock;
+        const DType* b = shift + i % blocks * kBlock;
+        const DType* src = data + i * spatial * kBlock;
+        DType* dst = out + i * spatial * kBlock;
+        for (int s = 0; s < spatial; ++s) {
+            for (int c = 0; c < kBlock; ++c) {
+                dst[s * kBlock + c] = src[s * kBlock + c] * a[c] + b[c];
+            }
+        }
+    }
+}
+}  // namespace op
+}  // namespace mxnet
+#endif  // MXNET_OPERATOR_NN_BLOCKED_LAYOUT_H_
@@ -0,0 +1,171 @@
+/*!
+ * Copyright (c) 2017 by Contributors
+ * \file depthwise_conv.h
+ * \brief cpu direct convolution of 1D and 2D images where every channel is
+ *  filtered by its own kernel, i.e. num_group equals the number of input and
+ *  output channels. im2col + gemm degenerates to one tiny gemm per channel
+ *  in this case, so the kernels are applied directly instead.
+ */
+#ifndef MXNET_OPERATOR_NN_DEPTHWISE_CONV_H_
+#define MXNET_OPERATOR_NN_DEPTHWISE_CONV_H_
+
+#include <mxnet/base.h>
+#include <mxnet/operator.h>
+#include <algorithm>
+#include <vector>
+#include "./im2col.h"
+
+namespace mxnet {
+namespace op {
+/*!
+ * \brief forward of a depthwise convolution, parallel over images and
+ *  channels
+ * \param data_im input of shape (N, C, H, W) or (N, C, W)
+ * \param weight filters of shape (C, 1, kernel_h, kernel_w)
+ * \param num number of images N
+ * \param data_out output of shape (N, C, output_h, output_w)
+ */
+template <typename DType>
+inline void depthwise_conv_forward(const DType* data_im, const DType* weight,
+                                   const index_t num, const TShape& im_shape,
+                                   const TShape& kernel_shape,
+                                   const TShape& pad, const TShape& stride,
+                                   const TShape& dilation, DType* data_out) {
+    const std::vector<int> g =
+        conv_geometry_2d(im_shape, kernel_shape, pad, stride, dilation);
+    const int channels = g[0], height = g[1], width = g[2];
+    const int kernel_h = g[3], kernel_w = g[4], pad_h = g[5], pad_w = g[6];
+    const int stride_h = g[7], stride_w = g[8];
+    const int dilation_h = g[9], dilation_w = g[10];
+    const int output_h =
+        (height + 2 * pad_h - (dilation_h * (kernel_h - 1) + 1)) / stride_h + 1;
+    const int output_w =
+        (width + 2 * pad_w - (dilation_w * (kernel_w - 1) + 1)) / stride_w + 1;
+    const int nunit = static_cast<int>(num) * channels;
+#pragma omp parallel for
+    for (int i = 0; i < nunit; ++i) {
+        const DType* im = data_im + i * height * width;
+        const DType* w = weight + (i % channels) * kernel_h * kernel_w;
+        DType* out = data_out + i * output_h * output_w;
+        for (int oh = 0; oh < output_h; ++oh) {
+            for (int ow = 0; ow < output_w; ++ow) {
+                DType sum = 0;
+                for (int kh = 0; kh < kernel_h; ++kh) {
+                    const int h = oh * stride_h - pad_h + kh * dilation_h;
+                    if (!is_a_ge_zero_and_a_lt_b(h, height)) continue;
+                    for (int kw = 0; kw < kernel_w; ++kw) {
+                        const int x = ow * stride_w - pad_w + kw * dilation_w;
+                        if (is_a_ge_zero_and_a_lt_b(x, width)) {
+                            sum += im[h * width + x] * w[kh * kernel_w + kw];
+                        }
+                    }
+                }
+                out[oh * output_w + ow] = sum;
+            }
+        }
+    }
+}
+
+/*!
+ * \brief backward of a depthwise convolution. The data gradient is computed
+ *  in parallel over images and channels, the weight gradient in parallel
+ *  over channels so that no two threads accumulate into the same filter.
+ * \param out_grad gradient of the output, (N, C, output_h, output_w)
+ * \param data_im input of the forward pass
+ * \param weight filters of shape (C, 1, kernel_h, kernel_w)
+ * \param grad_im gradient of the input, written according to req_data
+ * \param grad_weight gradient of the filters, written according to
+ *  req_weight
+ */
+template <typename DType>
+inline void depthwise_conv_backward(const DType* out_grad,
+                                    const DType* data_im, const DType* weight,
+                                    const index_t num, const TShape& im_shape,
+                                    const TShape& kernel_shape,
+                                    const TShape& pad, const TShape& stride,
+                                    const TShape& dilation, DType* grad_im,
+                                    OpReqType req_data, DType* grad_weight,
+                                    OpReqType req_weight) {
+    const std::vector<int> g =
+        conv_geometry_2d(im_shape, kernel_shape, pad, stride, dilation);
+    const int channels = g[0], height = g[1], width = g[2];
+    const int kernel_h = g[3], kernel_w = g[4], pad_h = g[5], pad_w = g[6];
+    const int stride_h = g[7], stride_w = g[8];
+    const int dilation_h = g[9], dilation_w = g[10];
+    const int output_h =
+        (height + 2 * pad_h - (dilation_h * (kernel_h - 1) + 1)) / stride_h + 1;
+    const int output_w =
+        (width + 2 * pad_w - (dilation_w * (kernel_w - 1) + 1)) / stride_w + 1;
+    const int image_size = height * width;
+    const int output_size = output_h * output_w;
+    const int kernel_size = kernel_h * kernel_w;
+    if (kNullOp != req_data) {
+        const int nunit = static_cast<int>(num) * channels;
+#pragma omp parallel for
+        for (int i = 0; i < nunit; ++i) {
+            const DType* dy = out_grad + i * output_size;
+            const DType* w = weight + (i % channels) * kernel_size;
+            DType* dx = grad_im + i * image_size;
+            if (kAddTo != req_data) {
+                std::fill(dx, dx + image_size, static_cast<DType>(0));
+            }
+            for (int oh = 0; oh < output_h; ++oh) {
+                for (int ow = 0; ow < output_w; ++ow) {
+                    const DType grad = dy[oh * output_w + ow];
+                    for (int kh = 0; kh < kernel_h; ++kh) {
+                        const int h = oh * stride_h - pad_h + kh * dilation_h;
+                        if (!is_a_ge_zero_and_a_lt_b(h, height)) continue;
+                        for (int kw = 0; kw < kernel_w; ++kw) {
+                            const int x =
+                                ow * stride_w - pad_w + kw * dilation_w;
+                            if (is_a_ge_zero_and_a_lt_b(x, width)) {
+                                dx[h * width + x] +=
+                                    grad * w[kh * kernel_w + kw];
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+    if (kNullOp != req_weight) {
+#pragma omp parallel for
+        for (int c = 0; c < channels; ++c) {
+            std::vector<DType> dw(kernel_size, static_cast<DType>(0));
+            for (index_t n = 0; n < num; ++n) {
+                const DType* dy = out_grad + (n * channels + c) * output_size;
+                const DType* im = data_im + (n * channels + c) * image_size;
+                for (int kh = 0; kh < kernel_h; ++kh) {
+                    for (int kw = 0; kw < kernel_w; ++kw) {
+                        DType sum = 0;
+                        for (int oh = 0; oh < output_h; ++oh) {
+                            const int h =
+                                oh * stride_h - pad_h + kh * dilation_h;
+                            if (!is_a_ge_zero_and_a_lt_b(h, height)) continue;
+                            for (int ow = 0; ow < output_w; ++ow) {
+                                const int x =
+                                    ow * stride_w - pad_w + kw * dilation_w;
+                                if (is_a_ge_zero_and_a_lt_b(x, width)) {
+                                    sum += dy[oh * output_w + ow] *
+                                           im[h * width + x];
+                                }
+                            }
+                        }
+                        dw[kh * kernel_w + kw] += sum;
+                    }
+                }
+            }
+            DType* out = grad_weight + c * kernel_size;
+            for (int k = 0; k < kernel_size; ++k) {
+                if (kAddTo == req_weight) {
+                    out[k] += dw[k];
+                } else {
+                    out[k] = dw[k];
+                }
+            }
+        }
+    }
+}
+}  // namespace op
+}  // namespace mxnet
+#endif  // MXNET_OPERATOR_NN_DEPTHWISE_CONV_H_
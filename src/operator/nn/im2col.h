@@ -69,6 +69,7 @@
 
 #include <mxnet/base.h>
 #include <mxnet/operator.h>
+#include <algorithm>
 #include <cstring>
 #include <vector>
 #include "../mxnet_op.h"
@@ -259,7 +260,7 @@ inline void im2col(mshadow::Stream<cpu>* s, const DType* data_im,
     if (2 == kernel_shape.ndim()) {
         im2col_cpu(data_im, im_shape[1], im_shape[2], im_shape[3],
                    kernel_shape[0], kernel_shape[1], pad[0], pad[1], stride[0],
-                   stride[1], dilation[1], dilation[1], data_col);
+                   stride[1], dilation[0], dilation[1], data_col);
     } else {
         im2col_nd_core_cpu(data_im, true, im_shape, col_shape, kernel_shape,
                            pad, stride, dilation, data_col);
@@ -351,6 +352,172 @@ inline void col2im(mshadow::Stream<cpu>* s, const DType* data_col,
     }
 }
 
+/*!
+ * \brief expand the 1D or 2D geometry of a convolution to 2D, a 1D image is
+ *  treated as an image of height 1.
+ * \return {channels, height, width, kernel_h, kernel_w, pad_h, pad_w,
+ *  stride_h, stride_w, dilation_h, dilation_w}
+ */
+inline std::vector<int> conv_geometry_2d(const TShape& im_shape,
+                                         const TShape& kernel_shape,
+                                         const TShape& pad,
+                                         const TShape& stride,
+                                         const TShape& dilation) {
+    CHECK_LE(kernel_shape.ndim(), 2U)
+        << "only 1D and 2D images can be expanded to 2D";
+    if (kernel_shape.ndim() == 1) {
+        return {static_cast<int>(im_shape[1]), 1,
+                static_cast<int>(im_shape[2]), 1,
+                static_cast<int>(kernel_shape[0]), 0,
+                static_cast<int>(pad[0]), 1,
+                static_cast<int>(stride[0]), 1,
+                static_cast<int>(dilation[0])};
+    }
+    return {static_cast<int>(im_shape[1]),  static_cast<int>(im_shape[2]),
+            static_cast<int>(im_shape[3]),  static_cast<int>(kernel_shape[0]),
+            static_cast<int>(kernel_shape[1]), static_cast<int>(pad[0]),
+            static_cast<int>(pad[1]),       static_cast<int>(stride[0]),
+            static_cast<int>(stride[1]),    static_cast<int>(dilation[0]),
+            static_cast<int>(dilation[1])};
+}
+
+/*!
+ * \brief cpu im2col of a batch of 1D or 2D images into one column buffer of
+ *  shape (C * kernel size, num * output size), so that a single gemm covers
+ *  the batch. Images and channels are unrolled in parallel.
+ * \param data_im pointer to the first image of the batch
+ * \param num number of images
+ * \param im_shape input image shape in dimensions (N, C, H, W) or (N, C, W)
+ * \param kernel_shape kernel filter shape
+ * \param pad pad shape
+ * \param stride stride shape
+ * \param dilation dilation shape
+ * \param data_col start pointer of the column buffer to be filled
+ */
+template <typename DType>
+inline void im2col_batch(mshadow::Stream<cpu>* s, const DType* data_im,
+                         const index_t num, const TShape& im_shape,
+                         const TShape& kernel_shape, const TShape& pad,
+                         const TShape& stride, const TShape& dilation,
+                         DType* data_col) {
+    const std::vector<int> g =
+        conv_geometry_2d(im_shape, kernel_shape, pad, stride, dilation);
+    const int channels = g[0], height = g[1], width = g[2];
+    const int kernel_h = g[3], kernel_w = g[4], pad_h = g[5], pad_w = g[6];
+    const int stride_h = g[7], stride_w = g[8];
+    const int dilation_h = g[9], dilation_w = g[10];
+    const int output_h =
+        (height + 2 * pad_h - (dilation_h * (kernel_h - 1) + 1)) / stride_h + 1;
+    const int output_w =
+        (width + 2 * pad_w - (dilation_w * (kernel_w - 1) + 1)) / stride_w + 1;
+    const index_t channel_size = height * width;
+    const index_t col_size = output_h * output_w;
+    // length of a row of the column buffer
+    const index_t ld = num * col_size;
+    const int nunit = static_cast<int>(num) * channels;
+#pragma omp parallel for
+    for (int i = 0; i < nunit; ++i) {
+        const index_t n = i / channels, channel = i % channels;
+        const DType* im = data_im + i * channel_size;
+        DType* col =
+            data_col + channel * kernel_h * kernel_w * ld + n * col_size;
+        for (int kernel_row = 0; kernel_row < kernel_h; kernel_row++) {
+            for (int kernel_col = 0; kernel_col < kernel_w; kernel_col++) {
+                DType* out = col;
+                col += ld;
+                int input_row = -pad_h + kernel_row * dilation_h;
+                for (int output_rows = output_h; output_rows; output_rows--) {
+                    if (!is_a_ge_zero_and_a_lt_b(input_row, height)) {
+                        std::fill(out, out + output_w, static_cast<DType>(0));
+                        out += output_w;
+                    } else {
+                        int input_col = -pad_w + kernel_col * dilation_w;
+                        for (int output_col = output_w; output_col;
+                             output_col--) {
+                            if (is_a_ge_zero_and_a_lt_b(input_col, width)) {
+                                *(out++) = im[input_row * width + input_col];
+                            } else {
+                                *(out++) = 0;
+                            }
+                            input_col += stride_w;
+                        }
+                    }
+                    input_row += stride_h;
+                }
+            }
+        }
+    }
+}
+
+/*!
+ * \brief cpu col2im of a column buffer filled by im2col_batch, back into a
+ *  batch of 1D or 2D images. Images and channels are packed in parallel.
+ * \param data_col start pointer of the column buffer
+ * \param num number of images
+ * \param im_shape input image shape in dimensions (N, C, H, W) or (N, C, W)
+ * \param kernel_shape kernel filter shape
+ * \param pad pad shape
+ * \param stride stride shape
+ * \param dilation dilation shape
+ * \param data_im pointer to the first image of the batch
+ */
+template <typename DType>
+inline void col2im_batch(mshadow::Stream<cpu>* s, const DType* data_col,
+                         const index_t num, const TShape& im_shape,
+                         const TShape& kernel_shape, const TShape& pad,
+                         const TShape& stride, const TShape& dilation,
+                         DType* data_im, OpReqType req) {
+    if (mxnet::kNullOp == req) return;
+    const std::vector<int> g =
+        conv_geometry_2d(im_shape, kernel_shape, pad, stride, dilation);
+    const int channels = g[0], height = g[1], width = g[2];
+    const int kernel_h = g[3], kernel_w = g[4], pad_h = g[5], pad_w = g[6];
+    const int stride_h = g[7], stride_w = g[8];
+    const int dilation_h = g[9], dilation_w = g[10];
+    const int output_h =
+        (height + 2 * pad_h - (dilation_h * (kernel_h - 1) + 1)) / stride_h + 1;
+    const int output_w =
+        (width + 2 * pad_w - (dilation_w * (kernel_w - 1) + 1)) / stride_w + 1;
+    const index_t channel_size = height * width;
+    const index_t col_size = output_h * output_w;
+    const index_t ld = num * col_size;
+    const int nunit = static_cast<int>(num) * channels;
+    // each unit only writes its own channel of its own image
+#pragma omp parallel for
+    for (int i = 0; i < nunit; ++i) {
+        const index_t n = i / channels, channel = i % channels;
+        DType* im = data_im + i * channel_size;
+        const DType* col =
+            data_col + channel * kernel_h * kernel_w * ld + n * col_size;
+        if (mxnet::kAddTo != req) {
+            std::fill(im, im + channel_size, static_cast<DType>(0));
+        }
+        for (int kernel_row = 0; kernel_row < kernel_h; kernel_row++) {
+            for (int kernel_col = 0; kernel_col < kernel_w; kernel_col++) {
+                const DType* in = col;
+                col += ld;
+                int input_row = -pad_h + kernel_row * dilation_h;
+                for (int output_rows = output_h; output_rows; output_rows--) {
+                    if (!is_a_ge_zero_and_a_lt_b(input_row, height)) {
+                        in += output_w;
+                    } else {
+                        int input_col = -pad_w + kernel_col * dilation_w;
+                        for (int output_col = output_w; output_col;
+                             output_col--) {
+                            if (is_a_ge_zero_and_a_lt_b(input_col, width)) {
+                                im[input_row * width + input_col] += *in;
+                            }
+                            in++;
+                            input_col += stride_w;
+                        }
+                    }
+                    input_row += stride_h;
+                }
+            }
+        }
+    }
+}
+
 }  // namespace op
 }  // namespace mxnet
 #ifdef __CUDACC__
@@ -0,0 +1,165 @@
+/*!
+ * Copyright (c) 2017 by Contributors
+ * \file online_softmax.h
+ * \brief softmax over the rows of a matrix on cpu. The maximum of a row and
+ *  the sum of exponentials are computed together one block at a time, so
+ *  the row is read from memory once for both, and long rows are spread over
+ *  the threads when there are fewer rows than threads.
+ */
+#ifndef MXNET_OPERATOR_NN_ONLINE_SOFTMAX_H_
+#define MXNET_OPERATOR_NN_ONLINE_SOFTMAX_H_
+
+#include <dmlc/omp.h>
+#include <mxnet/base.h>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "../simd_math.h"
+
+namespace mxnet {
+namespace op {
+/*! \brief number of elements of a row whose statistics are taken at once */
+const index_t kSoftmaxBlock = 2048;
+/*! \brief rows shorter than this are not worth the vectorized calls */
+const index_t kSoftmaxSimdMin = 16;
+
+/*! \brief the maximum of part of a row and the sum of exp(x - max) over it */
+template <typename DType>
+struct SoftmaxStat {
+    DType max;
+    DType sum;
+    /*! \brief add the statistics of another part of the row */
+    inline void Merge(const SoftmaxStat& other) {
+        if (other.max > max) {
+            sum = DType(sum * DType(std::exp(max - other.max)) + other.sum);
+            max = other.max;
+        } else {
+            sum = DType(sum + other.sum * DType(std::exp(other.max - max)));
+        }
+    }
+    /*! \brief log of the sum of exp(x) */
+    inline DType LogSumExp() const { return DType(max + std::log(sum)); }
+};
+
+/*! \brief the statistics of size consecutive elements */
+template <typename DType>
+inline SoftmaxStat<DType> SoftmaxBlockStat(const DType* in, index_t size) {
+    SoftmaxStat<DType> ret;
+    ret.max = in[0];
+    for (index_t j = 1; j < size; ++j) {
+        ret.max = in[j] > ret.max ? in[j] : ret.max;
+    }
+    ret.sum = DType(0);
+    for (index_t j = 0; j < size; ++j) {
+        ret.sum = DType(ret.sum + DType(std::exp(in[j] - ret.max)));
+    }
+    return ret;
+}
+
+inline SoftmaxStat<float> SoftmaxBlockStat(const float* in, index_t size) {
+    if (!simd::Enabled() || size < kSoftmaxSimdMin) {
+        return SoftmaxBlockStat<float>(in, size);
+    }
+    SoftmaxStat<float> ret;
+    ret.max = simd::Max(in, size);
+    ret.sum = simd::ExpSum(in, ret.max, size);
+    return ret;
+}
+
+/*! \brief out[j] = exp(in[j] - shift) * scale */
+template <typename DType>
+inline void SoftmaxExpScale(const DType* in, DType shift, DType scale,
+                            DType* out, index_t size) {
+    for (index_t j = 0; j < size; ++j) {
+        out[j] = DType(DType(std::exp(in[j] - shift)) * scale);
+    }
+}
+
+inline void SoftmaxExpScale(const float* in, float shift, float scale,
+                            float* out, index_t size) {
+    if (!simd::Enabled() || size < kSoftmaxSimdMin) {
+        SoftmaxExpScale<float>(in, shift, scale, out, size);
+    } else {
+        simd::ExpScale(in, shift, scale, out, size);
+    }
+}
+
+/*!
+ * \brief the statistics of a row, merged block by block in order, so that
+ *  they do not depend on whether the blocks were computed by one thread
+ */
+template <typename DType>
+inline SoftmaxStat<DType> SoftmaxRowStat(const DType* in, index_t m) {
+    SoftmaxStat<DType> ret = SoftmaxBlockStat(in, std::min(kSoftmaxBlock, m));
+    for (index_t begin = kSoftmaxBlock; begin < m; begin += kSoftmaxBlock) {
+        ret.Merge(SoftmaxBlockStat(in + begin,
+                                   std::min(kSoftmaxBlock, m - begin)));
+    }
+    return ret;
+}
+
+/*! \brief whether to spread the blocks of every row over the threads */
+inline bool SoftmaxSplitRows(index_t n, index_t m) {
+    return m > kSoftmaxBlock &&
+           n < static_cast<index_t>(omp_get_max_threads());
+}
+
+/*!
+ * \brief the statistics of each of the n rows of length m of in
+ * \param stats the n statistics
+ */
+template <typename DType>
+inline void SoftmaxRowStats(const DType* in, index_t n, index_t m,
+                            SoftmaxStat<DType>* stats) {
+    if (!SoftmaxSplitRows(n, m)) {
+#pragma omp parallel for
+        for (index_t i = 0; i < n; ++i) {
+            stats[i] = SoftmaxRowStat(in + i * m, m);
+        }
+        return;
+    }
+    const index_t nblock = (m + kSoftmaxBlock - 1) / kSoftmaxBlock;
+    std::vector<SoftmaxStat<DType> > part(n * nblock);
+#pragma omp parallel for
+    for (index_t b = 0; b < n * nblock; ++b) {
+        const index_t begin = (b % nblock) * kSoftmaxBlock;
+        part[b] = SoftmaxBlockStat(in + (b / nblock) * m + begin,
+                                   std::min(kSoftmaxBlock, m - begin));
+    }
+    for (index_t i = 0; i < n; ++i) {
+        stats[i] = part[i * nblock];
+        for (index_t b = 1; b < nblock; ++b) {
+            stats[i].Merge(part[i * nblock + b]);
+        }
+    }
+}
+
+/*!
+ * \brief Compute the statistics of the n rows of length m of in, and call
+ *  write(i, begin, size, stat) to produce the outputs of the elements
+ *  [begin, begin + size) of row i, which has statistics stat. When the rows
+ *  are not split, write is called once per row right after its statistics,
+ *  while the row is still in cache.
+ */
+template <typename DType, typename Write>
+inline void SoftmaxRows(const DType* in, index_t n, index_t m,
+                        const Write& write) {
+    if (!SoftmaxSplitRows(n, m)) {
+#pragma omp parallel for
+        for (index_t i = 0; i < n; ++i) {
+            write(i, 0, m, SoftmaxRowStat(in + i * m, m));
+        }
+        return;
+    }
+    std::vector<SoftmaxStat<DType> > stats(n);
+    SoftmaxRowStats(in, n, m, stats.data());
+    const index_t nblock = (m + kSoftmaxBlock - 1) / kSoftmaxBlock;
+#pragma omp parallel for
+    for (index_t b = 0; b < n * nblock; ++b) {
+        const index_t i = b / nblock, begin = (b % nblock) * kSoftmaxBlock;
+        write(i, begin, std::min(kSoftmaxBlock, m - begin), stats[i]);
+    }
+}
+}  // namespace op
+}  // namespace mxnet
+#endif  // MXNET_OPERATOR_NN_ONLINE_SOFTMAX_H_
@@ -70,6 +70,8 @@
 #include <mxnet/base.h>
 #include <mxnet/operator.h>
 #include <algorithm>
+#include <limits>
+#include <type_traits>
 #include "../mxnet_op.h"
 
 namespace mxnet {
@@ -77,7 +79,7 @@ namespace op {
 
 namespace pool_enum {
 enum PoolingOpInputs { kData };
-enum PoolingOpOutputs { kOut, kMask };
+enum PoolingOpOutputs { kOut };
 enum PoolingOpType { kMaxPooling, kAvgPooling, kSumPooling };
 enum PoolingOpPadConventionType { kValid, kFull };
 }  // namespace pool_enum
@@ -90,7 +92,7 @@ template <typename DType>
 inline void pool_max_1d_cpu(const DType* in_data, const TShape& ishape,
                             const TShape& oshape, const TShape& kernel,
                             const TShape& pad, const TShape& stride,
-                            DType* out_data) {
+                            DType* out_data, int32_t* mask_data) {
     using mshadow::red::limits::MinValue;
     const int width = ishape[2];
     const int pooled_width = oshape[2];
@@ -99,22 +101,79 @@ inline void pool_max_1d_cpu(const DType* in_data, const TShape& ishape,
     const int stride_w = stride[0];
     const index_t in_data_offset = ishape[2];
     const index_t out_data_offset = oshape[2];
-    for (index_t n = 0; n < oshape[0]; ++n) {
-        for (index_t c = 0; c < oshape[1]; ++c) {
-            for (int pw = 0; pw < pooled_width; ++pw) {
-                int wstart = pw * stride_w - pad_w;
-                int wend = std::min(wstart + kernel_w, width);
-                wstart = std::max(wstart, 0);
-                DType max_val = MinValue<DType>();
-                for (int w = wstart; w < wend; ++w) {
-                    if (in_data[w] > max_val) {
-                        max_val = in_data[w];
+    const int nplanes = oshape[0] * oshape[1];
+#pragma omp parallel for
+    for (int i = 0; i < nplanes; ++i) {
+        const DType* in = in_data + i * in_data_offset;
+        DType* out = out_data + i * out_data_offset;
+        int32_t* mask = mask_data ? mask_data + i * out_data_offset : NULL;
+        for (int pw = 0; pw < pooled_width; ++pw) {
+            int wstart = pw * stride_w - pad_w;
+            int wend = std::min(wstart + kernel_w, width);
+            wstart = std::max(wstart, 0);
+            DType max_val = MinValue<DType>();
+            int max_idx = -1;
+            for (int w = wstart; w < wend; ++w) {
+                if (in[w] > max_val) {
+                    max_val = in[w];
+                    max_idx = w;
+                }
+            }
+            out[pw] = max_val;
+            if (mask) mask[pw] = max_idx;
+        }
+    }
+}
+
+/*!
+ * \brief max pooling of one 2-D plane. Nonzero kKernelH and kKernelW fix
+ * the kernel size at compile time, so that windows lying inside the image
+ * are unrolled by the compiler.
+ */
+template <int kKernelH, int kKernelW, typename DType>
+inline void pool_max_2d_plane(const DType* in_data, int height, int width,
+                              int pooled_height, int pooled_width,
+                              int kernel_h, int kernel_w, int pad_h, int pad_w,
+                              int stride_h, int stride_w, DType* out_data,
+                              int32_t* mask) {
+    using mshadow::red::limits::MinValue;
+    if (kKernelH > 0) kernel_h = kKernelH;
+    if (kKernelW > 0) kernel_w = kKernelW;
+    for (int ph = 0; ph < pooled_height; ++ph) {
+        for (int pw = 0; pw < pooled_width; ++pw) {
+            int hstart = ph * stride_h - pad_h;
+            int wstart = pw * stride_w - pad_w;
+            int hend = std::min(hstart + kernel_h, height);
+            int wend = std::min(wstart + kernel_w, width);
+            hstart = std::max(hstart, 0);
+            wstart = std::max(wstart, 0);
+            const int pool_index = ph * pooled_width + pw;
+            DType max_val = MinValue<DType>();
+            int max_idx = -1;
+            if (hend - hstart == kernel_h && wend - wstart == kernel_w) {
+                const int start = hstart * width + wstart;
+                for (int h = 0; h < kernel_h; ++h) {
+                    for (int w = 0; w < kernel_w; ++w) {
+                        const int in_index = start + h * width + w;
+                        if (in_data[in_index] > max_val) {
+                            max_val = in_data[in_index];
+                            max_idx = in_index;
+                        }
+                    }
+                }
+            } else {
+                for (int h = hstart; h < hend; ++h) {
+                    for (int w = wstart; w < wend; ++w) {
+                        const int in_index = h * width + w;
+                        if (in_data[in_index] > max_val) {
+                            max_val = in_data[in_index];
+                            max_idx = in_index;
+                        }
                     }
                 }
-                out_data[pw] = max_val;
             }
-            in_data += in_data_offset;
-            out_data += out_data_offset;
+            out_data[pool_index] = max_val;
+            if (mask) mask[pool_index] = max_idx;
         }
     }
 }
@@ -127,8 +186,7 @@ template <typename DType>
 inline void pool_max_2d_cpu(const DType* in_data, const TShape& ishape,
                             const TShape& oshape, const TShape& kernel,
                             const TShape& pad, const TShape& stride,
-                            DType* out_data) {
-    using mshadow::red::limits::MinValue;
+                            DType* out_data, int32_t* mask_data) {
     const int height = ishape[2], width = ishape[3];
     const int pooled_height = oshape[2], pooled_width = oshape[3];
     const int kernel_h = kernel[0], kernel_w = kernel[1];
@@ -136,31 +194,24 @@ inline void pool_max_2d_cpu(const DType* in_data, const TShape& ishape,
     const int stride_h = stride[0], stride_w = stride[1];
     const index_t in_data_offset = ishape[2] * ishape[3];
     const index_t out_data_offset = oshape[2] * oshape[3];
-    for (index_t n = 0; n < oshape[0]; ++n) {
-        for (index_t c = 0; c < oshape[1]; ++c) {
-            for (int ph = 0; ph < pooled_height; ++ph) {
-                for (int pw = 0; pw < pooled_width; ++pw) {
-                    int hstart = ph * stride_h - pad_h;
-                    int wstart = pw * stride_w - pad_w;
-                    int hend = std::min(hstart + kernel_h, height);
-                    int wend = std::min(wstart + kernel_w, width);
-                    hstart = std::max(hstart, 0);
-                    wstart = std::max(wstart, 0);
-                    const int pool_index = ph * pooled_width + pw;
-                    DType max_val = MinValue<DType>();
-                    for (int h = hstart; h < hend; ++h) {
-                        for (int w = wstart; w < wend; ++w) {
-                            const int in_index = h * width + w;
-                            if (in_data[in_index] > max_val) {
-                                max_val = in_data[in_index];
-                            }
-                        }
-                    }
-                    out_data[pool_index] = max_val;
-                }
-            }
-            in_data += in_data_offset;
-            out_data += out_data_offset;
+    const int nplanes = oshape[0] * oshape[1];
+#pragma omp parallel for
+    for (int i = 0; i < nplanes; ++i) {
+        const DType* in = in_data + i * in_data_offset;
+        DType* out = out_data + i * out_data_offset;
+        int32_t* mask = mask_data ? mask_data + i * out_data_offset : NULL;
+        if (kernel_h == 2 && kernel_w == 2) {
+            pool_max_2d_plane<2, 2>(in, height, width, pooled_height,
+                                    pooled_width, kernel_h, kernel_w, pad_h,
+                                    pad_w, stride_h, stride_w, out, mask);
+        } else if (kernel_h == 3 && kernel_w == 3) {
+            pool_max_2d_plane<3, 3>(in, height, width, pooled_height,
+                                    pooled_width, kernel_h, kernel_w, pad_h,
+                                    pad_w, stride_h, stride_w, out, mask);
+        } else {
+            pool_max_2d_plane<0, 0>(in, height, width, pooled_height,
+                                    pooled_width, kernel_h, kernel_w, pad_h,
+                                    pad_w, stride_h, stride_w, out, mask);
         }
     }
 }
@@ -173,7 +224,7 @@ template <typename DType>
 inline void pool_max_3d_cpu(const DType* in_data, const TShape& ishape,
                             const TShape& oshape, const TShape& kernel,
                             const TShape& pad, const TShape& stride,
-                            DType* out_data) {
+                            DType* out_data, int32_t* mask_data) {
     using mshadow::red::limits::MinValue;
     const int depth = ishape[2], height = ishape[3], width = ishape[4];
     const int pooled_depth = oshape[2], pooled_height = oshape[3],
@@ -183,40 +234,44 @@ inline void pool_max_3d_cpu(const DType* in_data, const TShape& ishape,
     const int stride_d = stride[0], stride_h = stride[1], stride_w = stride[2];
     const index_t in_data_offset = ishape[2] * ishape[3] * ishape[4];
     const index_t out_data_offset = oshape[2] * oshape[3] * oshape[4];
-    for (index_t n = 0; n < oshape[0]; ++n) {
-        for (index_t c = 0; c < oshape[1]; ++c) {
-            for (int pd = 0; pd < pooled_depth; ++pd) {
-                for (int ph = 0; ph < pooled_height; ++ph) {
-                    for (int pw = 0; pw < pooled_width; ++pw) {
-                        int dstart = pd * stride_d - pad_d;
-                        int hstart = ph * stride_h - pad_h;
-                        int wstart = pw * stride_w - pad_w;
-                        int dend = std::min(dstart + kernel_d, depth);
-                        int hend = std::min(hstart + kernel_h, height);
-                        int wend = std::min(wstart + kernel_w, width);
-                        dstart = std::max(dstart, 0);
-                        hstart = std::max(hstart, 0);
-                        wstart = std::max(wstart, 0);
-                        const int pool_index =
-                            (pd * pooled_height + ph) * pooled_width + pw;
-                        DType max_val = MinValue<DType>();
-                        for (int d = dstart; d < dend; ++d) {
-                            for (int h = hstart; h < hend; ++h) {
-                                for (int w = wstart; w < wend; ++w) {
-                                    const int in_index =
-                                        (d * height + h) * width + w;
-                                    if (in_data[in_index] > max_val) {
-                                        max_val = in_data[in_index];
-                                    }
+    const int nplanes = oshape[0] * oshape[1];
+#pragma omp parallel for
+    for (int i = 0; i < nplanes; ++i) {
+        const DType* in = in_data + i * in_data_offset;
+        DType* out = out_data + i * out_data_offset;
+        int32_t* mask = mask_data ? mask_data + i * out_data_offset : NULL;
+        for (int pd = 0; pd < pooled_depth; ++pd) {
+            for (int ph = 0; ph < pooled_height; ++ph) {
+                for (int pw = 0; pw < pooled_width; ++pw) {
+                    int dstart = pd * stride_d - pad_d;
+                    int hstart = ph * stride_h - pad_h;
+                    int wstart = pw * stride_w - pad_w;
+                    int dend = std::min(dstart + kernel_d, depth);
+                    int hend = std::min(hstart + kernel_h, height);
+                    int wend = std::min(wstart + kernel_w, width);
+                    dstart = std::max(dstart, 0);
+                    hstart = std::max(hstart, 0);
+                    wstart = std::max(wstart, 0);
+                    const int pool_index =
+                        (pd * pooled_height + ph) * pooled_width + pw;
+                    DType max_val = MinValue<DType>();
+                    int max_idx = -1;
+                    for (int d = dstart; d < dend; ++d) {
+                        for (int h = hstart; h < hend; ++h) {
+                            for (int w = wstart; w < wend; ++w) {
+                                const int in_index =
+                                    (d * height + h) * width + w;
+                                if (in[in_index] > max_val) {
+                                    max_val = in[in_index];
+                                    max_idx = in_index;
                                 }
                             }
                         }
-                        out_data[pool_index] = max_val;
                     }
+                    out[pool_index] = max_val;
+                    if (mask) mask[pool_index] = max_idx;
                 }
             }
-            in_data += in_data_offset;
-            out_data += out_data_offset;
         }
     }
 }
@@ -237,22 +292,66 @@ inline void pool_sum_1d_cpu(const DType* in_data, const TShape& ishape,
     const int stride_w = stride[0];
     const index_t in_data_offset = ishape[2];
     const index_t out_data_offset = oshape[2];
-    for (index_t n = 0; n < oshape[0]; ++n) {
-        for (index_t c = 0; c < oshape[1]; ++c) {
-            for (int pw = 0; pw < pooled_width; ++pw) {
-                int wstart = pw * stride_w - pad_w;
-                int wend = std::min(wstart + kernel_w, width + pad_w);
-                int pool_size = (wend - wstart);
-                wstart = std::max(wstart, 0);
-                wend = std::min(wend, width);
-                DType sum = 0;
-                for (int w = wstart; w < wend; ++w) {
-                    sum += in_data[w];
+    const int nplanes = oshape[0] * oshape[1];
+#pragma omp parallel for
+    for (int i = 0; i < nplanes; ++i) {
+        const DType* in = in_data + i * in_data_offset;
+        DType* out = out_data + i * out_data_offset;
+        for (int pw = 0; pw < pooled_width; ++pw) {
+            int wstart = pw * stride_w - pad_w;
+            int wend = std::min(wstart + kernel_w, width + pad_w);
+            int pool_size = (wend - wstart);
+            wstart = std::max(wstart, 0);
+            wend = std::min(wend, width);
+            DType sum = 0;
+            for (int w = wstart; w < wend; ++w) {
+                sum += in[w];
+            }
+            out[pw] = (getAvg ? sum / pool_size : sum);
+        }
+    }
+}
+
+/*!
+ * \brief avg/sum pooling of one 2-D plane, see pool_max_2d_plane() for
+ * kKernelH and kKernelW.
+ */
+template <int kKernelH, int kKernelW, typename DType>
+inline void pool_sum_2d_plane(const DType* in_data, int height, int width,
+                              int pooled_height, int pooled_width,
+                              int kernel_h, int kernel_w, int pad_h, int pad_w,
+                              int stride_h, int stride_w, DType* out_data,
+                              bool getAvg) {
+    if (kKernelH > 0) kernel_h = kKernelH;
+    if (kKernelW > 0) kernel_w = kKernelW;
+    for (int ph = 0; ph < pooled_height; ++ph) {
+        for (int pw = 0; pw < pooled_width; ++pw) {
+            int hstart = ph * stride_h - pad_h;
+            int wstart = pw * stride_w - pad_w;
+            int hend = std::min(hstart + kernel_h, height + pad_h);
+            int wend = std::min(wstart + kernel_w, width + pad_w);
+            int pool_size = (hend - hstart) * (wend - wstart);
+            hstart = std::max(hstart, 0);
+            wstart = std::max(wstart, 0);
+            hend = std::min(hend, height);
+            wend = std::min(wend, width);
+            DType sum = 0;
+            if (hend - hstart == kernel_h && wend - wstart == kernel_w) {
+                const DType* window = in_data + hstart * width + wstart;
+                for (int h = 0; h < kernel_h; ++h) {
+                    for (int w = 0; w < kernel_w; ++w) {
+                        sum += window[h * width + w];
+                    }
+                }
+            } else {
+                for (int h = hstart; h < hend; ++h) {
+                    for (int w = wstart; w < wend; ++w) {
+                        sum += in_data[h * width + w];
+                    }
                 }
-                out_data[pw] = (getAvg ? sum / pool_size : sum);
             }
-            in_data += in_data_offset;
-            out_data += out_data_offset;
+            out_data[ph * pooled_width + pw] =
+                (getAvg ? sum / pool_size : sum);
         }
     }
 }
@@ -273,31 +372,23 @@ inline void pool_sum_2d_cpu(const DType* in_data, const TShape& ishape,
     const int stride_h = stride[0], stride_w = stride[1];
     const index_t in_data_offset = ishape[2] * ishape[3];
     const index_t out_data_offset = oshape[2] * oshape[3];
-    for (index_t n = 0; n < oshape[0]; ++n) {
-        for (index_t c = 0; c < oshape[1]; ++c) {
-            for (int ph = 0; ph < pooled_height; ++ph) {
-                for (int pw = 0; pw < pooled_width; ++pw) {
-                    int hstart = ph * stride_h - pad_h;
-                    int wstart = pw * stride_w - pad_w;
-                    int hend = std::min(hstart + kernel_h, height + pad_h);
-                    int wend = std::min(wstart + kernel_w, width + pad_w);
-                    int pool_size = (hend - hstart) * (wend - wstart);
-                    hstart = std::max(hstart, 0);
-                    wstart = std::max(wstart, 0);
-                    hend = std::min(hend, height);
-                    wend = std::min(wend, width);
-                    DType sum = 0;
-                    for (int h = hstart; h < hend; ++h) {
-                        for (int w = wstart; w < wend; ++w) {
-                            sum += in_data[h * width + w];
-                        }
-                    }
-                    out_data[ph * pooled_width + pw] =
-                        (getAvg ? sum / pool_size : sum);
-                }
-            }
-            in_data += in_data_offset;
-            out_data += out_data_offset;
+    const int nplanes = oshape[0] * oshape[1];
+#pragma omp parallel for
+    for (int i = 0; i < nplanes; ++i) {
+        const DType* in = in_data + i * in_data_offset;
+        DType* out = out_data + i * out_data_offset;
+        if (kernel_h == 2 && kernel_w == 2) {
+            pool_sum_2d_plane<2, 2>(in, height, width, pooled_height,
+                                    pooled_width, kernel_h, kernel_w, pad_h,
+                                    pad_w, stride_h, stride_w, out, getAvg);
+        } else if (kernel_h == 3 && kernel_w == 3) {
+            pool_sum_2d_plane<3, 3>(in, height, width, pooled_height,
+                                    pooled_width, kernel_h, kernel_w, pad_h,
+                                    pad_w, stride_h, stride_w, out, getAvg);
+        } else {
+            pool_sum_2d_plane<0, 0>(in, height, width, pooled_height,
+                                    pooled_width, kernel_h, kernel_w, pad_h,
+                                    pad_w, stride_h, stride_w, out, getAvg);
         }
     }
 }
@@ -319,41 +410,68 @@ inline void pool_sum_3d_cpu(const DType* in_data, const TShape& ishape,
     const int stride_d = stride[0], stride_h = stride[1], stride_w = stride[2];
     const index_t in_data_offset = ishape[2] * ishape[3] * ishape[4];
     const index_t out_data_offset = oshape[2] * oshape[3] * oshape[4];
-    for (index_t n = 0; n < oshape[0]; ++n) {
-        for (index_t c = 0; c < oshape[1]; ++c) {
-            for (int pd = 0; pd < pooled_depth; ++pd) {
-                for (int ph = 0; ph < pooled_height; ++ph) {
-                    for (int pw = 0; pw < pooled_width; ++pw) {
-                        int dstart = pd * stride_d - pad_d;
-                        int hstart = ph * stride_h - pad_h;
-                        int wstart = pw * stride_w - pad_w;
-                        int dend = std::min(dstart + kernel_d, depth + pad_d);
-                        int hend = std::min(hstart + kernel_h, height + pad_h);
-                        int wend = std::min(wstart + kernel_w, width + pad_w);
-                        int pool_size =
-                            (dend - dstart) * (hend - hstart) * (wend - wstart);
-                        dstart = std::max(dstart, 0);
-                        hstart = std::max(hstart, 0);
-                        wstart = std::max(wstart, 0);
-                        dend = std::min(dend, depth);
-                        hend = std::min(hend, height);
-                        wend = std::min(wend, width);
-                        DType sum = 0;
-                        for (int d = dstart; d < dend; ++d) {
-                            for (int h = hstart; h < hend; ++h) {
-                                for (int w = wstart; w < wend; ++w) {
-                                    sum +=
-                                        in_data[(d * height + h) * width + w];
-                                }
+    const int nplanes = oshape[0] * oshape[1];
+#pragma omp parallel for
+    for (int i = 0; i < nplanes; ++i) {
+        const DType* in = in_data + i * in_data_offset;
+        DType* out = out_data + i * out_data_offset;
+        for (int pd = 0; pd < pooled_depth; ++pd) {
+            for (int ph = 0; ph < pooled_height; ++ph) {
+                for (int pw = 0; pw < pooled_width; ++pw) {
+                    int dstart = pd * stride_d - pad_d;
+                    int hstart = ph * stride_h - pad_h;
+                    int wstart = pw * stride_w - pad_w;
+                    int dend = std::min(dstart + kernel_d, depth + pad_d);
+                    int hend = std::min(hstart + kernel_h, height + pad_h);
+                    int wend = std::min(wstart + kernel_w, width + pad_w);
+                    int pool_size =
+                        (dend - dstart) * (hend - hstart) * (wend - wstart);
+                    dstart = std::max(dstart, 0);
+                    hstart = std::max(hstart, 0);
+                    wstart = std::max(wstart, 0);
+                    dend = std::min(dend, depth);
+                    hend = std::min(hend, height);
+                    wend = std::min(wend, width);
+                    DType sum = 0;
+                    for (int d = dstart; d < dend; ++d) {
+                        for (int h = hstart; h < hend; ++h) {
+                            for (int w = wstart; w < wend; ++w) {
+                                sum += in[(d * height + h) * width + w];
                             }
                         }
-                        out_data[(pd * pooled_height + ph) * pooled_width +
-                                 pw] = (getAvg ? sum / pool_size : sum);
                     }
+                    out[(pd * pooled_height + ph) * pooled_width + pw] =
+                        (getAvg ? sum / pool_size : sum);
                 }
             }
-            in_data += in_data_offset;
-            out_data += out_data_offset;
+        }
+    }
+}
+
+/*!
+ * \brief max unpooling cpu function for 1/2/3-D images using the argmax
+ * stored in the mask by max pooling, instead of rescanning each window.
+ * Do not call this kernel directly. Use the interface unpool().
+ */
+template <typename DType>
+inline void unpool_max_mask_cpu(const DType* out_grad,
+                                const int32_t* mask_data,
+                                const TShape& ishape, const TShape& oshape,
+                                DType* in_grad) {
+    const index_t in_offset = ishape.ProdShape(2, ishape.ndim());
+    const index_t out_offset = oshape.ProdShape(2, oshape.ndim());
+    const int nplanes = oshape[0] * oshape[1];
+#pragma omp parallel for
+    for (int i = 0; i < nplanes; ++i) {
+        const DType* grad = out_grad + i * out_offset;
+        const int32_t* mask = mask_data + i * out_offset;
+        DType* in = in_grad + i * in_offset;
+        for (index_t j = 0; j < out_offset; ++j) {
+            // the mask is -1 where the window only covers padding
+            const int max_idx = mask[j];
+            if (max_idx >= 0) {
+                in[max_idx] += grad[j];
+            }
         }
     }
 }
@@ -375,29 +493,29 @@ inline void unpool_max_1d_cpu(const DType* out_grad, const DType* in_data,
     const int stride_w = stride[0];
     const index_t in_offset = ishape[2];
     const index_t out_offset = oshape[2];
-    for (index_t n = 0; n < oshape[0]; ++n) {
-        for (index_t c = 0; c < oshape[1]; ++c) {
-            for (int pw = 0; pw < pooled_width; ++pw) {
-                int wstart = pw * stride_w - pad_w;
-                int wend = std::min(wstart + kernel_w, width);
-                wstart = std::max(wstart, 0);
-                int max_idx = -1;
-                for (int w = wstart; w < wend; ++w) {
-                    if (in_data[w] == out_data[pw]) {
-                        max_idx = w;
-                        break;
-                    }
-                }
-                // In the case where pad > 0 and kernel = 1, for example,
-                // max_idx can be -1 reaching this step.
-                if (max_idx >= 0) {
-                    in_grad[max_idx] += out_grad[pw];
+    const int nplanes = oshape[0] * oshape[1];
+#pragma omp parallel for
+    for (int i = 0; i < nplanes; ++i) {
+        const DType* in = in_data + i * in_offset;
+        const DType* out = out_data + i * out_offset;
+        const DType* grad = out_grad + i * out_offset;
+        DType* igrad = in_grad + i * in_offset;
+        for (int pw = 0; pw < pooled_width; ++pw) {
+            int wstart = pw * stride_w - pad_w;
+            int wend = std::min(wstart + kernel_w, width);
+            wstart = std::max(wstart, 0);
+            int max_idx = -1;
+            for (int w = wstart; w < wend; ++w) {
+                if (in[w] == out[pw]) {
+                    max_idx = w;
+                    break;
                 }
             }
-            in_data += in_offset;
-            in_grad += in_offset;
-            out_data += out_offset;
-            out_grad += out_offset;
+            // In the case where pad > 0 and kernel = 1, for example,
+            // max_idx can be -1 reaching this step.
+            if (max_idx >= 0) {
+                igrad[max_idx] += grad[pw];
+            }
         }
     }
 }
@@ -419,41 +537,41 @@ inline void unpool_max_2d_cpu(const DType* out_grad, const DType* in_data,
     const int stride_h = stride[0], stride_w = stride[1];
     const index_t in_offset = ishape[2] * ishape[3];
     const index_t out_offset = oshape[2] * oshape[3];
-    for (index_t n = 0; n < oshape[0]; ++n) {
-        for (index_t c = 0; c < oshape[1]; ++c) {
-            for (int ph = 0; ph < pooled_height; ++ph) {
-                for (int pw = 0; pw < pooled_width; ++pw) {
-                    int hstart = ph * stride_h - pad_h;
-                    int wstart = pw * stride_w - pad_w;
-                    int hend = std::min(hstart + kernel_h, height);
-                    int wend = std::min(wstart + kernel_w, width);
-                    hstart = std::max(hstart, 0);
-                    wstart = std::max(wstart, 0);
-                    const int pool_index = ph * pooled_width + pw;
-                    int max_idx = -1;
-                    bool found = false;
-                    for (int h = hstart; h < hend; ++h) {
-                        for (int w = wstart; w < wend; ++w) {
-                            const int idx = h * width + w;
-                            if (in_data[idx] == out_data[pool_index]) {
-                                max_idx = idx;
-                                found = true;
-                                break;
-                            }
+    const int nplanes = oshape[0] * oshape[1];
+#pragma omp parallel for
+    for (int i = 0; i < nplanes; ++i) {
+        const DType* in = in_data + i * in_offset;
+        const DType* out = out_data + i * out_offset;
+        const DType* grad = out_grad + i * out_offset;
+        DType* igrad = in_grad + i * in_offset;
+        for (int ph = 0; ph < pooled_height; ++ph) {
+            for (int pw = 0; pw < pooled_width; ++pw) {
+                int hstart = ph * stride_h - pad_h;
+                int wstart = pw * stride_w - pad_w;
+                int hend = std::min(hstart + kernel_h, height);
+                int wend = std::min(wstart + kernel_w, width);
+                hstart = std::max(hstart, 0);
+                wstart = std::max(wstart, 0);
+                const int pool_index = ph * pooled_width + pw;
+                int max_idx = -1;
+                bool found = false;
+                for (int h = hstart; h < hend; ++h) {
+                    for (int w = wstart; w < wend; ++w) {
+                        const int idx = h * width + w;
+                        if (in[idx] == out[pool_index]) {
+                            max_idx = idx;
+                            found = true;
+                            break;
                         }
-                        if (found) break;
-                    }
-                    // In the case where pad > 0 and kernel = 1, for example,
-                    // max_idx can be -1 reaching this step.
-                    if (max_idx >= 0) {
-                        in_grad[max_idx] += out_grad[pool_index];
                     }
+                    if (found) break;
+                }
+                // In the case where pad > 0 and kernel = 1, for example,
+                // max_idx can be -1 reaching this step.
+                if (max_idx >= 0) {
+                    igrad[max_idx] += grad[pool_index];
                 }
             }
-            in_data += in_offset;
-            in_grad += in_offset;
-            out_data += out_offset;
-            out_grad += out_offset;
         }
     }
 }
@@ -476,52 +594,50 @@ inline void unpool_max_3d_cpu(const DType* out_grad, const DType* in_data,
     const int stride_d = stride[0], stride_h = stride[1], stride_w = stride[2];
     const index_t in_offset = ishape[2] * ishape[3] * ishape[4];
     const index_t out_offset = oshape[2] * oshape[3] * oshape[4];
-    for (index_t n = 0; n < oshape[0]; ++n) {
-        for (index_t c = 0; c < oshape[1]; ++c) {
-            for (int pd = 0; pd < pooled_depth; ++pd) {
-                for (int ph = 0; ph < pooled_height; ++ph) {
-                    for (int pw = 0; pw < pooled_width; ++pw) {
-                        int dstart = pd * stride_d - pad_d;
-                        int hstart = ph * stride_h - pad_h;
-                        int wstart = pw * stride_w - pad_w;
-                        int dend = std::min(dstart + kernel_d, depth);
-                        int hend = std::min(hstart + kernel_h, height);
-                        int wend = std::min(wstart + kernel_w, width);
-                        dstart = std::max(dstart, 0);
-                        hstart = std::max(hstart, 0);
-                        wstart = std::max(wstart, 0);
-                        const int pool_index =
-                            (pd * pooled_height + ph) * pooled_width + pw;
-                        int max_idx = -1;
-                        bool found = false;
-                        for (int d = dstart; d < dend; ++d) {
-                            for (int h = hstart; h < hend; ++h) {
-                                for (int w = wstart; w < wend; ++w) {
-                                    const int idx =
-                                        (d * height + h) * width + w;
-                                    if (in_data[idx] == out_data[pool_index]) {
-                                        max_idx = idx;
-                                        found = true;
-                                        break;
-                                    }
+    const int nplanes = oshape[0] * oshape[1];
+#pragma omp parallel for
+    for (int i = 0; i < nplanes; ++i) {
+        const DType* in = in_data + i * in_offset;
+        DType* igrad = in_grad + i * in_offset;
+        const DType* out = out_data + i * out_offset;
+        const DType* grad = out_grad + i * out_offset;
+        for (int pd = 0; pd < pooled_depth; ++pd) {
+            for (int ph = 0; ph < pooled_height; ++ph) {
+                for (int pw = 0; pw < pooled_width; ++pw) {
+                    int dstart = pd * stride_d - pad_d;
+                    int hstart = ph * stride_h - pad_h;
+                    int wstart = pw * stride_w - pad_w;
+                    int dend = std::min(dstart + kernel_d, depth);
+                    int hend = std::min(hstart + kernel_h, height);
+                    int wend = std::min(wstart + kernel_w, width);
+                    dstart = std::max(dstart, 0);
+                    hstart = std::max(hstart, 0);
+                    wstart = std::max(wstart, 0);
+                    const int pool_index =
+                        (pd * pooled_height + ph) * pooled_width + pw;
+                    int max_idx = -1;
+                    bool found = false;
+                    for (int d = dstart; d < dend; ++d) {
+                        for (int h = hstart; h < hend; ++h) {
+                            for (int w = wstart; w < wend; ++w) {
+                                const int idx = (d * height + h) * width + w;
+                                if (in[idx] == out[pool_index]) {
+                                    max_idx = idx;
+                                    found = true;
+                                    break;
                                 }
-                                if (found) break;
                             }
                             if (found) break;
                         }
-                        // In the case where pad > 0 and kernel = 1, for
-                        // example,
-                        // max_idx can be -1 reaching this step.
-                        if (max_idx >= 0) {
-                            in_grad[max_idx] += out_grad[pool_index];
-                        }
+                        if (found) break;
+                    }
+                    // In the case where pad > 0 and kernel = 1, for example,
+                    // max_idx can be -1 reaching this step.
+                    if (max_idx >= 0) {
+                        igrad[max_idx] += grad[pool_index];
                     }
                 }
             }
-            in_data += in_offset;
-            in_grad += in_offset;
-            out_data += out_offset;
-            out_grad += out_offset;
         }
     }
 }
@@ -542,23 +658,23 @@ inline void unpool_sum_1d_cpu(const DType* out_grad, const TShape& ishape,
     const int stride_w = stride[0];
     const index_t in_grad_offset = ishape[2];
     const index_t out_grad_offset = oshape[2];
-    for (index_t n = 0; n < oshape[0]; ++n) {
-        for (index_t c = 0; c < oshape[1]; ++c) {
-            for (int pw = 0; pw < pooled_width; ++pw) {
-                int wstart = pw * stride_w - pad_w;
-                int wend = std::min(wstart + kernel_w, width + pad_w);
-                int pool_size = 1;
-                if (isAvg) {
-                    pool_size = wend - wstart;
-                }
-                wstart = std::max(wstart, 0);
-                wend = std::min(wend, width);
-                for (int w = wstart; w < wend; ++w) {
-                    in_grad[w] += out_grad[pw] / pool_size;
-                }
+    const int nplanes = oshape[0] * oshape[1];
+#pragma omp parallel for
+    for (int i = 0; i < nplanes; ++i) {
+        DType* igrad = in_grad + i * in_grad_offset;
+        const DType* grad = out_grad + i * out_grad_offset;
+        for (int pw = 0; pw < pooled_width; ++pw) {
+            int wstart = pw * stride_w - pad_w;
+            int wend = std::min(wstart + kernel_w, width + pad_w);
+            int pool_size = 1;
+            if (isAvg) {
+                pool_size = wend - wstart;
+            }
+            wstart = std::max(wstart, 0);
+            wend = std::min(wend, width);
+            for (int w = wstart; w < wend; ++w) {
+                igrad[w] += grad[pw] / pool_size;
             }
-            in_grad += in_grad_offset;
-            out_grad += out_grad_offset;
         }
     }
 }
@@ -579,33 +695,33 @@ inline void unpool_sum_2d_cpu(const DType* out_grad, const TShape& ishape,
     const int stride_h = stride[0], stride_w = stride[1];
     const index_t in_grad_offset = ishape[2] * ishape[3];
     const index_t out_grad_offset = oshape[2] * oshape[3];
-    for (index_t n = 0; n < oshape[0]; ++n) {
-        for (index_t c = 0; c < oshape[1]; ++c) {
-            for (int ph = 0; ph < pooled_height; ++ph) {
-                for (int pw = 0; pw < pooled_width; ++pw) {
-                    int hstart = ph * stride_h - pad_h;
-                    int wstart = pw * stride_w - pad_w;
-                    int hend = std::min(hstart + kernel_h, height + pad_h);
-                    int wend = std::min(wstart + kernel_w, width + pad_w);
-                    int pool_size = 1;
-                    if (isAvg) {
-                        pool_size = (hend - hstart) * (wend - wstart);
-                    }
-                    hstart = std::max(hstart, 0);
-                    wstart = std::max(wstart, 0);
-                    hend = std::min(hend, height);
-                    wend = std::min(wend, width);
-                    const int pool_index = ph * pooled_width + pw;
-                    for (int h = hstart; h < hend; ++h) {
-                        for (int w = wstart; w < wend; ++w) {
-                            in_grad[h * width + w] +=
-                                out_grad[pool_index] / pool_size;
-                        }
+    const int nplanes = oshape[0] * oshape[1];
+#pragma omp parallel for
+    for (int i = 0; i < nplanes; ++i) {
+        DType* igrad = in_grad + i * in_grad_offset;
+        const DType* grad = out_grad + i * out_grad_offset;
+        for (int ph = 0; ph < pooled_height; ++ph) {
+            for (int pw = 0; pw < pooled_width; ++pw) {
+                int hstart = ph * stride_h - pad_h;
+                int wstart = pw * stride_w - pad_w;
+                int hend = std::min(hstart + kernel_h, height + pad_h);
+                int wend = std::min(wstart + kernel_w, width + pad_w);
+                int pool_size = 1;
+                if (isAvg) {
+                    pool_size = (hend - hstart) * (wend - wstart);
+                }
+                hstart = std::max(hstart, 0);
+                wstart = std::max(wstart, 0);
+                hend = std::min(hend, height);
+                wend = std::min(wend, width);
+                const int pool_index = ph * pooled_width + pw;
+                for (int h = hstart; h < hend; ++h) {
+                    for (int w = wstart; w < wend; ++w) {
+                        igrad[h * width + w] +=
+                            grad[pool_index] / pool_size;
                     }
                 }
             }
-            in_grad += in_grad_offset;
-            out_grad += out_grad_offset;
         }
     }
 }
@@ -627,43 +743,43 @@ inline void unpool_sum_3d_cpu(const DType* out_grad, const TShape& ishape,
     const int stride_d = stride[0], stride_h = stride[1], stride_w = stride[2];
     const index_t in_grad_offset = ishape[2] * ishape[3] * ishape[4];
     const index_t out_grad_offset = oshape[2] * oshape[3] * oshape[4];
-    for (index_t n = 0; n < oshape[0]; ++n) {
-        for (index_t c = 0; c < oshape[1]; ++c) {
-            for (int pd = 0; pd < pooled_depth; ++pd) {
-                for (int ph = 0; ph < pooled_height; ++ph) {
-                    for (int pw = 0; pw < pooled_width; ++pw) {
-                        int dstart = pd * stride_d - pad_d;
-                        int hstart = ph * stride_h - pad_h;
-                        int wstart = pw * stride_w - pad_w;
-                        int dend = std::min(dstart + kernel_d, depth + pad_d);
-                        int hend = std::min(hstart + kernel_h, height + pad_h);
-                        int wend = std::min(wstart + kernel_w, width + pad_w);
-                        int pool_size = 1;
-                        if (isAvg) {
-                            pool_size = (dend - dstart) * (hend - hstart) *
-                                        (wend - wstart);
-                        }
-                        dstart = std::max(dstart, 0);
-                        hstart = std::max(hstart, 0);
-                        wstart = std::max(wstart, 0);
-                        dend = std::min(dend, depth);
-                        hend = std::min(hend, height);
-                        wend = std::min(wend, width);
-                        const int pool_index =
-                            (pd * pooled_height + ph) * pooled_width + pw;
-                        for (int d = dstart; d < dend; ++d) {
-                            for (int h = hstart; h < hend; ++h) {
-                                for (int w = wstart; w < wend; ++w) {
-                                    in_grad[(d * height + h) * width + w] +=
-                                        out_grad[pool_index] / pool_size;
-                                }
+    const int nplanes = oshape[0] * oshape[1];
+#pragma omp parallel for
+    for (int i = 0; i < nplanes; ++i) {
+        DType* igrad = in_grad + i * in_grad_offset;
+        const DType* grad = out_grad + i * out_grad_offset;
+        for (int pd = 0; pd < pooled_depth; ++pd) {
+            for (int ph = 0; ph < pooled_height; ++ph) {
+                for (int pw = 0; pw < pooled_width; ++pw) {
+                    int dstart = pd * stride_d - pad_d;
+                    int hstart = ph * stride_h - pad_h;
+                    int wstart = pw * stride_w - pad_w;
+                    int dend = std::min(dstart + kernel_d, depth + pad_d);
+                    int hend = std::min(hstart + kernel_h, height + pad_h);
+                    int wend = std::min(wstart + kernel_w, width + pad_w);
+                    int pool_size = 1;
+                    if (isAvg) {
+                        pool_size = (dend - dstart) * (hend - hstart) *
+                                    (wend - wstart);
+                    }
+                    dstart = std::max(dstart, 0);
+                    hstart = std::max(hstart, 0);
+                    wstart = std::max(wstart, 0);
+                    dend = std::min(dend, depth);
+                    hend = std::min(hend, height);
+                    wend = std::min(wend, width);
+                    const int pool_index =
+                        (pd * pooled_height + ph) * pooled_width + pw;
+                    for (int d = dstart; d < dend; ++d) {
+                        for (int h = hstart; h < hend; ++h) {
+                            for (int w = wstart; w < wend; ++w) {
+                                igrad[(d * height + h) * width + w] +=
+                                    grad[pool_index] / pool_size;
                             }
                         }
                     }
                 }
             }
-            in_grad += in_grad_offset;
-            out_grad += out_grad_offset;
         }
     }
 }
@@ -682,18 +798,21 @@ inline void unpool_sum_3d_cpu(const DType* out_grad, const TShape& ishape,
  * \param req_type operator request type, only support kWriteTo for now
  * \param out_data pointer of the output tensor data in the format of NCW, NCHW,
  * or NCDHW
+ * \param mask_data pointer of the mask with the shape of the output, where max
+ * pooling stores the argmax of each window for unpool(). Can be NULL.
  */
 template <typename DType>
 inline void pool(mshadow::Stream<cpu>* s, const DType* in_data,
                  const TShape& ishape, const TShape& oshape,
                  const TShape& kernel, const TShape& pad, const TShape& stride,
-                 const int pool_type, OpReqType req_type, DType* out_data) {
+                 const int pool_type, OpReqType req_type, DType* out_data,
+                 int32_t* mask_data = NULL) {
     CHECK_EQ(req_type, kWriteTo)
         << "Only support req=kWriteTo in pooling operations";
     if (kernel.ndim() == 1) {
         if (pool_enum::kMaxPooling == pool_type) {
             pool_max_1d_cpu(in_data, ishape, oshape, kernel, pad, stride,
-                            out_data);
+                            out_data, mask_data);
         } else if (pool_enum::kAvgPooling == pool_type) {
             pool_sum_1d_cpu(in_data, ishape, oshape, kernel, pad, stride,
                             out_data, true);
@@ -706,7 +825,7 @@ inline void pool(mshadow::Stream<cpu>* s, const DType* in_data,
     } else if (kernel.ndim() == 2) {
         if (pool_enum::kMaxPooling == pool_type) {
             pool_max_2d_cpu(in_data, ishape, oshape, kernel, pad, stride,
-                            out_data);
+                            out_data, mask_data);
         } else if (pool_enum::kAvgPooling == pool_type) {
             pool_sum_2d_cpu(in_data, ishape, oshape, kernel, pad, stride,
                             out_data, true);
@@ -719,7 +838,7 @@ inline void pool(mshadow::Stream<cpu>* s, const DType* in_data,
     } else if (kernel.ndim() == 3) {
         if (pool_enum::kMaxPooling == pool_type) {
             pool_max_3d_cpu(in_data, ishape, oshape, kernel, pad, stride,
-                            out_data);
+                            out_data, mask_data);
         } else if (pool_enum::kAvgPooling == pool_type) {
             pool_sum_3d_cpu(in_data, ishape, oshape, kernel, pad, stride,
                             out_data, true);
@@ -751,6 +870,8 @@ inline void pool(mshadow::Stream<cpu>* s, const DType* in_data,
  * \param req_type operator request type: kNullOp, kNullWriteInplace,
  * kNullWriteTo, kNullAddTo
  * \param in_grad pointer of the gradient of the operator's input tensor
+ * \param mask_data pointer of the mask filled by pool(), if not NULL max
+ * unpooling reads the argmax from it instead of rescanning the windows
  */
 template <typename DType>
 inline void unpool(mshadow::Stream<cpu>* s, const DType* out_grad,
@@ -758,12 +879,17 @@ inline void unpool(mshadow::Stream<cpu>* s, const DType* out_grad,
                    const TShape& ishape, const TShape& oshape,
                    const TShape& kernel, const TShape& pad,
                    const TShape& stride, const int pool_type,
-                   OpReqType req_type, DType* in_grad) {
+                   OpReqType req_type, DType* in_grad,
+                   const int32_t* mask_data = NULL) {
     if (mxnet::kNullOp == req_type) return;
     if (mxnet::kAddTo != req_type) {
         mxnet_op::Kernel<mxnet_op::set_zero, cpu>::Launch(s, ishape.Size(),
                                                           in_grad);
     }
+    if (pool_enum::kMaxPooling == pool_type && mask_data != NULL) {
+        unpool_max_mask_cpu(out_grad, mask_data, ishape, oshape, in_grad);
+        return;
+    }
     if (kernel.ndim() == 1) {
         if (pool_enum::kMaxPooling == pool_type) {
             unpool_max_1d_cpu(out_grad, in_data, out_data, ishape, oshape,
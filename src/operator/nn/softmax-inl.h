@@ -11,6 +11,7 @@
 #include "../mxnet_op.h"
 #include "../operator_common.h"
 #include "../tensor/broadcast_reduce_op.h"
+#include "./online_softmax.h"
 
 namespace mxnet {
 namespace op {
@@ -30,6 +31,30 @@ struct log_softmax_fwd {
     }
 };
 
+/*! \brief write OP of size elements of a row with statistics stat */
+template <typename OP, typename DType>
+inline void SoftmaxWrite(OP, const DType *in, const SoftmaxStat<DType> &stat,
+                         DType *out, index_t size) {
+    for (index_t j = 0; j < size; ++j) {
+        out[j] = OP::Map(in[j] - stat.max, stat.sum);
+    }
+}
+
+template <typename DType>
+inline void SoftmaxWrite(softmax_fwd, const DType *in,
+                         const SoftmaxStat<DType> &stat, DType *out,
+                         index_t size) {
+    SoftmaxExpScale(in, stat.max, DType(DType(1) / stat.sum), out, size);
+}
+
+template <typename DType>
+inline void SoftmaxWrite(log_softmax_fwd, const DType *in,
+                         const SoftmaxStat<DType> &stat, DType *out,
+                         index_t size) {
+    const DType lse = stat.LogSumExp();
+    for (index_t j = 0; j < size; ++j) out[j] = DType(in[j] - lse);
+}
+
 template <typename OP, typename DType, int ndim>
 inline void Softmax(Stream<cpu> *s, DType *in, DType *out, Shape<ndim> shape,
                     int axis) {
@@ -40,6 +65,16 @@ inline void Softmax(Stream<cpu> *s, DType *in, DType *out, Shape<ndim> shape,
     sshape[axis] = 1;
     index_t sa = stride[axis];
 
+    if (sa == 1) {
+        // contiguous rows
+        SoftmaxRows(in, N, M, [&](index_t i, index_t begin, index_t size,
+                                  const SoftmaxStat<DType> &stat) {
+            SoftmaxWrite(OP(), in + i * M + begin, stat, out + i * M + begin,
+                         size);
+        });
+        return;
+    }
+
 #pragma omp parallel for
     for (int i = 0; i < N; ++i) {
         index_t base = unravel_dot(i, sshape, stride);
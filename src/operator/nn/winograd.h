@@ -0,0 +1,179 @@
+/*!
+ * Copyright (c) 2017 by Contributors
+ * \file winograd.h
+ * \brief cpu transforms of the Winograd minimal filtering algorithm
+ *  F(2x2, 3x3) for stride-1 3x3 convolution. Filters and 4x4 input tiles are
+ *  transformed into a 4x4 domain, where the convolution becomes 16
+ *  independent gemms, and each 4x4 product is transformed back into a 2x2
+ *  output tile.
+ *
+ *  Reference: Andrew Lavin and Scott Gray, "Fast Algorithms for Convolutional
+ *  Neural Networks", CVPR 2016.
+ */
+#ifndef MXNET_OPERATOR_NN_WINOGRAD_H_
+#define MXNET_OPERATOR_NN_WINOGRAD_H_
+
+#include <mxnet/base.h>
+
+namespace mxnet {
+namespace op {
+namespace winograd {
+/*! \brief number of output rows and columns computed by one tile */
+const int kTile = 2;
+/*! \brief number of input rows and columns read by one tile */
+const int kAlpha = 4;
+/*! \brief number of elements in the transform domain */
+const int kDomain = kAlpha * kAlpha;
+
+/*! \brief number of tiles covering an output of the given size */
+inline int num_tiles(int output_size) {
+    return (output_size + kTile - 1) / kTile;
+}
+}  // namespace winograd
+
+/*!
+ * \brief transform 3x3 filters into the winograd domain, U = G g G^T
+ * \param weight filters of shape (K, C, 3, 3)
+ * \param out_channels number of filters K
+ * \param in_channels number of input channels C
+ * \param data_u output of shape (16, K, C)
+ */
+template <typename DType>
+inline void winograd_filter_transform(const DType* weight, int out_channels,
+                                      int in_channels, DType* data_u) {
+    const int nunit = out_channels * in_channels;
+#pragma omp parallel for
+    for (int i = 0; i < nunit; ++i) {
+        const DType* g = weight + i * 9;
+        // t = G g, a 4x3 matrix
+        DType t[12];
+        for (int j = 0; j < 3; ++j) {
+            t[j] = g[j];
+            t[3 + j] = (g[j] + g[3 + j] + g[6 + j]) * DType(0.5f);
+            t[6 + j] = (g[j] - g[3 + j] + g[6 + j]) * DType(0.5f);
+            t[9 + j] = g[6 + j];
+        }
+        // u = t G^T, a 4x4 matrix scattered across the 16 gemm operands
+        for (int r = 0; r < 4; ++r) {
+            const DType* row = t + r * 3;
+            DType* u = data_u + r * 4 * nunit + i;
+            u[0] = row[0];
+            u[nunit] = (row[0] + row[1] + row[2]) * DType(0.5f);
+            u[2 * nunit] = (row[0] - row[1] + row[2]) * DType(0.5f);
+            u[3 * nunit] = row[2];
+        }
+    }
+}
+
+/*!
+ * \brief transform a range of 4x4 input tiles into the winograd domain,
+ *  V = B^T d B. Tiles are numbered over (image, tile row, tile column).
+ * \param data_im pointer to the first image of the batch
+ * \param channels number of input channels C
+ * \param height input height
+ * \param width input width
+ * \param pad_h padding of the height
+ * \param pad_w padding of the width
+ * \param tile_begin first tile to transform
+ * \param num_tile number of tiles P to transform
+ * \param data_v output of shape (16, C, P)
+ */
+template <typename DType>
+inline void winograd_input_transform(const DType* data_im, int channels,
+                                     int height, int width, int pad_h,
+                                     int pad_w, int tile_begin, int num_tile,
+                                     DType* data_v) {
+    using namespace winograd;
+    const int tiles_h = num_tiles(height + 2 * pad_h - 2);
+    const int tiles_w = num_tiles(width + 2 * pad_w - 2);
+    const int stride = channels * num_tile;
+    const int nunit = channels * num_tile;
+#pragma omp parallel for
+    for (int i = 0; i < nunit; ++i) {
+        const int c = i / num_tile, p = i % num_tile;
+        const int tile = tile_begin + p;
+        const int n = tile / (tiles_h * tiles_w);
+        const int y0 = (tile / tiles_w) % tiles_h * kTile - pad_h;
+        const int x0 = tile % tiles_w * kTile - pad_w;
+        const DType* im = data_im + (n * channels + c) * height * width;
+        // gather the tile, zero outside of the image
+        DType d[kDomain];
+        for (int r = 0; r < kAlpha; ++r) {
+            const int y = y0 + r;
+            for (int q = 0; q < kAlpha; ++q) {
+                const int x = x0 + q;
+                d[r * kAlpha + q] =
+                    (y >= 0 && y < height && x >= 0 && x < width)
+                        ? im[y * width + x]
+                        : DType(0);
+            }
+        }
+        // t = B^T d
+        DType t[kDomain];
+        for (int q = 0; q < kAlpha; ++q) {
+            t[q] = d[q] - d[8 + q];
+            t[4 + q] = d[4 + q] + d[8 + q];
+            t[8 + q] = d[8 + q] - d[4 + q];
+            t[12 + q] = d[4 + q] - d[12 + q];
+        }
+        // v = t B
+        DType* v = data_v + c * num_tile + p;
+        for (int r = 0; r < kAlpha; ++r) {
+            const DType* row = t + r * kAlpha;
+            v[(r * 4) * stride] = row[0] - row[2];
+            v[(r * 4 + 1) * stride] = row[1] + row[2];
+            v[(r * 4 + 2) * stride] = row[2] - row[1];
+            v[(r * 4 + 3) * stride] = row[1] - row[3];
+        }
+    }
+}
+
+/*!
+ * \brief transform a range of tiles back from the winograd domain,
+ *  Y = A^T m A, and write the 2x2 outputs that lie inside the image.
+ * \param data_m products of shape (16, K, P)
+ * \param channels number of output channels K
+ * \param output_h output height
+ * \param output_w output width
+ * \param tile_begin first tile to transform
+ * \param num_tile number of tiles P to transform
+ * \param data_out pointer to the first output image of the batch
+ */
+template <typename DType>
+inline void winograd_output_transform(const DType* data_m, int channels,
+                                      int output_h, int output_w,
+                                      int tile_begin, int num_tile,
+                                      DType* data_out) {
+    using namespace winograd;
+    const int tiles_h = num_tiles(output_h);
+    const int tiles_w = num_tiles(output_w);
+    const int stride = channels * num_tile;
+    const int nunit = channels * num_tile;
+#pragma omp parallel for
+    for (int i = 0; i < nunit; ++i) {
+        const int k = i / num_tile, p = i % num_tile;
+        const int tile = tile_begin + p;
+        const int n = tile / (tiles_h * tiles_w);
+        const int y0 = (tile / tiles_w) % tiles_h * kTile;
+        const int x0 = tile % tiles_w * kTile;
+        const DType* m = data_m + k * num_tile + p;
+        // s = A^T m, a 2x4 matrix
+        DType s[2 * kAlpha];
+        for (int q = 0; q < kAlpha; ++q) {
+            const DType m0 = m[q * stride], m1 = m[(4 + q) * stride];
+            const DType m2 = m[(8 + q) * stride], m3 = m[(12 + q) * stride];
+            s[q] = m0 + m1 + m2;
+            s[4 + q] = m1 - m2 - m3;
+        }
+        DType* out = data_out + (n * channels + k) * output_h * output_w;
+        for (int r = 0; r < kTile && y0 + r < output_h; ++r) {
+            const DType* row = s + r * kAlpha;
+            DType* dst = out + (y0 + r) * output_w + x0;
+            dst[0] = row[0] + row[1] + row[2];
+            if (x0 + 1 < output_w) dst[1] = row[1] - row[2] - row[3];
+        }
+    }
+}
+}  // namespace op
+}  // namespace mxnet
+#endif  // MXNET_OPERATOR_NN_WINOGRAD_H_
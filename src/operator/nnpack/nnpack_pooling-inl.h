@@ -33,6 +33,7 @@ class NNPACKPoolingOp : public PoolingOp<xpu, DType> {
     }
 
    public:
+    // writes no argmax mask, so the inherited Backward rescans the windows
     virtual void Forward(const OpContext &ctx,
                          const std::vector<TBlob> &in_data,
                          const std::vector<OpReqType> &req,
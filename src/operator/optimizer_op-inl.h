@@ -13,6 +13,10 @@
 #include <mxnet/operator_util.h>
 #include <nnvm/op.h>
 #include <nnvm/op_attr_types.h>
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <string>
 #include <vector>
 #include "./elemwise_op_common.h"
 #include "./mshadow_op.h"
@@ -451,6 +455,995 @@ inline void RMSPropUpdate(const nnvm::NodeAttrs &attrs, const OpContext &ctx,
     });
 }
 
+/*!
+ * \brief Elements of an array one thread updates at a time in the cpu
+ *  multi-tensor updates.
+ */
+const int kMultiTensorChunk = 1 << 14;
+
+/*! \brief elements [begin, end) of one of the arrays of a multi-tensor op */
+struct MultiTensorChunk {
+    int array, begin, end;
+};
+
+/*! \brief the arrays of the given sizes, cut into chunks */
+inline std::vector<MultiTensorChunk> MultiTensorChunks(
+    const std::vector<int> &sizes) {
+    std::vector<MultiTensorChunk> chunks;
+    for (size_t t = 0; t < sizes.size(); ++t) {
+        for (int begin = 0; begin < sizes[t]; begin += kMultiTensorChunk) {
+            chunks.push_back(MultiTensorChunk{
+                static_cast<int>(t), begin,
+                std::min(begin + kMultiTensorChunk, sizes[t])});
+        }
+    }
+    return chunks;
+}
+
+/*!
+ * \brief Calls apply(t, begin, end) over elements [begin, end) of every
+ *  array t. On cpu the chunks of all the arrays share one parallel loop, so
+ *  many small arrays cost no more than one large one.
+ */
+template <typename F>
+inline void MultiTensorApply(mshadow::Stream<cpu> *s,
+                             const std::vector<int> &sizes, const F &apply) {
+    const std::vector<MultiTensorChunk> chunks = MultiTensorChunks(sizes);
+    const int num_chunks = static_cast<int>(chunks.size());
+#if (MXNET_USE_CUDA == 0)
+#pragma omp parallel for
+#endif
+    for (int c = 0; c < num_chunks; ++c) {
+        apply(chunks[c].array, chunks[c].begin, chunks[c].end);
+    }
+}
+
+/*! \brief OP::Map(i, args...) for i in [begin, end) */
+template <typename OP, typename... Args>
+inline void MultiTensorMap(mshadow::Stream<cpu> *s, int begin, int end,
+                           Args... args) {
+    for (int i = begin; i < end; ++i) OP::Map(i, args...);
+}
+
+#ifdef __CUDACC__
+/*! \brief on gpu every array is one kernel launch */
+template <typename F>
+inline void MultiTensorApply(mshadow::Stream<gpu> *s,
+                             const std::vector<int> &sizes, const F &apply) {
+    for (size_t t = 0; t < sizes.size(); ++t) {
+        if (sizes[t] > 0) apply(static_cast<int>(t), 0, sizes[t]);
+    }
+}
+
+template <typename OP, typename... Args>
+inline void MultiTensorMap(mshadow::Stream<gpu> *s, int begin, int end,
+                           Args... args) {
+    mxnet_op::Kernel<OP, gpu>::Launch(s, end - begin, args...);
+}
+#endif  // __CUDACC__
+
+/*!
+ * \brief Sum of the squares of the gradients of a multi-tensor update, the
+ *  gradient of array t being inputs[t * stride + 1].
+ */
+template <typename DType>
+inline double MultiGradSumSquares(mshadow::Stream<cpu> *s,
+                                  const OpContext &ctx,
+                                  const std::vector<TBlob> &inputs,
+                                  int stride, const std::vector<int> &sizes) {
+    const std::vector<MultiTensorChunk> chunks = MultiTensorChunks(sizes);
+    const int num_chunks = static_cast<int>(chunks.size());
+    std::vector<double> partial(num_chunks);
+#if (MXNET_USE_CUDA == 0)
+#pragma omp parallel for
+#endif
+    for (int c = 0; c < num_chunks; ++c) {
+        const MultiTensorChunk &chunk = chunks[c];
+        const DType *grad = inputs[chunk.array * stride + 1].dptr<DType>();
+        double sum = 0;
+        for (int i = chunk.begin; i < chunk.end; ++i) {
+            const double g = static_cast<double>(grad[i]);
+            sum += g * g;
+        }
+        partial[c] = sum;
+    }
+    return std::accumulate(partial.begin(), partial.end(), 0.0);
+}
+
+template <typename DType, typename xpu>
+inline double MultiGradSumSquares(mshadow::Stream<xpu> *s,
+                                  const OpContext &ctx,
+                                  const std::vector<TBlob> &inputs,
+                                  int stride, const std::vector<int> &sizes) {
+    using namespace mshadow;
+    using namespace mshadow::expr;
+    const int num = static_cast<int>(sizes.size());
+    Tensor<xpu, 1, DType> sums =
+        ctx.requested[0].get_space_typed<xpu, 1, DType>(Shape1(num), s);
+    sums = scalar<DType>(0);
+    for (int t = 0; t < num; ++t) {
+        if (sizes[t] == 0) continue;
+        Tensor<xpu, 2, DType> grad(inputs[t * stride + 1].dptr<DType>(),
+                                   Shape2(1, sizes[t]), s);
+        Tensor<xpu, 1, DType> sum(sums.dptr_ + t, Shape1(1), s);
+        sum = sumall_except_dim<0>(F<mshadow_op::square>(grad));
+    }
+    std::vector<DType> host(num);
+    Copy(Tensor<cpu, 1, DType>(host.data(), Shape1(num)), sums, s);
+    s->Wait();
+    double total = 0;
+    for (int t = 0; t < num; ++t) total += static_cast<double>(host[t]);
+    return total;
+}
+
+/*!
+ * \brief The factor a multi-tensor update rescales the gradients by:
+ *  rescale_grad, times clip_global_norm / norm if the norm of all the
+ *  rescaled gradients exceeds a positive clip_global_norm.
+ */
+template <typename xpu, typename DType>
+inline DType MultiGradRescale(mshadow::Stream<xpu> *s, const OpContext &ctx,
+                              const std::vector<TBlob> &inputs, int stride,
+                              const std::vector<int> &sizes,
+                              float rescale_grad, float clip_global_norm) {
+    if (clip_global_norm <= 0.0f) return DType(rescale_grad);
+    const double norm =
+        std::abs(rescale_grad) *
+        std::sqrt(MultiGradSumSquares<DType>(s, ctx, inputs, stride, sizes));
+    if (norm <= clip_global_norm) return DType(rescale_grad);
+    return DType(rescale_grad * clip_global_norm / norm);
+}
+
+/*! \brief number of inputs of a multi-tensor update */
+template <typename ParamType, int num_states>
+inline uint32_t MultiUpdateNumInputs(const nnvm::NodeAttrs &attrs) {
+    return nnvm::get<ParamType>(attrs.parsed).num_weights * (2 + num_states);
+}
+
+template <typename ParamType>
+inline uint32_t MultiUpdateNumOutputs(const nnvm::NodeAttrs &attrs) {
+    return nnvm::get<ParamType>(attrs.parsed).num_weights;
+}
+
+/*! \brief weight_0, grad_0, states_0..., weight_1, ... */
+template <typename ParamType>
+inline std::vector<std::string> MultiUpdateInputNames(
+    const nnvm::NodeAttrs &attrs, const std::vector<std::string> &states) {
+    const int num_weights = nnvm::get<ParamType>(attrs.parsed).num_weights;
+    std::vector<std::string> ret;
+    for (int t = 0; t < num_weights; ++t) {
+        const std::string suffix = std::string("_") + std::to_string(t);
+        ret.push_back("weight" + suffix);
+        ret.push_back("grad" + suffix);
+        for (const std::string &state : states) ret.push_back(state + suffix);
+    }
+    return ret;
+}
+
+template <typename ParamType, int num_states>
+inline std::vector<uint32_t> MultiUpdateMutateInputs(
+    const nnvm::NodeAttrs &attrs) {
+    const uint32_t num_weights =
+        nnvm::get<ParamType>(attrs.parsed).num_weights;
+    std::vector<uint32_t> ret;
+    for (uint32_t t = 0; t < num_weights; ++t) {
+        for (uint32_t k = 0; k < num_states; ++k) {
+            ret.push_back(t * (2 + num_states) + 2 + k);
+        }
+    }
+    return ret;
+}
+
+/*!
+ * \brief Every weight shares its shape with its gradient, its states and its
+ *  output.
+ */
+template <typename ParamType, int num_states>
+inline bool MultiUpdateShape(const nnvm::NodeAttrs &attrs,
+                             std::vector<TShape> *in_attrs,
+                             std::vector<TShape> *out_attrs) {
+    const ParamType &param = nnvm::get<ParamType>(attrs.parsed);
+    const int stride = 2 + num_states;
+    CHECK_EQ(param.lrs.ndim(), static_cast<size_t>(param.num_weights))
+        << "lrs must hold one learning rate per weight";
+    CHECK_EQ(param.wds.ndim(), static_cast<size_t>(param.num_weights))
+        << "wds must hold one weight decay per weight";
+    CHECK_EQ(in_attrs->size(),
+             static_cast<size_t>(param.num_weights * stride));
+    CHECK_EQ(out_attrs->size(), static_cast<size_t>(param.num_weights));
+    bool ret = true;
+    for (int t = 0; t < param.num_weights; ++t) {
+        std::vector<TShape> in(in_attrs->begin() + t * stride,
+                               in_attrs->begin() + (t + 1) * stride);
+        std::vector<TShape> out(1, (*out_attrs)[t]);
+        ret = ElemwiseShape<2 + num_states, 1>(attrs, &in, &out) && ret;
+        std::copy(in.begin(), in.end(), in_attrs->begin() + t * stride);
+        (*out_attrs)[t] = out[0];
+    }
+    return ret;
+}
+
+/*! \brief all the arrays of a multi-tensor update share one type */
+inline bool MultiUpdateType(const nnvm::NodeAttrs &attrs,
+                            std::vector<int> *in_attrs,
+                            std::vector<int> *out_attrs) {
+    return ElemwiseAttr<int, type_is_none, type_assign, true, type_string>(
+        attrs, in_attrs, out_attrs, -1);
+}
+
+/*!
+ * \brief The sizes of the weights of a multi-tensor update, whose arrays
+ *  come in groups of stride.
+ */
+inline std::vector<int> MultiUpdateSizes(const std::vector<TBlob> &inputs,
+                                         int num_weights, int stride) {
+    std::vector<int> sizes(num_weights);
+    for (int t = 0; t < num_weights; ++t) {
+        sizes[t] = static_cast<int>(inputs[t * stride].Size());
+    }
+    return sizes;
+}
+
+struct MultiSGDParam : public dmlc::Parameter<MultiSGDParam> {
+    nnvm::Tuple<float> lrs;
+    nnvm::Tuple<float> wds;
+    float rescale_grad;
+    float clip_gradient;
+    float clip_global_norm;
+    int num_weights;
+    DMLC_DECLARE_PARAMETER(MultiSGDParam) {
+        DMLC_DECLARE_FIELD(lrs).describe("Learning rate of every weight.");
+        DMLC_DECLARE_FIELD(wds).describe("Weight decay of every weight.");
+        DMLC_DECLARE_FIELD(rescale_grad)
+            .set_default(1.0f)
+            .describe("Rescale gradient to grad = rescale_grad*grad.");
+        DMLC_DECLARE_FIELD(clip_gradient)
+            .set_default(-1.0f)
+            .describe(
+                "Clip gradient to the range of [-clip_gradient, clip_gradient] "
+                "If clip_gradient <= 0, gradient clipping is turned off. "
+                "grad = max(min(grad, clip_gradient), -clip_gradient).");
+        DMLC_DECLARE_FIELD(clip_global_norm)
+            .set_default(-1.0f)
+            .describe(
+                "If positive, all the rescaled gradients are scaled down "
+                "together so that their joint 2-norm is at most "
+                "clip_global_norm.");
+        DMLC_DECLARE_FIELD(num_weights)
+            .set_lower_bound(1)
+            .describe("Number of weights updated.");
+    }
+};
+
+template <typename xpu>
+inline void MultiSGDUpdate(const nnvm::NodeAttrs &attrs, const OpContext &ctx,
+                           const std::vector<TBlob> &inputs,
+                           const std::vector<OpReqType> &req,
+                           const std::vector<TBlob> &outputs) {
+    using namespace mxnet_op;
+    const MultiSGDParam &param = nnvm::get<MultiSGDParam>(attrs.parsed);
+    Stream<xpu> *s = ctx.get_stream<xpu>();
+    const std::vector<int> sizes =
+        MultiUpdateSizes(inputs, param.num_weights, 2);
+    MSHADOW_REAL_TYPE_SWITCH(inputs[0].type_flag_, DType, {
+        const DType rescale = MultiGradRescale<xpu, DType>(
+            s, ctx, inputs, 2, sizes, param.rescale_grad,
+            param.clip_global_norm);
+        MultiTensorApply(s, sizes, [&](int t, int begin, int end) {
+            const TBlob *in = &inputs[t * 2];
+            MultiTensorMap<SGDKernel>(
+                s, begin, end, outputs[t].dptr<DType>(), in[0].dptr<DType>(),
+                in[1].dptr<DType>(), static_cast<DType>(param.clip_gradient),
+                static_cast<DType>(param.lrs[t]),
+                static_cast<DType>(param.wds[t]), rescale, req[t]);
+        });
+    });
+}
+
+struct MultiSGDMomParam : public dmlc::Parameter<MultiSGDMomParam> {
+    nnvm::Tuple<float> lrs;
+    nnvm::Tuple<float> wds;
+    float momentum;
+    float rescale_grad;
+    float clip_gradient;
+    float clip_global_norm;
+    int num_weights;
+    DMLC_DECLARE_PARAMETER(MultiSGDMomParam) {
+        DMLC_DECLARE_FIELD(lrs).describe("Learning rate of every weight.");
+        DMLC_DECLARE_FIELD(wds).describe("Weight decay of every weight.");
+        DMLC_DECLARE_FIELD(momentum)
+            .set_default(0.0f)
+            .describe("The decay rate of momentum estimates at each epoch.");
+        DMLC_DECLARE_FIELD(rescale_grad)
+            .set_default(1.0f)
+            .describe("Rescale gradient to grad = rescale_grad*grad.");
+        DMLC_DECLARE_FIELD(clip_gradient)
+            .set_default(-1.0f)
+            .describe(
+                "Clip gradient to the range of [-clip_gradient, clip_gradient] "
+                "If clip_gradient <= 0, gradient clipping is turned off. "
+                "grad = max(min(grad, clip_gradient), -clip_gradient).");
+        DMLC_DECLARE_FIELD(clip_global_norm)
+            .set_default(-1.0f)
+            .describe(
+                "If positive, all the rescaled gradients are scaled down "
+                "together so that their joint 2-norm is at most "
+                "clip_global_norm.");
+        DMLC_DECLARE_FIELD(num_weights)
+            .set_lower_bound(1)
+            .describe("Number of weights updated.");
+    }
+};
+
+template <typename xpu>
+inline void MultiSGDMomUpdate(const nnvm::NodeAttrs &attrs,
+                              const OpContext &ctx,
+                              const std::vector<TBlob> &inputs,
+                              const std::vector<OpReqType> &req,
+                              const std::vector<TBlob> &outputs) {
+    using namespace mxnet_op;
+    const MultiSGDMomParam &param = nnvm::get<MultiSGDMomParam>(attrs.parsed);
+    Stream<xpu> *s = ctx.get_stream<xpu>();
+    const std::vector<int> sizes =
+        MultiUpdateSizes(inputs, param.num_weights, 3);
+    MSHADOW_REAL_TYPE_SWITCH(inputs[0].type_flag_, DType, {
+        const DType rescale = MultiGradRescale<xpu, DType>(
+            s, ctx, inputs, 3, sizes, param.rescale_grad,
+            param.clip_global_norm);
+        MultiTensorApply(s, sizes, [&](int t, int begin, int end) {
+            const TBlob *in = &inputs[t * 3];
+            MultiTensorMap<SGDMomKernel>(
+                s, begin, end, outputs[t].dptr<DType>(), in[2].dptr<DType>(),
+                in[0].dptr<DType>(), in[1].dptr<DType>(),
+                static_cast<DType>(param.clip_gradient),
+                static_cast<DType>(param.momentum),
+                static_cast<DType>(param.lrs[t]),
+                static_cast<DType>(param.wds[t]), rescale, req[t]);
+        });
+    });
+}
+
+struct MultiAdamParam : public dmlc::Parameter<MultiAdamParam> {
+    nnvm::Tuple<float> lrs;
+    nnvm::Tuple<float> wds;
+    float beta1;
+    float beta2;
+    float epsilon;
+    float rescale_grad;
+    float clip_gradient;
+    float clip_global_norm;
+    int num_weights;
+    DMLC_DECLARE_PARAMETER(MultiAdamParam) {
+        DMLC_DECLARE_FIELD(lrs).describe(
+            "Learning rate of every weight, including the bias corrections.");
+        DMLC_DECLARE_FIELD(wds).describe("Weight decay of every weight.");
+        DMLC_DECLARE_FIELD(beta1)
+            .set_default(0.9f)
+            .describe("The decay rate for the 1st moment estimates.");
+        DMLC_DECLARE_FIELD(beta2)
+            .set_default(0.999f)
+            .describe("The decay rate for the 2nd moment estimates.");
+        DMLC_DECLARE_FIELD(epsilon)
+            .set_default(1e-8f)
+            .describe("A small constant for numerical stability.");
+        DMLC_DECLARE_FIELD(rescale_grad)
+            .set_default(1.0f)
+            .describe("Rescale gradient to grad = rescale_grad*grad.");
+        DMLC_DECLARE_FIELD(clip_gradient)
+            .set_default(-1.0f)
+            .describe(
+                "Clip gradient to the range of [-clip_gradient, clip_gradient] "
+                "If clip_gradient <= 0, gradient clipping is turned off. "
+                "grad = max(min(grad, clip_gradient), -clip_gradient).");
+        DMLC_DECLARE_FIELD(clip_global_norm)
+            .set_default(-1.0f)
+            .describe(
+                "If positive, all the rescaled gradients are scaled down "
+                "together so that their joint 2-norm is at most "
+                "clip_global_norm.");
+        DMLC_DECLARE_FIELD(num_weights)
+            .set_lower_bound(1)
+            .describe("Number of weights updated.");
+    }
+};
+
+/*! \brief the steps of AdamUpdate for one element */
+struct AdamKernel {
+    template <typename DType>
+    MSHADOW_XINLINE static void Map(
+        int i, DType *out_data, DType *mean_data, DType *var_data,
+        const DType *weight_data, const DType *grad_data,
+        const DType param_clip_gradient, const DType param_beta1,
+        const DType param_beta2, const DType param_lr, const DType param_wd,
+        const DType param_epsilon, const DType param_rescale_grad,
+        const OpReqType req) {
+        DType grad =
+            param_rescale_grad * grad_data[i] + param_wd * weight_data[i];
+        if (param_clip_gradient >= 0.0f) {
+            grad = mshadow_op::clip::Map(grad, param_clip_gradient);
+        }
+        mean_data[i] = param_beta1 * mean_data[i] + (1.f - param_beta1) * grad;
+        var_data[i] =
+            param_beta2 * var_data[i] + (1.f - param_beta2) * grad * grad;
+        KERNEL_ASSIGN(out_data[i], req,
+                      weight_data[i] -
+                          param_lr * mean_data[i] /
+                              (mshadow_op::square_root::Map(var_data[i]) +
+                               param_epsilon));
+    }
+};
+
+template <typename xpu>
+inline void MultiAdamUpdate(const nnvm::NodeAttrs &attrs,
+                            const OpContext &ctx,
+                            const std::vector<TBlob> &inputs,
+                            const std::vector<OpReqType> &req,
+                            const std::vector<TBlob> &outputs) {
+    using namespace mxnet_op;
+    const MultiAdamParam &param = nnvm::get<MultiAdamParam>(attrs.parsed);
+    Stream<xpu> *s = ctx.get_stream<xpu>();
+    const std::vector<int> sizes =
+        MultiUpdateSizes(inputs, param.num_weights, 4);
+    MSHADOW_REAL_TYPE_SWITCH(inputs[0].type_flag_, DType, {
+        const DType rescale = MultiGradRescale<xpu, DType>(
+            s, ctx, inputs, 4, sizes, param.rescale_grad,
+            param.clip_global_norm);
+        MultiTensorApply(s, sizes, [&](int t, int begin, int end) {
+            const TBlob *in = &inputs[t * 4];
+            MultiTensorMap<AdamKernel>(
+                s, begin, end, outputs[t].dptr<DType>(), in[2].dptr<DType>(),
+                in[3].dptr<DType>(), in[0].dptr<DType>(), in[1].dptr<DType>(),
+                static_cast<DType>(param.clip_gradient),
+                static_cast<DType>(param.beta1),
+                static_cast<DType>(param.beta2),
+                static_cast<DType>(param.lrs[t]),
+                static_cast<DType>(param.wds[t]),
+                static_cast<DType>(param.epsilon), rescale, req[t]);
+        });
+    });
+}
+
+/*!
+ * \brief out[0] = the sum of the squares of the size elements of data, on
+ *  the device of the stream.
+ */
+template <typename xpu, typename DType>
+inline void SumOfSquares(mshadow::Stream<xpu> *s, const DType *data,
+                         int size, DType *out) {
+    using namespace mshadow;
+    using namespace mshadow::expr;
+    Tensor<xpu, 2, DType> in(const_cast<DType *>(data), Shape2(1, size), s);
+    Tensor<xpu, 1, DType> sum(out, Shape1(1), s);
+    sum = sumall_except_dim<0>(F<mshadow_op::square>(in));
+}
+
+template <typename DType>
+inline void SumOfSquares(mshadow::Stream<cpu> *s, const DType *data,
+                         int size, DType *out) {
+    double sum = 0;
+#if (MXNET_USE_CUDA == 0)
+#pragma omp parallel for reduction(+ : sum)
+#endif
+    for (int i = 0; i < size; ++i) {
+        const double v = static_cast<double>(data[i]);
+        sum += v * v;
+    }
+    *out = DType(sum);
+}
+
+/*! \brief the clipped, rescaled gradient */
+struct ClipGradKernel {
+    template <typename DType>
+    MSHADOW_XINLINE static void Map(int i, DType *out, const DType *grad,
+                                    const DType param_clip_gradient,
+                                    const DType param_rescale_grad) {
+        if (param_clip_gradient >= 0.0f) {
+            out[i] = mshadow_op::clip::Map(param_rescale_grad * grad[i],
+                                           param_clip_gradient);
+        } else {
+            out[i] = param_rescale_grad * grad[i];
+        }
+    }
+};
+
+struct LARSParam : public dmlc::Parameter<LARSParam> {
+    float lr;
+    float momentum;
+    float eta;
+    float epsilon;
+    float wd;
+    float rescale_grad;
+    float clip_gradient;
+    DMLC_DECLARE_PARAMETER(LARSParam) {
+        DMLC_DECLARE_FIELD(lr).describe("Learning rate");
+        DMLC_DECLARE_FIELD(momentum)
+            .set_default(0.0f)
+            .describe("The decay rate of momentum estimates at each epoch.");
+        DMLC_DECLARE_FIELD(eta)
+            .set_default(0.001f)
+            .describe("Trust coefficient of the layer-wise learning rate.");
+        DMLC_DECLARE_FIELD(epsilon)
+            .set_default(1e-9f)
+            .describe("A small constant for numerical stability.");
+        DMLC_DECLARE_FIELD(wd)
+            .set_default(0.0f)
+            .describe(
+                "Weight decay augments the objective function with a "
+                "regularization term that penalizes large weights. "
+                "The penalty scales with the square of the magnitude of each "
+                "weight.");
+        DMLC_DECLARE_FIELD(rescale_grad)
+            .set_default(1.0f)
+            .describe("Rescale gradient to grad = rescale_grad*grad.");
+        DMLC_DECLARE_FIELD(clip_gradient)
+            .set_default(-1.0f)
+            .describe(
+                "Clip gradient to the range of [-clip_gradient, clip_gradient] "
+                "If clip_gradient <= 0, gradient clipping is turned off. "
+                "grad = max(min(grad, clip_gradient), -clip_gradient).");
+    }
+};
+
+/*!
+ * \brief The momentum step of LARS, given the sums of the squares of the
+ *  weight and of the clipped gradient in norms.
+ */
+struct LARSMomKernel {
+    template <typename DType>
+    MSHADOW_XINLINE static void Map(
+        int i, DType *out_data, DType *mom_data, const DType *weight_data,
+        const DType *grad_data, const DType *norms, const DType param_momentum,
+        const DType param_lr, const DType param_eta, const DType param_epsilon,
+        const DType param_wd, const OpReqType req) {
+        const DType weight_norm = mshadow_op::square_root::Map(norms[0]);
+        const DType grad_norm = mshadow_op::square_root::Map(norms[1]);
+        // a layer whose weight or gradient is zero keeps the global rate
+        const DType ratio =
+            weight_norm > 0.0f && grad_norm > 0.0f
+                ? param_eta * weight_norm /
+                      (grad_norm + param_wd * weight_norm + param_epsilon)
+                : DType(1.0f);
+        mom_data[i] =
+            param_momentum * mom_data[i] -
+            param_lr * ratio * (grad_data[i] + param_wd * weight_data[i]);
+        KERNEL_ASSIGN(out_data[i], req, weight_data[i] + mom_data[i]);
+    }
+};
+
+template <typename xpu>
+inline void LARSMomUpdate(const nnvm::NodeAttrs &attrs, const OpContext &ctx,
+                          const std::vector<TBlob> &inputs,
+                          const std::vector<OpReqType> &req,
+                          const std::vector<TBlob> &outputs) {
+    using namespace mxnet_op;
+    const LARSParam &param = nnvm::get<LARSParam>(attrs.parsed);
+    Stream<xpu> *s = ctx.get_stream<xpu>();
+    const int size = static_cast<int>(inputs[0].Size());
+    MSHADOW_REAL_TYPE_SWITCH(inputs[0].type_flag_, DType, {
+        // the clipped gradient, then the two sums of squares
+        Tensor<xpu, 1, DType> workspace =
+            ctx.requested[0].get_space_typed<xpu, 1, DType>(
+                Shape1(size + 2), s);
+        DType *grad = workspace.dptr_;
+        DType *norms = grad + size;
+        const DType *weight = inputs[0].dptr<DType>();
+        Kernel<ClipGradKernel, xpu>::Launch(
+            s, size, grad, inputs[1].dptr<DType>(),
+            static_cast<DType>(param.clip_gradient),
+            static_cast<DType>(param.rescale_grad));
+        SumOfSquares(s, weight, size, norms);
+        SumOfSquares(s, static_cast<const DType *>(grad), size, norms + 1);
+        Kernel<LARSMomKernel, xpu>::Launch(
+            s, size, outputs[0].dptr<DType>(), inputs[2].dptr<DType>(),
+            weight, static_cast<const DType *>(grad),
+            static_cast<const DType *>(norms),
+            static_cast<DType>(param.momentum), static_cast<DType>(param.lr),
+            static_cast<DType>(param.eta), static_cast<DType>(param.epsilon),
+            static_cast<DType>(param.wd), req[0]);
+    });
+}
+
+struct LAMBParam : public dmlc::Parameter<LAMBParam> {
+    float lr;
+    float beta1;
+    float beta2;
+    float epsilon;
+    int t;
+    bool bias_correction;
+    float lower_bound;
+    float upper_bound;
+    float wd;
+    float rescale_grad;
+    float clip_gradient;
+    DMLC_DECLARE_PARAMETER(LAMBParam) {
+        DMLC_DECLARE_FIELD(lr).describe("Learning rate");
+        DMLC_DECLARE_FIELD(beta1)
+            .set_default(0.9f)
+            .describe("The decay rate for the 1st moment estimates.");
+        DMLC_DECLARE_FIELD(beta2)
+            .set_default(0.999f)
+            .describe("The decay rate for the 2nd moment estimates.");
+        DMLC_DECLARE_FIELD(epsilon)
+            .set_default(1e-6f)
+            .describe("A small constant for numerical stability.");
+        DMLC_DECLARE_FIELD(t)
+            .set_default(1)
+            .set_lower_bound(1)
+            .describe("Index of the update, from 1, for the bias correction.");
+        DMLC_DECLARE_FIELD(bias_correction)
+            .set_default(true)
+            .describe("Whether to correct the bias of the moment estimates.");
+        DMLC_DECLARE_FIELD(lower_bound)
+            .set_default(-1.0f)
+            .describe(
+                "Lower bound of the weight norm in the trust ratio, if "
+                "positive.");
+        DMLC_DECLARE_FIELD(upper_bound)
+            .set_default(-1.0f)
+            .describe(
+                "Upper bound of the weight norm in the trust ratio, if "
+                "positive.");
+        DMLC_DECLARE_FIELD(wd)
+            .set_default(0.0f)
+            .describe(
+                "Weight decay augments the objective function with a "
+                "regularization term that penalizes large weights. "
+                "The penalty scales with the square of the magnitude of each "
+                "weight.");
+        DMLC_DECLARE_FIELD(rescale_grad)
+            .set_default(1.0f)
+            .describe("Rescale gradient to grad = rescale_grad*grad.");
+        DMLC_DECLARE_FIELD(clip_gradient)
+            .set_default(-1.0f)
+            .describe(
+                "Clip gradient to the range of [-clip_gradient, clip_gradient] "
+                "If clip_gradient <= 0, gradient clipping is turned off. "
+                "grad = max(min(grad, clip_gradient), -clip_gradient).");
+    }
+};
+
+/*! \brief the moments of LAMB, and the direction of its step into r */
+struct LAMBDirectionKernel {
+    template <typename DType>
+    MSHADOW_XINLINE static void Map(
+        int i, DType *r_data, DType *mean_data, DType *var_data,
+        const DType *weight_data, const DType *grad_data,
+        const DType param_clip_gradient, const DType param_beta1,
+        const DType param_beta2, const DType param_epsilon,
+        const DType param_wd, const DType param_rescale_grad,
+        const DType mean_scale, const DType var_scale) {
+        DType grad = param_rescale_grad * grad_data[i];
+        if (param_clip_gradient >= 0.0f) {
+            grad = mshadow_op::clip::Map(grad, param_clip_gradient);
+        }
+        mean_data[i] = param_beta1 * mean_data[i] + (1.f - param_beta1) * grad;
+        var_data[i] =
+            param_beta2 * var_data[i] + (1.f - param_beta2) * grad * grad;
+        r_data[i] =
+            mean_scale * mean_data[i] /
+                (mshadow_op::square_root::Map(var_scale * var_data[i]) +
+                 param_epsilon) +
+            param_wd * weight_data[i];
+    }
+};
+
+/*!
+ * \brief The step of LAMB along r, given the sums of the squares of the
+ *  weight and of r in norms.
+ */
+struct LAMBStepKernel {
+    template <typename DType>
+    MSHADOW_XINLINE static void Map(int i, DType *out_data,
+                                    const DType *weight_data,
+                                    const DType *r_data, const DType *norms,
+                                    const DType param_lr,
+                                    const DType param_lower_bound,
+                                    const DType param_upper_bound,
+                                    const OpReqType req) {
+        DType weight_norm = mshadow_op::square_root::Map(norms[0]);
+        const DType r_norm = mshadow_op::square_root::Map(norms[1]);
+        if (param_lower_bound > 0.0f && weight_norm < param_lower_bound) {
+            weight_norm = param_lower_bound;
+        }
+        if (param_upper_bound > 0.0f && weight_norm > param_upper_bound) {
+            weight_norm = param_upper_bound;
+        }
+        const DType ratio = weight_norm > 0.0f && r_norm > 0.0f
+                                ? weight_norm / r_norm
+                                : DType(1.0f);
+        KERNEL_ASSIGN(out_data[i], req,
+                      weight_data[i] - param_lr * ratio * r_data[i]);
+    }
+};
+
+template <typename xpu>
+inline void LAMBUpdate(const nnvm::NodeAttrs &attrs, const OpContext &ctx,
+                       const std::vector<TBlob> &inputs,
+                       const std::vector<OpReqType> &req,
+                       const std::vector<TBlob> &outputs) {
+    using namespace mxnet_op;
+    const LAMBParam &param = nnvm::get<LAMBParam>(attrs.parsed);
+    Stream<xpu> *s = ctx.get_stream<xpu>();
+    const int size = static_cast<int>(inputs[0].Size());
+    float mean_scale = 1.0f, var_scale = 1.0f;
+    if (param.bias_correction) {
+        mean_scale = 1.0f / (1.0f - std::pow(param.beta1, param.t));
+        var_scale = 1.0f / (1.0f - std::pow(param.beta2, param.t));
+    }
+    MSHADOW_REAL_TYPE_SWITCH(inputs[0].type_flag_, DType, {
+        // the direction of the step, then the two sums of squares
+        Tensor<xpu, 1, DType> workspace =
+            ctx.requested[0].get_space_typed<xpu, 1, DType>(
+                Shape1(size + 2), s);
+        DType *r = workspace.dptr_;
+        DType *norms = r + size;
+        const DType *weight = inputs[0].dptr<DType>();
+        Kernel<LAMBDirectionKernel, xpu>::Launch(
+            s, size, r, inputs[2].dptr<DType>(), inputs[3].dptr<DType>(),
+            weight, inputs[1].dptr<DType>(),
+            static_cast<DType>(param.clip_gradient),
+            static_cast<DType>(param.beta1), static_cast<DType>(param.beta2),
+            static_cast<DType>(param.epsilon), static_cast<DType>(param.wd),
+            static_cast<DType>(param.rescale_grad),
+            static_cast<DType>(mean_scale), static_cast<DType>(var_scale));
+        SumOfSquares(s, weight, size, norms);
+        SumOfSquares(s, static_cast<const DType *>(r), size, norms + 1);
+        Kernel<LAMBStepKernel, xpu>::Launch(
+            s, size, outputs[0].dptr<DType>(), weight,
+            static_cast<const DType *>(r), static_cast<const DType *>(norms),
+            static_cast<DType>(param.lr),
+            static_cast<DType>(param.lower_bound),
+            static_cast<DType>(param.upper_bound), req[0]);
+    });
+}
+
+/*!
+ * \brief skip_row[i] = 1 if row i of the gradient, seen as rows of row_size
+ *  elements, is all zero, as for the rows of an embedding that no sample of
+ *  the batch looks up. A lazy update leaves such rows alone.
+ */
+struct LazySkipRowKernel {
+    template <typename DType>
+    MSHADOW_XINLINE static void Map(int i, int *skip_row,
+                                    const DType *grad_data,
+                                    const int row_size) {
+        int skip = 1;
+        for (int j = i * row_size; j < (i + 1) * row_size; ++j) {
+            if (grad_data[j] != 0.0f) {
+                skip = 0;
+                break;
+            }
+        }
+        skip_row[i] = skip;
+    }
+};
+
+/*!
+ * \brief view of a weight or gradient as (shape[0], -1), so that the rows a
+ *  lazy update skips run along its first axis
+ */
+template <typename xpu, typename DType>
+inline mshadow::Tensor<xpu, 2, DType> LazyRowsView(const TBlob &blob,
+                                                   mshadow::Stream<xpu> *s) {
+    const index_t rows = blob.shape_[0];
+    const index_t row_size = rows == 0 ? 0 : blob.shape_.Size() / rows;
+    return blob.get_with_shape<xpu, 2, DType>(mshadow::Shape2(rows, row_size),
+                                              s);
+}
+
+/*!
+ * \brief the rows of grad, a (rows, row_size) matrix, a lazy update skips,
+ *  in temp space; NULL if the update is not lazy
+ */
+template <typename xpu, typename DType>
+inline const int *LazySkipRows(const OpContext &ctx,
+                               const mshadow::Tensor<xpu, 2, DType> &grad,
+                               bool lazy_update) {
+    using namespace mshadow;
+    using namespace mxnet_op;
+    if (!lazy_update || grad.shape_.Size() == 0) return NULL;
+    Stream<xpu> *s = ctx.get_stream<xpu>();
+    Tensor<xpu, 1, int> skip_row =
+        ctx.requested[0].get_space_typed<xpu, 1, int>(Shape1(grad.shape_[0]),
+                                                      s);
+    Kernel<LazySkipRowKernel, xpu>::Launch(s, grad.shape_[0], skip_row.dptr_,
+                                           grad.dptr_,
+                                           static_cast<int>(grad.shape_[1]));
+    return skip_row.dptr_;
+}
+
+struct AdagradParam : public dmlc::Parameter<AdagradParam> {
+    float lr;
+    float epsilon;
+    float wd;
+    float rescale_grad;
+    float clip_gradient;
+    bool lazy_update;
+    DMLC_DECLARE_PARAMETER(AdagradParam) {
+        DMLC_DECLARE_FIELD(lr).describe("Learning rate");
+        DMLC_DECLARE_FIELD(epsilon)
+            .set_default(1e-7f)
+            .describe("A small constant for numerical stability.");
+        DMLC_DECLARE_FIELD(wd)
+            .set_default(0.0f)
+            .describe(
+                "Weight decay augments the objective function with a "
+                "regularization term that penalizes large weights. "
+                "The penalty scales with the square of the magnitude of each "
+                "weight.");
+        DMLC_DECLARE_FIELD(rescale_grad)
+            .set_default(1.0f)
+            .describe("Rescale gradient to grad = rescale_grad*grad.");
+        DMLC_DECLARE_FIELD(clip_gradient)
+            .set_default(-1.0f)
+            .describe(
+                "Clip gradient to the range of [-clip_gradient, clip_gradient] "
+                "If clip_gradient <= 0, gradient clipping is turned off. "
+                "grad = max(min(grad, clip_gradient), -clip_gradient).");
+        DMLC_DECLARE_FIELD(lazy_update)
+            .set_default(false)
+            .describe(
+                "If true, rows of the weight whose gradient is all zero, "
+                "along the first axis, are not updated, not even by the "
+                "weight decay.");
+    }
+};
+
+/*!
+ * \brief the Adagrad update of element i of the weight, left alone if
+ *  skip_row is not NULL and flags its row of row_size elements
+ */
+struct AdagradKernel {
+    template <typename DType>
+    MSHADOW_XINLINE static void Map(
+        int i, DType *out_data, DType *history_data, const DType *weight_data,
+        const DType *grad_data, const int *skip_row, const int row_size,
+        const DType param_clip_gradient, const DType param_lr,
+        const DType param_epsilon, const DType param_wd,
+        const DType param_rescale_grad, const OpReqType req) {
+        if (skip_row != NULL && skip_row[i / row_size]) {
+            KERNEL_ASSIGN(out_data[i], req, weight_data[i]);
+            return;
+        }
+        DType grad = param_rescale_grad * grad_data[i];
+        if (param_clip_gradient >= 0.0f) {
+            grad = mshadow_op::clip::Map(grad, param_clip_gradient);
+        }
+        history_data[i] += grad * grad;
+        KERNEL_ASSIGN(
+            out_data[i], req,
+            weight_data[i] -
+                param_lr * (grad / mshadow_op::square_root::Map(
+                                       history_data[i] + param_epsilon) +
+                            param_wd * weight_data[i]));
+    }
+};
+
+template <typename xpu>
+inline void AdagradUpdate(const nnvm::NodeAttrs &attrs, const OpContext &ctx,
+                          const std::vector<TBlob> &inputs,
+                          const std::vector<OpReqType> &req,
+                          const std::vector<TBlob> &outputs) {
+    using namespace mxnet_op;
+    const AdagradParam &param = nnvm::get<AdagradParam>(attrs.parsed);
+    Stream<xpu> *s = ctx.get_stream<xpu>();
+    MSHADOW_REAL_TYPE_SWITCH(inputs[0].type_flag_, DType, {
+        Tensor<xpu, 2, DType> weight = LazyRowsView<xpu, DType>(inputs[0], s);
+        Tensor<xpu, 2, DType> grad = LazyRowsView<xpu, DType>(inputs[1], s);
+        const int *skip_row = LazySkipRows(ctx, grad, param.lazy_update);
+        Kernel<AdagradKernel, xpu>::Launch(
+            s, weight.shape_.Size(), outputs[0].dptr<DType>(),
+            inputs[2].dptr<DType>(), weight.dptr_, grad.dptr_, skip_row,
+            static_cast<int>(weight.shape_[1]),
+            static_cast<DType>(param.clip_gradient),
+            static_cast<DType>(param.lr), static_cast<DType>(param.epsilon),
+            static_cast<DType>(param.wd),
+            static_cast<DType>(param.rescale_grad), req[0]);
+    });
+}
+
+struct FtrlParam : public dmlc::Parameter<FtrlParam> {
+    float lr;
+    float lamda1;
+    float beta;
+    float wd;
+    float rescale_grad;
+    float clip_gradient;
+    bool lazy_update;
+    DMLC_DECLARE_PARAMETER(FtrlParam) {
+        DMLC_DECLARE_FIELD(lr).describe("Learning rate");
+        DMLC_DECLARE_FIELD(lamda1)
+            .set_default(0.01f)
+            .describe("The L1 regularization coefficient.");
+        DMLC_DECLARE_FIELD(beta)
+            .set_default(1.0f)
+            .describe("Per-coordinate learning rate correlation parameter.");
+        DMLC_DECLARE_FIELD(wd)
+            .set_default(0.0f)
+            .describe(
+                "Weight decay augments the objective function with a "
+                "regularization term that penalizes large weights. "
+                "The penalty scales with the square of the magnitude of each "
+                "weight.");
+        DMLC_DECLARE_FIELD(rescale_grad)
+            .set_default(1.0f)
+            .describe("Rescale gradient to grad = rescale_grad*grad.");
+        DMLC_DECLARE_FIELD(clip_gradient)
+            .set_default(-1.0f)
+            .describe(
+                "Clip gradient to the range of [-clip_gradient, clip_gradient] "
+                "If clip_gradient <= 0, gradient clipping is turned off. "
+                "grad = max(min(grad, clip_gradient), -clip_gradient).");
+        DMLC_DECLARE_FIELD(lazy_update)
+            .set_default(false)
+            .describe(
+                "If true, rows of the weight whose gradient is all zero, "
+                "along the first axis, are not updated.");
+    }
+};
+
+/*!
+ * \brief the FTRL-proximal update of element i of the weight, left alone if
+ *  skip_row is not NULL and flags its row of row_size elements
+ */
+struct FtrlKernel {
+    template <typename DType>
+    MSHADOW_XINLINE static void Map(
+        int i, DType *out_data, DType *z_data, DType *n_data,
+        const DType *weight_data, const DType *grad_data,
+        const int *skip_row, const int row_size,
+        const DType param_clip_gradient, const DType param_lr,
+        const DType param_lamda1, const DType param_beta,
+        const DType param_wd, const DType param_rescale_grad,
+        const OpReqType req) {
+        if (skip_row != NULL && skip_row[i / row_size]) {
+            KERNEL_ASSIGN(out_data[i], req, weight_data[i]);
+            return;
+        }
+        DType grad = param_rescale_grad * grad_data[i];
+        if (param_clip_gradient >= 0.0f) {
+            grad = mshadow_op::clip::Map(grad, param_clip_gradient);
+        }
+        const DType n = n_data[i] + grad * grad;
+        z_data[i] += grad - (mshadow_op::square_root::Map(n) -
+                             mshadow_op::square_root::Map(n_data[i])) *
+                                weight_data[i] / param_lr;
+        n_data[i] = n;
+        const DType z = z_data[i];
+        const DType weight =
+            mshadow_op::abs::Map(z) > param_lamda1
+                ? (mshadow_op::sign::Map(z) * param_lamda1 - z) /
+                      ((param_beta + mshadow_op::square_root::Map(n)) /
+                           param_lr +
+                       param_wd)
+                : DType(0.0f);
+        KERNEL_ASSIGN(out_data[i], req, weight);
+    }
+};
+
+template <typename xpu>
+inline void FtrlUpdate(const nnvm::NodeAttrs &attrs, const OpContext &ctx,
+                       const std::vector<TBlob> &inputs,
+                       const std::vector<OpReqType> &req,
+                       const std::vector<TBlob> &outputs) {
+    using namespace mxnet_op;
+    const FtrlParam &param = nnvm::get<FtrlParam>(attrs.parsed);
+    Stream<xpu> *s = ctx.get_stream<xpu>();
+    MSHADOW_REAL_TYPE_SWITCH(inputs[0].type_flag_, DType, {
+        Tensor<xpu, 2, DType> weight = LazyRowsView<xpu, DType>(inputs[0], s);
+        Tensor<xpu, 2, DType> grad = LazyRowsView<xpu, DType>(inputs[1], s);
+        const int *skip_row = LazySkipRows(ctx, grad, param.lazy_update);
+        Kernel<FtrlKernel, xpu>::Launch(
+            s, weight.shape_.Size(), outputs[0].dptr<DType>(),
+            inputs[2].dptr<DType>(), inputs[3].dptr<DType>(), weight.dptr_,
+            grad.dptr_, skip_row, static_cast<int>(weight.shape_[1]),
+            static_cast<DType>(param.clip_gradient),
+            static_cast<DType>(param.lr), static_cast<DType>(param.lamda1),
+            static_cast<DType>(param.beta), static_cast<DType>(param.wd),
+            static_cast<DType>(param.rescale_grad), req[0]);
+    });
+}
+
 }  // namespace op
 }  // namespace mxnet
 
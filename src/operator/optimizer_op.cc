@@ -14,6 +14,13 @@ DMLC_REGISTER_PARAMETER(SGDMomParam);
 DMLC_REGISTER_PARAMETER(AdamParam);
 DMLC_REGISTER_PARAMETER(RMSPropParam);
 DMLC_REGISTER_PARAMETER(RMSPropAlexParam);
+DMLC_REGISTER_PARAMETER(MultiSGDParam);
+DMLC_REGISTER_PARAMETER(MultiSGDMomParam);
+DMLC_REGISTER_PARAMETER(MultiAdamParam);
+DMLC_REGISTER_PARAMETER(LARSParam);
+DMLC_REGISTER_PARAMETER(LAMBParam);
+DMLC_REGISTER_PARAMETER(AdagradParam);
+DMLC_REGISTER_PARAMETER(FtrlParam);
 
 NNVM_REGISTER_OP(sgd_update)
     .describe(
@@ -199,5 +206,264 @@ to be 0.9 and the learning rate :math:`\eta` to be 0.0001.
     .add_argument("delta", "NDArray-or-Symbol", "delta")
     .add_arguments(RMSPropAlexParam::__FIELDS__());
 
+NNVM_REGISTER_OP(multi_sgd_update)
+    .describe(R"code(Update function for Stochastic Gradient Descent (SGD)
+optimizer over many weights at once.
+
+The inputs are ``weight_0, grad_0, weight_1, grad_1, ...``, and every weight is
+updated as by ``sgd_update`` with its own learning rate in ``lrs`` and weight
+decay in ``wds``. All the weights are updated by one operator, which saves the
+cost of scheduling one operator per weight when there are many small ones.
+
+If ``clip_global_norm`` is positive and the 2-norm of all the rescaled
+gradients together exceeds it, the gradients are first scaled down by
+``clip_global_norm / norm``.
+
+)code" ADD_FILELINE)
+    .set_num_inputs(MultiUpdateNumInputs<MultiSGDParam, 0>)
+    .set_num_outputs(MultiUpdateNumOutputs<MultiSGDParam>)
+    .set_attr_parser(ParamParser<MultiSGDParam>)
+    .set_attr<nnvm::FListInputNames>(
+        "FListInputNames",
+        [](const nnvm::NodeAttrs& attrs) {
+            return MultiUpdateInputNames<MultiSGDParam>(attrs, {});
+        })
+    .set_attr<nnvm::FInferShape>("FInferShape",
+                                 MultiUpdateShape<MultiSGDParam, 0>)
+    .set_attr<nnvm::FInferType>("FInferType", MultiUpdateType)
+    .set_attr<FResourceRequest>("FResourceRequest",
+                                [](const NodeAttrs& attrs) {
+                                    return std::vector<ResourceRequest>{
+                                        ResourceRequest::kTempSpace};
+                                })
+    .set_attr<FCompute>("FCompute<cpu>", MultiSGDUpdate<cpu>)
+    .add_argument("data", "NDArray-or-Symbol[]",
+                  "Weights and gradients, interleaved")
+    .add_arguments(MultiSGDParam::__FIELDS__());
+
+NNVM_REGISTER_OP(multi_sgd_mom_update)
+    .describe(R"code(Momentum update function for Stochastic Gradient Descent
+(SGD) optimizer over many weights at once.
+
+The inputs are ``weight_0, grad_0, mom_0, weight_1, grad_1, mom_1, ...``, and
+every weight is updated as by ``sgd_mom_update`` with its own learning rate in
+``lrs`` and weight decay in ``wds``. All the weights are updated by one
+operator, which saves the cost of scheduling one operator per weight when there
+are many small ones.
+
+If ``clip_global_norm`` is positive and the 2-norm of all the rescaled
+gradients together exceeds it, the gradients are first scaled down by
+``clip_global_norm / norm``.
+
+)code" ADD_FILELINE)
+    .set_num_inputs(MultiUpdateNumInputs<MultiSGDMomParam, 1>)
+    .set_num_outputs(MultiUpdateNumOutputs<MultiSGDMomParam>)
+    .set_attr_parser(ParamParser<MultiSGDMomParam>)
+    .set_attr<nnvm::FListInputNames>(
+        "FListInputNames",
+        [](const nnvm::NodeAttrs& attrs) {
+            return MultiUpdateInputNames<MultiSGDMomParam>(attrs, {"mom"});
+        })
+    .set_attr<nnvm::FInferShape>("FInferShape",
+                                 MultiUpdateShape<MultiSGDMomParam, 1>)
+    .set_attr<nnvm::FInferType>("FInferType", MultiUpdateType)
+    .set_attr<nnvm::FMutateInputs>("FMutateInputs",
+                                   MultiUpdateMutateInputs<MultiSGDMomParam, 1>)
+    .set_attr<FResourceRequest>("FResourceRequest",
+                                [](const NodeAttrs& attrs) {
+                                    return std::vector<ResourceRequest>{
+                                        ResourceRequest::kTempSpace};
+                                })
+    .set_attr<FCompute>("FCompute<cpu>", MultiSGDMomUpdate<cpu>)
+    .add_argument("data", "NDArray-or-Symbol[]",
+                  "Weights, gradients and momentums, interleaved")
+    .add_arguments(MultiSGDMomParam::__FIELDS__());
+
+NNVM_REGISTER_OP(multi_adam_update)
+    .describe(R"code(Update function for Adam optimizer over many weights at
+once.
+
+The inputs are ``weight_0, grad_0, mean_0, var_0, weight_1, ...``, and every
+weight is updated as by ``adam_update`` with its own learning rate in ``lrs``
+and weight decay in ``wds``. The gradients are not modified. All the weights
+are updated by one operator, which saves the cost of scheduling one operator
+per weight when there are many small ones.
+
+If ``clip_global_norm`` is positive and the 2-norm of all the rescaled
+gradients together exceeds it, the gradients are first scaled down by
+``clip_global_norm / norm``.
+
+)code" ADD_FILELINE)
+    .set_num_inputs(MultiUpdateNumInputs<MultiAdamParam, 2>)
+    .set_num_outputs(MultiUpdateNumOutputs<MultiAdamParam>)
+    .set_attr_parser(ParamParser<MultiAdamParam>)
+    .set_attr<nnvm::FListInputNames>(
+        "FListInputNames",
+        [](const nnvm::NodeAttrs& attrs) {
+            return MultiUpdateInputNames<MultiAdamParam>(attrs,
+                                                         {"mean", "var"});
+        })
+    .set_attr<nnvm::FInferShape>("FInferShape",
+                                 MultiUpdateShape<MultiAdamParam, 2>)
+    .set_attr<nnvm::FInferType>("FInferType", MultiUpdateType)
+    .set_attr<nnvm::FMutateInputs>("FMutateInputs",
+                                   MultiUpdateMutateInputs<MultiAdamParam, 2>)
+    .set_attr<FResourceRequest>("FResourceRequest",
+                                [](const NodeAttrs& attrs) {
+                                    return std::vector<ResourceRequest>{
+                                        ResourceRequest::kTempSpace};
+                                })
+    .set_attr<FCompute>("FCompute<cpu>", MultiAdamUpdate<cpu>)
+    .add_argument("data", "NDArray-or-Symbol[]",
+                  "Weights, gradients, means and variances, interleaved")
+    .add_arguments(MultiAdamParam::__FIELDS__());
+
+NNVM_REGISTER_OP(lars_mom_update)
+    .describe(R"code(Momentum update function for Layer-wise Adaptive Rate
+Scaling (LARS), for training with large batches.
+
+The learning rate of every layer is scaled by a trust ratio of the norm of its
+weight to the norm of its gradient, where the gradient is rescaled and clipped.
+It updates the weights using::
+
+  ratio = eta * norm(weight) / (norm(grad) + wd * norm(weight) + epsilon)
+  mom = momentum * mom - lr * ratio * (grad + wd * weight)
+  weight += mom
+
+The ratio is 1 if either norm is zero. LARS is described in *Large Batch
+Training of Convolutional Networks*, available at
+https://arxiv.org/abs/1708.03888.
+
+)code" ADD_FILELINE)
+    .set_num_inputs(3)
+    .set_num_outputs(1)
+    .set_attr_parser(ParamParser<LARSParam>)
+    .set_attr<nnvm::FInferShape>("FInferShape", ElemwiseShape<3, 1>)
+    .set_attr<nnvm::FInferType>("FInferType", ElemwiseType<3, 1>)
+    .set_attr<nnvm::FMutateInputs>("FMutateInputs",
+                                   [](const nnvm::NodeAttrs& attrs) {
+                                       return std::vector<uint32_t>{2};
+                                   })
+    .set_attr<FResourceRequest>("FResourceRequest",
+                                [](const NodeAttrs& attrs) {
+                                    return std::vector<ResourceRequest>{
+                                        ResourceRequest::kTempSpace};
+                                })
+    .set_attr<FCompute>("FCompute<cpu>", LARSMomUpdate<cpu>)
+    .add_argument("weight", "NDArray-or-Symbol", "Weight")
+    .add_argument("grad", "NDArray-or-Symbol", "Gradient")
+    .add_argument("mom", "NDArray-or-Symbol", "Momentum")
+    .add_arguments(LARSParam::__FIELDS__());
+
+NNVM_REGISTER_OP(lamb_update)
+    .describe(R"code(Update function for the LAMB optimizer, Adam with a
+layer-wise trust ratio, for training with large batches.
+
+It updates the weights using::
+
+  m = beta1 * m + (1 - beta1) * grad
+  v = beta2 * v + (1 - beta2) * grad**2
+  r = m_hat / (sqrt(v_hat) + epsilon) + wd * weight
+  weight -= lr * norm(weight) / norm(r) * r
+
+where ``m_hat`` and ``v_hat`` are ``m`` and ``v`` divided by ``1 - beta1**t``
+and ``1 - beta2**t`` if ``bias_correction`` is set, and themselves otherwise.
+The norm of the weight is clipped to ``[lower_bound, upper_bound]`` where those
+are positive, and the ratio is 1 if either norm is zero. LAMB is described in
+*Large Batch Optimization for Deep Learning: Training BERT in 76 minutes*,
+available at https://arxiv.org/abs/1904.00962.
+
+)code" ADD_FILELINE)
+    .set_num_inputs(4)
+    .set_num_outputs(1)
+    .set_attr_parser(ParamParser<LAMBParam>)
+    .set_attr<nnvm::FInferShape>("FInferShape", ElemwiseShape<4, 1>)
+    .set_attr<nnvm::FInferType>("FInferType", ElemwiseType<4, 1>)
+    .set_attr<nnvm::FMutateInputs>("FMutateInputs",
+                                   [](const nnvm::NodeAttrs& attrs) {
+                                       return std::vector<uint32_t>{2, 3};
+                                   })
+    .set_attr<FResourceRequest>("FResourceRequest",
+                                [](const NodeAttrs& attrs) {
+                                    return std::vector<ResourceRequest>{
+                                        ResourceRequest::kTempSpace};
+                                })
+    .set_attr<FCompute>("FCompute<cpu>", LAMBUpdate<cpu>)
+    .add_argument("weight", "NDArray-or-Symbol", "Weight")
+    .add_argument("grad", "NDArray-or-Symbol", "Gradient")
+    .add_argument("mean", "NDArray-or-Symbol", "Moving mean")
+    .add_argument("var", "NDArray-or-Symbol", "Moving variance")
+    .add_arguments(LAMBParam::__FIELDS__());
+
+NNVM_REGISTER_OP(adagrad_update)
+    .describe(R"code(Update function for AdaGrad optimizer.
+
+It updates the weights using::
+
+  history += grad**2
+  weight -= lr * (grad / sqrt(history + epsilon) + wd * weight)
+
+With ``lazy_update``, the rows of the weight along its first axis whose
+gradient is all zero, such as the rows of an embedding no sample looked up, are
+left as they are, and so is their history.
+
+)code" ADD_FILELINE)
+    .set_num_inputs(3)
+    .set_num_outputs(1)
+    .set_attr_parser(ParamParser<AdagradParam>)
+    .set_attr<nnvm::FInferShape>("FInferShape", ElemwiseShape<3, 1>)
+    .set_attr<nnvm::FInferType>("FInferType", ElemwiseType<3, 1>)
+    .set_attr<nnvm::FMutateInputs>("FMutateInputs",
+                                   [](const nnvm::NodeAttrs& attrs) {
+                                       return std::vector<uint32_t>{2};
+                                   })
+    .set_attr<FResourceRequest>("FResourceRequest",
+                                [](const NodeAttrs& attrs) {
+                                    return std::vector<ResourceRequest>{
+                                        ResourceRequest::kTempSpace};
+                                })
+    .set_attr<FCompute>("FCompute<cpu>", AdagradUpdate<cpu>)
+    .add_argument("weight", "NDArray-or-Symbol", "Weight")
+    .add_argument("grad", "NDArray-or-Symbol", "Gradient")
+    .add_argument("history", "NDArray-or-Symbol", "Sum of squared gradients")
+    .add_arguments(AdagradParam::__FIELDS__());
+
+NNVM_REGISTER_OP(ftrl_update)
+    .describe(R"code(Update function for the FTRL-proximal optimizer.
+
+It updates the weights using::
+
+  z += grad - (sqrt(n + grad**2) - sqrt(n)) * weight / lr
+  n += grad**2
+  weight = (sign(z) * lamda1 - z) / ((beta + sqrt(n)) / lr + wd) * (abs(z) > lamda1)
+
+With ``lazy_update``, the rows of the weight along its first axis whose
+gradient is all zero, such as the rows of an embedding no sample looked up, are
+left as they are, and so are their ``z`` and ``n``. FTRL-proximal is described
+in *Ad Click Prediction: a View from the Trenches*, available at
+http://dl.acm.org/citation.cfm?id=2488200.
+
+)code" ADD_FILELINE)
+    .set_num_inputs(4)
+    .set_num_outputs(1)
+    .set_attr_parser(ParamParser<FtrlParam>)
+    .set_attr<nnvm::FInferShape>("FInferShape", ElemwiseShape<4, 1>)
+    .set_attr<nnvm::FInferType>("FInferType", ElemwiseType<4, 1>)
+    .set_attr<nnvm::FMutateInputs>("FMutateInputs",
+                                   [](const nnvm::NodeAttrs& attrs) {
+                                       return std::vector<uint32_t>{2, 3};
+                                   })
+    .set_attr<FResourceRequest>("FResourceRequest",
+                                [](const NodeAttrs& attrs) {
+                                    return std::vector<ResourceRequest>{
+                                        ResourceRequest::kTempSpace};
+                                })
+    .set_attr<FCompute>("FCompute<cpu>", FtrlUpdate<cpu>)
+    .add_argument("weight", "NDArray-or-Symbol", "Weight")
+    .add_argument("grad", "NDArray-or-Symbol", "Gradient")
+    .add_argument("z", "NDArray-or-Symbol", "z")
+    .add_argument("n", "NDArray-or-Symbol", "Square of grad")
+    .add_arguments(FtrlParam::__FIELDS__());
+
 }  // namespace op
 }  // namespace mxnet
@@ -24,5 +24,26 @@ NNVM_REGISTER_OP(rmsprop_update)
 NNVM_REGISTER_OP(rmspropalex_update)
 .set_attr<FCompute>("FCompute<gpu>", RMSPropAlexUpdate<gpu>);
 
+NNVM_REGISTER_OP(multi_sgd_update)
+.set_attr<FCompute>("FCompute<gpu>", MultiSGDUpdate<gpu>);
+
+NNVM_REGISTER_OP(multi_sgd_mom_update)
+.set_attr<FCompute>("FCompute<gpu>", MultiSGDMomUpdate<gpu>);
+
+NNVM_REGISTER_OP(multi_adam_update)
+.set_attr<FCompute>("FCompute<gpu>", MultiAdamUpdate<gpu>);
+
+NNVM_REGISTER_OP(lars_mom_update)
+.set_attr<FCompute>("FCompute<gpu>", LARSMomUpdate<gpu>);
+
+NNVM_REGISTER_OP(lamb_update)
+.set_attr<FCompute>("FCompute<gpu>", LAMBUpdate<gpu>);
+
+NNVM_REGISTER_OP(adagrad_update)
+.set_attr<FCompute>("FCompute<gpu>", AdagradUpdate<gpu>);
+
+NNVM_REGISTER_OP(ftrl_update)
+.set_attr<FCompute>("FCompute<gpu>", FtrlUpdate<gpu>);
+
 }  // namespace op
 }  // namespace mxnet
@@ -14,6 +14,7 @@
 #include <algorithm>
 #include <map>
 #include <string>
+#include <type_traits>
 #include <utility>
 #include <vector>
 #include "./nn/pool.h"
@@ -85,6 +86,15 @@ class PoolingOp : public Operator {
         Stream<xpu>* s = ctx.get_stream<xpu>();
         const TShape& ishape = in_data[pool_enum::kData].shape_;
 
+        // cpu max pooling for training keeps the argmax of each window for
+        // the backward; elsewhere the backward rescans the windows
+        int32_t* mask = NULL;
+        mask_valid_ = std::is_same<xpu, cpu>::value && ctx.is_train &&
+                      param_.pool_type == pool_enum::kMaxPooling;
+        if (mask_valid_) {
+            mask_.resize(out_data[pool_enum::kOut].Size());
+            mask = mask_.data();
+        }
         pool(s, in_data[pool_enum::kData].dptr<DType>(),
              in_data[pool_enum::kData].shape_, out_data[pool_enum::kOut].shape_,
              param_.global_pool
@@ -94,7 +104,7 @@ class PoolingOp : public Operator {
              param_.pad,
              param_.global_pool ? TShape(param_.kernel.ndim()) : param_.stride,
              param_.pool_type, req[pool_enum::kOut],
-             out_data[pool_enum::kOut].dptr<DType>());
+             out_data[pool_enum::kOut].dptr<DType>(), mask);
     }
 
     virtual void Backward(const OpContext& ctx,
@@ -125,11 +135,16 @@ class PoolingOp : public Operator {
             param_.pad,
             param_.global_pool ? TShape(param_.kernel.ndim()) : param_.stride,
             param_.pool_type, req[pool_enum::kData],
-            in_grad[pool_enum::kData].dptr<DType>());
+            in_grad[pool_enum::kData].dptr<DType>(),
+            mask_valid_ ? mask_.data() : NULL);
     }
 
    private:
     PoolingParam param_;
+    /*! \brief argmax index of each window of the last forward */
+    std::vector<int32_t> mask_;
+    /*! \brief whether the last forward of this operator filled mask_ */
+    bool mask_valid_{false};
 };  // class PoolingOp
 
 template <typename xpu>
@@ -9,6 +9,7 @@
 #include <mshadow/packet-inl.h>
 #include <mshadow/tensor.h>
 #include <cassert>
+#include <vector>
 #include "./roi_pooling-inl.h"
 
 using std::max;
@@ -36,13 +37,20 @@ inline void ROIPoolForward(const Tensor<cpu, 4, Dtype> &out,
     const int num_rois = bbox.size(0);
     const int batch_size = data.size(0);
     const int data_size = data.size(1) * data.size(2) * data.size(3);
-    // For each ROI R = [batch_index x1 y1 x2 y2]: max pool over R
+    const int channel_size = height_ * width_;
+    const int pooled_size = pooled_height_ * pooled_width_;
+    // The pooling regions of a ROI are the same in all its channels: for
+    // every ROI, the [start, end) pairs of its pooled rows then columns
+    const int bins_size = 2 * (pooled_height_ + pooled_width_);
+    std::vector<int> bins(num_rois * bins_size);
+#pragma omp parallel for
     for (int n = 0; n < num_rois; ++n) {
-        int roi_batch_ind = bottom_rois[0];
-        int roi_start_w = round(bottom_rois[1] * spatial_scale_);
-        int roi_start_h = round(bottom_rois[2] * spatial_scale_);
-        int roi_end_w = round(bottom_rois[3] * spatial_scale_);
-        int roi_end_h = round(bottom_rois[4] * spatial_scale_);
+        const Dtype *roi = bottom_rois + n * bbox.size(1);
+        int roi_batch_ind = roi[0];
+        int roi_start_w = round(roi[1] * spatial_scale_);
+        int roi_start_h = round(roi[2] * spatial_scale_);
+        int roi_end_w = round(roi[3] * spatial_scale_);
+        int roi_end_h = round(roi[4] * spatial_scale_);
         assert(roi_batch_ind >= 0);
         assert(roi_batch_ind < batch_size);
 
@@ -54,56 +62,67 @@ inline void ROIPoolForward(const Tensor<cpu, 4, Dtype> &out,
         const Dtype bin_size_w =
             static_cast<Dtype>(roi_width) / static_cast<Dtype>(pooled_width_);
 
-        const Dtype *batch_data = bottom_data + data_size * roi_batch_ind;
-
-        for (int c = 0; c < channels_; ++c) {
-            for (int ph = 0; ph < pooled_height_; ++ph) {
-                for (int pw = 0; pw < pooled_width_; ++pw) {
-                    // Compute pooling region for this output unit:
-                    //  start (included) = floor(ph * roi_height /
-                    //  pooled_height_)
-                    //  end (excluded) = ceil((ph + 1) * roi_height /
-                    //  pooled_height_)
-                    int hstart = static_cast<int>(
-                        floor(static_cast<Dtype>(ph) * bin_size_h));
-                    int wstart = static_cast<int>(
-                        floor(static_cast<Dtype>(pw) * bin_size_w));
-                    int hend = static_cast<int>(
-                        ceil(static_cast<Dtype>(ph + 1) * bin_size_h));
-                    int wend = static_cast<int>(
-                        ceil(static_cast<Dtype>(pw + 1) * bin_size_w));
-
-                    hstart = min(max(hstart + roi_start_h, 0), height_);
-                    hend = min(max(hend + roi_start_h, 0), height_);
-                    wstart = min(max(wstart + roi_start_w, 0), width_);
-                    wend = min(max(wend + roi_start_w, 0), width_);
-
-                    bool is_empty = (hend <= hstart) || (wend <= wstart);
-
-                    const int pool_index = ph * pooled_width_ + pw;
-                    if (is_empty) {
-                        top_data[pool_index] = 0;
-                        argmax_data[pool_index] = -1;
-                    }
+        // Compute pooling region for each output unit:
+        //  start (included) = floor(ph * roi_height / pooled_height_)
+        //  end (excluded) = ceil((ph + 1) * roi_height / pooled_height_)
+        int *roi_bins = &bins[n * bins_size];
+        for (int ph = 0; ph < pooled_height_; ++ph) {
+            int hstart =
+                static_cast<int>(floor(static_cast<Dtype>(ph) * bin_size_h));
+            int hend = static_cast<int>(
+                ceil(static_cast<Dtype>(ph + 1) * bin_size_h));
+            roi_bins[2 * ph] = min(max(hstart + roi_start_h, 0), height_);
+            roi_bins[2 * ph + 1] = min(max(hend + roi_start_h, 0), height_);
+        }
+        roi_bins += 2 * pooled_height_;
+        for (int pw = 0; pw < pooled_width_; ++pw) {
+            int wstart =
+                static_cast<int>(floor(static_cast<Dtype>(pw) * bin_size_w));
+            int wend = static_cast<int>(
+                ceil(static_cast<Dtype>(pw + 1) * bin_size_w));
+            roi_bins[2 * pw] = min(max(wstart + roi_start_w, 0), width_);
+            roi_bins[2 * pw + 1] = min(max(wend + roi_start_w, 0), width_);
+        }
+    }
 
-                    for (int h = hstart; h < hend; ++h) {
-                        for (int w = wstart; w < wend; ++w) {
-                            const int index = h * width_ + w;
-                            if (batch_data[index] > top_data[pool_index]) {
-                                top_data[pool_index] = batch_data[index];
-                                argmax_data[pool_index] = index;
-                            }
+    // For each ROI R = [batch_index x1 y1 x2 y2]: max pool over R, one
+    // channel of one ROI at a time
+    const int num_planes = num_rois * channels_;
+#pragma omp parallel for
+    for (int i = 0; i < num_planes; ++i) {
+        const int n = i / channels_, c = i % channels_;
+        int roi_batch_ind = bottom_rois[n * bbox.size(1)];
+        const Dtype *batch_data =
+            bottom_data + data_size * roi_batch_ind + c * channel_size;
+        Dtype *top = top_data + i * pooled_size;
+        Dtype *argmax = argmax_data + i * pooled_size;
+        const int *hbins = &bins[n * bins_size];
+        const int *wbins = hbins + 2 * pooled_height_;
+        for (int ph = 0; ph < pooled_height_; ++ph) {
+            const int hstart = hbins[2 * ph], hend = hbins[2 * ph + 1];
+            for (int pw = 0; pw < pooled_width_; ++pw) {
+                const int wstart = wbins[2 * pw], wend = wbins[2 * pw + 1];
+                const int pool_index = ph * pooled_width_ + pw;
+                if ((hend <= hstart) || (wend <= wstart)) {
+                    top[pool_index] = 0;
+                    argmax[pool_index] = -1;
+                    continue;
+                }
+                Dtype best = top[pool_index];
+                int best_index = argmax[pool_index];
+                for (int h = hstart; h < hend; ++h) {
+                    for (int w = wstart; w < wend; ++w) {
+                        const int index = h * width_ + w;
+                        if (batch_data[index] > best) {
+                            best = batch_data[index];
+                            best_index = index;
                         }
                     }
                 }
+                top[pool_index] = best;
+                argmax[pool_index] = best_index;
             }
-            // Increment all data pointers by one channel
-            batch_data += data.size(2) * data.size(3);
-            top_data += out.size(2) * out.size(3);
-            argmax_data += max_idx.size(2) * max_idx.size(3);
         }
-        // Increment ROI data pointer
-        bottom_rois += bbox.size(1);
     }
 
     return;
@@ -126,92 +145,46 @@ inline void ROIPoolBackwardAcc(const Tensor<cpu, 4, Dtype> &in_grad,
     const int width_ = in_grad.size(3);
     const int pooled_height_ = out_grad.size(2);
     const int pooled_width_ = out_grad.size(3);
+    const int pooled_size = pooled_height_ * pooled_width_;
 
     const int num_rois = bbox.size(0);
 
-    for (int b = 0; b < batch_size_; ++b) {
-        for (int c = 0; c < channels_; ++c) {
-            for (int h = 0; h < height_; ++h) {
-                for (int w = 0; w < width_; ++w) {
-                    int offset_bottom_diff =
-                        (b * channels_ + c) * height_ * width_;
-                    offset_bottom_diff += h * width_ + w;
-
-                    Dtype gradient = 0;
-                    // Accumulate gradient over all ROIs that pooled this
-                    // element
-                    for (int roi_n = 0; roi_n < num_rois; ++roi_n) {
-                        const Dtype *offset_bottom_rois =
-                            bottom_rois + roi_n * 5;
-                        int roi_batch_ind = offset_bottom_rois[0];
-                        assert(roi_batch_ind >= 0);
-                        assert(roi_batch_ind < batch_size_);
-                        if (b != roi_batch_ind) {
-                            continue;
-                        }
-
-                        int roi_start_w =
-                            round(offset_bottom_rois[1] * spatial_scale_);
-                        int roi_start_h =
-                            round(offset_bottom_rois[2] * spatial_scale_);
-                        int roi_end_w =
-                            round(offset_bottom_rois[3] * spatial_scale_);
-                        int roi_end_h =
-                            round(offset_bottom_rois[4] * spatial_scale_);
-
-                        bool in_roi = (w >= roi_start_w && w <= roi_end_w &&
-                                       h >= roi_start_h && h <= roi_end_h);
-                        if (!in_roi) {
-                            continue;
-                        }
-
-                        // force malformed ROIs to be 1 * 1
-                        int roi_height = max(roi_end_h - roi_start_h + 1, 1);
-                        int roi_width = max(roi_end_w - roi_start_w + 1, 1);
-                        const Dtype bin_size_h =
-                            static_cast<Dtype>(roi_height) /
-                            static_cast<Dtype>(pooled_height_);
-                        const Dtype bin_size_w =
-                            static_cast<Dtype>(roi_width) /
-                            static_cast<Dtype>(pooled_width_);
-
-                        // compute pooled regions correspond to original (h, w)
-                        // point
-                        int phstart = static_cast<int>(floor(
-                            static_cast<Dtype>(h - roi_start_h) / bin_size_h));
-                        int pwstart = static_cast<int>(floor(
-                            static_cast<Dtype>(w - roi_start_w) / bin_size_w));
-                        int phend = static_cast<int>(
-                            ceil(static_cast<Dtype>(h - roi_start_h + 1) /
-                                 bin_size_h));
-                        int pwend = static_cast<int>(
-                            ceil(static_cast<Dtype>(w - roi_start_w + 1) /
-                                 bin_size_w));
-
-                        // clip to boundaries of pooled region
-                        phstart = min(max(phstart, 0), pooled_height_);
-                        phend = min(max(phend, 0), pooled_height_);
-                        pwstart = min(max(pwstart, 0), pooled_width_);
-                        pwend = min(max(pwend, 0), pooled_width_);
+    // Each pooled element passes its gradient to the input element it took
+    // the maximum of. A thread owns one channel of one image, and goes
+    // through the ROIs of that image, so no two threads add to one element.
+    const int num_planes = batch_size_ * channels_;
+#pragma omp parallel for
+    for (int i = 0; i < num_planes; ++i) {
+        const int b = i / channels_, c = i % channels_;
+        Dtype *plane = bottom_diff + i * height_ * width_;
+        for (int roi_n = 0; roi_n < num_rois; ++roi_n) {
+            const Dtype *offset_bottom_rois = bottom_rois + roi_n * 5;
+            int roi_batch_ind = offset_bottom_rois[0];
+            assert(roi_batch_ind >= 0);
+            assert(roi_batch_ind < batch_size_);
+            if (b != roi_batch_ind) {
+                continue;
+            }
 
-                        // accumulate over gradients in pooled regions
-                        int offset = (roi_n * channels_ + c) * pooled_height_ *
-                                     pooled_width_;
-                        const Dtype *offset_top_diff = top_diff + offset;
-                        const Dtype *offset_argmax_data = argmax_data + offset;
-                        for (int ph = phstart; ph < phend; ++ph) {
-                            for (int pw = pwstart; pw < pwend; ++pw) {
-                                const int pooled_index =
-                                    ph * pooled_width_ + pw;
-                                if (static_cast<int>(
-                                        offset_argmax_data[pooled_index]) ==
-                                    h * width_ + w) {
-                                    gradient += offset_top_diff[pooled_index];
-                                }
-                            }
-                        }
-                    }
-                    bottom_diff[offset_bottom_diff] += gradient;
+            int roi_start_w = round(offset_bottom_rois[1] * spatial_scale_);
+            int roi_start_h = round(offset_bottom_rois[2] * spatial_scale_);
+            int roi_end_w = round(offset_bottom_rois[3] * spatial_scale_);
+            int roi_end_h = round(offset_bottom_rois[4] * spatial_scale_);
+
+            const int offset = (roi_n * channels_ + c) * pooled_size;
+            const Dtype *offset_top_diff = top_diff + offset;
+            const Dtype *offset_argmax_data = argmax_data + offset;
+            for (int j = 0; j < pooled_size; ++j) {
+                const int index = static_cast<int>(offset_argmax_data[j]);
+                if (index < 0) {
+                    continue;
+                }
+                // as on gpu, only elements inside the ROI get gradient
+                const int h = index / width_, w = index % width_;
+                bool in_roi = (w >= roi_start_w && w <= roi_end_w &&
+                               h >= roi_start_h && h <= roi_end_h);
+                if (in_roi) {
+                    plane[index] += offset_top_diff[j];
                 }
             }
         }
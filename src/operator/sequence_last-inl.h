@@ -30,6 +30,7 @@ enum SequenceLastOpOutputs { kOut };
 
 struct SequenceLastParam : public dmlc::Parameter<SequenceLastParam> {
     bool use_sequence_length;
+    bool packed;
     DMLC_DECLARE_PARAMETER(SequenceLastParam) {
         DMLC_DECLARE_FIELD(use_sequence_length)
             .set_default(false)
@@ -37,6 +38,13 @@ struct SequenceLastParam : public dmlc::Parameter<SequenceLastParam> {
                 "If set to true, this layer takes in an extra input parameter "
                 "`sequence_length` "
                 "to specify variable length sequence");
+        DMLC_DECLARE_FIELD(packed)
+            .set_default(false)
+            .describe(
+                "If set to true, `data` is the packed output of "
+                "`pack_sequence` and this layer takes its `batch_sizes` and "
+                "`sorted_indices` outputs as extra inputs instead of "
+                "`sequence_length`");
     }
 };
 
@@ -53,9 +61,13 @@ class SequenceLastOp : public Operator {
         using namespace mshadow;
         using namespace mshadow::expr;
 
-        CHECK_EQ(in_data.size(), param_.use_sequence_length ? 2U : 1U);
+        CHECK_EQ(in_data.size(), SequenceNumInputs(param_));
         CHECK_EQ(out_data.size(), 1U);
         Stream<xpu> *s = ctx.get_stream<xpu>();
+        if (param_.packed) {
+            ForwardPacked(s, in_data, req, out_data);
+            return;
+        }
 
         // Get any size input + output into required form
         index_t n = in_data[seq_last::kData].size(1);
@@ -96,12 +108,16 @@ class SequenceLastOp : public Operator {
         using namespace mshadow;
         using namespace mshadow::expr;
         CHECK_EQ(out_grad.size(), 1U);
-        CHECK_EQ(in_data.size(), param_.use_sequence_length ? 2U : 1U);
+        CHECK_EQ(in_data.size(), SequenceNumInputs(param_));
 
         // break immediately if null grad
         if (req[seq_last::kData] == kNullOp) return;
 
         Stream<xpu> *s = ctx.get_stream<xpu>();
+        if (param_.packed) {
+            BackwardPacked(s, out_grad, in_data, req, in_grad);
+            return;
+        }
 
         // Get any size input + output into required form
         index_t n = in_grad[seq_last::kData].size(1);
@@ -132,6 +148,53 @@ class SequenceLastOp : public Operator {
     }
 
    private:
+    // the last row of the sequence at position j is in its last step
+    void ForwardPacked(mshadow::Stream<xpu> *s,
+                       const std::vector<TBlob> &in_data,
+                       const std::vector<OpReqType> &req,
+                       const std::vector<TBlob> &out_data) {
+        using namespace mshadow;
+        const SequencePacking packing = PackedInputOf<xpu, DType>(in_data, s);
+        const TBlob &packed = in_data[seq_packed::kData];
+        const index_t n = packing.order.size();
+        const index_t width = packed.Size() / packed.size(0);
+        Tensor<xpu, 2, DType> data = packed.get_with_shape<xpu, 2, DType>(
+            Shape2(packed.size(0), width), s);
+        Tensor<xpu, 2, DType> out =
+            out_data[seq_last::kOut].get_with_shape<xpu, 2, DType>(
+                Shape2(n, width), s);
+        if (req[seq_last::kOut] == kWriteTo) out = 0.0f;
+        for (index_t j = 0; j < n; ++j) {
+            const index_t len = packing.Length(j);
+            if (len == 0) continue;
+            out[packing.order[j]] += data[packing.offsets[len - 1] + j];
+        }
+    }
+
+    void BackwardPacked(mshadow::Stream<xpu> *s,
+                        const std::vector<TBlob> &out_grad,
+                        const std::vector<TBlob> &in_data,
+                        const std::vector<OpReqType> &req,
+                        const std::vector<TBlob> &in_grad) {
+        using namespace mshadow;
+        const SequencePacking packing = PackedInputOf<xpu, DType>(in_data, s);
+        const TBlob &grad = in_grad[seq_packed::kData];
+        const index_t n = packing.order.size();
+        const index_t width = grad.Size() / grad.size(0);
+        Tensor<xpu, 2, DType> data_grad = grad.get_with_shape<xpu, 2, DType>(
+            Shape2(grad.size(0), width), s);
+        Tensor<xpu, 2, DType> output_grad =
+            out_grad[seq_last::kOut].get_with_shape<xpu, 2, DType>(
+                Shape2(n, width), s);
+        if (req[seq_last::kData] == kWriteTo) data_grad = 0.0f;
+        for (index_t j = 0; j < n; ++j) {
+            const index_t len = packing.Length(j);
+            if (len == 0) continue;
+            data_grad[packing.offsets[len - 1] + j] +=
+                output_grad[packing.order[j]];
+        }
+    }
+
     SequenceLastParam param_;
 };  // class SequenceLastOp
 
@@ -144,10 +207,7 @@ class SequenceLastProp : public OperatorProperty {
     int NumOutputs() const override { return 1; }
 
     std::vector<std::string> ListArguments() const override {
-        if (param_.use_sequence_length)
-            return {"data", "sequence_length"};
-        else
-            return {"data"};
+        return SequenceArguments(param_);
     }
 
     std::vector<std::string> ListOutputs() const override { return {"output"}; }
@@ -155,6 +215,9 @@ class SequenceLastProp : public OperatorProperty {
     void Init(const std::vector<std::pair<std::string, std::string>> &kwargs)
         override {
         param_.Init(kwargs);
+        CHECK(!param_.packed || !param_.use_sequence_length)
+            << "packed data carries its sequence lengths, "
+            << "use_sequence_length must not be set";
     }
 
     std::map<std::string, std::string> GetParams() const override {
@@ -165,8 +228,18 @@ class SequenceLastProp : public OperatorProperty {
                     std::vector<TShape> *out_shape,
                     std::vector<TShape> *aux_shape) const override {
         using namespace mshadow;
-        CHECK_EQ(in_shape->size(), param_.use_sequence_length ? 2U : 1U)
-            << "Input:[data, sequence_length]";
+        CHECK_EQ(in_shape->size(), SequenceNumInputs(param_))
+            << (param_.packed ? "Input:[data, batch_sizes, sorted_indices]"
+                              : "Input:[data, sequence_length]");
+        if (param_.packed) {
+            if (!PackedInputShape(in_shape)) return false;
+            const TShape &dshape = (*in_shape)[seq_packed::kData];
+            TShape oshape = dshape;
+            oshape[0] = (*in_shape)[seq_packed::kSortedIndices][0];
+            out_shape->clear();
+            out_shape->push_back(oshape);
+            return true;
+        }
 
         const TShape &dshape = (*in_shape)[seq_last::kData];
         CHECK_GT(dshape.ndim(), 2U)
@@ -188,7 +261,7 @@ class SequenceLastProp : public OperatorProperty {
 
     bool InferType(std::vector<int> *in_type, std::vector<int> *out_type,
                    std::vector<int> *aux_type) const override {
-        CHECK_GE(in_type->size(), param_.use_sequence_length ? 2U : 1U);
+        CHECK_GE(in_type->size(), SequenceNumInputs(param_));
         int dtype = (*in_type)[0];
         CHECK_NE(dtype, -1) << "First input must have specified type";
         for (index_t i = 0; i < in_type->size(); ++i) {
@@ -217,7 +290,11 @@ class SequenceLastProp : public OperatorProperty {
     std::vector<int> DeclareBackwardDependency(
         const std::vector<int> &out_grad, const std::vector<int> &in_data,
         const std::vector<int> &out_data) const override {
-        if (param_.use_sequence_length)
+        if (param_.packed)
+            return {out_grad[seq_last::kOut],
+                    in_data[seq_packed::kBatchSizes],
+                    in_data[seq_packed::kSortedIndices]};
+        else if (param_.use_sequence_length)
             return {out_grad[seq_last::kOut],
                     in_data[seq_last::kSequenceLength]};
         else
@@ -41,6 +41,10 @@ an input array of positive ints of dimension [batch_size]. To use this parameter
 set `use_sequence_length` to `True`, otherwise each example in the batch is assumed
 to have the max sequence length.
 
+With `packed` set to `True`, `data` is the output of `pack_sequence` and
+`batch_sizes` and `sorted_indices` are its other two outputs. Only the packed
+rows are read.
+
 .. note:: Alternatively, you can also use `take` operator.
 
 Example::
@@ -80,6 +84,10 @@ Example::
                   " batch_size, other_feature_dims] where n>2")
     .add_argument("sequence_length", "NDArray-or-Symbol",
                   "vector of sequence lengths of the form [batch_size]")
+    .add_argument("batch_sizes", "NDArray-or-Symbol",
+                  "with `packed`, the batch_sizes output of pack_sequence")
+    .add_argument("sorted_indices", "NDArray-or-Symbol",
+                  "with `packed`, the sorted_indices output of pack_sequence")
     .add_arguments(SequenceLastParam::__FIELDS__());
 
 }  // namespace op
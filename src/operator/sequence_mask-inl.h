@@ -19,6 +19,7 @@
 #include "./mshadow_op.h"
 #include "./operator_common.h"
 #include "./operator_common.h"
+#include "./sequence_op_common.h"
 
 namespace mxnet {
 namespace op {
@@ -30,6 +31,7 @@ enum SequenceMaskOpOutputs { kOut };
 
 struct SequenceMaskParam : public dmlc::Parameter<SequenceMaskParam> {
     bool use_sequence_length;
+    bool packed;
     float value;
     DMLC_DECLARE_PARAMETER(SequenceMaskParam) {
         DMLC_DECLARE_FIELD(use_sequence_length)
@@ -38,6 +40,13 @@ struct SequenceMaskParam : public dmlc::Parameter<SequenceMaskParam> {
                 "If set to true, this layer takes in an extra input parameter "
                 "`sequence_length` "
                 "to specify variable length sequence");
+        DMLC_DECLARE_FIELD(packed)
+            .set_default(false)
+            .describe(
+                "If set to true, `data` is the packed output of "
+                "`pack_sequence` and this layer takes its `batch_sizes` and "
+                "`sorted_indices` outputs as extra inputs instead of "
+                "`sequence_length`");
         DMLC_DECLARE_FIELD(value)
             .set_default(0.)
             .describe("The value to be used as a mask.");
@@ -56,9 +65,23 @@ class SequenceMaskOp : public Operator {
                          const std::vector<TBlob> &aux_args) {
         using namespace mshadow;
         using namespace mshadow::expr;
-        CHECK_EQ(in_data.size(), param_.use_sequence_length ? 2U : 1U);
+        CHECK_EQ(in_data.size(), SequenceNumInputs(param_));
         CHECK_EQ(out_data.size(), 1U);
         Stream<xpu> *s = ctx.get_stream<xpu>();
+        if (param_.packed) {
+            // only the rows past the packed ones are padding
+            Tensor<xpu, 2, DType> data, out;
+            const index_t rows = PackedRows(s, in_data, in_data, out_data,
+                                            &data, &out);
+            if (rows > 0) {
+                Assign(out.Slice(0, rows), req[seq_mask::kOut],
+                       F<mshadow_op::identity>(data.Slice(0, rows)));
+            }
+            if (rows < out.size(0)) {
+                out.Slice(rows, out.size(0)) = static_cast<DType>(param_.value);
+            }
+            return;
+        }
 
         // Get any size input + output into required form
         int max_seq_len = in_data[seq_mask::kData].size(0);
@@ -89,8 +112,23 @@ class SequenceMaskOp : public Operator {
         using namespace mshadow;
         using namespace mshadow::expr;
         CHECK_EQ(out_grad.size(), 1U);
-        CHECK_EQ(in_data.size(), param_.use_sequence_length ? 2U : 1U);
+        CHECK_EQ(in_data.size(), SequenceNumInputs(param_));
         Stream<xpu> *s = ctx.get_stream<xpu>();
+        if (param_.packed) {
+            Tensor<xpu, 2, DType> output_grad, data_grad;
+            const index_t rows = PackedRows(s, in_data, out_grad, in_grad,
+                                            &output_grad, &data_grad);
+            const OpReqType grad_req = req[seq_mask::kData];
+            if (rows > 0) {
+                Assign(data_grad.Slice(0, rows), grad_req,
+                       F<mshadow_op::identity>(output_grad.Slice(0, rows)));
+            }
+            if (rows < data_grad.size(0) && grad_req != kNullOp &&
+                grad_req != kAddTo) {
+                data_grad.Slice(rows, data_grad.size(0)) = DType(0);
+            }
+            return;
+        }
 
         // Get any size input + output into required form
         int max_seq_len = in_grad[seq_mask::kData].size(0);
@@ -116,6 +154,21 @@ class SequenceMaskOp : public Operator {
     }
 
    private:
+    // src and dst as (rows, width) matrices; returns the packed rows
+    index_t PackedRows(mshadow::Stream<xpu> *s,
+                       const std::vector<TBlob> &in_data,
+                       const std::vector<TBlob> &src_blobs,
+                       const std::vector<TBlob> &dst_blobs,
+                       mshadow::Tensor<xpu, 2, DType> *src,
+                       mshadow::Tensor<xpu, 2, DType> *dst) {
+        const TBlob &packed = src_blobs[0];
+        const mshadow::Shape<2> s2 =
+            mshadow::Shape2(packed.size(0), packed.Size() / packed.size(0));
+        *src = packed.get_with_shape<xpu, 2, DType>(s2, s);
+        *dst = dst_blobs[0].get_with_shape<xpu, 2, DType>(s2, s);
+        return PackedInputOf<xpu, DType>(in_data, s).Rows();
+    }
+
     SequenceMaskParam param_;
 };  // class SequenceMaskOp
 
@@ -130,10 +183,7 @@ class SequenceMaskProp : public OperatorProperty {
     int NumOutputs() const override { return 1; }
 
     std::vector<std::string> ListArguments() const override {
-        if (param_.use_sequence_length)
-            return {"data", "sequence_length"};
-        else
-            return {"data"};
+        return SequenceArguments(param_);
     }
 
     std::vector<std::string> ListOutputs() const override { return {"output"}; }
@@ -141,6 +191,9 @@ class SequenceMaskProp : public OperatorProperty {
     void Init(const std::vector<std::pair<std::string, std::string> > &kwargs)
         override {
         param_.Init(kwargs);
+        CHECK(!param_.packed || !param_.use_sequence_length)
+            << "packed data carries its sequence lengths, "
+            << "use_sequence_length must not be set";
     }
 
     std::map<std::string, std::string> GetParams() const override {
@@ -151,8 +204,15 @@ class SequenceMaskProp : public OperatorProperty {
                     std::vector<TShape> *out_shape,
                     std::vector<TShape> *aux_shape) const override {
         using namespace mshadow;
-        CHECK_EQ(in_shape->size(), param_.use_sequence_length ? 2U : 1U)
-            << "Input:[data, sequence_length]";
+        CHECK_EQ(in_shape->size(), SequenceNumInputs(param_))
+            << (param_.packed ? "Input:[data, batch_sizes, sorted_indices]"
+                              : "Input:[data, sequence_length]");
+        if (param_.packed) {
+            if (!PackedInputShape(in_shape)) return false;
+            out_shape->clear();
+            out_shape->push_back((*in_shape)[seq_packed::kData]);
+            return true;
+        }
 
         const TShape &dshape = (*in_shape)[seq_mask::kData];
         CHECK_GT(dshape.ndim(), 2U)
@@ -170,7 +230,7 @@ class SequenceMaskProp : public OperatorProperty {
 
     bool InferType(std::vector<int> *in_type, std::vector<int> *out_type,
                    std::vector<int> *aux_type) const override {
-        CHECK_GE(in_type->size(), param_.use_sequence_length ? 2U : 1U);
+        CHECK_GE(in_type->size(), SequenceNumInputs(param_));
         int dtype = (*in_type)[0];
         CHECK_NE(dtype, -1) << "First input must have specified type";
         for (index_t i = 0; i < in_type->size(); ++i) {
@@ -199,7 +259,11 @@ class SequenceMaskProp : public OperatorProperty {
     std::vector<int> DeclareBackwardDependency(
         const std::vector<int> &out_grad, const std::vector<int> &in_data,
         const std::vector<int> &out_data) const override {
-        if (param_.use_sequence_length)
+        if (param_.packed)
+            return {out_grad[seq_mask::kOut],
+                    in_data[seq_packed::kBatchSizes],
+                    in_data[seq_packed::kSortedIndices]};
+        else if (param_.use_sequence_length)
             return {out_grad[seq_mask::kOut],
                     in_data[seq_mask::kSequenceLength]};
         else
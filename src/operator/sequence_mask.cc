@@ -11,9 +11,18 @@ namespace mshadow {
 template <typename DType>
 inline void SequenceMask(const Tensor<cpu, 3, DType> &dst,
                          const Tensor<cpu, 1, DType> label, DType value) {
-    for (index_t b = 0; b < dst.size(1); ++b)
-        for (index_t s = label[b]; s < dst.size(0); ++s)
-            for (index_t r = 0; r < dst.size(2); ++r) dst[s][b][r] = value;
+    // only the padding is written, one time step per thread
+    const int max_seq_len = static_cast<int>(dst.size(0));
+#pragma omp parallel for
+    for (int s = 0; s < max_seq_len; ++s) {
+        for (index_t b = 0; b < dst.size(1); ++b) {
+            if (static_cast<index_t>(label[b]) > static_cast<index_t>(s)) {
+                continue;
+            }
+            DType *row = dst[s][b].dptr_;
+            std::fill(row, row + dst.size(2), value);
+        }
+    }
 }
 
 }  // namespace mshadow
@@ -53,6 +62,10 @@ To use this parameter, set `use_sequence_length` to `True`,
 otherwise each example in the batch is assumed to have the max sequence length and
 this operator works as the `identity` operator.
 
+With `packed` set to `True`, `data` is the output of `pack_sequence` and
+`batch_sizes` and `sorted_indices` are its other two outputs. The padding is
+then the rows past the packed ones, and only those are set to `value`.
+
 Example::
 
    x = [[[  1.,   2.,   3.],
@@ -114,6 +127,10 @@ Example::
                   " batch_size, other_feature_dims] where n>2")
     .add_argument("sequence_length", "NDArray-or-Symbol",
                   "vector of sequence lengths of the form [batch_size]")
+    .add_argument("batch_sizes", "NDArray-or-Symbol",
+                  "with `packed`, the batch_sizes output of pack_sequence")
+    .add_argument("sorted_indices", "NDArray-or-Symbol",
+                  "with `packed`, the sorted_indices output of pack_sequence")
     .add_arguments(SequenceMaskParam::__FIELDS__());
 
 }  // namespace op
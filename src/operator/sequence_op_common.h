@@ -8,6 +8,9 @@
 #define MXNET_OPERATOR_SEQUENCE_OP_COMMON_H_
 #include <dmlc/logging.h>
 #include <mxnet/operator.h>
+#include <algorithm>
+#include <numeric>
+#include <string>
 #include <vector>
 #include "./operator_common.h"
 
@@ -40,6 +43,121 @@ void IndexTensorToVector(mshadow::Tensor<cpu, 1, DType> data,
         (*index_vec)[i] = static_cast<index_t>(index_array[i]);
 }
 
+/*!
+ * \brief Layout of a batch of variable-length sequences packed time step by
+ *  time step, as the packed input of cudnn rnn: step t holds the sequences
+ *  longer than t, longest first, so that no padding is stored.
+ */
+struct SequencePacking {
+    /*! \brief batch index of the sequence at every position of a step */
+    std::vector<index_t> order;
+    /*! \brief number of sequences at every time step, non-increasing */
+    std::vector<index_t> batch_sizes;
+    /*! \brief first packed row of every time step, and the number of rows */
+    std::vector<index_t> offsets;
+
+    SequencePacking() {}
+
+    SequencePacking(const std::vector<index_t> &lengths, index_t max_seq_len)
+        : order(lengths.size()),
+          batch_sizes(max_seq_len, 0),
+          offsets(max_seq_len + 1, 0) {
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(),
+                         [&lengths](index_t a, index_t b) {
+                             return lengths[a] > lengths[b];
+                         });
+        for (index_t b : order) {
+            CHECK_LE(lengths[b], max_seq_len)
+                << "sequence_length is larger than the sequence axis";
+            for (index_t t = 0; t < lengths[b]; ++t) ++batch_sizes[t];
+        }
+        for (index_t t = 0; t < max_seq_len; ++t) {
+            offsets[t + 1] = offsets[t] + batch_sizes[t];
+        }
+    }
+
+    /*!
+     * \brief the packing with the given steps, as given by the batch_sizes
+     *  and sorted_indices outputs of pack_sequence
+     */
+    static SequencePacking FromSteps(const std::vector<index_t> &batch_sizes,
+                                     const std::vector<index_t> &order) {
+        SequencePacking packing;
+        packing.order = order;
+        packing.batch_sizes = batch_sizes;
+        packing.offsets.assign(batch_sizes.size() + 1, 0);
+        for (size_t t = 0; t < batch_sizes.size(); ++t) {
+            CHECK_LE(batch_sizes[t], t ? batch_sizes[t - 1] : order.size())
+                << "batch_sizes must be non-increasing and at most the batch";
+            packing.offsets[t + 1] = packing.offsets[t] + batch_sizes[t];
+        }
+        return packing;
+    }
+
+    inline index_t Rows() const { return offsets.back(); }
+
+    /*! \brief length of the sequence at position j of the steps */
+    inline index_t Length(index_t j) const {
+        return std::partition_point(batch_sizes.begin(), batch_sizes.end(),
+                                    [j](index_t n) { return n > j; }) -
+               batch_sizes.begin();
+    }
+};
+
+namespace seq_packed {
+enum SequencePackedInputs { kData, kBatchSizes, kSortedIndices };
+}
+
+/*!
+ * \brief the packing of the packed data input of a sequence op, read from
+ *  its batch_sizes and sorted_indices inputs
+ */
+template <typename xpu, typename DType>
+inline SequencePacking PackedInputOf(const std::vector<TBlob> &in_data,
+                                     mshadow::Stream<xpu> *s) {
+    const TBlob &steps = in_data[seq_packed::kBatchSizes];
+    const TBlob &order = in_data[seq_packed::kSortedIndices];
+    std::vector<index_t> batch_sizes(steps.Size()), sorted(order.Size());
+    IndexTensorToVector(steps.get<xpu, 1, DType>(s), &batch_sizes);
+    IndexTensorToVector(order.get<xpu, 1, DType>(s), &sorted);
+    return SequencePacking::FromSteps(batch_sizes, sorted);
+}
+
+/*!
+ * \brief shape inference of the (data, batch_sizes, sorted_indices) inputs
+ *  of a sequence op on packed data of max_seq_len * batch rows
+ */
+inline bool PackedInputShape(std::vector<TShape> *in_shape) {
+    const TShape &dshape = (*in_shape)[seq_packed::kData];
+    const TShape &steps = (*in_shape)[seq_packed::kBatchSizes];
+    const TShape &order = (*in_shape)[seq_packed::kSortedIndices];
+    if (dshape.ndim() == 0 || steps.ndim() == 0 || order.ndim() == 0) {
+        return false;
+    }
+    CHECK_GE(dshape.ndim(), 2U)
+        << "The packed data array must be of rank 2 or greater.";
+    CHECK_EQ(steps.ndim(), 1U) << "batch_sizes must be a vector.";
+    CHECK_EQ(order.ndim(), 1U) << "sorted_indices must be a vector.";
+    CHECK_EQ(dshape[0], steps[0] * order[0])
+        << "The packed data must have max_seq_len * batch rows";
+    return true;
+}
+
+/*! \brief number of inputs of a sequence op with the given parameters */
+template <typename Param>
+inline index_t SequenceNumInputs(const Param &param) {
+    return param.packed ? 3U : param.use_sequence_length ? 2U : 1U;
+}
+
+/*! \brief input names of a sequence op with the given parameters */
+template <typename Param>
+inline std::vector<std::string> SequenceArguments(const Param &param) {
+    if (param.packed) return {"data", "batch_sizes", "sorted_indices"};
+    if (param.use_sequence_length) return {"data", "sequence_length"};
+    return {"data"};
+}
+
 }  // namespace op
 }  // namespace mxnet
 #endif  // MXNET_OPERATOR_SEQUENCE_OP_COMMON_H_
@@ -30,6 +30,7 @@ enum SequenceReverseOpOutputs { kOut };
 
 struct SequenceReverseParam : public dmlc::Parameter<SequenceReverseParam> {
     bool use_sequence_length;
+    bool packed;
     DMLC_DECLARE_PARAMETER(SequenceReverseParam) {
         DMLC_DECLARE_FIELD(use_sequence_length)
             .set_default(false)
@@ -37,9 +38,124 @@ struct SequenceReverseParam : public dmlc::Parameter<SequenceReverseParam> {
                 "If set to true, this layer takes in an extra input parameter "
                 "`sequence_length` "
                 "to specify variable length sequence");
+        DMLC_DECLARE_FIELD(packed)
+            .set_default(false)
+            .describe(
+                "If set to true, `data` is the packed output of "
+                "`pack_sequence` and this layer takes its `batch_sizes` and "
+                "`sorted_indices` outputs as extra inputs instead of "
+                "`sequence_length`");
     }
 };
 
+/*!
+ * \brief out[s][b] = data[indices[b] - s - 1][b] for s < indices[b], and
+ *  data[s][b] in the padding
+ */
+template <typename xpu, typename DType>
+inline void SequenceReverse(const mshadow::Tensor<xpu, 3, DType> data,
+                            const mshadow::Tensor<xpu, 3, DType> &out,
+                            const std::vector<index_t> &indices,
+                            OpReqType req) {
+    using namespace mshadow;
+    using namespace mshadow::expr;
+    index_t seq_length;
+    index_t max_seq_len = data.size(0);
+    index_t batch_size = data.size(1);
+    for (index_t b = 0; b < batch_size; ++b) {
+        seq_length = indices[b];
+        for (index_t s = 0; s < max_seq_len; ++s) {
+            if (s < seq_length)
+                Assign(out[s][b], req,
+                       F<mshadow_op::identity>(
+                           data[seq_length - s - 1]
+                               [b])) else  // preserve padding type
+                    Assign(out[s][b], req,
+                           F<mshadow_op::identity>(data[s][b]))
+        }
+    }
+}
+
+/*! \brief the rows of one time step per thread, each copied at once */
+template <typename DType>
+inline void SequenceReverse(const mshadow::Tensor<cpu, 3, DType> data,
+                            const mshadow::Tensor<cpu, 3, DType> &out,
+                            const std::vector<index_t> &indices,
+                            OpReqType req) {
+    if (req == kNullOp) return;
+    const int max_seq_len = static_cast<int>(data.size(0));
+    const index_t batch_size = data.size(1), width = data.size(2);
+#pragma omp parallel for
+    for (int s = 0; s < max_seq_len; ++s) {
+        for (index_t b = 0; b < batch_size; ++b) {
+            const index_t seq_length = indices[b];
+            const index_t src =
+                static_cast<index_t>(s) < seq_length ? seq_length - s - 1 : s;
+            const DType *in = data[src][b].dptr_;
+            DType *row = out[s][b].dptr_;
+            if (req == kAddTo) {
+                for (index_t r = 0; r < width; ++r) row[r] += in[r];
+            } else {
+                std::copy(in, in + width, row);
+            }
+        }
+    }
+}
+
+/*!
+ * \brief Reverse every sequence of data packed as in packing: out takes row
+ *  len - t - 1 of the sequence as its row t, and is zero past the packed rows.
+ */
+template <typename xpu, typename DType>
+inline void PackedSequenceReverse(const mshadow::Tensor<xpu, 2, DType> data,
+                                  const mshadow::Tensor<xpu, 2, DType> &out,
+                                  const SequencePacking &packing,
+                                  OpReqType req) {
+    using namespace mshadow;
+    using namespace mshadow::expr;
+    if (req == kNullOp) return;
+    const index_t max_seq_len = packing.batch_sizes.size();
+    for (index_t t = 0; t < max_seq_len; ++t) {
+        for (index_t j = 0; j < packing.batch_sizes[t]; ++j) {
+            const index_t src = packing.offsets[packing.Length(j) - t - 1];
+            Assign(out[packing.offsets[t] + j], req,
+                   F<mshadow_op::identity>(data[src + j]));
+        }
+    }
+    if (req != kAddTo && packing.Rows() < out.size(0)) {
+        out.Slice(packing.Rows(), out.size(0)) = DType(0);
+    }
+}
+
+/*! \brief the packed rows of one time step per thread */
+template <typename DType>
+inline void PackedSequenceReverse(const mshadow::Tensor<cpu, 2, DType> data,
+                                  const mshadow::Tensor<cpu, 2, DType> &out,
+                                  const SequencePacking &packing,
+                                  OpReqType req) {
+    if (req == kNullOp) return;
+    const int max_seq_len = static_cast<int>(packing.batch_sizes.size());
+    const index_t width = data.size(1);
+#pragma omp parallel for
+    for (int t = 0; t < max_seq_len; ++t) {
+        for (index_t j = 0; j < packing.batch_sizes[t]; ++j) {
+            const index_t src = packing.offsets[packing.Length(j) - t - 1];
+            const DType *in = data[src + j].dptr_;
+            DType *row = out[packing.offsets[t] + j].dptr_;
+            if (req == kAddTo) {
+                for (index_t r = 0; r < width; ++r) row[r] += in[r];
+            } else {
+                std::copy(in, in + width, row);
+            }
+        }
+    }
+    if (req != kAddTo) {
+        std::fill(out.dptr_ + static_cast<size_t>(packing.Rows()) * width,
+                  out.dptr_ + static_cast<size_t>(out.size(0)) * width,
+                  DType(0));
+    }
+}
+
 template <typename xpu, typename DType>
 class SequenceReverseOp : public Operator {
    public:
@@ -47,23 +163,7 @@ class SequenceReverseOp : public Operator {
     void sequence_reverse(const mshadow::Tensor<xpu, 3, DType> data,
                           const mshadow::Tensor<xpu, 3, DType> &out,
                           std::vector<index_t> indices, OpReqType req) {
-        using namespace mshadow;
-        using namespace mshadow::expr;
-        index_t seq_length;
-        index_t max_seq_len = data.size(0);
-        index_t batch_size = data.size(1);
-        for (index_t b = 0; b < batch_size; ++b) {
-            seq_length = indices[b];
-            for (index_t s = 0; s < max_seq_len; ++s) {
-                if (s < seq_length)
-                    Assign(out[s][b], req,
-                           F<mshadow_op::identity>(
-                               data[seq_length - s - 1]
-                                   [b])) else  // preserve padding type
-                        Assign(out[s][b], req,
-                               F<mshadow_op::identity>(data[s][b]))
-            }
-        }
+        SequenceReverse(data, out, indices, req);
     }
 
     virtual void Forward(const OpContext &ctx,
@@ -73,9 +173,23 @@ class SequenceReverseOp : public Operator {
                          const std::vector<TBlob> &aux_args) {
         using namespace mshadow;
         using namespace mshadow::expr;
-        CHECK_EQ(in_data.size(), param_.use_sequence_length ? 2U : 1U);
+        CHECK_EQ(in_data.size(), SequenceNumInputs(param_));
         CHECK_EQ(out_data.size(), 1U);
         Stream<xpu> *s = ctx.get_stream<xpu>();
+        if (param_.packed) {
+            const TBlob &packed = in_data[seq_packed::kData];
+            const Shape<2> s2 =
+                Shape2(packed.size(0), packed.Size() / packed.size(0));
+            Tensor<xpu, 2, DType> data =
+                packed.get_with_shape<xpu, 2, DType>(s2, s);
+            Tensor<xpu, 2, DType> out =
+                out_data[seq_reverse::kOut].get_with_shape<xpu, 2, DType>(s2,
+                                                                          s);
+            PackedSequenceReverse(data, out,
+                                  PackedInputOf<xpu, DType>(in_data, s),
+                                  req[seq_reverse::kOut]);
+            return;
+        }
 
         // Get any size input + output into required form
         int max_seq_len = in_data[seq_reverse::kData].size(0);
@@ -109,8 +223,23 @@ class SequenceReverseOp : public Operator {
         using namespace mshadow;
         using namespace mshadow::expr;
         CHECK_EQ(out_grad.size(), 1U);
-        CHECK_EQ(in_data.size(), param_.use_sequence_length ? 2U : 1U);
+        CHECK_EQ(in_data.size(), SequenceNumInputs(param_));
         Stream<xpu> *s = ctx.get_stream<xpu>();
+        if (param_.packed) {
+            // the reverse is its own inverse
+            const TBlob &grad = in_grad[seq_packed::kData];
+            const Shape<2> s2 =
+                Shape2(grad.size(0), grad.Size() / grad.size(0));
+            Tensor<xpu, 2, DType> data_grad =
+                grad.get_with_shape<xpu, 2, DType>(s2, s);
+            Tensor<xpu, 2, DType> output_grad =
+                out_grad[seq_reverse::kOut].get_with_shape<xpu, 2, DType>(s2,
+                                                                          s);
+            PackedSequenceReverse(output_grad, data_grad,
+                                  PackedInputOf<xpu, DType>(in_data, s),
+                                  req[seq_reverse::kData]);
+            return;
+        }
 
         // Get any size input + output into required form
         int max_seq_len = in_grad[seq_reverse::kData].size(0);
@@ -150,10 +279,7 @@ class SequenceReverseProp : public OperatorProperty {
     int NumOutputs() const override { return 1; }
 
     std::vector<std::string> ListArguments() const override {
-        if (param_.use_sequence_length)
-            return {"data", "sequence_length"};
-        else
-            return {"data"};
+        return SequenceArguments(param_);
     }
 
     std::vector<std::string> ListOutputs() const override { return {"output"}; }
@@ -161,6 +287,9 @@ class SequenceReverseProp : public OperatorProperty {
     void Init(const std::vector<std::pair<std::string, std::string> > &kwargs)
         override {
         param_.Init(kwargs);
+        CHECK(!param_.packed || !param_.use_sequence_length)
+            << "packed data carries its sequence lengths, "
+            << "use_sequence_length must not be set";
     }
 
     std::map<std::string, std::string> GetParams() const override {
@@ -171,8 +300,15 @@ class SequenceReverseProp : public OperatorProperty {
                     std::vector<TShape> *out_shape,
                     std::vector<TShape> *aux_shape) const override {
         using namespace mshadow;
-        CHECK_EQ(in_shape->size(), param_.use_sequence_length ? 2U : 1U)
-            << "Input:[data, sequence_length]";
+        CHECK_EQ(in_shape->size(), SequenceNumInputs(param_))
+            << (param_.packed ? "Input:[data, batch_sizes, sorted_indices]"
+                              : "Input:[data, sequence_length]");
+        if (param_.packed) {
+            if (!PackedInputShape(in_shape)) return false;
+            out_shape->clear();
+            out_shape->push_back((*in_shape)[seq_packed::kData]);
+            return true;
+        }
 
         const TShape &dshape = (*in_shape)[seq_reverse::kData];
         CHECK_GT(dshape.ndim(), 2U)
@@ -190,7 +326,7 @@ class SequenceReverseProp : public OperatorProperty {
 
     bool InferType(std::vector<int> *in_type, std::vector<int> *out_type,
                    std::vector<int> *aux_type) const override {
-        CHECK_GE(in_type->size(), param_.use_sequence_length ? 2U : 1U);
+        CHECK_GE(in_type->size(), SequenceNumInputs(param_));
         int dtype = (*in_type)[0];
         CHECK_NE(dtype, -1) << "First input must have specified type";
         for (index_t i = 0; i < in_type->size(); ++i) {
@@ -219,7 +355,11 @@ class SequenceReverseProp : public OperatorProperty {
     std::vector<int> DeclareBackwardDependency(
         const std::vector<int> &out_grad, const std::vector<int> &in_data,
         const std::vector<int> &out_data) const override {
-        if (param_.use_sequence_length)
+        if (param_.packed)
+            return {out_grad[seq_reverse::kOut],
+                    in_data[seq_packed::kBatchSizes],
+                    in_data[seq_packed::kSortedIndices]};
+        else if (param_.use_sequence_length)
             return {out_grad[seq_reverse::kOut],
                     in_data[seq_reverse::kSequenceLength]};
         else
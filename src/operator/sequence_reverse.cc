@@ -40,6 +40,10 @@ Parameter `sequence_length` is used to handle variable-length sequences.
 To use this parameter, set `use_sequence_length` to `True`,
 otherwise each example in the batch is assumed to have the max sequence length.
 
+With `packed` set to `True`, `data` is the output of `pack_sequence` and
+`batch_sizes` and `sorted_indices` are its other two outputs. The output is
+packed the same way, and its rows past the packed ones are zero.
+
 Example::
 
    x = [[[  1.,   2.,   3.],
@@ -101,6 +105,10 @@ Example::
                   " batch_size, other dims] where n>2 ")
     .add_argument("sequence_length", "NDArray-or-Symbol",
                   "vector of sequence lengths of the form [batch_size]")
+    .add_argument("batch_sizes", "NDArray-or-Symbol",
+                  "with `packed`, the batch_sizes output of pack_sequence")
+    .add_argument("sorted_indices", "NDArray-or-Symbol",
+                  "with `packed`, the sorted_indices output of pack_sequence")
     .add_arguments(SequenceReverseParam::__FIELDS__());
 
 }  // namespace op
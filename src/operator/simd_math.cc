@@ -0,0 +1,239 @@
+/*!
+ *  Copyright (c) 2017 by Contributors
+ * \file simd_math.cc
+ * \brief vectorized exp, log, tanh, sigmoid and softrelu over float arrays.
+ *  The polynomials follow the single precision functions of Cephes.
+ */
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include "./simd_math.h"
+
+// compile the loops for several instruction sets, chosen when loading by
+// the features of the cpu; "arch=" clones would only be chosen on exactly
+// the named cpu models
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 7 && \
+    defined(__x86_64__) && defined(__linux__)
+#define MXNET_SIMD_CLONES \
+    __attribute__((target_clones("avx512f", "avx2", "default")))
+// the clones may only inline the kernels if they are forced to, as their
+// instruction set differs from that of the kernels
+#define MXNET_SIMD_KERNEL inline __attribute__((always_inline))
+#else
+#define MXNET_SIMD_CLONES
+#define MXNET_SIMD_KERNEL inline
+#endif
+
+// the selects of the kernels only vectorize if comparisons may be executed
+// speculatively; none of the code here reads the floating point flags
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC optimize("no-trapping-math")
+#endif
+
+namespace mxnet {
+namespace op {
+namespace simd {
+namespace {
+MXNET_SIMD_KERNEL float as_float(int32_t i) {
+    float f;
+    std::memcpy(&f, &i, sizeof(f));
+    return f;
+}
+
+MXNET_SIMD_KERNEL int32_t as_int(float f) {
+    int32_t i;
+    std::memcpy(&i, &f, sizeof(i));
+    return i;
+}
+
+MXNET_SIMD_KERNEL float exp_kernel(float x) {
+    // exp(x) = 2^n * exp(r) with |r| <= ln(2) / 2. Clamping to [lo, hi]
+    // leaves exp(lo) rounding to zero and exp(hi) overflowing to infinity,
+    // and NaN passes through both selects, so the result needs no selects
+    // of its own; those keep the loop from vectorizing with AVX2.
+    const float hi = 89.0f, lo = -104.0f;
+    // selects on values rather than std::min and std::max, whose references
+    // keep the loop from being if-converted
+    float xc = x < lo ? lo : x;
+    xc = xc > hi ? hi : xc;
+    // n = floor(x / ln(2) + 0.5), truncating and correcting negatives
+    const float t = xc * 1.44269504088896341f + 0.5f;
+    int32_t n = static_cast<int32_t>(t);
+    n -= static_cast<float>(n) > t ? 1 : 0;
+    const float nf = static_cast<float>(n);
+    const float r = xc - nf * 0.693359375f + nf * 2.12194440e-4f;
+    float y = 1.9875691500e-4f;
+    y = y * r + 1.3981999507e-3f;
+    y = y * r + 8.3334519073e-3f;
+    y = y * r + 4.1665795894e-2f;
+    y = y * r + 1.6666665459e-1f;
+    y = y * r + 5.0000001201e-1f;
+    y = y * r * r + r + 1.0f;
+    // 2^n in two factors, which stay normal for n in [-150, 128]
+    const uint32_t n1 = static_cast<uint32_t>(n >> 1) + 127;
+    const uint32_t n2 = static_cast<uint32_t>(n - (n >> 1)) + 127;
+    return y * as_float(static_cast<int32_t>(n1 << 23)) *
+           as_float(static_cast<int32_t>(n2 << 23));
+}
+
+MXNET_SIMD_KERNEL float log_kernel(float x) {
+    // log(x) = e * ln(2) + log(m) with m in [sqrt(0.5), sqrt(2))
+    const bool denormal = x < 1.17549435e-38f;
+    const float xs = denormal ? x * 33554432.0f : x;
+    const int32_t bits = as_int(xs);
+    int32_t e = ((bits >> 23) & 0xff) - 126 - (denormal ? 25 : 0);
+    float m = as_float((bits & 0x007fffff) | 0x3f000000);
+    const bool small = m < 0.707106781186547524f;
+    e -= small ? 1 : 0;
+    m = (small ? m + m : m) - 1.0f;
+    const float z = m * m;
+    float y = 7.0376836292e-2f;
+    y = y * m - 1.1514610310e-1f;
+    y = y * m + 1.1676998740e-1f;
+    y = y * m - 1.2420140846e-1f;
+    y = y * m + 1.4249322787e-1f;
+    y = y * m - 1.6668057665e-1f;
+    y = y * m + 2.0000714765e-1f;
+    y = y * m - 2.4999993993e-1f;
+    y = y * m + 3.3333331174e-1f;
+    y = y * m * z;
+    const float ef = static_cast<float>(e);
+    y += ef * -2.12194440e-4f;
+    y -= 0.5f * z;
+    y = m + y + ef * 0.693359375f;
+    const float inf = as_float(0x7f800000);
+    y = x == inf ? inf : y;
+    y = x == 0.0f ? -inf : y;
+    y = x < 0.0f ? as_float(0x7fc00000) : y;
+    return x != x ? x : y;
+}
+
+MXNET_SIMD_KERNEL float tanh_kernel(float x) {
+    const float ax = x < 0.0f ? -x : x;
+    // odd polynomial near zero, 1 - 2 / (exp(2|x|) + 1) elsewhere
+    const float z = x * x;
+    float p = -5.70498872745e-3f;
+    p = p * z + 2.06390887954e-2f;
+    p = p * z - 5.37397155531e-2f;
+    p = p * z + 1.33314422036e-1f;
+    p = p * z - 3.33332819422e-1f;
+    p = p * z * x + x;
+    float q = 1.0f - 2.0f / (exp_kernel(ax + ax) + 1.0f);
+    q = x < 0.0f ? -q : q;
+    return ax < 0.625f ? p : q;
+}
+
+MXNET_SIMD_KERNEL float sigmoid_kernel(float x) {
+    return 1.0f / (1.0f + exp_kernel(-x));
+}
+
+MXNET_SIMD_KERNEL float softrelu_kernel(float x) {
+    // log(1 + exp(x)) = max(x, 0) + log1p(exp(-|x|)), and
+    // log1p(t) = log(u) * t / (u - 1) for u = 1 + t rounded
+    const float t = exp_kernel(x < 0.0f ? x : -x);
+    const float u = 1.0f + t;
+    const float log1p = u == 1.0f ? t : log_kernel(u) * t / (u - 1.0f);
+    return (x > 0.0f ? x : 0.0f) + log1p;
+}
+
+#define MXNET_SIMD_LOOP(name, kernel)                                   \
+    MXNET_SIMD_CLONES void name(const float* in, float* out, int size) { \
+        for (int i = 0; i < size; ++i) out[i] = kernel(in[i]);          \
+    }
+
+MXNET_SIMD_LOOP(ExpBlock, exp_kernel)
+MXNET_SIMD_LOOP(LogBlock, log_kernel)
+MXNET_SIMD_LOOP(TanhBlock, tanh_kernel)
+MXNET_SIMD_LOOP(SigmoidBlock, sigmoid_kernel)
+MXNET_SIMD_LOOP(SoftReLUBlock, softrelu_kernel)
+#undef MXNET_SIMD_LOOP
+
+// reductions keep kLanes partial results, so that they vectorize without
+// reassociating floating point additions
+const int kLanes = 16;
+
+MXNET_SIMD_CLONES float MaxBlock(const float* in, int size) {
+    float lane[kLanes];
+    for (int l = 0; l < kLanes; ++l) lane[l] = in[0];
+    int i = 0;
+    for (; i + kLanes <= size; i += kLanes) {
+        for (int l = 0; l < kLanes; ++l) {
+            lane[l] = in[i + l] > lane[l] ? in[i + l] : lane[l];
+        }
+    }
+    float ret = in[0];
+    for (int l = 0; l < kLanes; ++l) ret = lane[l] > ret ? lane[l] : ret;
+    for (; i < size; ++i) ret = in[i] > ret ? in[i] : ret;
+    return ret;
+}
+
+MXNET_SIMD_CLONES float ExpSumBlock(const float* in, float shift, int size) {
+    float lane[kLanes] = {0.0f};
+    int i = 0;
+    for (; i + kLanes <= size; i += kLanes) {
+        for (int l = 0; l < kLanes; ++l) {
+            lane[l] += exp_kernel(in[i + l] - shift);
+        }
+    }
+    float ret = 0.0f;
+    for (; i < size; ++i) ret += exp_kernel(in[i] - shift);
+    for (int l = 0; l < kLanes; ++l) ret += lane[l];
+    return ret;
+}
+
+MXNET_SIMD_CLONES void ExpScaleBlock(const float* in, float shift,
+                                     float scale, float* out, int size) {
+    for (int i = 0; i < size; ++i) {
+        out[i] = exp_kernel(in[i] - shift) * scale;
+    }
+}
+
+/*! \brief run a vectorized loop over blocks of the array in parallel */
+inline void ParallelBlocks(const float* in, float* out, index_t size,
+                           void (*block)(const float*, float*, int)) {
+    const index_t kBlock = 4096;
+    const index_t nblock = (size + kBlock - 1) / kBlock;
+#pragma omp parallel for if (nblock > 1)
+    for (index_t b = 0; b < nblock; ++b) {
+        const index_t begin = b * kBlock;
+        block(in + begin, out + begin,
+              static_cast<int>(std::min(kBlock, size - begin)));
+    }
+}
+}  // namespace
+
+void Exp(const float* in, float* out, index_t size) {
+    ParallelBlocks(in, out, size, ExpBlock);
+}
+
+void Log(const float* in, float* out, index_t size) {
+    ParallelBlocks(in, out, size, LogBlock);
+}
+
+void Tanh(const float* in, float* out, index_t size) {
+    ParallelBlocks(in, out, size, TanhBlock);
+}
+
+void Sigmoid(const float* in, float* out, index_t size) {
+    ParallelBlocks(in, out, size, SigmoidBlock);
+}
+
+void SoftReLU(const float* in, float* out, index_t size) {
+    ParallelBlocks(in, out, size, SoftReLUBlock);
+}
+
+float Max(const float* in, index_t size) {
+    return MaxBlock(in, static_cast<int>(size));
+}
+
+float ExpSum(const float* in, float shift, index_t size) {
+    return ExpSumBlock(in, shift, static_cast<int>(size));
+}
+
+void ExpScale(const float* in, float shift, float scale, float* out,
+              index_t size) {
+    ExpScaleBlock(in, shift, scale, out, static_cast<int>(size));
+}
+}  // namespace simd
+}  // namespace op
+}  // namespace mxnet
@@ -0,0 +1,92 @@
+/*!
+ *  Copyright (c) 2017 by Contributors
+ * \file simd_math.h
+ * \brief vectorized exp, log, tanh, sigmoid and softrelu over float arrays
+ *  on cpu, and the dispatch of the matching mshadow_op functors to them
+ */
+#ifndef MXNET_OPERATOR_SIMD_MATH_H_
+#define MXNET_OPERATOR_SIMD_MATH_H_
+
+#include <dmlc/parameter.h>
+#include <mxnet/base.h>
+#include <type_traits>
+#include "./mshadow_op.h"
+
+namespace mxnet {
+namespace op {
+namespace simd {
+/*!
+ * \brief Polynomial approximations computed without branches or libm calls,
+ *  so that the loops vectorize. They are compiled for several instruction
+ *  sets where the compiler supports it and picked by the cpu at load time.
+ *  The error is within 1 ulp of the exact result for exp and log and within
+ *  3 ulp for tanh, sigmoid and softrelu.
+ */
+void Exp(const float* in, float* out, index_t size);
+void Log(const float* in, float* out, index_t size);
+void Tanh(const float* in, float* out, index_t size);
+void Sigmoid(const float* in, float* out, index_t size);
+void SoftReLU(const float* in, float* out, index_t size);
+
+/*!
+ * \brief Reductions and maps for softmax, with the same approximation of exp.
+ *  Unlike the functions above they run on the calling thread only, for
+ *  callers that split the work themselves.
+ */
+/*! \brief the maximum of in, which has at least one element */
+float Max(const float* in, index_t size);
+/*! \brief the sum of exp(in[i] - shift) */
+float ExpSum(const float* in, float shift, index_t size);
+/*! \brief out[i] = exp(in[i] - shift) * scale */
+void ExpScale(const float* in, float shift, float scale, float* out,
+              index_t size);
+
+/*! \brief whether MXNET_CPU_SIMD_MATH leaves the vectorized functions on */
+inline bool Enabled() {
+    static const bool enabled = dmlc::GetEnv("MXNET_CPU_SIMD_MATH", true);
+    return enabled;
+}
+}  // namespace simd
+
+/*! \brief the vectorized version of the functor OP, if there is one */
+template <typename OP>
+struct SimdMap {
+    static const bool kEnabled = false;
+    static void Map(const float* in, float* out, index_t size) {}
+};
+
+#define MXNET_SIMD_MAP(OP, FUNC)                                    \
+    template <>                                                     \
+    struct SimdMap<mshadow_op::OP> {                                \
+        static const bool kEnabled = true;                          \
+        static void Map(const float* in, float* out, index_t size) { \
+            simd::FUNC(in, out, size);                              \
+        }                                                           \
+    };
+
+MXNET_SIMD_MAP(exp, Exp)
+MXNET_SIMD_MAP(log, Log)
+MXNET_SIMD_MAP(tanh, Tanh)
+MXNET_SIMD_MAP(sigmoid, Sigmoid)
+MXNET_SIMD_MAP(softrelu, SoftReLU)
+#undef MXNET_SIMD_MAP
+
+/*!
+ * \brief out = OP(in) with the vectorized functions, for float32 data on cpu
+ *  written or overwritten in place.
+ * \return false if OP has no vectorized version for this call, in which case
+ *  nothing is computed
+ */
+template <typename xpu, typename OP>
+inline bool SimdMapTo(const TBlob& in, OpReqType req, const TBlob& out) {
+    if (!std::is_same<xpu, cpu>::value || !SimdMap<OP>::kEnabled ||
+        in.type_flag_ != mshadow::kFloat32 ||
+        (req != kWriteTo && req != kWriteInplace) || !simd::Enabled()) {
+        return false;
+    }
+    SimdMap<OP>::Map(in.dptr<float>(), out.dptr<float>(), in.Size());
+    return true;
+}
+}  // namespace op
+}  // namespace mxnet
+#endif  // MXNET_OPERATOR_SIMD_MATH_H_
@@ -15,6 +15,7 @@
 #include <string>
 #include <utility>
 #include <vector>
+#include "./nn/online_softmax.h"
 #include "./operator_common.h"
 
 namespace mxnet {
@@ -76,6 +77,74 @@ struct SoftmaxOutputParam : public dmlc::Parameter<SoftmaxOutputParam> {
     };
 };
 
+/*! \brief softmax over the rows of data */
+template <typename xpu, typename DType>
+inline void SoftmaxOutputRows(mshadow::Tensor<xpu, 2, DType> out,
+                              const mshadow::Tensor<xpu, 2, DType> &data) {
+    mshadow::Softmax(out, data);
+}
+
+template <typename DType>
+inline void SoftmaxOutputRows(mshadow::Tensor<cpu, 2, DType> out,
+                              const mshadow::Tensor<cpu, 2, DType> &data) {
+    const index_t m = data.size(1);
+    SoftmaxRows(data.dptr_, data.size(0), m,
+                [&](index_t i, index_t begin, index_t size,
+                    const SoftmaxStat<DType> &stat) {
+                    SoftmaxExpScale(data.dptr_ + i * m + begin, stat.max,
+                                    DType(DType(1) / stat.sum),
+                                    out.dptr_ + i * m + begin, size);
+                });
+}
+
+/*!
+ * \brief grad = (out - one_hot(label)) * scale, zero in the rows labelled
+ *  ignore_label if use_ignore, and multiplied by ograd unless it is NULL
+ */
+template <typename xpu, typename DType>
+inline void SoftmaxOutputGrad(mshadow::Tensor<xpu, 2, DType> grad,
+                              const mshadow::Tensor<xpu, 2, DType> &out,
+                              const mshadow::Tensor<xpu, 1, DType> &label,
+                              const SoftmaxOutputParam &param, DType scale,
+                              const mshadow::Tensor<xpu, 2, DType> *ograd) {
+    if (param.use_ignore) {
+        SoftmaxGrad(grad, out, label, static_cast<DType>(param.ignore_label));
+    } else {
+        SoftmaxGrad(grad, out, label);
+    }
+    grad *= scale;
+    if (ograd != NULL) grad *= *ograd;
+}
+
+template <typename DType>
+inline void SoftmaxOutputGrad(mshadow::Tensor<cpu, 2, DType> grad,
+                              const mshadow::Tensor<cpu, 2, DType> &out,
+                              const mshadow::Tensor<cpu, 1, DType> &label,
+                              const SoftmaxOutputParam &param, DType scale,
+                              const mshadow::Tensor<cpu, 2, DType> *ograd) {
+    const int ignore = static_cast<int>(param.ignore_label);
+    const index_t n = out.size(0), m = out.size(1);
+    // one pass per row instead of one for the gradient and one per factor
+#pragma omp parallel for
+    for (index_t i = 0; i < n; ++i) {
+        const DType *o = out.dptr_ + i * m;
+        const DType *og = ograd != NULL ? ograd->dptr_ + i * m : NULL;
+        DType *g = grad.dptr_ + i * m;
+        const int k = static_cast<int>(label.dptr_[i]);
+        if (param.use_ignore && k == ignore) {
+            for (index_t j = 0; j < m; ++j) g[j] = DType(0);
+            continue;
+        }
+        for (index_t j = 0; j < m; ++j) g[j] = DType(o[j] * scale);
+        if (k >= 0 && static_cast<index_t>(k) < m) {
+            g[k] = DType(g[k] - scale);
+        }
+        if (og != NULL) {
+            for (index_t j = 0; j < m; ++j) g[j] = DType(g[j] * og[j]);
+        }
+    }
+}
+
 template <typename xpu, typename DType>
 class SoftmaxOutputOp : public Operator {
    public:
@@ -110,7 +179,7 @@ class SoftmaxOutputOp : public Operator {
                     in_data[softmaxout_enum::kData].FlatTo2D<xpu, DType>(s);
                 Tensor<xpu, 2, DType> out =
                     out_data[softmaxout_enum::kOut].FlatTo2D<xpu, DType>(s);
-                Softmax(out, data);
+                SoftmaxOutputRows(out, data);
             } else {
                 int n = in_data[softmaxout_enum::kData].size(0);
                 int k = in_data[softmaxout_enum::kData].Size() / n;
@@ -121,7 +190,7 @@ class SoftmaxOutputOp : public Operator {
                 Tensor<xpu, 2, DType> out =
                     out_data[softmaxout_enum::kOut]
                         .get_with_shape<xpu, 2, DType>(s2, s);
-                Softmax(out, data);
+                SoftmaxOutputRows(out, data);
             }
         }
     }
@@ -240,12 +309,6 @@ class SoftmaxOutputOp : public Operator {
                 in_grad[softmaxout_enum::kData].get_with_shape<xpu, 2, DType>(
                     data_shape, s);
             index_t valid_cnt = label.shape_.Size();
-            if (param_.use_ignore) {
-                SoftmaxGrad(grad, out, label,
-                            static_cast<DType>(param_.ignore_label));
-            } else {
-                SoftmaxGrad(grad, out, label);
-            }
             if (param_.normalization == softmaxout_enum::kBatch) {
                 valid_cnt = label.size(0);
             } else if (param_.normalization == softmaxout_enum::kValid) {
@@ -263,13 +326,14 @@ class SoftmaxOutputOp : public Operator {
             } else {
                 valid_cnt = 1;
             }
-            grad *= DType(param_.grad_scale / valid_cnt);
+            Tensor<xpu, 2, DType> ograd;
             if (param_.out_grad) {
-                Tensor<xpu, 2, DType> ograd =
-                    out_grad[softmaxout_enum::kOut]
-                        .get_with_shape<xpu, 2, DType>(data_shape, s);
-                grad *= ograd;
+                ograd = out_grad[softmaxout_enum::kOut]
+                            .get_with_shape<xpu, 2, DType>(data_shape, s);
             }
+            SoftmaxOutputGrad(grad, out, label, param_,
+                              DType(param_.grad_scale / valid_cnt),
+                              param_.out_grad ? &ograd : NULL);
         }
     }
 
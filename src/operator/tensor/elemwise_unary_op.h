@@ -12,6 +12,7 @@
 #include "../elemwise_op_common.h"
 #include "../mshadow_op.h"
 #include "../mxnet_op.h"
+#include "../simd_math.h"
 #include "../special_functions-inl.h"
 
 namespace mxnet {
@@ -48,6 +49,7 @@ void UnaryCompute(const nnvm::NodeAttrs& attrs, const OpContext& ctx,
                   const std::vector<TBlob>& outputs) {
     using namespace mshadow;
     using namespace mshadow::expr;
+    if (SimdMapTo<xpu, OP>(inputs[0], req[0], outputs[0])) return;
     Stream<xpu>* s = ctx.get_stream<xpu>();
     MSHADOW_TYPE_SWITCH(outputs[0].type_flag_, DType, {
         Tensor<xpu, 1, DType> out = outputs[0].FlatTo1D<xpu, DType>(s);
@@ -72,6 +72,56 @@ AddTakeGradLargeBatchWorkspaceSize(size_t num_keys) {
 template <typename IndexType, typename xpu>
 inline typename std::enable_if<std::is_same<xpu, gpu>::value, size_t>::type
 AddTakeGradLargeBatchWorkspaceSize(size_t num_keys);
+/*!
+ * \brief CPU: dst[sorted[i]] += src[index[i]], or with req kWriteTo
+ *  dst[k] = sum of src[index[i]] over sorted[i] == k. The runs of equal keys
+ *  of sorted are spread over the threads, so a key must not appear in two
+ *  runs. With kWriteTo only the rows of dst that no key refers to are
+ *  zeroed, rather than all of them before the sums are added.
+ */
+template <typename IndexType, typename DType>
+inline void AddTakeGradLargeBatch(
+    mshadow::Tensor<cpu, 2, DType> dst,
+    const mshadow::Tensor<cpu, 1, IndexType>& sorted,
+    const mshadow::Tensor<cpu, 1, IndexType>& index,
+    const mshadow::Tensor<cpu, 2, DType>& src,
+    mshadow::Tensor<cpu, 1, char>* workspace, OpReqType req) {
+    const index_t num_key = sorted.size(0);
+    const index_t num_row = dst.size(0), num_col = dst.size(1);
+    // the runs [begin[r], begin[r + 1]) of equal keys
+    std::vector<index_t> begin;
+    for (index_t y = 0; y < num_key; ++y) {
+        if (y == 0 || sorted[y] != sorted[y - 1]) begin.push_back(y);
+    }
+    const index_t num_run = begin.size();
+    begin.push_back(num_key);
+#pragma omp parallel for
+    for (index_t r = 0; r < num_run; ++r) {
+        DType* out = dst[static_cast<index_t>(sorted[begin[r]])].dptr_;
+        index_t y = begin[r];
+        if (req == kWriteTo) {
+            const DType* in = src[static_cast<index_t>(index[y++])].dptr_;
+            std::copy(in, in + num_col, out);
+        }
+        for (; y < begin[r + 1]; ++y) {
+            const DType* in = src[static_cast<index_t>(index[y])].dptr_;
+            for (index_t j = 0; j < num_col; ++j) {
+                out[j] += in[j];
+            }
+        }
+    }
+    if (req != kWriteTo) return;
+    std::vector<char> written(num_row, 0);
+    for (index_t r = 0; r < num_run; ++r) {
+        written[static_cast<index_t>(sorted[begin[r]])] = 1;
+    }
+#pragma omp parallel for
+    for (index_t i = 0; i < num_row; ++i) {
+        if (!written[i]) {
+            std::fill(dst[i].dptr_, dst[i].dptr_ + num_col, DType(0));
+        }
+    }
+}
 /*!
  * \brief CPU/GPU: Gradient accumulate of embedding matrix.
                    dst[sorted[i]] += src[index[i]]
@@ -90,9 +140,7 @@ inline void AddTakeGradLargeBatch(
     const mshadow::Tensor<cpu, 1, IndexType>& index,
     const mshadow::Tensor<cpu, 2, DType>& src,
     mshadow::Tensor<cpu, 1, char>* workspace = NULL) {
-    for (index_t y = 0; y < sorted.size(0); ++y) {
-        dst[sorted[y]] += src[index[y]];
-    }
+    AddTakeGradLargeBatch(dst, sorted, index, src, workspace, kAddTo);
 }
 /*!
  * \brief CPU/GPU: Gradient accumulate of embedding matrix.
@@ -112,6 +160,19 @@ inline void AddTakeGradLargeBatch(
     const mshadow::Tensor<gpu, 1, IndexType>& index,
     const mshadow::Tensor<gpu, 2, DType>& src,
     mshadow::Tensor<gpu, 1, char>* workspace = NULL);
+/*!
+ * \brief GPU: AddTakeGradLargeBatch into dst, zeroed first for req kWriteTo
+ */
+template <typename IndexType, typename DType>
+inline void AddTakeGradLargeBatch(
+    mshadow::Tensor<gpu, 2, DType> dst,
+    const mshadow::Tensor<gpu, 1, IndexType>& sorted,
+    const mshadow::Tensor<gpu, 1, IndexType>& index,
+    const mshadow::Tensor<gpu, 2, DType>& src,
+    mshadow::Tensor<gpu, 1, char>* workspace, OpReqType req) {
+    if (req == kWriteTo) dst = mshadow::expr::scalar<DType>(0.0f);
+    AddTakeGradLargeBatch(dst, sorted, index, src, workspace);
+}
 
 inline bool EmbeddingOpShape(const nnvm::NodeAttrs& attrs,
                              std::vector<TShape>* in_attrs,
@@ -242,11 +303,15 @@ struct tcast_clip {
     }
 };
 
+/*!
+ * \brief dst[index[i]] += src[i] by sorting index, or for req kWriteTo dst
+ *  set to these sums and zero elsewhere
+ */
 template <typename xpu, typename IndexType, typename DType>
 void AddTakeGradLargeBatchCaller(
     const OpContext& ctx, mshadow::Tensor<xpu, 2, DType> dst,
     const mshadow::Tensor<xpu, 1, IndexType>& index,
-    const mshadow::Tensor<xpu, 2, DType>& src) {
+    const mshadow::Tensor<xpu, 2, DType>& src, OpReqType req = kAddTo) {
     using namespace mxnet_op;
     using namespace mshadow::expr;
 
@@ -286,7 +351,7 @@ void AddTakeGradLargeBatchCaller(
     mxnet::op::SortByKey(sorted_data, original_index, true, &temp_storage, 0,
                          num_bits);
     mxnet::op::AddTakeGradLargeBatch(dst, sorted_data, original_index, src,
-                                     &temp_storage);
+                                     &temp_storage, req);
 }
 
 template <typename xpu>
@@ -320,9 +385,6 @@ void EmbeddingOpBackward(const nnvm::NodeAttrs& attrs, const OpContext& ctx,
 
             if (req[embedding::kWeight] == kWriteTo ||
                 req[embedding::kWeight] == kAddTo) {
-                if (req[embedding::kWeight] == kWriteTo) {
-                    grad_in = scalar<DType>(0.0f);
-                }
                 // shape_out_prod ~= the number of elements loaded in
                 // AddTakeGrad
                 // shape_in_prod  ~= the number of elements stored in
@@ -339,9 +401,13 @@ void EmbeddingOpBackward(const nnvm::NodeAttrs& attrs, const OpContext& ctx,
                     static_cast<uint64_t>(grad_out.shape_[1]);
                 if (shape_out_prod < (uint64_t)16384 &&
                     shape_in_prod < (uint64_t)16384) {
+                    if (req[embedding::kWeight] == kWriteTo) {
+                        grad_in = scalar<DType>(0.0f);
+                    }
                     AddTakeGrad(grad_in, data, grad_out);
                 } else {
-                    AddTakeGradLargeBatchCaller(ctx, grad_in, data, grad_out);
+                    AddTakeGradLargeBatchCaller(ctx, grad_in, data, grad_out,
+                                                req[embedding::kWeight]);
                 }
             } else {
                 LOG(FATAL) << "wrong req";
@@ -491,9 +557,6 @@ void TakeOpBackward(const nnvm::NodeAttrs& attrs, const OpContext& ctx,
                     s);
 
             if (req[take_::kArr] == kWriteTo || req[take_::kArr] == kAddTo) {
-                if (req[take_::kArr] == kWriteTo) {
-                    grad_in = scalar<DType>(0.0f);
-                }
                 // shape_out_prod ~= the number of elements loaded in
                 // AddTakeGrad
                 // shape_in_prod  ~= the number of elements stored in
@@ -510,9 +573,13 @@ void TakeOpBackward(const nnvm::NodeAttrs& attrs, const OpContext& ctx,
                     static_cast<uint64_t>(grad_out.shape_[1]);
                 if (shape_out_prod < (uint64_t)16384 &&
                     shape_in_prod < (uint64_t)16384) {
+                    if (req[take_::kArr] == kWriteTo) {
+                        grad_in = scalar<DType>(0.0f);
+                    }
                     AddTakeGrad(grad_in, idx, grad_out);
                 } else {
-                    AddTakeGradLargeBatchCaller(ctx, grad_in, idx, grad_out);
+                    AddTakeGradLargeBatchCaller(ctx, grad_in, idx, grad_out,
+                                                req[take_::kArr]);
                 }
             } else {
                 LOG(FATAL) << "wrong req";
@@ -8,134 +8,59 @@
 namespace mxnet {
 namespace op {
 
+// The samplers draw one sample from the distribution given by the two
+// parameters, of which the single-parameter distributions ignore the second.
 struct UniformSampler {
-    template <typename DType>
-    struct Sampler {
-        std::mt19937 rnd_;
-        // Ensure that half_t is handled correctly.
-        typedef typename std::conditional<std::is_floating_point<DType>::value,
-                                          DType, double>::type FType;
-        typedef typename std::conditional<
-            std::is_integral<DType>::value,
-            std::uniform_int_distribution<DType>,
-            std::uniform_real_distribution<FType>>::type GType;
-        GType gen_;
-        template <typename PType>
-        Sampler(PType a, PType b, int seed) : rnd_(seed), gen_(a, b) {}
-        MSHADOW_XINLINE DType operator()() { return gen_(rnd_); }
-    };
+    template <typename FType>
+    static FType Sample(RandomSampler<FType>* s, FType low, FType high) {
+        return s->Uniform(low, high);
+    }
 };
 
 struct NormalSampler {
-    template <typename DType>
-    struct Sampler {
-        std::mt19937 rnd_;
-        typedef typename std::conditional<std::is_floating_point<DType>::value,
-                                          DType, double>::type GType;
-        std::normal_distribution<GType> gen_;
-        template <typename PType>
-        Sampler(PType mu, PType sigma, int seed)
-            : rnd_(seed), gen_(mu, sigma) {}
-        MSHADOW_XINLINE DType operator()() { return gen_(rnd_); }
-    };
+    template <typename FType>
+    static FType Sample(RandomSampler<FType>* s, FType mu, FType sigma) {
+        return s->Normal(mu, sigma);
+    }
 };
 
 struct GammaSampler {
-    template <typename DType>
-    struct Sampler {
-        std::mt19937 rnd_;
-        // Avoid problems with static check during compilation for integral
-        // types.
-        typedef typename std::conditional<std::is_floating_point<DType>::value,
-                                          DType, double>::type GType;
-        std::gamma_distribution<GType> gen_;
-        template <typename PType>
-        Sampler(PType alpha, PType beta, int seed)
-            : rnd_(seed), gen_(alpha, beta) {}
-        MSHADOW_XINLINE DType operator()() { return gen_(rnd_); }
-    };
+    template <typename FType>
+    static FType Sample(RandomSampler<FType>* s, FType alpha, FType beta) {
+        return s->Gamma(alpha, beta);
+    }
 };
 
 struct ExponentialSampler {
-    template <typename DType>
-    struct Sampler {
-        std::mt19937 rnd_;
-        // Avoid problems with static check during compilation for integral
-        // types.
-        typedef typename std::conditional<std::is_floating_point<DType>::value,
-                                          DType, double>::type GType;
-        std::exponential_distribution<GType> gen_;
-        template <typename PType>
-        Sampler(PType lambda, PType, int seed) : rnd_(seed), gen_(lambda) {}
-        MSHADOW_XINLINE DType operator()() { return gen_(rnd_); }
-    };
+    template <typename FType>
+    static FType Sample(RandomSampler<FType>* s, FType lambda, FType) {
+        return s->Exponential(lambda);
+    }
 };
 
 struct PoissonSampler {
-    template <typename DType>
-    struct Sampler {
-        std::mt19937 rnd_;
-        // Allow sampling of a Poisson distribution also to output floating
-        // point types.
-        typedef typename std::conditional<std::is_integral<DType>::value, DType,
-                                          int>::type GType;
-        std::poisson_distribution<GType> gen_;
-        template <typename PType>
-        Sampler(PType lambda, PType, int seed) : rnd_(seed), gen_(lambda) {}
-        MSHADOW_XINLINE DType operator()() {
-            return static_cast<DType>(gen_(rnd_));
-        }
-    };
+    template <typename FType>
+    static FType Sample(RandomSampler<FType>* s, FType lambda, FType) {
+        return s->Poisson(lambda);
+    }
 };
 
 // Negative binomial distribution as defined in C++ standard library
 struct NegativeBinomialSampler {
-    template <typename DType>
-    struct Sampler {
-        std::mt19937 rnd_;
-        // Allow sampling of a negative binomial distribution also to output
-        // floating point types.
-        typedef typename std::conditional<std::is_integral<DType>::value, DType,
-                                          int>::type GType;
-        std::negative_binomial_distribution<GType> gen_;
-        template <typename PType>
-        Sampler(PType k, PType p, int seed) : rnd_(seed), gen_(k, p) {}
-        MSHADOW_XINLINE DType operator()() {
-            return static_cast<DType>(gen_(rnd_));
-        }
-    };
+    template <typename FType>
+    static FType Sample(RandomSampler<FType>* s, FType k, FType p) {
+        return s->NegativeBinomial(k, p);
+    }
 };
 
 // Generalized form of the negative binomial distribution which is generated by
 // a poisson-gamma mixture: X ~ NegBin(mu, alpha) corresponds to
 // X ~ Poisson(Gamma(1/alpha,mu*alpha))
 struct GeneralizedNegativeBinomialSampler {
-    template <typename DType>
-    struct Sampler {
-        // We allow the boundary case where the negative binomial equals the
-        // Poisson distribution
-        bool poisson_;
-        double mu_;
-        std::mt19937 rnd_;
-        // Realize the negative binomial by a Poisson distribution over a gamma
-        // distributed mean.
-        std::gamma_distribution<> gen_;
-        template <typename PType>
-        Sampler(PType mu, PType alpha, int seed)
-            : poisson_(alpha == 0.0),
-              mu_(mu),
-              rnd_(seed),
-              gen_((alpha == PType(0) ? PType(1) : PType(1) / alpha),
-                   mu * alpha) {}
-        // Allow sampling of a Poisson distribution also to output floating
-        // point types.
-        typedef typename std::conditional<std::is_integral<DType>::value, DType,
-                                          int>::type GType;
-        MSHADOW_XINLINE DType operator()() {
-            return static_cast<DType>(std::poisson_distribution<GType>(
-                poisson_ ? mu_ : gen_(rnd_))(rnd_));
-        }
-    };
+    template <typename FType>
+    static FType Sample(RandomSampler<FType>* s, FType mu, FType alpha) {
+        return s->GeneralizedNegativeBinomial(mu, alpha);
+    }
 };
 
 DMLC_REGISTER_PARAMETER(MultiSampleParam);
@@ -158,11 +83,12 @@ DMLC_REGISTER_PARAMETER(MultiSampleParam);
             })                                                               \
         .set_attr<nnvm::FInferShape>("FInferShape", MultiSampleOpShape)      \
         .set_attr<nnvm::FInferType>("FInferType", MultiSampleOpType)         \
-        .set_attr<FResourceRequest>("FResourceRequest",                      \
-                                    [](const NodeAttrs& attrs) {             \
-                                        return std::vector<ResourceRequest>( \
-                                            1, ResourceRequest::kRandom);    \
-                                    })                                       \
+        .set_attr<FResourceRequest>(                                         \
+            "FResourceRequest",                                              \
+            [](const NodeAttrs& attrs) {                                     \
+                return std::vector<ResourceRequest>(                         \
+                    1, ResourceRequest::kParallelRandom);                    \
+            })                                                               \
         .set_attr<FCompute>("FCompute<cpu>",                                 \
                             MultiSampleOpForward<cpu, sampler>)              \
         .set_attr<nnvm::FGradient>("FGradient", MakeZeroGradNodes)           \
@@ -13,6 +13,7 @@
 #include "../mshadow_op.h"
 #include "../mxnet_op.h"
 #include "../operator_common.h"
+#include "./parallel_sampler.h"
 
 namespace mxnet {
 namespace op {
@@ -136,8 +137,6 @@ void MultiSampleOpForward(const nnvm::NodeAttrs& attrs, const OpContext& ctx,
     CHECK_EQ(outputs.size(), 1);
     CHECK_EQ(req.size(), 1);
     using namespace mxnet_op;
-    const MultiSampleParam& param = nnvm::get<MultiSampleParam>(attrs.parsed);
-    mshadow::Stream<xpu>* s = ctx.get_stream<xpu>();
     const TBlob& in0 = inputs[0];
     const TBlob& in1 = (inputs.size() == 1 ? inputs[0] : inputs[1]);
     const TBlob& out = outputs[0];
@@ -147,43 +146,25 @@ void MultiSampleOpForward(const nnvm::NodeAttrs& attrs, const OpContext& ctx,
     CHECK_GT(in0.Size(), 0);
     CHECK_EQ(out.CheckContiguous(), true);
     CHECK_EQ(out.Size() % in0.Size(), 0);
-    const int N(in0.Size()), M(out.Size() / in0.Size());
-
-    // Seed for the sampling process. In order to guarantee deterministic
-    // behaviour for single threaded cpu, this is taken from mshadow random
-    // generator.
-    const int seed(ctx.requested[0].get_random<xpu, float>(s)->GetRandInt());
+    const index_t M = out.Size() / in0.Size();
 
     MSHADOW_TYPE_SWITCH(in0.type_flag_, IType, {
         MSHADOW_REAL_TYPE_SWITCH(out.type_flag_, OType, {
             MXNET_ASSIGN_REQ_SWITCH(req[0], req_type, {
-                // Get the output as a 2D-tensor with dimensions NxM
-                Tensor<xpu, 2, OType> samples =
-                    out.get_with_shape<xpu, 2, OType>(Shape2(N, M), s);
+                typedef typename SampleReal<OType>::type FType;
                 const IType *iptr1 = in0.dptr<IType>(),
                             *iptr2 = in1.dptr<IType>();
-
-                // The seeds for the different generators are itself a random
-                // sequence. We don't
-                // want to create the same samples in case that we have two
-                // samplers with same
-                // input parameters.
-                std::mt19937 seed_generator(seed);
-                for (int i = 0; i < N; ++i) {
-                    // Generate seed for this sampler. Must be mutexed as
-                    // calling
-                    // a random generator is not thread safe.
-                    int seed = seed_generator();
-                    typename generator::template Sampler<OType> sampler(
-                        iptr1[i], iptr2[i], seed);
-                    // Get the sub-tensor that will hold the results of this
-                    // sampler.
-                    Tensor<xpu, 1, OType> slice =
-                        samples.Slice(i, i + 1).FlatTo1D();
-                    for (int j = 0; j < M; ++j) {
-                        KERNEL_ASSIGN(slice[j], req_type, sampler());
-                    }
-                }
+                OType* optr = out.dptr<OType>();
+                // sample j of distribution i is at i * M + j
+                ParallelSample<FType>(
+                    ctx.requested[0].get_parallel_random(), out.Size(),
+                    [&](RandomSampler<FType>* sampler, index_t i) {
+                        const index_t k = i / M;
+                        KERNEL_ASSIGN(optr[i], req_type,
+                                      OType(generator::Sample(
+                                          sampler, FType(iptr1[k]),
+                                          FType(iptr2[k]))));
+                    });
             });
         });
     });
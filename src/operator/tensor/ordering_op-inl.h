@@ -9,6 +9,7 @@
 #include <dmlc/optional.h>
 #include <mshadow/tensor.h>
 #include <mxnet/operator_util.h>
+#include <algorithm>
 #include <type_traits>
 #include <vector>
 #include "../elemwise_op_common.h"
@@ -149,6 +150,89 @@ inline void ParseTopKParam(const TShape& src_shape, const TopKParam& param,
                                          << *element_num << ", get k = " << *k;
 }
 
+/*!
+ * \brief Order the batches of dat, each of element_num elements, so that
+ *  the first k elements of every batch are its top k in order, and give the
+ *  index of each element in the original dat and the id of its batch.
+ * \param dat the batch-major data, reordered in place
+ * \param indices range(0, dat.size(0)) on entry, then the original index of
+ *  each element of dat
+ * \param batch_id the batch of each element of dat
+ */
+template <typename xpu>
+inline void TopKSort(mshadow::Tensor<xpu, 1, real_t> dat,
+                     mshadow::Tensor<xpu, 1, real_t> indices,
+                     mshadow::Tensor<xpu, 1, real_t> batch_id, int batch_size,
+                     int element_num, int k, bool is_ascend) {
+    using namespace mshadow::expr;
+    // Perform inplace batch sort using the `SortByKey` in MShadow
+    // After sorting, each batch in `dat` will be sorted in the
+    // corresponding order
+    //   and the `indices` will contain the corresponding index in `dat`
+    // Sort the data and keep record of the correspondence to global indices.
+    mxnet::op::SortByKey(dat, indices, is_ascend);
+    // Calculate the corresponding batch indices of the elements
+    batch_id = F<mshadow_op::floor>(indices / static_cast<real_t>(element_num));
+    // Since the SortByKey performs stable sort, the second SortByKey will
+    // reorder
+    //   the dat based on the order of the batch_id
+    mxnet::op::SortByKey(batch_id, dat, true);
+    // Reorder the indices
+    batch_id = F<mshadow_op::floor>(indices / static_cast<real_t>(element_num));
+    mxnet::op::SortByKey(batch_id, indices, true);
+}
+
+/*!
+ * \brief CPU: select the top k of every batch on its own, in parallel over
+ *  the batches. The top k so far are kept in a heap whose root is the last
+ *  of them, so a pass over the batch costs O(element_num log k) and mostly
+ *  compares against the root, rather than sorting all of dat. Past the first
+ *  k, the elements of a batch are left out of order. Equal elements keep
+ *  their original order, as with the stable sort.
+ */
+inline void TopKSort(mshadow::Tensor<cpu, 1, real_t> dat,
+                     mshadow::Tensor<cpu, 1, real_t> indices,
+                     mshadow::Tensor<cpu, 1, real_t> batch_id, int batch_size,
+                     int element_num, int k, bool is_ascend) {
+#pragma omp parallel
+    {
+        std::vector<int> order(k);
+        std::vector<real_t> top(k);
+#pragma omp for
+        for (int i = 0; i < batch_size; ++i) {
+            real_t* row = dat.dptr_ + i * element_num;
+            auto before = [row, is_ascend](int a, int b) {
+                if (row[a] == row[b]) return a < b;
+                return is_ascend ? row[a] < row[b] : row[a] > row[b];
+            };
+            const auto first = order.begin(), last = order.begin() + k;
+            for (int j = 0; j < k; ++j) order[j] = j;
+            if (k < element_num) {
+                std::make_heap(first, last, before);
+                for (int j = k; j < element_num; ++j) {
+                    if (before(j, order[0])) {
+                        std::pop_heap(first, last, before);
+                        order[k - 1] = j;
+                        std::push_heap(first, last, before);
+                    }
+                }
+                std::sort_heap(first, last, before);
+            } else {
+                std::sort(first, last, before);
+            }
+            for (int j = 0; j < k; ++j) {
+                top[j] = row[order[j]];
+                indices[i * element_num + j] =
+                    static_cast<real_t>(i * element_num + order[j]);
+            }
+            std::copy(top.begin(), top.end(), row);
+            for (int j = 0; j < element_num; ++j) {
+                batch_id[i * element_num + j] = static_cast<real_t>(i);
+            }
+        }
+    }
+}
+
 /*!
    * \brief Implementation of the TopK operation
    *
@@ -218,21 +302,9 @@ void TopKImpl(RunContext ctx, Resource resource, const TBlob& src,
         CHECK_EQ(mask_val.CheckContiguous(), true);
     }
 
-    // 2. Perform inplace batch sort using the `SortByKey` in MShadow
-    // After sorting, each batch in `sorted_dat` will be sorted in the
-    // corresponding order
-    //   and the `indices` will contain the corresponding index in `sorted_dat`
-    // Sort the data and keep record of the correspondence to global indices.
-    mxnet::op::SortByKey(sorted_dat, indices, is_ascend);
-    // Calculate the corresponding batch indices of the elements
-    batch_id = F<mshadow_op::floor>(indices / static_cast<real_t>(element_num));
-    // Since the SortByKey performs stable sort, the second SortByKey will
-    // reorder
-    //   the sorted_dat based on the order of the batch_id
-    mxnet::op::SortByKey(batch_id, sorted_dat, true);
-    // Reorder the indices
-    batch_id = F<mshadow_op::floor>(indices / static_cast<real_t>(element_num));
-    mxnet::op::SortByKey(batch_id, indices, true);
+    // 2. Bring the top k elements of every batch to its front, in order
+    TopKSort(sorted_dat, indices, batch_id, batch_size, element_num, k,
+             is_ascend);
 
     // 3. Assign results to the ret blob
     if (param.ret_typ == topk_enum::kReturnMask) {
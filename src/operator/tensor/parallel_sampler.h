@@ -0,0 +1,159 @@
+/*!
+ *  Copyright (c) 2017 by Contributors
+ * \file parallel_sampler.h
+ * \brief samples of the common distributions drawn from the counter-based
+ *  random resource in parallel, with results that do not depend on the
+ *  number of threads
+ */
+#ifndef MXNET_OPERATOR_TENSOR_PARALLEL_SAMPLER_H_
+#define MXNET_OPERATOR_TENSOR_PARALLEL_SAMPLER_H_
+
+#include <mxnet/random_generator.h>
+#include <algorithm>
+#include <cmath>
+
+namespace mxnet {
+namespace op {
+/*! \brief number of consecutive samples drawn from one subsequence */
+const index_t kSampleBlock = 1024;
+
+/*! \brief the type samples of DType are computed in */
+template <typename DType>
+struct SampleReal {
+    typedef float type;
+};
+template <>
+struct SampleReal<double> {
+    typedef double type;
+};
+
+/*!
+ * \brief Samples of the common distributions from one stream, computed in
+ *  FType. The distributions are parametrized as in sample_op.h.
+ */
+template <typename FType>
+class RandomSampler {
+   public:
+    explicit RandomSampler(const random::Philox4x32& gen)
+        : gen_(gen), has_normal_(false) {}
+    /*! \brief uniform in [0, 1) */
+    inline FType Uniform() {
+        return sizeof(FType) > sizeof(float)
+                   ? static_cast<FType>(gen_.UniformDouble())
+                   : static_cast<FType>(gen_.UniformFloat());
+    }
+    inline FType Uniform(FType low, FType high) {
+        return low + (high - low) * Uniform();
+    }
+    inline FType Normal(FType loc, FType scale) {
+        return loc + scale * StandardNormal();
+    }
+    inline FType Exponential(FType lambda) {
+        return -std::log(FType(1) - Uniform()) / lambda;
+    }
+    /*! \brief gamma with shape alpha and scale beta */
+    inline FType Gamma(FType alpha, FType beta) {
+        if (alpha >= FType(1)) return StandardGamma(alpha) * beta;
+        // boost the shape above one, x * u^(1/alpha) ~ Gamma(alpha)
+        const FType u = FType(1) - Uniform();
+        return StandardGamma(alpha + FType(1)) *
+               std::pow(u, FType(1) / alpha) * beta;
+    }
+    inline FType Poisson(FType lambda) {
+        const double lam = lambda;
+        if (lam < 12.0) {
+            // count the uniforms whose product stays above exp(-lambda)
+            const double g = std::exp(-lam);
+            double t = 1.0;
+            int k = -1;
+            do {
+                ++k;
+                t *= Uniform();
+            } while (t > g);
+            return static_cast<FType>(k);
+        }
+        // rejection from a Lorentzian, Numerical Recipes 7.3
+        const double sq = std::sqrt(2.0 * lam), alxm = std::log(lam);
+        const double g = lam * alxm - std::lgamma(lam + 1.0);
+        double em, t;
+        do {
+            double y;
+            do {
+                y = std::tan(M_PI * Uniform());
+                em = sq * y + lam;
+            } while (em < 0.0);
+            em = std::floor(em);
+            t = 0.9 * (1.0 + y * y) *
+                std::exp(em * alxm - std::lgamma(em + 1.0) - g);
+        } while (Uniform() > t);
+        return static_cast<FType>(em);
+    }
+    /*! \brief failures before k successes of probability p */
+    inline FType NegativeBinomial(FType k, FType p) {
+        return Poisson(Gamma(k, (FType(1) - p) / p));
+    }
+    /*! \brief Poisson(Gamma(1 / alpha, mu * alpha)), or Poisson(mu) */
+    inline FType GeneralizedNegativeBinomial(FType mu, FType alpha) {
+        if (alpha == FType(0)) return Poisson(mu);
+        return Poisson(Gamma(FType(1) / alpha, mu * alpha));
+    }
+
+   private:
+    /*! \brief Box-Muller, keeping the second sample of each pair */
+    inline FType StandardNormal() {
+        if (has_normal_) {
+            has_normal_ = false;
+            return normal_;
+        }
+        const FType r = std::sqrt(FType(-2) * std::log(FType(1) - Uniform()));
+        const FType theta = FType(2 * M_PI) * Uniform();
+        normal_ = r * std::sin(theta);
+        has_normal_ = true;
+        return r * std::cos(theta);
+    }
+    /*! \brief Marsaglia and Tsang, for alpha >= 1 */
+    inline FType StandardGamma(FType alpha) {
+        const FType d = alpha - FType(1) / FType(3);
+        const FType c = FType(1) / std::sqrt(FType(9) * d);
+        while (true) {
+            FType x, v;
+            do {
+                x = StandardNormal();
+                v = FType(1) + c * x;
+            } while (v <= FType(0));
+            v = v * v * v;
+            const FType u = Uniform();
+            const FType x2 = x * x;
+            if (u < FType(1) - FType(0.0331) * x2 * x2) return d * v;
+            const FType bound =
+                FType(0.5) * x2 + d * (FType(1) - v + std::log(v));
+            if (std::log(u) < bound) return d * v;
+        }
+    }
+    /*! \brief the stream */
+    random::Philox4x32 gen_;
+    /*! \brief whether normal_ holds the second sample of a pair */
+    bool has_normal_;
+    FType normal_;
+};
+
+/*!
+ * \brief Call body(&sampler, i) for i in [0, size), in parallel over blocks
+ *  of kSampleBlock samples. Each block draws from its own subsequence of
+ *  rnd, so the result only depends on the state of rnd.
+ */
+template <typename FType, typename Body>
+inline void ParallelSample(random::ParallelRandom* rnd, index_t size,
+                           const Body& body) {
+    const index_t nblock = (size + kSampleBlock - 1) / kSampleBlock;
+    const uint64_t first = rnd->Reserve(nblock);
+#pragma omp parallel for if (nblock > 1)
+    for (index_t b = 0; b < nblock; ++b) {
+        RandomSampler<FType> sampler(rnd->Stream(first + b));
+        const index_t end = std::min(size, (b + 1) * kSampleBlock);
+        for (index_t i = b * kSampleBlock; i < end; ++i) body(&sampler, i);
+    }
+}
+}  // namespace op
+}  // namespace mxnet
+#endif  // MXNET_OPERATOR_TENSOR_PARALLEL_SAMPLER_H_
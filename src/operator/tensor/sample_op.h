@@ -13,6 +13,7 @@
 #include "../elemwise_op_common.h"
 #include "../mshadow_op.h"
 #include "./init_op.h"
+#include "./parallel_sampler.h"
 
 namespace mxnet {
 namespace op {
@@ -251,14 +252,17 @@ void SampleUniform_(const nnvm::NodeAttrs& attrs, const OpContext& ctx,
                     const std::vector<TBlob>& outputs) {
     using namespace mxnet::op;
     using namespace mshadow::expr;
-    mshadow::Stream<xpu>* s = ctx.get_stream<xpu>();
     const SampleUniformParam& param =
         nnvm::get<SampleUniformParam>(attrs.parsed);
     MSHADOW_REAL_TYPE_SWITCH(outputs[0].type_flag_, DType, {
-        mshadow::Random<xpu, DType>* prnd =
-            ctx.requested[0].get_random<xpu, DType>(s);
-        mshadow::Tensor<xpu, 2, DType> out = outputs[0].FlatTo2D<xpu, DType>(s);
-        prnd->SampleUniform(&out, param.low, param.high);
+        typedef typename SampleReal<DType>::type FType;
+        const FType low = param.low, high = param.high;
+        DType* out = outputs[0].dptr<DType>();
+        ParallelSample<FType>(
+            ctx.requested[2].get_parallel_random(), outputs[0].Size(),
+            [&](RandomSampler<FType>* sampler, index_t i) {
+                out[i] = DType(sampler->Uniform(low, high));
+            });
     });
 }
 
@@ -269,15 +273,18 @@ void SampleNormal_(const nnvm::NodeAttrs& attrs, const OpContext& ctx,
                    const std::vector<TBlob>& outputs) {
     using namespace mxnet::op;
     using namespace mshadow::expr;
-    mshadow::Stream<xpu>* s = ctx.get_stream<xpu>();
     const SampleNormalParam& param = nnvm::get<SampleNormalParam>(attrs.parsed);
     CHECK_GT(param.scale, 0)
         << "scale parameter in gaussian has to be positive";
     MSHADOW_REAL_TYPE_SWITCH(outputs[0].type_flag_, DType, {
-        mshadow::Random<xpu, DType>* prnd =
-            ctx.requested[0].get_random<xpu, DType>(s);
-        mshadow::Tensor<xpu, 2, DType> out = outputs[0].FlatTo2D<xpu, DType>(s);
-        prnd->SampleGaussian(&out, param.loc, param.scale);  // NOLINT(*)
+        typedef typename SampleReal<DType>::type FType;
+        const FType loc = param.loc, scale = param.scale;
+        DType* out = outputs[0].dptr<DType>();
+        ParallelSample<FType>(
+            ctx.requested[2].get_parallel_random(), outputs[0].Size(),
+            [&](RandomSampler<FType>* sampler, index_t i) {
+                out[i] = DType(sampler->Normal(loc, scale));
+            });
     });
 }
 
@@ -288,17 +295,20 @@ void SampleGamma_(const nnvm::NodeAttrs& attrs, const OpContext& ctx,
                   const std::vector<TBlob>& outputs) {
     using namespace mxnet::op;
     using namespace mshadow::expr;
-    mshadow::Stream<xpu>* s = ctx.get_stream<xpu>();
     const SampleGammaParam& param = nnvm::get<SampleGammaParam>(attrs.parsed);
     CHECK_GT(param.alpha, 0)
         << "alpha parameter in gamma distribution has to be positive";
     CHECK_GT(param.beta, 0)
         << "beta parameter in gamma distribution has to be positive";
     MSHADOW_REAL_TYPE_SWITCH(outputs[0].type_flag_, DType, {
-        mshadow::Random<xpu, DType>* prnd =
-            ctx.requested[0].get_random<xpu, DType>(s);
-        mshadow::Tensor<xpu, 2, DType> out = outputs[0].FlatTo2D<xpu, DType>(s);
-        prnd->SampleGamma(&out, param.alpha, param.beta);  // NOLINT(*)
+        typedef typename SampleReal<DType>::type FType;
+        const FType alpha = param.alpha, beta = param.beta;
+        DType* out = outputs[0].dptr<DType>();
+        ParallelSample<FType>(
+            ctx.requested[2].get_parallel_random(), outputs[0].Size(),
+            [&](RandomSampler<FType>* sampler, index_t i) {
+                out[i] = DType(sampler->Gamma(alpha, beta));
+            });
     });
 }
 
@@ -309,16 +319,19 @@ void SampleExponential_(const nnvm::NodeAttrs& attrs, const OpContext& ctx,
                         const std::vector<TBlob>& outputs) {
     using namespace mxnet::op;
     using namespace mshadow::expr;
-    mshadow::Stream<xpu>* s = ctx.get_stream<xpu>();
     const SampleExponentialParam& param =
         nnvm::get<SampleExponentialParam>(attrs.parsed);
     CHECK_GT(param.lam, 0)
         << "lambda parameter in exponential distribution has to be positive";
     MSHADOW_REAL_TYPE_SWITCH(outputs[0].type_flag_, DType, {
-        mshadow::Random<xpu, DType>* prnd =
-            ctx.requested[0].get_random<xpu, DType>(s);
-        mshadow::Tensor<xpu, 2, DType> out = outputs[0].FlatTo2D<xpu, DType>(s);
-        prnd->SampleExponential(&out, param.lam);  // NOLINT(*)
+        typedef typename SampleReal<DType>::type FType;
+        const FType lam = param.lam;
+        DType* out = outputs[0].dptr<DType>();
+        ParallelSample<FType>(
+            ctx.requested[2].get_parallel_random(), outputs[0].Size(),
+            [&](RandomSampler<FType>* sampler, index_t i) {
+                out[i] = DType(sampler->Exponential(lam));
+            });
     });
 }
 
@@ -329,16 +342,19 @@ void SamplePoisson_(const nnvm::NodeAttrs& attrs, const OpContext& ctx,
                     const std::vector<TBlob>& outputs) {
     using namespace mxnet::op;
     using namespace mshadow::expr;
-    mshadow::Stream<xpu>* s = ctx.get_stream<xpu>();
     const SamplePoissonParam& param =
         nnvm::get<SamplePoissonParam>(attrs.parsed);
     CHECK_GE(param.lam, 0)
         << "lambda parameter in poisson distribution has to be non-negative";
     MSHADOW_REAL_TYPE_SWITCH(outputs[0].type_flag_, DType, {
-        mshadow::Random<xpu, DType>* prnd =
-            ctx.requested[0].get_random<xpu, DType>(s);
-        mshadow::Tensor<xpu, 2, DType> out = outputs[0].FlatTo2D<xpu, DType>(s);
-        prnd->SamplePoisson(&out, param.lam);  // NOLINT(*)
+        typedef typename SampleReal<DType>::type FType;
+        const FType lam = param.lam;
+        DType* out = outputs[0].dptr<DType>();
+        ParallelSample<FType>(
+            ctx.requested[2].get_parallel_random(), outputs[0].Size(),
+            [&](RandomSampler<FType>* sampler, index_t i) {
+                out[i] = DType(sampler->Poisson(lam));
+            });
     });
 }
 
@@ -349,7 +365,6 @@ void SampleNegBinomial_(const nnvm::NodeAttrs& attrs, const OpContext& ctx,
                         const std::vector<TBlob>& outputs) {
     using namespace mxnet::op;
     using namespace mshadow::expr;
-    mshadow::Stream<xpu>* s = ctx.get_stream<xpu>();
     const SampleNegBinomialParam& param =
         nnvm::get<SampleNegBinomialParam>(attrs.parsed);
     CHECK_GE(param.k, 0) << "k parameter in negative binomial distribution has "
@@ -357,10 +372,14 @@ void SampleNegBinomial_(const nnvm::NodeAttrs& attrs, const OpContext& ctx,
     CHECK_GE(param.p, 0) << "p parameter in negative binomial distribution has "
                             "to be non-negative";
     MSHADOW_REAL_TYPE_SWITCH(outputs[0].type_flag_, DType, {
-        mshadow::Random<xpu, DType>* prnd =
-            ctx.requested[0].get_random<xpu, DType>(s);
-        mshadow::Tensor<xpu, 2, DType> out = outputs[0].FlatTo2D<xpu, DType>(s);
-        prnd->SampleNegativeBinomial(&out, param.k, param.p);  // NOLINT(*)
+        typedef typename SampleReal<DType>::type FType;
+        const FType k = param.k, p = param.p;
+        DType* out = outputs[0].dptr<DType>();
+        ParallelSample<FType>(
+            ctx.requested[2].get_parallel_random(), outputs[0].Size(),
+            [&](RandomSampler<FType>* sampler, index_t i) {
+                out[i] = DType(sampler->NegativeBinomial(k, p));
+            });
     });
 }
 
@@ -371,7 +390,6 @@ void SampleGenNegBinomial_(const nnvm::NodeAttrs& attrs, const OpContext& ctx,
                            const std::vector<TBlob>& outputs) {
     using namespace mxnet::op;
     using namespace mshadow::expr;
-    mshadow::Stream<xpu>* s = ctx.get_stream<xpu>();
     const SampleGenNegBinomialParam& param =
         nnvm::get<SampleGenNegBinomialParam>(attrs.parsed);
     CHECK_GE(param.mu, 0) << "mu parameter in generalized negative binomial "
@@ -379,11 +397,14 @@ void SampleGenNegBinomial_(const nnvm::NodeAttrs& attrs, const OpContext& ctx,
     CHECK_GE(param.alpha, 0) << "alpha parameter in generalized negative "
                                 "binomial distribution has to be non-negative";
     MSHADOW_REAL_TYPE_SWITCH(outputs[0].type_flag_, DType, {
-        mshadow::Random<xpu, DType>* prnd =
-            ctx.requested[0].get_random<xpu, DType>(s);
-        mshadow::Tensor<xpu, 2, DType> out = outputs[0].FlatTo2D<xpu, DType>(s);
-        prnd->SampleGeneralizedNegativeBinomial(&out, param.mu,
-                                                param.alpha);  // NOLINT(*)
+        typedef typename SampleReal<DType>::type FType;
+        const FType mu = param.mu, alpha = param.alpha;
+        DType* out = outputs[0].dptr<DType>();
+        ParallelSample<FType>(
+            ctx.requested[2].get_parallel_random(), outputs[0].Size(),
+            [&](RandomSampler<FType>* sampler, index_t i) {
+                out[i] = DType(sampler->GeneralizedNegativeBinomial(mu, alpha));
+            });
     });
 }
 
@@ -426,8 +447,11 @@ inline bool SampleOpType(const nnvm::NodeAttrs& attrs,
     return true;
 }
 
+// the gpu versions of uniform and normal use the first two, the cpu versions
+// the counter-based generator
 inline std::vector<ResourceRequest> SampleResource(const NodeAttrs& attrs) {
-    return {ResourceRequest::kRandom, ResourceRequest::kTempSpace};
+    return {ResourceRequest::kRandom, ResourceRequest::kTempSpace,
+            ResourceRequest::kParallelRandom};
 }
 
 }  // namespace op
@@ -70,15 +70,19 @@ class ResourceManagerImpl : public ResourceManager {
         engine_ref_ = Engine::_GetSharedRef();
         storage_ref_ = Storage::_GetSharedRef();
         cpu_rand_.reset(new ResourceRandom<cpu>(Context::CPU(), global_seed_));
+        cpu_parallel_rand_.reset(
+            new ResourceParallelRandom(Context::CPU(), global_seed_));
         cpu_space_.reset(
             new ResourceTempSpace(Context::CPU(), cpu_temp_space_copy_));
     }
     ~ResourceManagerImpl() {
         // need explicit delete, before engine get killed
         cpu_rand_.reset(nullptr);
+        cpu_parallel_rand_.reset(nullptr);
         cpu_space_.reset(nullptr);
 #if MXNET_USE_CUDA
         gpu_rand_.Clear();
+        gpu_parallel_rand_.Clear();
         gpu_space_.Clear();
 #endif
         if (engine_ref_ != nullptr) {
@@ -97,6 +101,8 @@ class ResourceManagerImpl : public ResourceManager {
                     return cpu_rand_->resource;
                 case ResourceRequest::kTempSpace:
                     return cpu_space_->GetNext();
+                case ResourceRequest::kParallelRandom:
+                    return cpu_parallel_rand_->resource;
                 default:
                     LOG(FATAL) << "Unknown supported type " << req.type;
             }
@@ -122,6 +128,15 @@ class ResourceManagerImpl : public ResourceManager {
                              })
                         ->GetNext();
                 }
+                case ResourceRequest::kParallelRandom: {
+                    return gpu_parallel_rand_
+                        .Get(ctx.dev_id,
+                             [ctx, this]() {
+                                 return new ResourceParallelRandom(
+                                     ctx, global_seed_);
+                             })
+                        ->resource;
+                }
                 default:
                     LOG(FATAL) << "Unknown supported type " << req.type;
             }
@@ -136,9 +151,12 @@ class ResourceManagerImpl : public ResourceManager {
     void SeedRandom(uint32_t seed) override {
         global_seed_ = seed;
         cpu_rand_->Seed(global_seed_);
+        cpu_parallel_rand_->Seed(global_seed_);
 #if MXNET_USE_CUDA
         gpu_rand_.ForEach(
             [seed](size_t i, ResourceRandom<gpu>* p) { p->Seed(seed); });
+        gpu_parallel_rand_.ForEach(
+            [seed](size_t i, ResourceParallelRandom* p) { p->Seed(seed); });
 #endif
     }
 
@@ -185,6 +203,44 @@ class ResourceManagerImpl : public ResourceManager {
         }
     };
 
+    // the counter-based random number resources, whose state is on the host
+    struct ResourceParallelRandom {
+        /*! \brief the context of the generator */
+        Context ctx;
+        /*! \brief the generator state */
+        random::ParallelRandom* prnd;
+        /*! \brief resource representation */
+        Resource resource;
+        /*! \brief constructor */
+        explicit ResourceParallelRandom(Context ctx, uint32_t global_seed)
+            : ctx(ctx) {
+            resource.var = Engine::Get()->NewVariable();
+            prnd = new random::ParallelRandom(Key(global_seed));
+            resource.ptr_ = prnd;
+            resource.req = ResourceRequest(ResourceRequest::kParallelRandom);
+        }
+        ~ResourceParallelRandom() {
+            random::ParallelRandom* r = prnd;
+            Engine::Get()->DeleteVariable(
+                [r](RunContext rctx) { delete r; }, ctx, resource.var);
+        }
+        // the key differs between seeds and devices
+        inline uint64_t Key(uint32_t global_seed) const {
+            return (static_cast<uint64_t>(global_seed) << 32) |
+                   (static_cast<uint64_t>(ctx.dev_mask()) << 16) |
+                   static_cast<uint64_t>(ctx.dev_id);
+        }
+        // set seed to the generator, after the calls already pushed
+        inline void Seed(uint32_t global_seed) {
+            const uint64_t key = Key(global_seed);
+            random::ParallelRandom* r = prnd;
+            Engine::Get()->PushSync(
+                [r, key](RunContext rctx) { r->Seed(key); }, ctx, {},
+                {resource.var}, FnProperty::kNormal, 0,
+                PROFILER_MESSAGE("ResourceParallelRandomSetSeed"));
+        }
+    };
+
     // temporal space resource.
     struct ResourceTempSpace {
         /*! \brief the context of the device */
@@ -242,11 +298,15 @@ class ResourceManagerImpl : public ResourceManager {
     uint32_t global_seed_;
     /*! \brief CPU random number resources */
     std::unique_ptr<ResourceRandom<cpu> > cpu_rand_;
+    /*! \brief CPU counter-based random number resources */
+    std::unique_ptr<ResourceParallelRandom> cpu_parallel_rand_;
     /*! \brief CPU temp space resources */
     std::unique_ptr<ResourceTempSpace> cpu_space_;
 #if MXNET_USE_CUDA
     /*! \brief random number generator for GPU */
     common::LazyAllocArray<ResourceRandom<gpu> > gpu_rand_;
+    /*! \brief counter-based random number generator for GPU */
+    common::LazyAllocArray<ResourceParallelRandom> gpu_parallel_rand_;
     /*! \brief temp space for GPU */
     common::LazyAllocArray<ResourceTempSpace> gpu_space_;
 #endif
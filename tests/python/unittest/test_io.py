@@ -88,7 +88,90 @@ def test_NDArrayIter():
         else:
             assert(labelcount[i] == 100)
 
+def test_CSVIter():
+    import tempfile
+    tmpdir = tempfile.mkdtemp()
+    data_path = os.path.join(tmpdir, 'data.csv')
+    label_path = os.path.join(tmpdir, 'label.csv')
+    num_rows = 1000
+    with open(data_path, 'w') as fout:
+        for i in range(num_rows):
+            fout.write('%d,%.2f,-%d,%de-1\n' % (i, i + 0.25, i, i))
+    with open(label_path, 'w') as fout:
+        for i in range(num_rows):
+            fout.write('%d,%d\n' % (i * 2, i % 10))
+
+    dataiter = mx.io.CSVIter(data_csv=data_path, data_shape=(4,),
+                             label_csv=label_path, label_shape=(2,),
+                             batch_size=100, round_batch=False,
+                             preprocess_threads=3)
+    expected = np.array([[i, i + 0.25, -i, i * 0.1] for i in range(num_rows)])
+    batchidx = 0
+    for batch in dataiter:
+        begin = batchidx * 100
+        assert np.allclose(batch.data[0].asnumpy(), expected[begin:begin + 100])
+        assert (batch.label[0].asnumpy()[:, 0] == np.arange(begin, begin + 100) * 2).all()
+        batchidx += 1
+    assert batchidx == num_rows / 100
+
+    stats = dataiter.getstats()
+    assert stats['num_batches'] == num_rows / 100
+    for key in ['read_time', 'batch_time', 'wait_time', 'queued_batches']:
+        assert stats[key] >= 0
+
+    dataiter = mx.io.CSVIter(data_csv=data_path, data_shape=(2,),
+                             data_columns=(2, 0), dtype='int32',
+                             label_csv=label_path, label_columns=(1,),
+                             batch_size=100)
+    for batch in dataiter:
+        data = batch.data[0].asnumpy()
+        assert data.dtype == np.int32
+        assert (data[:, 0] == -data[:, 1]).all()
+        assert (batch.label[0].asnumpy().flatten() == data[:, 1] % 10).all()
+
+    # resume from a saved position
+    kwargs = dict(data_csv=data_path, data_shape=(4,), label_csv=label_path,
+                  label_shape=(2,), batch_size=300)
+    dataiter = mx.io.CSVIter(**kwargs)
+    dataiter.next()
+    state = dataiter.getstate()
+    expected = [dataiter.next().data[0].asnumpy() for _ in range(3)]
+    dataiter = mx.io.CSVIter(**kwargs)
+    dataiter.setstate(state)
+    for i in range(3):
+        assert np.allclose(dataiter.next().data[0].asnumpy(), expected[i])
+
+def test_LibSVMIter():
+    import tempfile
+    tmpdir = tempfile.mkdtemp()
+    data_path = os.path.join(tmpdir, 'data.t')
+    with open(data_path, 'w') as fout:
+        fout.write('1.0 0:0.5 2:1.2\n')
+        fout.write('-2.0\n')
+        fout.write('-3.0 0:0.6 1:2.4 2:1.2\n')
+        fout.write('4 2:-1.2\n')
+
+    dataiter = mx.io.LibSVMIter(data_libsvm=data_path, data_shape=(3,),
+                                batch_size=3)
+    batch = dataiter.next()
+    assert (batch.data[0].asnumpy() == np.array([0.5, 1.2, 0.6, 2.4, 1.2],
+                                                dtype=np.float32)).all()
+    assert (batch.label[0].asnumpy() == np.array([1, -2, -3])).all()
+    assert (dataiter.getaux(0).asnumpy() == np.array([0, 2, 0, 1, 2])).all()
+    assert (dataiter.getaux(1).asnumpy() == np.array([0, 2, 2, 5])).all()
+    batch = dataiter.next()
+    assert batch.pad == 2
+    assert (batch.label[0].asnumpy() == np.array([4, 0, 0])).all()
+    assert (dataiter.getaux(1).asnumpy() == np.array([0, 1, 1, 1])).all()
+    try:
+        dataiter.next()
+        assert False
+    except StopIteration:
+        pass
+
 if __name__ == "__main__":
+    test_LibSVMIter()
+    test_CSVIter()
     test_NDArrayIter()
     test_MNISTIter()
     test_Cifar10Rec()
@@ -379,6 +379,23 @@ def test_sigmoid():
     check_symbolic_forward(y, [xa], [ya])
     check_symbolic_backward(y, [xa], [np.ones(shape)], [ya * (1 - ya)])
 
+def test_simd_math():
+    # large enough for several blocks, covering the saturated ranges
+    xa = np.random.uniform(low=-100.0, high=100.0, size=(5, 3001))
+    xa[0, :4] = [0.0, 88.0, -87.0, -104.0]
+    x = mx.symbol.Variable("x")
+    for act_type, f in [('sigmoid', lambda a: 1.0 / (1.0 + np.exp(-a))),
+                        ('tanh', np.tanh),
+                        ('softrelu', lambda a: np.logaddexp(0.0, a))]:
+        y = mx.sym.Activation(x, act_type=act_type)
+        check_symbolic_forward(y, [xa], [f(xa)], rtol=1e-5, atol=1e-20)
+    check_symbolic_forward(mx.sym.tanh(x), [xa], [np.tanh(xa)], rtol=1e-5)
+    xe = np.random.uniform(low=-100.0, high=88.0, size=(3, 3001))
+    check_symbolic_forward(mx.sym.exp(x), [xe], [np.exp(xe)], rtol=1e-5,
+                           atol=1e-20)
+    xl = np.exp(np.random.uniform(low=-80.0, high=80.0, size=(3, 3001)))
+    check_symbolic_forward(mx.sym.log(x), [xl], [np.log(xl)], rtol=1e-5)
+
 def test_binary_logic():
     def _inner_test(forward_gt, logic_sym, x_shape, y_shape, test_scalar=True):
         x = mx.symbol.Variable("x")
@@ -435,13 +452,15 @@ def test_binary_logic():
                 x_shape=(1, 10), y_shape=(10, 1), test_scalar=False)
 
 def test_embedding():
-    in_dim = 10
-    out_dim = 4
-    batch = 24
+    # the large shapes take the sorted, segmented gradient path
+    for in_dim, out_dim, batch in [(10, 4, 24), (5000, 8, 3000)]:
+        for req in ['write', 'add']:
+            check_embedding(in_dim, out_dim, batch, req)
 
+def check_embedding(in_dim, out_dim, batch, req):
     data = mx.sym.Variable("data")
     embed = mx.sym.Embedding(data=data, input_dim=in_dim, output_dim=out_dim, name="embed")
-    exe_test = embed.simple_bind(default_context(), grad_req={'data': 'null', 'embed_weight': 'write'}, data=(batch,))
+    exe_test = embed.simple_bind(default_context(), grad_req={'data': 'null', 'embed_weight': req}, data=(batch,))
     arg_map = dict(zip(embed.list_arguments(), exe_test.arg_arrays))
     grad_map = dict(zip(embed.list_arguments(), exe_test.grad_arrays))
     np_data = np.random.randint(low=0, high=in_dim, size=batch)
@@ -457,8 +476,13 @@ def test_embedding():
     np_grad = np.random.uniform(-1, 1, exe_test.outputs[0].shape)
     grad = mx.nd.zeros(np_grad.shape)
     grad[:] = np_grad
+    np_init = np.random.uniform(-1, 1, grad_map["embed_weight"].shape)
+    grad_map["embed_weight"][:] = np_init
     exe_test.backward([grad])
-    assert_almost_equal(grad_map["embed_weight"].asnumpy(), np.dot(np_onehot.T, np_grad))
+    expected = np.dot(np_onehot.T, np_grad)
+    if req == 'add':
+        expected += np_init
+    assert_almost_equal(grad_map["embed_weight"].asnumpy(), expected, rtol=1e-4, atol=1e-4)
 
 # check ops handle duplicate input correctly.
 def test_binary_op_duplicate_input():
@@ -890,6 +914,97 @@ def test_convolution_grouping():
     for arr1, arr2 in zip(exe1.outputs + exe1.grad_arrays, exe2.outputs + exe2.grad_arrays):
         np.testing.assert_allclose(arr1.asnumpy(), arr2.asnumpy(), rtol=1e-3, atol=1e-4)
 
+def test_convolution_cpu_algo():
+    import os
+    # winograd and direct depthwise kernels must agree with im2col + gemm
+    def check(shape, **kwargs):
+        sym = mx.sym.Convolution(data=mx.sym.Variable('x'), name='conv', **kwargs)
+        exes = []
+        for fast_algo in ['0', '1']:
+            os.environ['MXNET_CPU_CONV_FAST_ALGO'] = fast_algo
+            exes.append(sym.simple_bind(mx.cpu(), x=shape))
+        del os.environ['MXNET_CPU_CONV_FAST_ALGO']
+        exe1, exe2 = exes
+        for arr1, arr2 in zip(exe1.arg_arrays, exe2.arg_arrays):
+            arr1[:] = np.random.normal(size=arr1.shape)
+            arr2[:] = arr1
+        for exe in exes:
+            exe.forward(is_train=True)
+            exe.backward(exe.outputs[0])
+        for arr1, arr2 in zip(exe1.outputs + exe1.grad_arrays, exe2.outputs + exe2.grad_arrays):
+            np.testing.assert_allclose(arr1.asnumpy(), arr2.asnumpy(), rtol=1e-3, atol=1e-4)
+
+    check((2, 8, 9, 7), num_filter=16, kernel=(3, 3), pad=(1, 1))
+    check((2, 8, 6, 5), num_filter=8, kernel=(3, 3), no_bias=True)
+    check((2, 6, 10, 9), num_filter=6, num_group=6, kernel=(3, 3), stride=(2, 2), pad=(1, 1))
+    check((2, 4, 12), num_filter=4, num_group=4, kernel=(5,), dilate=(2,))
+
+def test_pooling():
+    def check(shape, pool_type, **kwargs):
+        data = mx.sym.Variable('data')
+        sym = mx.sym.Pooling(data=data, pool_type=pool_type, name='pool', **kwargs)
+        # the argmax mask of max pooling is not an output
+        assert sym.list_outputs() == ['pool_output']
+        x = np.random.permutation(np.prod(shape)).reshape(shape) / 10.0
+        check_numeric_gradient(sym, [x], numeric_eps=1e-3, rtol=1e-2, atol=1e-3)
+
+    for pool_type in ['max', 'avg', 'sum']:
+        check((2, 3, 8, 8), pool_type, kernel=(2, 2), stride=(2, 2))
+        check((2, 3, 7, 7), pool_type, kernel=(3, 3), stride=(2, 2), pad=(1, 1))
+        check((2, 3, 5, 6), pool_type, kernel=(1, 1), global_pool=True)
+        check((2, 3, 9), pool_type, kernel=(3,), stride=(2,))
+        check((1, 2, 4, 5, 5), pool_type, kernel=(2, 2, 2), stride=(2, 2, 2))
+
+def test_blocked_layout():
+    import os
+    # inference in the channel-blocked layout must match the plain layout
+    data = mx.sym.Variable('data')
+    conv1 = mx.sym.Convolution(data=data, num_filter=16, kernel=(3, 3), pad=(1, 1), name='conv1')
+    bn = mx.sym.BatchNorm(data=conv1, fix_gamma=False, name='bn')
+    act = mx.sym.Activation(data=bn, act_type='relu', name='relu')
+    pool = mx.sym.Pooling(data=act, pool_type='max', kernel=(3, 3), stride=(2, 2), pad=(1, 1), name='pool')
+    conv2 = mx.sym.Convolution(data=pool, num_filter=16, kernel=(3, 3), pad=(2, 2), dilate=(2, 2), name='conv2')
+    res = conv2 + pool
+    avg = mx.sym.Pooling(data=res, pool_type='avg', kernel=(3, 3), stride=(2, 2), name='avg')
+    sym = mx.sym.Group([mx.sym.Flatten(avg), act])
+    shape = (2, 16, 9, 9)
+    arg_shapes, _, aux_shapes = sym.infer_shape(data=shape)
+    args = [mx.nd.array(np.random.normal(size=s)) for s in arg_shapes]
+    auxs = [mx.nd.array(np.random.uniform(0.5, 1.5, size=s)) for s in aux_shapes]
+    outputs = []
+    for block in ['0', '8', '16']:
+        os.environ['MXNET_CPU_BLOCKED_LAYOUT'] = block
+        exe = sym.bind(mx.cpu(), args=args, aux_states=auxs, grad_req='null')
+        exe.forward(is_train=False)
+        outputs.append([out.asnumpy() for out in exe.outputs])
+    del os.environ['MXNET_CPU_BLOCKED_LAYOUT']
+    for out in outputs[1:]:
+        for out1, out2 in zip(outputs[0], out):
+            np.testing.assert_allclose(out1, out2, rtol=1e-4, atol=1e-4)
+
+def test_fused_batch_norm():
+    import os
+    # inference with batch norm folded into the layer before it
+    data = mx.sym.Variable('data')
+    conv = mx.sym.Convolution(data=data, num_filter=8, kernel=(3, 3), pad=(1, 1), name='conv')
+    bn1 = mx.sym.BatchNorm(data=conv, fix_gamma=False, name='bn1')
+    act = mx.sym.Activation(data=bn1, act_type='relu', name='relu')
+    fc = mx.sym.FullyConnected(data=act, num_hidden=10, name='fc')
+    bn2 = mx.sym.BatchNorm(data=fc, eps=1e-4, name='bn2')
+    shape = (4, 3, 6, 6)
+    arg_shapes, _, aux_shapes = bn2.infer_shape(data=shape)
+    args = [mx.nd.array(np.random.normal(size=s)) for s in arg_shapes]
+    auxs = [mx.nd.array(np.random.uniform(0.5, 1.5, size=s)) for s in aux_shapes]
+    for is_train in [False, True]:
+        outputs = []
+        for fuse in ['0', '1']:
+            os.environ['MXNET_EXEC_FUSE_BATCH_NORM'] = fuse
+            exe = bn2.bind(mx.cpu(), args=args, aux_states=auxs, grad_req='null')
+            exe.forward(is_train=is_train)
+            outputs.append(exe.outputs[0].asnumpy())
+        np.testing.assert_allclose(outputs[0], outputs[1], rtol=1e-4, atol=1e-4)
+    del os.environ['MXNET_EXEC_FUSE_BATCH_NORM']
+
 def gen_broadcast_data(idx):
     # Manually set test cases
     binary_op_data_shape = np.array(
@@ -2290,6 +2405,15 @@ def test_order():
                            expected=[gt_topk(dat=a_npy, axis=1, ret_typ="indices", k=1,
                                              is_ascend=True)])
 
+    # long rows with ties: equal elements keep their original order
+    ties = np.random.randint(0, 20, size=(3, 1000)).astype(np.float32)
+    for is_ascend in [True, False]:
+        order = np.argsort(ties if is_ascend else -ties, axis=1, kind='mergesort')
+        b = mx.sym.topk(a, axis=1, is_ascend=is_ascend, ret_typ="both", k=5)
+        check_symbolic_forward(b, location={'a': ties},
+                               expected=[ties[np.arange(3)[:, None], order[:, :5]],
+                                         order[:, :5]])
+
 
 def test_blockgrad():
     a = mx.sym.Variable('a')
@@ -2983,6 +3107,30 @@ def test_log_softmax():
             check_numeric_gradient(sym, [data], rtol=0.05, atol=1e-3)
 
 
+def test_softmax_long_rows():
+    # rows long enough to be split into blocks, and rows of a few elements
+    for shape in [(2, 5000), (1, 2049), (7, 3), (40, 20)]:
+        data = np.random.uniform(-10, 10, size=shape).astype(np.float32)
+        label = np.random.randint(0, shape[1], size=(shape[0],))
+        prob = np_softmax(data.astype(np.float64))
+        check_symbolic_forward(mx.sym.softmax(), [data], [prob], rtol=1e-4, atol=1e-7)
+        check_symbolic_forward(mx.sym.log_softmax(), [data], [np.log(prob)],
+                               rtol=1e-4, atol=1e-5)
+        x = mx.sym.Variable('x')
+        l = mx.sym.Variable('l')
+        onehot = np.zeros(shape)
+        onehot[np.arange(shape[0]), label] = 1
+        sym = mx.sym.SoftmaxOutput(data=x, label=l)
+        check_symbolic_forward(sym, {'x': data, 'l': label}, [prob], rtol=1e-4, atol=1e-7)
+        check_symbolic_backward(sym, {'x': data, 'l': label}, [np.ones(shape)],
+                                {'x': prob - onehot}, rtol=1e-4, atol=1e-7)
+        sym = mx.sym.softmax_cross_entropy(data=x, label=l)
+        loss = -np.sum(np.log(np.maximum(prob[np.arange(shape[0]), label], 1e-8)))
+        check_symbolic_forward(sym, {'x': data, 'l': label}, [np.array([loss])], rtol=1e-4)
+        check_symbolic_backward(sym, {'x': data, 'l': label}, [np.array([2.0])],
+                                {'x': 2 * (prob - onehot)}, rtol=1e-4, atol=1e-6)
+
+
 def test_pick():
     def test_pick_helper(index_type=np.int32):
         for _ in range(100):
@@ -3073,6 +3221,242 @@ def test_quantization_op():
   assert same(a_.asnumpy(),  a_real.asnumpy())
 
 
+def test_quantize_model():
+    # quantized inference must stay close to float inference
+    data = mx.sym.Variable('data')
+    conv = mx.sym.Convolution(data=data, num_filter=8, kernel=(3, 3), pad=(1, 1), name='conv')
+    act = mx.sym.Activation(data=conv, act_type='relu', name='relu')
+    pool = mx.sym.Pooling(data=act, pool_type='max', kernel=(2, 2), stride=(2, 2), name='pool')
+    flat = mx.sym.Flatten(data=pool, name='flat')
+    fc = mx.sym.FullyConnected(data=flat, num_hidden=10, name='fc')
+    shape = (4, 3, 8, 8)
+    arg_shapes, _, _ = fc.infer_shape(data=shape)
+    arg_params = {name: mx.nd.array(np.random.uniform(-1, 1, size=s))
+                  for name, s in zip(fc.list_arguments(), arg_shapes) if name != 'data'}
+    x = mx.nd.array(np.random.uniform(-1, 1, size=shape))
+    exe = fc.bind(mx.cpu(), args=dict(arg_params, data=x), grad_req='null')
+    expected = exe.forward(is_train=False)[0].asnumpy()
+    calib_data = mx.io.NDArrayIter(data=x, batch_size=2)
+    for calib_mode in ['none', 'naive']:
+        qsym, qarg_params, _ = mx.contrib.quantization.quantize_model(
+            fc, arg_params, {}, calib_mode=calib_mode, calib_data=calib_data)
+        assert 'conv_weight_quantize' in qsym.list_arguments()
+        exe = qsym.bind(mx.cpu(), args=dict(qarg_params, data=x), grad_req='null')
+        out = exe.forward(is_train=False)[0].asnumpy()
+        assert np.abs(out - expected).max() < 0.05 * np.abs(expected).max()
+
+
+def test_quantize_model_positive_padded():
+    # the range of strictly positive data is widened to zero, so the padding
+    # of the quantized convolution stays zero
+    data = mx.sym.Variable('data')
+    conv = mx.sym.Convolution(data=data, num_filter=4, kernel=(3, 3), pad=(2, 2), name='conv')
+    shape = (2, 3, 6, 6)
+    arg_shapes, _, _ = conv.infer_shape(data=shape)
+    arg_params = {name: mx.nd.array(np.random.uniform(-1, 1, size=s))
+                  for name, s in zip(conv.list_arguments(), arg_shapes) if name != 'data'}
+    x = mx.nd.array(np.random.uniform(1, 2, size=shape))
+    exe = conv.bind(mx.cpu(), args=dict(arg_params, data=x), grad_req='null')
+    expected = exe.forward(is_train=False)[0].asnumpy()
+    qsym, qarg_params, _ = mx.contrib.quantization.quantize_model(conv, arg_params, {})
+    exe = qsym.bind(mx.cpu(), args=dict(qarg_params, data=x), grad_req='null')
+    out = exe.forward(is_train=False)[0].asnumpy()
+    assert np.abs(out - expected).max() < 0.05 * np.abs(expected).max()
+
+
+def test_sampled_softmax():
+    # the samplers draw distinct classes in range with consistent counts
+    label = mx.nd.array([0, 3, 99])
+    sampled, true_count, sampled_count = mx.contrib.nd.log_uniform_sampler(
+        label, num_sampled=20, range_max=100)
+    sampled = sampled.asnumpy().astype(np.int64)
+    assert len(set(sampled)) == 20
+    assert sampled.min() >= 0 and sampled.max() < 100
+    assert np.all(true_count.asnumpy() > 0) and np.all(true_count.asnumpy() <= 1)
+    # the more frequent class is more likely to be drawn
+    assert true_count.asnumpy()[0] > true_count.asnumpy()[2]
+    counts = mx.nd.array([0, 5, 0, 1])
+    sampled, _, sampled_count = mx.contrib.nd.unigram_sampler(
+        mx.nd.array([1]), counts, num_sampled=2)
+    assert sorted(sampled.asnumpy().tolist()) == [1, 3]
+    assert np.all(sampled_count.asnumpy() > 0) and np.all(sampled_count.asnumpy() <= 1)
+
+    # the logits and their gradients against numpy
+    batch, dim, num_class, num_sampled = 4, 5, 10, 3
+    data = np.random.uniform(-1, 1, (batch, dim))
+    weight = np.random.uniform(-1, 1, (num_class, dim))
+    bias = np.random.uniform(-1, 1, (num_class,))
+    label = np.array([1, 4, 4, 7])
+    sampled = np.array([4, 0, 9])
+    true_count = np.random.uniform(0.1, 1, (batch,))
+    sampled_count = np.random.uniform(0.1, 1, (num_sampled,))
+    classes = np.concatenate([label, sampled])
+    logits = np.dot(data, weight[classes].T) + bias[classes]
+    expected = np.concatenate([
+        np.diag(logits[:, :batch])[:, None] - np.log(true_count)[:, None],
+        logits[:, batch:] - np.log(sampled_count)], axis=1)
+    hit = label[:, None] == sampled[None, :]
+    expected[:, 1:][hit] = -1e30
+
+    names = ['data', 'weight', 'bias', 'label', 'sampled',
+             'true_expected_count', 'sampled_expected_count']
+    sym = mx.contrib.sym.sampled_logits(*[mx.sym.Variable(n) for n in names])
+    args = [data, weight, bias, label, sampled, true_count, sampled_count]
+    check_symbolic_forward(sym, args, [expected], rtol=1e-4, atol=1e-4)
+    ograd = np.random.uniform(-1, 1, expected.shape)
+    ograd_sampled = np.where(hit, 0, ograd[:, 1:])
+    grad_data = ograd[:, :1] * weight[label] + np.dot(ograd_sampled, weight[sampled])
+    grad_weight = np.zeros_like(weight)
+    grad_bias = np.zeros_like(bias)
+    for i in range(batch):
+        grad_weight[label[i]] += ograd[i, 0] * data[i]
+        grad_bias[label[i]] += ograd[i, 0]
+        for j in range(num_sampled):
+            grad_weight[sampled[j]] += ograd_sampled[i, j] * data[i]
+            grad_bias[sampled[j]] += ograd_sampled[i, j]
+    check_symbolic_backward(sym, args, [ograd],
+                            {'data': grad_data, 'weight': grad_weight,
+                             'bias': grad_bias}, rtol=1e-4, atol=1e-4)
+
+
+def test_fft_ifft():
+    def interleave(c):
+        return np.stack([c.real, c.imag], axis=-1).reshape(c.shape[:-1] + (2 * c.shape[-1],))
+    def to_complex(x):
+        return x[..., 0::2] + 1j * x[..., 1::2]
+    # even sizes use the half-length real transform, odd ones and primes the
+    # generic radix stages
+    for shape in [(3, 8), (2, 7), (2, 97), (2, 1000), (2, 3, 4, 6)]:
+        n = shape[-1]
+        x = np.random.normal(size=shape)
+        fft = mx.contrib.sym.fft(mx.sym.Variable('data'))
+        check_symbolic_forward(fft, [x], [interleave(np.fft.fft(x))], rtol=1e-3, atol=1e-3)
+        g = np.random.normal(size=shape[:-1] + (2 * n,))
+        check_symbolic_backward(fft, [x], [g], [n * np.fft.ifft(to_complex(g)).real],
+                                rtol=1e-3, atol=1e-3)
+        z = np.random.normal(size=shape[:-1] + (2 * n,))
+        ifft = mx.contrib.sym.ifft(mx.sym.Variable('data'))
+        check_symbolic_forward(ifft, [z], [n * np.fft.ifft(to_complex(z)).real],
+                               rtol=1e-3, atol=1e-3)
+        check_symbolic_backward(ifft, [z], [x], [interleave(np.fft.fft(x))],
+                                rtol=1e-3, atol=1e-3)
+
+
+def test_count_sketch():
+    n, in_dim, out_dim = 20, 50, 16
+    x = np.random.uniform(-10, 10, (n, in_dim))
+    h = np.random.randint(0, out_dim, (1, in_dim))
+    s = np.random.randint(0, 2, (1, in_dim)) * 2 - 1
+    sym = mx.contrib.sym.count_sketch(mx.sym.Variable('data'), mx.sym.Variable('h'),
+                                      mx.sym.Variable('s'), out_dim=out_dim)
+    expected = np.zeros((n, out_dim))
+    for j in range(in_dim):
+        expected[:, h[0, j]] += s[0, j] * x[:, j]
+    check_symbolic_forward(sym, [x, h, s], [expected], rtol=1e-4, atol=1e-4)
+    g = np.random.normal(size=(n, out_dim))
+    check_symbolic_backward(sym, [x, h, s], [g], {'data': g[:, h[0]] * s},
+                            rtol=1e-4, atol=1e-4)
+
+def test_multibox_detection_nms():
+    # anchors 0 and 1 overlap in class 0, anchor 2 overlaps them in class 1
+    anchors = mx.nd.array([[[0.1, 0.1, 0.5, 0.5], [0.12, 0.1, 0.52, 0.5],
+                            [0.11, 0.1, 0.51, 0.5], [0.6, 0.6, 0.9, 0.9]]])
+    cls_prob = mx.nd.array([[[0.1, 0.1, 0.1, 0.15],
+                             [0.9, 0.8, 0.0, 0.0],
+                             [0.0, 0.1, 0.9, 0.85]]])
+    loc_pred = mx.nd.zeros((1, 16))
+    boxes = anchors.asnumpy()[0]
+    def check(expected_ids, **kwargs):
+        out = mx.contrib.nd.MultiBoxDetection(cls_prob, loc_pred, anchors,
+                                              **kwargs).asnumpy()[0]
+        # sorted by decreasing score, ties in anchor order
+        order = [0, 2, 3, 1]
+        assert_almost_equal(out[:, 1], [0.9, 0.9, 0.85, 0.8])
+        assert_almost_equal(out[:, 2:], boxes[order], atol=1e-6)
+        assert_almost_equal(out[:, 0], expected_ids)
+    check([0, 1, 1, -1])
+    check([0, -1, 1, -1], force_suppress=True)
+    check([0, 1, -1, -1], nms_topk=2)
+
+def test_ctc_decode():
+    # the first sequence is more likely "a" than blank at every step, but
+    # each step more likely blank: greedy yields "" while the beam finds "a"
+    probs = np.array([[[0.6, 0.4, 1e-6], [1e-6, 1e-6, 1.0]],
+                      [[0.6, 0.4, 1e-6], [1e-6, 1.0, 1e-6]],
+                      [[0.6, 0.4, 1e-6], [1e-6, 1.0, 1e-6]]])
+    data = mx.nd.array(np.log(probs))
+    greedy = mx.nd.contrib.ctc_greedy_decode(data).asnumpy()
+    assert_almost_equal(greedy, [[0, 0, 0], [2, 1, 0]])
+    for dtype in [np.float32, np.float64]:
+        beam = mx.nd.contrib.ctc_beam_decode(data.astype(dtype),
+                                             beam_size=4).asnumpy()
+        assert_almost_equal(beam, [[1, 0, 0], [2, 1, 0]])
+
+def test_pack_sequence():
+    x = np.random.uniform(size=(5, 4, 3))
+    length = np.array([2, 5, 0, 3])
+    packed, batch_sizes, order = mx.nd.contrib.pack_sequence(
+        mx.nd.array(x), mx.nd.array(length))
+    assert_almost_equal(batch_sizes.asnumpy(), [3, 3, 2, 1, 1])
+    assert_almost_equal(order.asnumpy(), [1, 3, 0, 2])
+    rows = [x[t, b] for t in range(5) for b in [1, 3, 0, 2] if t < length[b]]
+    expected = np.zeros((20, 3))
+    expected[:len(rows)] = rows
+    assert_almost_equal(packed.asnumpy(), expected)
+    padded = x * (np.arange(5)[:, None] < length)[:, :, None]
+    unpacked = mx.nd.contrib.unpack_sequence(packed, mx.nd.array(length))
+    assert_almost_equal(unpacked.asnumpy(), padded)
+    # the gradient of unpack is pack
+    data = mx.sym.Variable('data')
+    seq = mx.sym.Variable('sequence_length')
+    sym = mx.sym.contrib.unpack_sequence(data, seq)
+    check_symbolic_backward(sym, [expected, length], [x],
+                            [expected, np.zeros(4)])
+    # the sequence ops take the packed layout directly
+    last = mx.nd.SequenceLast(packed, batch_sizes, order, packed=True)
+    expected_last = np.array([x[max(l - 1, 0), b] * (l > 0)
+                              for b, l in enumerate(length)])
+    assert_almost_equal(last.asnumpy(), expected_last)
+    masked = mx.nd.SequenceMask(packed, batch_sizes, order, packed=True,
+                                value=-1)
+    expected_masked = np.full((20, 3), -1.0)
+    expected_masked[:len(rows)] = rows
+    assert_almost_equal(masked.asnumpy(), expected_masked)
+    reversed_ = mx.nd.SequenceReverse(packed, batch_sizes, order, packed=True)
+    expected_reversed = np.zeros_like(x)
+    for b, l in enumerate(length):
+        expected_reversed[:l, b] = x[:l, b][::-1]
+    assert_almost_equal(
+        mx.nd.contrib.unpack_sequence(reversed_, mx.nd.array(length)).asnumpy(),
+        expected_reversed)
+    # and route the gradient back to the packed rows
+    pos = {(t, b): i for i, (t, b) in enumerate(
+        (t, b) for t in range(5) for b in [1, 3, 0, 2] if t < length[b])}
+    batch = mx.sym.Variable('batch_sizes')
+    indices = mx.sym.Variable('sorted_indices')
+    location = {'data': expected, 'batch_sizes': batch_sizes.asnumpy(),
+                'sorted_indices': order.asnumpy()}
+    ograd = np.random.uniform(size=(4, 3))
+    grad = np.zeros((20, 3))
+    for b, l in enumerate(length):
+        if l > 0:
+            grad[pos[(l - 1, b)]] = ograd[b]
+    check_symbolic_backward(
+        mx.sym.SequenceLast(data, batch, indices, packed=True), location,
+        [ograd], {'data': grad})
+    ograd = np.random.uniform(size=(20, 3))
+    grad = ograd.copy()
+    grad[len(rows):] = 0
+    check_symbolic_backward(
+        mx.sym.SequenceMask(data, batch, indices, packed=True, value=-1),
+        location, [ograd], {'data': grad})
+    grad = np.zeros((20, 3))
+    for (t, b), i in pos.items():
+        grad[i] = ograd[pos[(length[b] - 1 - t, b)]]
+    check_symbolic_backward(
+        mx.sym.SequenceReverse(data, batch, indices, packed=True), location,
+        [ograd], {'data': grad})
+
 def test_custom_op():
     class Sqr(mx.operator.CustomOp):
         def forward(self, is_train, req, in_data, out_data, aux):
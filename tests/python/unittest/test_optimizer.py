@@ -350,7 +350,258 @@ def test_rms():
     for kwarg in kwargs:
         compare_optimizer(opt1(**kwarg), opt2(**kwarg), shape)
 
+# AdaGrad
+
+class PyAdaGrad(mx.optimizer.Optimizer):
+    """python reference implemenation of adagrad"""
+    def __init__(self, eps=1e-7, **kwargs):
+        super(PyAdaGrad, self).__init__(**kwargs)
+        self.float_stable_eps = eps
+
+    def create_state(self, index, weight):
+        return mx.nd.zeros(weight.shape, weight.context)  # history
+
+    def update(self, index, weight, grad, state):
+        lr = self._get_lr(index)
+        wd = self._get_wd(index)
+        self._update_count(index)
+
+        grad = grad * self.rescale_grad
+        if self.clip_gradient is not None:
+            grad = mx.nd.clip(grad, -self.clip_gradient, self.clip_gradient)
+        history = state
+        history[:] += (grad * grad)
+        weight[:] += -lr * (grad / mx.nd.sqrt(history + self.float_stable_eps) + wd * weight)
+
+def check_lazy_update(opt_class, num_states, **kwargs):
+    # rows 1 and 3 get no gradient; the default update still changes them,
+    # the lazy update leaves them and their states alone. Rows run along the
+    # first axis, so row 0, only partly zero, is updated all through
+    assert not opt_class(**kwargs).lazy_update
+    for lazy_update in [False, True]:
+        opt = opt_class(lazy_update=lazy_update, **kwargs)
+        weight = mx.random.uniform(shape=(4, 3, 2), ctx=default_context())
+        grad = mx.random.uniform(shape=(4, 3, 2), ctx=default_context())
+        grad[0][0] = 0
+        grad[1] = 0
+        grad[3] = 0
+        state = opt.create_state(0, weight)
+        states = list(state) if num_states > 1 else [state]
+        for s in states:
+            s[:] = 0.5
+        before = weight.asnumpy()
+        opt.update(0, weight, grad, state)
+        after = weight.asnumpy()
+        assert not np.allclose(after[[0, 2]], before[[0, 2]])
+        assert not np.allclose(after[0, 0], before[0, 0])
+        if not lazy_update:
+            assert not np.allclose(after[[1, 3]], before[[1, 3]])
+            continue
+        assert_almost_equal(after[[1, 3]], before[[1, 3]])
+        for s in states:
+            assert_almost_equal(s.asnumpy()[[1, 3]], np.full((2, 3, 2), 0.5))
+
+def test_adagrad():
+    mx.random.seed(0)
+    opt1 = PyAdaGrad
+    opt2 = mx.optimizer.AdaGrad
+    shape = (3, 4, 5)
+    kwargs = [{},
+              {'clip_gradient': 0.5},
+              {'clip_gradient': 0.4, 'rescale_grad': 0.14},
+              {'rescale_grad': 0.8},
+              {'clip_gradient': 0.5, 'wd': 0.07},
+              {'clip_gradient': 0.4, 'rescale_grad': 0.14, 'wd': 0.03},
+              {'rescale_grad': 0.8, 'wd': 0.05}]
+    for kwarg in kwargs:
+        compare_optimizer(opt1(**kwarg), opt2(**kwarg), shape)
+    check_lazy_update(mx.optimizer.AdaGrad, 1, wd=0.1)
+
+# FTRL
+
+class PyFtrl(mx.optimizer.Optimizer):
+    """python reference implemenation of ftrl"""
+    def __init__(self, lamda1=0.01, learning_rate=0.1, beta=1, **kwargs):
+        super(PyFtrl, self).__init__(**kwargs)
+        self.lamda1 = lamda1
+        self.beta = beta
+        self.lr = learning_rate
+
+    def create_state(self, index, weight):
+        return (mx.nd.zeros(weight.shape, weight.context),  # dn
+                mx.nd.zeros(weight.shape, weight.context))  # n
+
+    def update(self, index, weight, grad, state):
+        self._update_count(index)
+        wd = self._get_wd(index)
+        lr = self._get_lr(index)
+
+        grad = grad * self.rescale_grad
+        if self.clip_gradient is not None:
+            grad = mx.nd.clip(grad, -self.clip_gradient, self.clip_gradient)
+        dn, n = state
+        dn += grad - (mx.nd.sqrt(n + grad * grad) - mx.nd.sqrt(n)) * weight / lr
+        n += grad * grad
+        weight[:] = (mx.nd.sign(dn) * self.lamda1 - dn) / \
+                    ((self.beta + mx.nd.sqrt(n)) / lr + wd) * (mx.nd.abs(dn) > self.lamda1)
+
+def test_ftrl():
+    mx.random.seed(0)
+    opt1 = PyFtrl
+    opt2 = mx.optimizer.Ftrl
+    shape = (3, 4, 5)
+    kwargs = [{},
+              {'clip_gradient': 0.5},
+              {'clip_gradient': 0.4, 'rescale_grad': 0.14},
+              {'rescale_grad': 0.8, 'lamda1': 0.3},
+              {'clip_gradient': 0.5, 'wd': 0.07},
+              {'clip_gradient': 0.4, 'rescale_grad': 0.14, 'wd': 0.03},
+              {'rescale_grad': 0.8, 'wd': 0.05, 'beta': 0.5}]
+    for kwarg in kwargs:
+        compare_optimizer(opt1(**kwarg), opt2(**kwarg), shape)
+    check_lazy_update(mx.optimizer.Ftrl, 2)
+
+# LARS and LAMB
+
+class PyLARS(mx.optimizer.Optimizer):
+    """python reference implemenation of lars"""
+    def __init__(self, momentum=0.9, eta=0.001, epsilon=1e-9, **kwargs):
+        super(PyLARS, self).__init__(**kwargs)
+        self.momentum = momentum
+        self.eta = eta
+        self.epsilon = epsilon
+
+    def create_state(self, index, weight):
+        return mx.nd.zeros(weight.shape, weight.context, dtype=weight.dtype)
+
+    def update(self, index, weight, grad, state):
+        lr = self._get_lr(index)
+        wd = self._get_wd(index)
+        self._update_count(index)
+
+        w = weight.asnumpy()
+        g = grad.asnumpy() * self.rescale_grad
+        if self.clip_gradient is not None:
+            g = np.clip(g, -self.clip_gradient, self.clip_gradient)
+        w_norm, g_norm = np.linalg.norm(w), np.linalg.norm(g)
+        ratio = 1.0
+        if w_norm > 0 and g_norm > 0:
+            ratio = self.eta * w_norm / (g_norm + wd * w_norm + self.epsilon)
+        mom = self.momentum * state.asnumpy() - lr * ratio * (g + wd * w)
+        state[:] = mom
+        weight[:] = w + mom
+
+class PyLAMB(mx.optimizer.Optimizer):
+    """python reference implemenation of lamb"""
+    def __init__(self, learning_rate=0.001, beta1=0.9, beta2=0.999, epsilon=1e-6,
+                 lower_bound=None, upper_bound=None, bias_correction=True, **kwargs):
+        super(PyLAMB, self).__init__(learning_rate=learning_rate, **kwargs)
+        self.beta1 = beta1
+        self.beta2 = beta2
+        self.epsilon = epsilon
+        self.lower_bound = lower_bound
+        self.upper_bound = upper_bound
+        self.bias_correction = bias_correction
+
+    def create_state(self, index, weight):
+        return (mx.nd.zeros(weight.shape, weight.context, dtype=weight.dtype),
+                mx.nd.zeros(weight.shape, weight.context, dtype=weight.dtype))
+
+    def update(self, index, weight, grad, state):
+        lr = self._get_lr(index)
+        wd = self._get_wd(index)
+        self._update_count(index)
+        t = self._index_update_count[index]
+
+        w = weight.asnumpy()
+        g = grad.asnumpy() * self.rescale_grad
+        if self.clip_gradient is not None:
+            g = np.clip(g, -self.clip_gradient, self.clip_gradient)
+        mean, var = state
+        m = self.beta1 * mean.asnumpy() + (1 - self.beta1) * g
+        v = self.beta2 * var.asnumpy() + (1 - self.beta2) * g * g
+        mean[:] = m
+        var[:] = v
+        if self.bias_correction:
+            m = m / (1 - self.beta1**t)
+            v = v / (1 - self.beta2**t)
+        r = m / (np.sqrt(v) + self.epsilon) + wd * w
+        w_norm, r_norm = np.linalg.norm(w), np.linalg.norm(r)
+        if self.lower_bound:
+            w_norm = max(w_norm, self.lower_bound)
+        if self.upper_bound:
+            w_norm = min(w_norm, self.upper_bound)
+        ratio = w_norm / r_norm if w_norm > 0 and r_norm > 0 else 1.0
+        weight[:] = w - lr * ratio * r
+
+def test_lars():
+    mx.random.seed(0)
+    shape = (3, 4, 5)
+    kwargs = [{},
+              {'clip_gradient': 0.5, 'eta': 0.01},
+              {'clip_gradient': 0.4, 'rescale_grad': 0.14, 'momentum': 0.5},
+              {'rescale_grad': 0.8, 'wd': 0.05}]
+    for kwarg in kwargs:
+        compare_optimizer(PyLARS(**kwarg), mx.optimizer.LARS(**kwarg), shape)
+
+def test_lamb():
+    mx.random.seed(0)
+    shape = (3, 4, 5)
+    kwargs = [{},
+              {'clip_gradient': 0.5, 'wd': 0.07},
+              {'rescale_grad': 0.8, 'bias_correction': False},
+              {'lower_bound': 5.0, 'upper_bound': 6.0, 'wd': 0.01}]
+    for kwarg in kwargs:
+        compare_optimizer(PyLAMB(**kwarg), mx.optimizer.LAMB(**kwarg), shape)
+
+# Multi-tensor updates
+
+def test_multi_update():
+    mx.random.seed(0)
+    shapes = [(3, 4), (5,), (200, 200), (1,)]
+    lrs = [0.1, 0.05, 0.2, 0.01]
+    wds = [0.0, 0.01, 0.001, 0.1]
+    def arrays(num_states):
+        return [[mx.random.uniform(shape=shape, ctx=default_context())
+                 for _ in range(2 + num_states)] for shape in shapes]
+    def check(multi_op, single_op, num_states, norm_scale=1.0, **kwargs):
+        groups = arrays(num_states)
+        copies = [[x.copy() for x in group] for group in groups]
+        multi_op(*[x for group in groups for x in group],
+                 out=[group[0] for group in groups], lrs=lrs, wds=wds,
+                 num_weights=len(shapes), **kwargs)
+        kwargs.pop('clip_global_norm', None)
+        kwargs['rescale_grad'] = kwargs.get('rescale_grad', 1.0) * norm_scale
+        for lr, wd, group in zip(lrs, wds, copies):
+            single_op(*group, out=group[0], lr=lr, wd=wd, **kwargs)
+        # adam_update overwrites its gradient, multi_adam_update does not
+        for group, copy in zip(groups, copies):
+            for x, y in zip(group[:1] + group[2:], copy[:1] + copy[2:]):
+                assert_almost_equal(x.asnumpy(), y.asnumpy(), rtol=1e-4,
+                                    atol=1e-6)
+    for kwargs in [{}, {'rescale_grad': 0.5, 'clip_gradient': 0.3}]:
+        check(mx.nd.multi_sgd_update, mx.nd.sgd_update, 0, **kwargs)
+        check(mx.nd.multi_sgd_mom_update, mx.nd.sgd_mom_update, 1,
+              momentum=0.9, **kwargs)
+        check(mx.nd.multi_adam_update, mx.nd.adam_update, 2, **kwargs)
+    # the gradients of uniform(0, 1) have a norm of about sqrt(40000 / 3)
+    mx.random.seed(1)
+    grads = [g for _, g in arrays(0)]
+    norm = math.sqrt(sum((g.asnumpy().astype(np.float64) ** 2).sum()
+                         for g in grads)) * 0.5
+    mx.random.seed(1)
+    check(mx.nd.multi_sgd_update, mx.nd.sgd_update, 0,
+          norm_scale=10.0 / norm, rescale_grad=0.5, clip_global_norm=10.0)
+    mx.random.seed(1)
+    check(mx.nd.multi_sgd_update, mx.nd.sgd_update, 0, rescale_grad=0.5,
+          clip_global_norm=1e6)
+
 if __name__ == '__main__':
     test_adam()
     test_rms()
     test_sgd()
+    test_multi_update()
+    test_adagrad()
+    test_ftrl()
+    test_lars()
+    test_lamb()
@@ -169,6 +169,31 @@ def test_random():
     check_with_device(mx.context.current_context(), 'float32')
     check_with_device(mx.context.current_context(), 'float64')
 
+def test_parallel_random():
+    # cpu samples and dropout masks depend on the seed only, and successive
+    # calls draw different numbers
+    ctx = mx.cpu()
+    mu = mx.nd.array([[1.0, 2.5], [0.5, 4.0]], ctx=ctx)
+    alpha = mx.nd.array([[1.0, 0.1], [2.0, 0.5]], ctx=ctx)
+    x = mx.nd.ones((50, 999), ctx=ctx)
+    def draw():
+        with mx.contrib.autograd.train_section():
+            mask = mx.nd.Dropout(x, p=0.3)
+        return [mx.nd.sample_gamma(mu, alpha, shape=(3000,)).asnumpy(),
+                mx.nd.random_normal(shape=(70, 301), ctx=ctx).asnumpy(),
+                mask.asnumpy()]
+    mx.random.seed(42)
+    ret1 = draw()
+    ret2 = draw()
+    mx.random.seed(42)
+    ret3 = draw()
+    for a, b, c in zip(ret1, ret2, ret3):
+        assert same(a, c)
+        assert not same(a, b)
+    kept = ret1[2] != 0
+    assert abs(kept.mean() - 0.7) < 0.01
+    assert np.allclose(ret1[2][kept], 1 / 0.7)
+
 
 
 if __name__ == '__main__':